@@ -165,6 +165,12 @@ int main(int argc, char **argv)
         QCommandLineOption subtitleOption("subtitle", "Subtitle file.", "file");
         parser.addOption(subtitleOption);
 
+        QCommandLineOption segmentsOption("segments",
+                                          "Comma separated frame ranges (in-out) whose video is encoded in parallel processes. The audio is rendered once and "
+                                          "the parts are joined without reencoding.",
+                                          "ranges");
+        parser.addOption(segmentsOption);
+
         QCommandLineOption debugOption("debug", "Enable debug mode, doesn't delete log file on render success.");
         parser.addOption(debugOption);
 
@@ -237,6 +243,10 @@ int main(int argc, char **argv)
         bool debugMode = parser.isSet(debugOption);
 
         auto *rJob = new RenderJob(render, playlist, target, pid, in, out, subtitleFile, debugMode, &app);
+        const QStringList segments = parser.value(segmentsOption).split(QLatin1Char(','), Qt::SkipEmptyParts);
+        if (!segments.isEmpty() && !rJob->setSegments(doc, segments)) {
+            qDebug() << "Cannot render in segments, rendering in one piece";
+        }
         QObject::connect(rJob, &RenderJob::renderingFinished, rJob, [&]() {
             rJob->deleteLater();
             app.quit();
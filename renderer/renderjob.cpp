@@ -14,6 +14,7 @@
 #include <QJsonObject>
 #include <QStandardPaths>
 #include <QStringList>
+#include <QTemporaryFile>
 #include <utility>
 
 RenderJob::RenderJob(const QString &render, const QString &scenelist, const QString &target, int pid, int in, int out, const QString &subtitleFile,
@@ -100,6 +101,7 @@ void RenderJob::sendFinish(int status, const QString &error)
 void RenderJob::slotAbort()
 {
     m_renderProcess.kill();
+    cleanupSegments();
     sendFinish(-3, QString());
     if (m_erase) {
         QFile(m_scenelist).remove();
@@ -212,10 +214,14 @@ void RenderJob::start()
         }
         connect(m_kdenlivesocket, &QLocalSocket::readyRead, this, &RenderJob::gotMessage);
     }
-    // Because of the logging, we connect to stderr in all cases.
-    connect(&m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
-    m_logstream << "Started render process: " << m_prog << ' ' << m_args.join(QLatin1Char(' ')) << "\n";
-    m_renderProcess.start(m_prog, m_args);
+    if (!m_segments.empty()) {
+        startSegments();
+    } else {
+        // Because of the logging, we connect to stderr in all cases.
+        connect(&m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
+        m_logstream << "Started render process: " << m_prog << ' ' << m_args.join(QLatin1Char(' ')) << "\n";
+        m_renderProcess.start(m_prog, m_args);
+    }
     if (m_debugMode) {
         m_logstream << "Using MLT REPOSITORY: " << qgetenv("MLT_REPOSITORY") << "\n";
         m_logstream << "Using MLT DATA: " << qgetenv("MLT_DATA") << "\n";
@@ -242,15 +248,7 @@ void RenderJob::slotIsOver(int exitCode, QProcess::ExitStatus status)
     }
     if (status == QProcess::CrashExit || m_renderProcess.error() != QProcess::UnknownError || exitCode != 0) {
         // rendering crashed
-        sendFinish(-2, m_errorMessage);
-        QStringList args;
-        QString error = tr("Rendering of %1 aborted, resulting video will probably be corrupted.").arg(m_dest);
-        if (m_frame > 0) {
-            error += QLatin1Char('\n') + tr("Frame: %1").arg(m_frame);
-        }
-        args << QStringLiteral("--error") << error;
-        m_logstream << error << "\n";
-        QProcess::startDetached(QStringLiteral("kdialog"), args);
+        reportFailure();
     } else {
         m_logstream << "Rendering of " << m_dest << " finished"
                     << "\n";
@@ -261,25 +259,8 @@ void RenderJob::slotIsOver(int exitCode, QProcess::ExitStatus status)
             if (!m_debugMode && QFile::exists(m_dest)) {
                 m_logfile.remove();
             }
-            if (!m_subtitleFile.isEmpty()) {
-                // Embed subtitles
-                QString ffmpegExe = QStandardPaths::findExecutable(QStringLiteral("ffmpeg"));
-                if (!ffmpegExe.isEmpty()) {
-                    QFileInfo videoRender(m_dest);
-                    m_temporaryRenderFile = QDir::temp().absoluteFilePath(videoRender.fileName());
-                    QStringList args = {
-                        "-y", "-v", "quiet", "-stats", "-i", m_dest, "-i", m_subtitleFile, "-c", "copy", "-f", "matroska", m_temporaryRenderFile};
-                    qDebug() << "::: JOB ARGS: " << args;
-                    m_progress = 0;
-                    disconnect(&m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
-                    m_subsProcess.setProcessChannelMode(QProcess::MergedChannels);
-                    connect(&m_subsProcess, &QProcess::readyReadStandardOutput, this, &RenderJob::receivedSubtitleProgress);
-                    m_subsProcess.start(ffmpegExe, args);
-                    m_subsProcess.waitForStarted(-1);
-                    m_subsProcess.waitForFinished(-1);
-                    slotCheckSubtitleProcess(m_subsProcess.exitCode(), m_subsProcess.exitStatus());
-                    return;
-                }
+            if (embedSubtitles()) {
+                return;
             }
             sendFinish(-1, QString());
         }
@@ -288,6 +269,278 @@ void RenderJob::slotIsOver(int exitCode, QProcess::ExitStatus status)
     m_looper.quit();
 }
 
+void RenderJob::reportFailure()
+{
+    sendFinish(-2, m_errorMessage);
+    QStringList args;
+    QString error = tr("Rendering of %1 aborted, resulting video will probably be corrupted.").arg(m_dest);
+    if (m_frame > 0) {
+        error += QLatin1Char('\n') + tr("Frame: %1").arg(m_frame);
+    }
+    args << QStringLiteral("--error") << error;
+    m_logstream << error << "\n";
+    QProcess::startDetached(QStringLiteral("kdialog"), args);
+}
+
+bool RenderJob::embedSubtitles()
+{
+    if (m_subtitleFile.isEmpty()) {
+        return false;
+    }
+    QString ffmpegExe = QStandardPaths::findExecutable(QStringLiteral("ffmpeg"));
+    if (ffmpegExe.isEmpty()) {
+        return false;
+    }
+    QFileInfo videoRender(m_dest);
+    m_temporaryRenderFile = QDir::temp().absoluteFilePath(videoRender.fileName());
+    QStringList args = {"-y", "-v", "quiet", "-stats", "-i", m_dest, "-i", m_subtitleFile, "-c", "copy", "-f", "matroska", m_temporaryRenderFile};
+    qDebug() << "::: JOB ARGS: " << args;
+    m_progress = 0;
+    disconnect(&m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
+    m_subsProcess.setProcessChannelMode(QProcess::MergedChannels);
+    connect(&m_subsProcess, &QProcess::readyReadStandardOutput, this, &RenderJob::receivedSubtitleProgress);
+    m_subsProcess.start(ffmpegExe, args);
+    m_subsProcess.waitForStarted(-1);
+    m_subsProcess.waitForFinished(-1);
+    slotCheckSubtitleProcess(m_subsProcess.exitCode(), m_subsProcess.exitStatus());
+    return true;
+}
+
+bool RenderJob::setSegments(const QDomDocument &doc, const QStringList &ranges)
+{
+    if (ranges.count() < 2 || QStandardPaths::findExecutable(QStringLiteral("ffmpeg")).isEmpty()) {
+        return false;
+    }
+    QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+    if (consumer.isNull() || consumer.hasAttribute(QLatin1String("vn")) || consumer.hasAttribute(QLatin1String("video_off"))) {
+        return false;
+    }
+    std::vector<Segment> segments;
+    for (const QString &range : ranges) {
+        bool okIn, okOut;
+        Segment segment;
+        segment.in = range.section(QLatin1Char('-'), 0, 0).toInt(&okIn);
+        segment.out = range.section(QLatin1Char('-'), 1, 1).toInt(&okOut);
+        if (!okIn || !okOut || segment.out < segment.in) {
+            qWarning() << "Invalid segment" << range;
+            return false;
+        }
+        segments.push_back(segment);
+    }
+    const bool hasAudio = !consumer.hasAttribute(QLatin1String("an")) && !consumer.hasAttribute(QLatin1String("audio_off"));
+    if (hasAudio) {
+        // The audio is not split, segment boundaries are rarely on an audio frame boundary
+        Segment audio;
+        audio.in = segments.front().in;
+        audio.out = segments.back().out;
+        audio.audio = true;
+        segments.push_back(audio);
+    }
+    // Parts are written next to the final file, they are as large as the result
+    const QFileInfo info(m_dest);
+    const QString suffix = info.suffix().isEmpty() ? QString() : QStringLiteral(".") + info.suffix();
+    QDomDocument segmentDoc = doc.cloneNode(true).toDocument();
+    QDomElement segmentConsumer = segmentDoc.documentElement().firstChildElement(QStringLiteral("consumer"));
+    for (size_t i = 0; i < segments.size(); ++i) {
+        Segment &segment = segments[i];
+        segment.target = info.absoluteDir().absoluteFilePath(
+            segment.audio ? QStringLiteral("%1.audio%2").arg(info.completeBaseName(), suffix)
+                          : QStringLiteral("%1.part%2%3").arg(info.completeBaseName()).arg(i + 1).arg(suffix));
+        segmentConsumer.setAttribute(QStringLiteral("in"), segment.in);
+        segmentConsumer.setAttribute(QStringLiteral("out"), segment.out);
+        segmentConsumer.setAttribute(QStringLiteral("target"), segment.target);
+        if (segment.audio) {
+            segmentConsumer.setAttribute(QStringLiteral("vn"), 1);
+            segmentConsumer.setAttribute(QStringLiteral("video_off"), 1);
+            segmentConsumer.removeAttribute(QStringLiteral("an"));
+            segmentConsumer.removeAttribute(QStringLiteral("audio_off"));
+        } else {
+            segmentConsumer.setAttribute(QStringLiteral("an"), 1);
+            segmentConsumer.setAttribute(QStringLiteral("audio_off"), 1);
+        }
+        QTemporaryFile tmp(QDir::temp().absoluteFilePath(QStringLiteral("kdenlive-XXXXXX.mlt")));
+        tmp.setAutoRemove(false);
+        if (!tmp.open()) {
+            qWarning() << "Cannot create segment playlist";
+            for (const Segment &written : segments) {
+                if (!written.playlist.isEmpty()) {
+                    QFile::remove(written.playlist);
+                }
+            }
+            return false;
+        }
+        tmp.write(segmentDoc.toByteArray());
+        tmp.close();
+        segment.playlist = tmp.fileName();
+    }
+    m_segments = std::move(segments);
+    m_concatList = info.absoluteDir().absoluteFilePath(QStringLiteral("%1.parts.txt").arg(info.completeBaseName()));
+    return true;
+}
+
+void RenderJob::startSegments()
+{
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        Segment &segment = m_segments[i];
+        segment.process = new QProcess(this);
+        segment.process->setReadChannel(QProcess::StandardError);
+        connect(segment.process, &QProcess::readyReadStandardError, this, [this, i]() { receivedSegmentStderr(i); });
+        connect(segment.process, &QProcess::finished, this, [this, i](int exitCode, QProcess::ExitStatus status) { slotSegmentOver(i, exitCode, status); });
+        const QStringList args = {QStringLiteral("-progress2"), segment.playlist};
+        m_logstream << "Started render process: " << m_prog << ' ' << args.join(QLatin1Char(' ')) << "\n";
+        segment.process->start(m_prog, args);
+    }
+}
+
+void RenderJob::receivedSegmentStderr(size_t ix)
+{
+    Segment &segment = m_segments[ix];
+    segment.output.append(QString::fromLocal8Bit(segment.process->readAllStandardError()));
+    const int lineEnd = segment.output.lastIndexOf(QLatin1Char('\n'));
+    if (lineEnd < 0) {
+        return;
+    }
+    const QStringList lines = segment.output.left(lineEnd).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    segment.output.remove(0, lineEnd + 1);
+    for (const QString &line : lines) {
+        const QString result = line.simplified();
+        if (!result.startsWith(QLatin1String("Current Frame"))) {
+            if (!result.isEmpty()) {
+                m_errorMessage.append(result + QStringLiteral("<br>"));
+                m_logstream << result;
+            }
+            continue;
+        }
+        bool ok;
+        const int progress = result.section(QLatin1Char(' '), -1).toInt(&ok);
+        if (ok && progress > segment.progress && progress <= 100) {
+            segment.progress = progress;
+        }
+    }
+    // The audio is much faster to render than the video, only count the video in the progress
+    qint64 total = 0;
+    qint64 done = 0;
+    for (const Segment &s : m_segments) {
+        if (!s.audio) {
+            total += s.out - s.in + 1;
+            done += qint64(s.out - s.in + 1) * s.progress / 100;
+        }
+    }
+    const int progress = total > 0 ? int(100 * done / total) : 0;
+    qint64 elapsedTime = m_startTime.secsTo(QDateTime::currentDateTime());
+    if (progress <= m_progress || elapsedTime == m_seconds) {
+        return;
+    }
+    m_seconds = elapsedTime;
+    m_progress = progress;
+    m_frame = m_framein + int(done);
+    updateProgress();
+}
+
+void RenderJob::slotSegmentOver(size_t ix, int exitCode, QProcess::ExitStatus status)
+{
+    Segment &segment = m_segments[ix];
+    if (status == QProcess::CrashExit || segment.process->error() != QProcess::UnknownError || exitCode != 0 || !QFile::exists(segment.target)) {
+        m_logstream << "Segment " << segment.in << '-' << segment.out << " failed\n";
+        cleanupSegments();
+        if (m_erase) {
+            QFile(m_scenelist).remove();
+        }
+        reportFailure();
+        Q_EMIT renderingFinished();
+        m_looper.quit();
+        return;
+    }
+    segment.progress = 100;
+    for (const Segment &s : m_segments) {
+        if (s.progress < 100) {
+            // Wait for the other workers
+            return;
+        }
+    }
+    if (m_erase) {
+        QFile(m_scenelist).remove();
+    }
+    const bool joined = concatSegments();
+    cleanupSegments();
+    if (!joined) {
+        reportFailure();
+        Q_EMIT renderingFinished();
+        m_looper.quit();
+        return;
+    }
+    m_logstream << "Rendering of " << m_dest << " finished"
+                << "\n";
+    m_logstream.flush();
+    if (!m_debugMode) {
+        m_logfile.remove();
+    }
+    if (embedSubtitles()) {
+        return;
+    }
+    sendFinish(-1, QString());
+    Q_EMIT renderingFinished();
+    m_looper.quit();
+}
+
+bool RenderJob::concatSegments()
+{
+    QFile list(m_concatList);
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        m_errorMessage.append(tr("Cannot write %1").arg(m_concatList));
+        return false;
+    }
+    QString audioFile;
+    QTextStream stream(&list);
+    for (const Segment &segment : m_segments) {
+        if (segment.audio) {
+            audioFile = segment.target;
+            continue;
+        }
+        QString path = segment.target;
+        path.replace(QLatin1Char('\''), QStringLiteral("'\\''"));
+        stream << "file '" << path << "'\n";
+    }
+    stream.flush();
+    list.close();
+    QStringList args = {"-y", "-v", "error", "-f", "concat", "-safe", "0", "-i", m_concatList};
+    if (!audioFile.isEmpty()) {
+        // The metadata is only kept by the audio part, concat input has none
+        args << "-i" << audioFile << "-map" << "0:v" << "-map" << "1:a" << "-map_metadata" << "1";
+    }
+    args << "-c" << "copy" << m_dest;
+    m_logstream << "Joining segments: ffmpeg " << args.join(QLatin1Char(' ')) << "\n";
+    QProcess ffmpeg;
+    ffmpeg.setProcessChannelMode(QProcess::MergedChannels);
+    ffmpeg.start(QStandardPaths::findExecutable(QStringLiteral("ffmpeg")), args);
+    ffmpeg.waitForFinished(-1);
+    if (ffmpeg.exitStatus() == QProcess::CrashExit || ffmpeg.exitCode() != 0 || !QFile::exists(m_dest)) {
+        const QString output = QString::fromLocal8Bit(ffmpeg.readAll());
+        m_logstream << output;
+        m_errorMessage.append(output);
+        return false;
+    }
+    return true;
+}
+
+void RenderJob::cleanupSegments()
+{
+    for (Segment &segment : m_segments) {
+        if (segment.process && segment.process->state() != QProcess::NotRunning) {
+            segment.process->disconnect(this);
+            segment.process->kill();
+            segment.process->waitForFinished();
+        }
+        if (!m_debugMode) {
+            QFile::remove(segment.playlist);
+        }
+        QFile::remove(segment.target);
+    }
+    if (!m_concatList.isEmpty()) {
+        QFile::remove(m_concatList);
+    }
+}
+
 void RenderJob::receivedSubtitleProgress()
 {
     QString outputData = QString::fromLocal8Bit(m_subsProcess.readAllStandardOutput()).simplified();
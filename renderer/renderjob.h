@@ -7,6 +7,7 @@
 #pragma once
 
 #include <QDateTime>
+#include <QDomDocument>
 #include <QEventLoop>
 #include <QFile>
 #include <QLocalSocket>
@@ -25,6 +26,12 @@ public:
               const QString &subtitleFile = QString(), bool debugMode = false, QObject *parent = nullptr);
     ~RenderJob() override;
 
+    /** @brief Encode the video of the frame @param ranges ("in-out") in parallel melt processes instead of a single one.
+     *  The audio is rendered once over the whole range, so that it has no seam, and the parts are then joined by ffmpeg
+     *  without reencoding. @param doc is the parsed scenelist.
+     *  @returns false if the job cannot be segmented, it is then rendered in one piece */
+    bool setSegments(const QDomDocument &doc, const QStringList &ranges);
+
 public Q_SLOTS:
     void start();
 
@@ -38,6 +45,18 @@ private Q_SLOTS:
     void gotMessage();
 
 private:
+    struct Segment
+    {
+        QString playlist;
+        QString target;
+        int in;
+        int out;
+        /** @brief True for the process rendering the audio of the whole range */
+        bool audio{false};
+        int progress{0};
+        QProcess *process{nullptr};
+        QString output;
+    };
     QString m_scenelist;
     QString m_dest;
     int m_progress;
@@ -67,10 +86,24 @@ private:
     /** @brief Used to write to the log file. */
     QTextStream m_logstream;
     QString m_outputData;
+    std::vector<Segment> m_segments;
+    QString m_concatList;
     void fromServer();
     void sendFinish(int status, const QString &error);
     void updateProgress();
     void sendProgress();
+    /** @brief Report a failed render to Kdenlive and the user */
+    void reportFailure();
+    /** @brief Embed the subtitles in the rendered file if requested.
+     *  @returns true if the job was finished by the subtitle process */
+    bool embedSubtitles();
+    void startSegments();
+    void receivedSegmentStderr(size_t ix);
+    void slotSegmentOver(size_t ix, int exitCode, QProcess::ExitStatus status);
+    /** @brief Join the rendered segments and the audio in the final file */
+    bool concatSegments();
+    /** @brief Kill the running workers and delete their files */
+    void cleanupSegments();
 
 Q_SIGNALS:
     void renderingFinished();
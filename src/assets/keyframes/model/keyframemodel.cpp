@@ -16,13 +16,29 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QLineF>
+#include <QMutexLocker>
 #include <QSize>
+#include <algorithm>
 #include <mlt++/Mlt.h>
 #include <utility>
 
 // std::unordered_map and QHash could not be used here
 static QMap<KeyframeType::KeyframeEnum, QString> KeyframeTypeName;
 
+/** @brief Instead of building and parsing the whole animation for each query, each segment between two keyframes
+    gets its own MLT animation, holding only the keyframes its interpolation depends on: the two keyframes around the
+    segment and their neighbours, used by the smooth types. A query then finds its segment by a binary search and
+    MLT only scans a few keyframes. */
+struct KeyframeModel::CompiledAnimation
+{
+    // Keyframe positions in frames, sorted, and their type and value
+    std::vector<int> frames;
+    std::vector<std::pair<KeyframeType::KeyframeEnum, QVariant>> keys;
+    // One animation per segment, built on first use
+    std::vector<std::unique_ptr<Mlt::Properties>> segments;
+    Context context;
+};
+
 KeyframeModel::KeyframeModel(std::weak_ptr<AssetParameterModel> model, const QModelIndex &index, std::weak_ptr<DocUndoStack> undo_stack, int in, int out,
                              QObject *parent)
     : QAbstractListModel(parent)
@@ -40,6 +56,8 @@ KeyframeModel::KeyframeModel(std::weak_ptr<AssetParameterModel> model, const QMo
     refresh(in, out);
 }
 
+KeyframeModel::~KeyframeModel() = default;
+
 // static
 void KeyframeModel::initKeyframeTypes()
 {
@@ -590,6 +608,7 @@ Fun KeyframeModel::updateKeyframe_lambda(GenTime pos, KeyframeType::KeyframeEnum
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        invalidateCompiledAnimation();
         if (notify) Q_EMIT dataChanged(index(row), index(row), {ValueRole, NormalizedValueRole, TypeRole});
         return true;
     };
@@ -610,6 +629,7 @@ Fun KeyframeModel::addKeyframe_lambda(GenTime pos, KeyframeType::KeyframeEnum ty
         if (notify) beginInsertRows(QModelIndex(), insertionRow, insertionRow);
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        invalidateCompiledAnimation();
         if (notify) endInsertRows();
         return true;
     };
@@ -626,6 +646,7 @@ Fun KeyframeModel::deleteKeyframe_lambda(GenTime pos, bool notify)
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         if (notify) beginRemoveRows(QModelIndex(), row, row);
         m_keyframeList.erase(pos);
+        invalidateCompiledAnimation();
         if (notify) endRemoveRows();
         qDebug() << "after" << getAnimProperty();
         return true;
@@ -1111,6 +1132,38 @@ QVariant KeyframeModel::getInterpolatedValue(int p) const
     return getInterpolatedValue(pos);
 }
 
+QVector<QVariant> KeyframeModel::getInterpolatedValues(int from, int to) const
+{
+    QVector<QVariant> values;
+    if (to < from) {
+        return values;
+    }
+    values.reserve(to - from + 1);
+    if (m_keyframeList.size() == 0 || !(m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::ColorWheel ||
+                                        m_paramType == ParamType::AnimatedRect || m_paramType == ParamType::Color)) {
+        for (int frame = from; frame <= to; ++frame) {
+            values << getInterpolatedValue(frame);
+        }
+        return values;
+    }
+    QMutexLocker lock(&m_compiledMutex);
+    CompiledAnimation &anim = compiledAnimation();
+    // Walk the segments along with the frames instead of searching each frame
+    auto next = std::upper_bound(anim.frames.cbegin(), anim.frames.cend(), from);
+    size_t key = size_t(std::distance(anim.frames.cbegin(), next));
+    for (int frame = from; frame <= to; ++frame) {
+        while (key < anim.frames.size() && anim.frames[key] <= frame) {
+            key++;
+        }
+        if (key > 0 && anim.frames[key - 1] == frame) {
+            values << anim.keys[key - 1].second;
+            continue;
+        }
+        values << sampleSegment(anim, qMin(key > 0 ? key - 1 : 0, anim.segments.size() - 1), frame);
+    }
+    return values;
+}
+
 QVariant KeyframeModel::updateInterpolated(const QVariant &interpValue, double val)
 {
     QStringList vals = interpValue.toString().split(QLatin1Char(' '));
@@ -1152,50 +1205,122 @@ QVariant KeyframeModel::getNormalizedValue(double newVal) const
     return QVariant();
 }
 
-QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
+void KeyframeModel::invalidateCompiledAnimation()
 {
-    if (m_keyframeList.count(pos) > 0) {
-        return m_keyframeList.at(pos).second;
+    QMutexLocker lock(&m_compiledMutex);
+    m_compiledAnimation.reset();
+}
+
+bool KeyframeModel::Context::operator==(const Context &other) const
+{
+    return out == other.out && useOpacity == other.useOpacity && qFuzzyCompare(fps, other.fps) && profile == other.profile && lcNumeric == other.lcNumeric;
+}
+
+KeyframeModel::Context KeyframeModel::currentContext() const
+{
+    Context context;
+    context.fps = pCore->getCurrentFps();
+    if (auto ptr = m_model.lock()) {
+        context.out = ptr->data(m_index, AssetParameterModel::ParentDurationRole).toInt();
+        context.useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
+        Mlt::Properties passed;
+        ptr->passProperties(passed);
+        context.profile = passed.get_data("_profile");
+        context.lcNumeric = QByteArray(passed.get_lcnumeric());
     }
-    if (m_keyframeList.size() == 0) {
-        return QVariant();
+    return context;
+}
+
+KeyframeModel::CompiledAnimation &KeyframeModel::compiledAnimation() const
+{
+    const Context context = currentContext();
+    if (m_compiledAnimation && !(m_compiledAnimation->context == context)) {
+        // The item was resized, or the profile or the asset locale changed
+        m_compiledAnimation.reset();
     }
-    Mlt::Properties mlt_prop;
-    QString animData;
-    int out = 0;
-    bool useOpacity = false;
-    if (auto ptr = m_model.lock()) {
-        ptr->passProperties(mlt_prop);
-        out = ptr->data(m_index, AssetParameterModel::ParentDurationRole).toInt();
-        useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
-        animData = ptr->data(m_index, AssetParameterModel::ValueRole).toString();
+    if (!m_compiledAnimation) {
+        auto anim = std::make_unique<CompiledAnimation>();
+        anim->frames.reserve(m_keyframeList.size());
+        anim->keys.reserve(m_keyframeList.size());
+        for (const auto &keyframe : m_keyframeList) {
+            anim->frames.push_back(keyframe.first.frames(context.fps));
+            anim->keys.push_back(keyframe.second);
+        }
+        // A single keyframe still needs one segment to answer the queries
+        anim->segments.resize(anim->frames.size() > 1 ? anim->frames.size() - 1 : anim->frames.size());
+        anim->context = context;
+        m_compiledAnimation = std::move(anim);
     }
+    return *m_compiledAnimation;
+}
 
-    if (!animData.isEmpty() && (m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::ColorWheel)) {
-        mlt_prop.set("key", animData.toUtf8().constData());
+QVariant KeyframeModel::sampleSegment(CompiledAnimation &anim, size_t segment, int frame) const
+{
+    std::unique_ptr<Mlt::Properties> &mlt_prop = anim.segments[segment];
+    if (!mlt_prop) {
+        mlt_prop = std::make_unique<Mlt::Properties>();
+        if (auto ptr = m_model.lock()) {
+            ptr->passProperties(*mlt_prop.get());
+        }
+        const size_t first = segment > 0 ? segment - 1 : 0;
+        const size_t last = qMin(segment + 2, anim.frames.size() - 1);
+        std::unique_ptr<Mlt::Animation> mltAnim;
+        for (size_t i = first; i <= last; ++i) {
+            if (m_paramType == ParamType::AnimatedRect || m_paramType == ParamType::Color) {
+                mlt_prop->anim_set("key", anim.keys[i].second.toString().toUtf8().constData(), anim.frames[i]);
+            } else {
+                mlt_prop->anim_set("key", anim.keys[i].second.toDouble(), anim.frames[i]);
+            }
+            if (!mltAnim) {
+                mltAnim.reset(mlt_prop->get_anim("key"));
+            }
+            mltAnim->key_set_type(int(i - first), convertToMltType(anim.keys[i].first));
+        }
+        // Reload the animation from its string, like the parameter value is read by MLT
+        char *cut = mltAnim->serialize_cut();
+        mltAnim.reset();
+        mlt_prop->set("key", cut);
+        free(cut);
         // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        return QVariant(mlt_prop.anim_get_double("key", pos.frames(pCore->getCurrentFps())));
+        (void)mlt_prop->anim_get_double("key", 0, anim.context.out);
     }
-    if (!animData.isEmpty() && m_paramType == ParamType::AnimatedRect) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        mlt_rect rect = mlt_prop.anim_get_rect("key", pos.frames(pCore->getCurrentFps()));
+    switch (m_paramType) {
+    case ParamType::AnimatedRect: {
+        mlt_rect rect = mlt_prop->anim_get_rect("key", frame);
         QString res = QStringLiteral("%1 %2 %3 %4").arg(int(rect.x)).arg(int(rect.y)).arg(int(rect.w)).arg(int(rect.h));
-        if (useOpacity) {
+        if (anim.context.useOpacity) {
             res.append(QStringLiteral(" %1").arg(QString::number(rect.o, 'f')));
         }
         return QVariant(res);
     }
-    if (!animData.isEmpty() && m_paramType == ParamType::Color) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        mlt_color mltColor = mlt_prop.anim_get_color("key", pos.frames(pCore->getCurrentFps()));
+    case ParamType::Color: {
+        mlt_color mltColor = mlt_prop->anim_get_color("key", frame);
         QColor color(mltColor.r, mltColor.g, mltColor.b, mltColor.a);
         return QVariant(QColorUtils::colorToString(color, true));
     }
+    default:
+        return QVariant(mlt_prop->anim_get_double("key", frame));
+    }
+}
+
+QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
+{
+    if (m_keyframeList.count(pos) > 0) {
+        return m_keyframeList.at(pos).second;
+    }
+    if (m_keyframeList.size() == 0) {
+        return QVariant();
+    }
+    if (m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::ColorWheel || m_paramType == ParamType::AnimatedRect ||
+        m_paramType == ParamType::Color) {
+        QMutexLocker lock(&m_compiledMutex);
+        CompiledAnimation &anim = compiledAnimation();
+        const int frame = pos.frames(pCore->getCurrentFps());
+        // Last keyframe at or before frame, the first segment also covers the frames before the first keyframe
+        auto next = std::upper_bound(anim.frames.cbegin(), anim.frames.cend(), frame);
+        size_t segment = size_t(qMax(0, int(std::distance(anim.frames.cbegin(), next)) - 1));
+        return sampleSegment(anim, qMin(segment, anim.segments.size() - 1), frame);
+    }
     if (m_paramType == ParamType::Roto_spline) {
         // interpolate
         auto next = m_keyframeList.upper_bound(pos);
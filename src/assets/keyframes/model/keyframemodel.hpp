@@ -11,6 +11,7 @@
 #include "utils/gentime.h"
 
 #include <QAbstractListModel>
+#include <QMutex>
 #include <QReadWriteLock>
 #include <QtGlobal>
 
@@ -18,6 +19,7 @@
 
 #include <map>
 #include <memory>
+#include <vector>
 
 class AssetParameterModel;
 class DocUndoStack;
@@ -44,6 +46,7 @@ public:
      */
     explicit KeyframeModel(std::weak_ptr<AssetParameterModel> model, const QModelIndex &index, std::weak_ptr<DocUndoStack> undo_stack, int in = -1,
                            int out = -1, QObject *parent = nullptr);
+    ~KeyframeModel() override;
 
     enum { TypeRole = Qt::UserRole + 1, PosRole, FrameRole, ValueRole, NormalizedValueRole, SelectedRole, ActiveRole, MoveOnlyRole };
     friend class KeyframeModelList;
@@ -146,6 +149,9 @@ public:
     /** @brief Return the interpolated value at given pos */
     QVariant getInterpolatedValue(int pos) const;
     QVariant getInterpolatedValue(const GenTime &pos) const;
+    /** @brief Return the interpolated values of all frames between @param from and @param to, both included.
+        This is much faster than querying the frames one by one. */
+    QVector<QVariant> getInterpolatedValues(int from, int to) const;
     QVariant updateInterpolated(const QVariant &interpValue, double val);
     /** @brief Return the real value from a normalized one */
     QVariant getNormalizedValue(double newVal) const;
@@ -216,6 +222,32 @@ private:
     mutable QReadWriteLock m_lock;
 
     std::map<GenTime, std::pair<KeyframeType::KeyframeEnum, QVariant>> m_keyframeList;
+
+    /** @brief The keyframes compiled for interpolation queries, built on first query and discarded when m_keyframeList or its Context changes */
+    struct CompiledAnimation;
+    /** @brief What the compiled animation depends on besides the keyframes */
+    struct Context
+    {
+        int out{0};
+        bool useOpacity{false};
+        double fps{0.};
+        // The properties passed by the asset model
+        void *profile{nullptr};
+        QByteArray lcNumeric;
+        bool operator==(const Context &other) const;
+    };
+    /** @brief Read the current context of the compiled animation */
+    Context currentContext() const;
+    mutable std::unique_ptr<CompiledAnimation> m_compiledAnimation;
+    mutable QMutex m_compiledMutex;
+    /** @brief Discard the compiled animation, must be called on each change of m_keyframeList */
+    void invalidateCompiledAnimation();
+    /** @brief Returns the compiled animation, building it if needed or if its context changed. Must be called with m_compiledMutex locked */
+    CompiledAnimation &compiledAnimation() const;
+    /** @brief Interpolate the value at @param frame, which must be in @param segment or outside of the keyframes if it is the first or last segment.
+        Must be called with m_compiledMutex locked */
+    QVariant sampleSegment(CompiledAnimation &anim, size_t segment, int frame) const;
+
     bool moveOneKeyframe(GenTime oldPos, GenTime pos, QVariant newVal, Fun &undo, Fun &redo, bool updateView = true, bool allowedToFail = false);
 
 Q_SIGNALS:
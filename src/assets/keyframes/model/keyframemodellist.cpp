@@ -751,6 +751,13 @@ QVariant KeyframeModelList::getInterpolatedValue(const GenTime &pos, const QPers
     return m_parameters.at(index)->getInterpolatedValue(pos);
 }
 
+QVector<QVariant> KeyframeModelList::getInterpolatedValues(int from, int to, const QPersistentModelIndex &index) const
+{
+    READ_LOCK();
+    Q_ASSERT(m_parameters.count(index) > 0);
+    return m_parameters.at(index)->getInterpolatedValues(from, to);
+}
+
 KeyframeModel *KeyframeModelList::getKeyModel()
 {
     if (m_inTimelineIndex.isValid()) {
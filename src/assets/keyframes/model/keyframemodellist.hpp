@@ -126,6 +126,10 @@ public:
        @param pos is the position where we interpolate
        @param index is the index of the queried parameter. */
     QVariant getInterpolatedValue(const GenTime &pos, const QPersistentModelIndex &index) const;
+    /** @brief Return the interpolated values of a parameter on a range of frames.
+       @param from and @param to are the first and last frames of the range
+       @param index is the index of the queried parameter. */
+    QVector<QVariant> getInterpolatedValues(int from, int to, const QPersistentModelIndex &index) const;
 
     /** @brief Load keyframes from the current parameter value. */
     void refresh();
@@ -0,0 +1,66 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audiometerring.hpp"
+
+#include <algorithm>
+
+AudioMeterRing::AudioMeterRing(int capacity, int channels)
+    : m_capacity(size_t(std::max(1, capacity)))
+    , m_channels(std::max(1, channels))
+    , m_positions(m_capacity, 0)
+    , m_levels(m_capacity * size_t(m_channels), 0.)
+{
+}
+
+int AudioMeterRing::capacity() const
+{
+    return int(m_capacity);
+}
+
+int AudioMeterRing::channels() const
+{
+    return m_channels;
+}
+
+bool AudioMeterRing::push(int position, const double *levels)
+{
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= m_capacity) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const size_t slot = head % m_capacity;
+    m_positions[slot] = position;
+    std::copy(levels, levels + m_channels, m_levels.begin() + std::ptrdiff_t(slot * size_t(m_channels)));
+    // Publish the entry
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool AudioMeterRing::pop(int &position, double *levels)
+{
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_head.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const size_t slot = tail % m_capacity;
+    position = m_positions[slot];
+    const auto first = m_levels.cbegin() + std::ptrdiff_t(slot * size_t(m_channels));
+    std::copy(first, first + m_channels, levels);
+    // Give the slot back to the producer
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void AudioMeterRing::clear()
+{
+    m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+int AudioMeterRing::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,52 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/** @class AudioMeterRing
+    @brief Fixed size queue of audio meter levels, passed from one producer thread to one consumer thread.
+    Each entry holds a frame position and the level of each channel. All the storage is allocated on
+    construction, pushing and popping never allocate, lock or wait: when the queue is full, push fails
+    and the entry is dropped.
+    push() must only be called from the producer thread (the MLT consumer thread), pop() and clear()
+    only from the consumer thread (the GUI thread).
+ */
+class AudioMeterRing
+{
+
+public:
+    AudioMeterRing(int capacity, int channels);
+    AudioMeterRing(const AudioMeterRing &) = delete;
+    AudioMeterRing &operator=(const AudioMeterRing &) = delete;
+
+    int capacity() const;
+    int channels() const;
+
+    /** @brief Queue the @param levels of each channel for frame @param position.
+        @returns false if the queue is full, the levels are then dropped */
+    bool push(int position, const double *levels);
+    /** @brief Take the oldest queued entry, copying its levels to @param levels which must hold channels() values.
+        @returns false if the queue is empty */
+    bool pop(int &position, double *levels);
+    /** @brief Drop all the queued entries */
+    void clear();
+    /** @brief Number of entries dropped because the queue was full */
+    int dropped() const;
+
+private:
+    const size_t m_capacity;
+    const int m_channels;
+    std::vector<int> m_positions;
+    std::vector<double> m_levels;
+    // Both indexes only grow, the slot of an index is index % m_capacity.
+    // They are written by one thread each, and kept on separate cache lines.
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+    std::atomic<int> m_dropped{0};
+};
@@ -6,6 +6,7 @@
 #include "mixerwidget.hpp"
 
 #include "audiolevelwidget.hpp"
+#include "audiometerring.hpp"
 #include "capture/mediacapture.h"
 #include "core.h"
 #include "iecscale.h"
@@ -36,17 +37,11 @@ void MixerWidget::property_changed(mlt_service, MixerWidget *widget, mlt_event_d
     if (widget && !strcmp(Mlt::EventData(data).to_string(), "_position")) {
         mlt_properties filter_props = MLT_FILTER_PROPERTIES(widget->m_monitorFilter->get_filter());
         int pos = mlt_properties_get_int(filter_props, "_position");
-        if (!widget->m_levels.contains(pos)) {
-            QVector<double> levels;
-            for (int i = 0; i < widget->m_channels; i++) {
-                // NOTE: this is an approximation. To get the real peak level, we need version 2 of audiolevel MLT filter, see property_changedV2
-                levels << log10(mlt_properties_get_double(filter_props, QStringLiteral("_audio_level.%1").arg(i).toUtf8().constData()) / 1.18) * 20;
-            }
-            widget->m_levels[pos] = std::move(levels);
-            if (widget->m_levels.size() > widget->m_maxLevels) {
-                widget->m_levels.erase(widget->m_levels.begin());
-            }
+        for (int i = 0; i < widget->m_channels; i++) {
+            // NOTE: this is an approximation. To get the real peak level, we need version 2 of audiolevel MLT filter, see property_changedV2
+            widget->m_readLevels[size_t(i)] = log10(mlt_properties_get_double(filter_props, widget->m_levelProperties[size_t(i)].constData()) / 1.18) * 20;
         }
+        widget->m_levelRing->push(pos, widget->m_readLevels.data());
     }
 }
 
@@ -55,16 +50,10 @@ void MixerWidget::property_changedV2(mlt_service, MixerWidget *widget, mlt_event
     if (widget && !strcmp(Mlt::EventData(data).to_string(), "_position")) {
         mlt_properties filter_props = MLT_FILTER_PROPERTIES(widget->m_monitorFilter->get_filter());
         int pos = mlt_properties_get_int(filter_props, "_position");
-        if (!widget->m_levels.contains(pos)) {
-            QVector<double> levels;
-            for (int i = 0; i < widget->m_channels; i++) {
-                levels << mlt_properties_get_double(filter_props, QStringLiteral("_audio_level.%1").arg(i).toUtf8().constData());
-            }
-            widget->m_levels[pos] = std::move(levels);
-            if (widget->m_levels.size() > widget->m_maxLevels) {
-                widget->m_levels.erase(widget->m_levels.begin());
-            }
+        for (int i = 0; i < widget->m_channels; i++) {
+            widget->m_readLevels[size_t(i)] = mlt_properties_get_double(filter_props, widget->m_levelProperties[size_t(i)].constData());
         }
+        widget->m_levelRing->push(pos, widget->m_readLevels.data());
     }
 }
 
@@ -88,6 +77,16 @@ MixerWidget::MixerWidget(int tid, Mlt::Tractor *service, QString trackTag, const
     , m_trackTag(std::move(trackTag))
     , m_sliderHandleSize(sliderHandle)
 {
+    // Everything used to pass the levels is allocated here, so that playback does not allocate
+    m_levelRing = std::make_unique<AudioMeterRing>(m_maxLevels, m_channels);
+    for (int i = 0; i < m_channels; i++) {
+        m_levelProperties.push_back(QStringLiteral("_audio_level.%1").arg(i).toUtf8());
+    }
+    m_readLevels.resize(size_t(m_channels));
+    m_receivedLevels.resize(size_t(m_channels));
+    m_storedPositions.assign(size_t(m_maxLevels), -1);
+    m_storedLevels.resize(size_t(m_maxLevels * m_channels));
+    m_displayLevels.resize(m_channels);
     buildUI(service, trackName);
 }
 
@@ -335,7 +334,7 @@ void MixerWidget::buildUI(Mlt::Tractor *service, const QString &trackName)
             m_volumeSpin->setValue(dbValue);
             m_levelFilter->set("level", dbValue);
             m_levelFilter->set("disable", value == 60 ? 1 : 0);
-            m_levels.clear();
+            clear();
             Q_EMIT m_manager->purgeCache();
             pCore->setDocumentModified();
         }
@@ -347,7 +346,7 @@ void MixerWidget::buildUI(Mlt::Tractor *service, const QString &trackName)
             if (m_balanceFilter != nullptr) {
                 m_balanceFilter->set("start", (value + 50) / 100.);
                 m_balanceFilter->set("disable", value == 0 ? 1 : 0);
-                m_levels.clear();
+                clear();
                 Q_EMIT m_manager->purgeCache();
                 pCore->setDocumentModified();
             }
@@ -454,12 +453,26 @@ void MixerWidget::updateLabel()
     }
 }
 
+void MixerWidget::receiveLevels()
+{
+    int pos;
+    while (m_levelRing->pop(pos, m_receivedLevels.data())) {
+        if (pos < 0) {
+            continue;
+        }
+        const size_t slot = size_t(pos % m_maxLevels);
+        m_storedPositions[slot] = pos;
+        std::copy(m_receivedLevels.cbegin(), m_receivedLevels.cend(), m_storedLevels.begin() + std::ptrdiff_t(slot * size_t(m_channels)));
+    }
+}
+
 void MixerWidget::updateAudioLevel(int pos)
 {
-    QMutexLocker lk(&m_storeMutex);
-    if (m_levels.contains(pos)) {
-        m_audioMeterWidget->setAudioValues(m_levels.value(pos));
-        // m_levels.remove(pos);
+    receiveLevels();
+    if (pos >= 0 && m_storedPositions[size_t(pos % m_maxLevels)] == pos) {
+        const auto first = m_storedLevels.cbegin() + std::ptrdiff_t(size_t(pos % m_maxLevels) * size_t(m_channels));
+        std::copy(first, first + m_channels, m_displayLevels.begin());
+        m_audioMeterWidget->setAudioValues(m_displayLevels);
     } else {
         m_audioMeterWidget->setAudioValues(m_audioData);
     }
@@ -467,15 +480,14 @@ void MixerWidget::updateAudioLevel(int pos)
 
 void MixerWidget::reset()
 {
-    QMutexLocker lk(&m_storeMutex);
-    m_levels.clear();
+    clear();
     m_audioMeterWidget->setAudioValues(m_audioData);
 }
 
 void MixerWidget::clear()
 {
-    QMutexLocker lk(&m_storeMutex);
-    m_levels.clear();
+    m_levelRing->clear();
+    std::fill(m_storedPositions.begin(), m_storedPositions.end(), -1);
 }
 
 bool MixerWidget::isMute() const
@@ -8,10 +8,10 @@
 #include "definitions.h"
 #include "mlt++/MltService.h"
 
-#include <QMutex>
 #include <QWidget>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 class KDualAction;
 class AudioLevelWidget;
@@ -23,6 +23,7 @@ class QLabel;
 class QToolButton;
 class MixerManager;
 class KSqueezedTextLabel;
+class AudioMeterRing;
 
 namespace Mlt {
 class Tractor;
@@ -76,7 +77,6 @@ protected:
     std::shared_ptr<Mlt::Filter> m_levelFilter;
     std::shared_ptr<Mlt::Filter> m_monitorFilter;
     std::shared_ptr<Mlt::Filter> m_balanceFilter;
-    QMap<int, QVector<double>> m_levels;
     int m_channels;
     KDualAction *m_muteAction;
     QSpinBox *m_balanceSpin;
@@ -91,7 +91,17 @@ private:
     QToolButton *m_collapse;
     QToolButton *m_monitor;
     KSqueezedTextLabel *m_trackLabel;
-    QMutex m_storeMutex;
+    /** @brief Levels read on the MLT consumer thread, waiting to be received by the GUI thread */
+    std::unique_ptr<AudioMeterRing> m_levelRing;
+    /** @brief Name of the level property of each channel, built once */
+    std::vector<QByteArray> m_levelProperties;
+    /** @brief Levels being read on the MLT consumer thread */
+    std::vector<double> m_readLevels;
+    /** @brief Levels of the last m_maxLevels received positions, the levels of a position are in slot position % m_maxLevels */
+    std::vector<int> m_storedPositions;
+    std::vector<double> m_storedLevels;
+    std::vector<double> m_receivedLevels;
+    QVector<double> m_displayLevels;
     double m_lastVolume;
     QVector<double> m_audioData;
     Mlt::Event *m_listener;
@@ -100,6 +110,8 @@ private:
     int m_sliderHandleSize;
     /** @Update track label to reflect state */
     void updateLabel();
+    /** @brief Move the levels queued by the MLT consumer thread to the stored levels */
+    void receiveLevels();
 
 Q_SIGNALS:
     void gotLevels(QPair<double, double>);
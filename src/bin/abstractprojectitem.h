@@ -131,7 +131,9 @@ public:
         ClipType,
         ClipHasAudioAndVideo,
         // Item is the folder containing sequences
-        SequenceFolder
+        SequenceFolder,
+        // Comments of the clip markers, used by the bin search
+        DataMarkers
     };
 
     virtual void setClipStatus(FileStatus::ClipStatus status);
@@ -20,6 +20,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "jobs/cliploadtask.h"
 #include "jobs/proxytask.h"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioLevelsBuffer.h"
+#include "lib/audio/audioLevelsPyramid.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "macros.hpp"
 #include "mltcontroller/clippropertiescontroller.h"
@@ -31,7 +33,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "projectitemmodel.h"
 #include "projectsubclip.h"
 #include "timeline2/model/snapmodel.hpp"
+#include "utils/sharedaudiosource.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 #include "utils/timecode.h"
 #include "xml/xml.hpp"
 
@@ -110,8 +114,13 @@ ProjectClip::ProjectClip(const QString &id, const QIcon &thumb, const std::share
     if (hasLimitedDuration()) {
         connect(&m_boundaryTimer, &QTimer::timeout, this, &ProjectClip::refreshBounds);
     }
-    connect(m_markerModel.get(), &MarkerListModel::modelChanged, this,
-            [&]() { setProducerProperty(QStringLiteral("kdenlive:markers"), m_markerModel->toJson()); });
+    connect(m_markerModel.get(), &MarkerListModel::modelChanged, this, [&]() {
+        setProducerProperty(QStringLiteral("kdenlive:markers"), m_markerModel->toJson());
+        if (auto ptr = m_model.lock()) {
+            std::static_pointer_cast<ProjectItemModel>(ptr)->onItemUpdated(std::static_pointer_cast<ProjectClip>(shared_from_this()),
+                                                                           {AbstractProjectItem::DataMarkers});
+        }
+    });
     QString markers = getProducerProperty(QStringLiteral("kdenlive:markers"));
     if (!markers.isEmpty()) {
         QMetaObject::invokeMethod(m_markerModel.get(), "importFromJson", Qt::QueuedConnection, Q_ARG(QString, markers), Q_ARG(bool, true), Q_ARG(bool, false));
@@ -189,8 +198,13 @@ ProjectClip::ProjectClip(const QString &id, const QDomElement &description, cons
     m_date = QFileInfo(m_temporaryUrl).lastModified();
     m_boundaryTimer.setSingleShot(true);
     m_boundaryTimer.setInterval(500);
-    connect(m_markerModel.get(), &MarkerListModel::modelChanged, this,
-            [&]() { setProducerProperty(QStringLiteral("kdenlive:markers"), m_markerModel->toJson()); });
+    connect(m_markerModel.get(), &MarkerListModel::modelChanged, this, [&]() {
+        setProducerProperty(QStringLiteral("kdenlive:markers"), m_markerModel->toJson());
+        if (auto ptr = m_model.lock()) {
+            std::static_pointer_cast<ProjectItemModel>(ptr)->onItemUpdated(std::static_pointer_cast<ProjectClip>(shared_from_this()),
+                                                                           {AbstractProjectItem::DataMarkers});
+        }
+    });
 }
 
 std::shared_ptr<ProjectClip> ProjectClip::construct(const QString &id, const QDomElement &description, const QIcon &thumb,
@@ -215,6 +229,7 @@ ProjectClip::~ProjectClip()
         }
         // Release audio producers
         m_audioProducers.clear();
+        m_sharedAudioSources.clear();
         m_videoProducers.clear();
         m_timewarpProducers.clear();
     }
@@ -282,8 +297,13 @@ void ProjectClip::updateAudioThumbnail(bool cachedThumb)
                     st.next();
                     int channels = channelsList.value(st.key());
                     double channelHeight = double(streamHeight) / channels;
-                    const QVector<uint8_t> audioLevels = audioFrameCache(st.key());
-                    qreal indicesPrPixel = qreal(audioLevels.length()) / img.width();
+                    const std::shared_ptr<const AudioLevelsBuffer> audioLevels = audioFrameCache(st.key());
+                    if (!audioLevels) {
+                        streamCount++;
+                        continue;
+                    }
+                    int levelsCount = audioLevels->size();
+                    qreal indicesPrPixel = qreal(levelsCount) / img.width();
                     int idx;
                     for (int channel = 0; channel < channels; channel++) {
                         double y = (streamHeight * streamCount) + (channel * channelHeight) + channelHeight / 2;
@@ -291,10 +311,10 @@ void ProjectClip::updateAudioThumbnail(bool cachedThumb)
                             idx = int(ceil(i * indicesPrPixel));
                             idx += idx % channels;
                             idx += channel;
-                            if (idx >= audioLevels.length() || idx < 0) {
+                            if (idx >= levelsCount || idx < 0) {
                                 break;
                             }
-                            double level = audioLevels.at(idx) * channelHeight / 510.; // divide height by 510 (2*255) to get height
+                            double level = audioLevels->at(idx) * channelHeight / 510.; // divide height by 510 (2*255) to get height
                             painter.drawLine(i, int(y - level), i, int(y + level));
                         }
                     }
@@ -420,6 +440,7 @@ void ProjectClip::resetSequenceThumbnails()
     pCore->taskManager.discardJobs(ObjectId(KdenliveObjectType::BinClip, m_binId.toInt(), QUuid()), AbstractTask::LOADJOB, true);
     m_thumbXml.clear();
     ThumbnailCache::get()->invalidateThumbsForClip(m_binId);
+    ThumbnailProducerPool::get()->invalidate(m_binId);
     // Force refeshing thumbs producer
     lk.unlock();
     m_uuid = QUuid::createUuid();
@@ -441,6 +462,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
         pCore->taskManager.discardJobs(oid, AbstractTask::THUMBJOB);
         pCore->taskManager.discardJobs(oid, AbstractTask::CACHEJOB);
         m_thumbXml.clear();
+        ThumbnailProducerPool::get()->invalidate(m_binId);
         // Reset uuid to enforce reloading thumbnails from qml cache
         m_uuid = QUuid::createUuid();
         updateTimelineClips({TimelineModel::ClipThumbRole, TimelineModel::ResourceRole});
@@ -492,6 +514,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
                 m_clipStatus = FileStatus::StatusWaiting;
             }
             m_thumbXml.clear();
+            ThumbnailProducerPool::get()->invalidate(m_binId);
             ClipLoadTask::start(oid, xml, false, -1, -1, this);
         }
     }
@@ -597,6 +620,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool gene
         m_thumbMutex.lock();
         m_thumbXml.clear();
         m_thumbMutex.unlock();
+        ThumbnailProducerPool::get()->invalidate(m_binId);
     }
 
     isReloading = false;
@@ -684,6 +708,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool gene
         }
         // Release audio producers
         m_audioProducers.clear();
+        m_sharedAudioSources.clear();
         m_videoProducers.clear();
         m_timewarpProducers.clear();
     }
@@ -1008,6 +1033,8 @@ std::shared_ptr<Mlt::Producer> ProjectClip::getTimelineProducer(int trackId, int
                 if (m_clipType == ClipType::Timeline) {
                     std::shared_ptr<Mlt::Producer> prod(m_masterProducer->cut(0, -1));
                     m_audioProducers[trackId] = prod;
+                } else if (useSharedAudio()) {
+                    m_audioProducers[trackId] = sharedAudioProducer(audioStream);
                 } else {
                     m_audioProducers[trackId] = cloneProducer(true, true);
                 }
@@ -1024,20 +1051,7 @@ std::shared_ptr<Mlt::Producer> ProjectClip::getTimelineProducer(int trackId, int
                         }
                     }
                 }
-                if (audioStream > -1) {
-                    int newAudioStreamIndex = audioStreamIndex(audioStream);
-                    if (newAudioStreamIndex > -1) {
-                        /** If the audioStreamIndex is not found, for example when replacing a clip with another one using different indexes,
-                        default to first audio stream */
-                        m_audioProducers[trackId]->set("audio_index", audioStream);
-                    } else {
-                        newAudioStreamIndex = 0;
-                    }
-                    if (newAudioStreamIndex > audioStreamsCount() - 1) {
-                        newAudioStreamIndex = 0;
-                    }
-                    m_audioProducers[trackId]->set("astream", newAudioStreamIndex);
-                }
+                setProducerAudioStream(*m_audioProducers[trackId].get(), audioStream);
                 m_effectStack->addService(m_audioProducers[trackId]);
             }
             std::shared_ptr<Mlt::Producer> prod(m_audioProducers[trackId]->cut());
@@ -1275,6 +1289,11 @@ std::pair<std::shared_ptr<Mlt::Producer>, bool> ProjectClip::giveMasterAndGetTim
             }
             if (state == PlaylistState::AudioOnly) {
                 int audioStream = master->parent().get_int("audio_index");
+                if (useSharedAudio()) {
+                    // Replace the track producer loaded from the project, which has its own decoder, by a cursor on the shared one
+                    std::shared_ptr<Mlt::Producer> prod(getTimelineProducer(tid, clipId, state, audioStream, speed, secondPlaylist)->cut(in, out));
+                    return {prod, false};
+                }
                 if (audioStream > -1) {
                     tid += 100 * audioStream;
                 }
@@ -1410,6 +1429,51 @@ void ProjectClip::saveZone(QPoint zone, const QDir &dir)
     xmlConsumer.run();
 }
 
+void ProjectClip::setProducerAudioStream(Mlt::Producer &producer, int audioStream)
+{
+    if (audioStream < 0) {
+        return;
+    }
+    int newAudioStreamIndex = audioStreamIndex(audioStream);
+    if (newAudioStreamIndex > -1) {
+        /** If the audioStreamIndex is not found, for example when replacing a clip with another one using different indexes,
+        default to first audio stream */
+        producer.set("audio_index", audioStream);
+    } else {
+        newAudioStreamIndex = 0;
+    }
+    if (newAudioStreamIndex > audioStreamsCount() - 1) {
+        newAudioStreamIndex = 0;
+    }
+    producer.set("astream", newAudioStreamIndex);
+}
+
+bool ProjectClip::useSharedAudio() const
+{
+    if (!KdenliveSettings::sharedaudiodecoder() || (m_clipType != ClipType::AV && m_clipType != ClipType::Audio)) {
+        return false;
+    }
+    return QString(m_masterProducer->get("mlt_service")).startsWith(QLatin1String("avformat"));
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::sharedAudioProducer(int audioStream)
+{
+    // avformat-novalidate clones only open the file on their first frame, the model is never decoded
+    std::shared_ptr<Mlt::Producer> model = cloneProducer(true, true);
+    std::shared_ptr<SharedAudioSource> &source = m_sharedAudioSources[audioStream];
+    if (!source) {
+        std::shared_ptr<Mlt::Producer> decoder = cloneProducer(true, true);
+        decoder->set("set.test_audio", 0);
+        decoder->set("set.test_image", 1);
+        // Don't open the video decoder
+        decoder->set("video_index", -1);
+        setProducerAudioStream(*decoder.get(), audioStream);
+        source = SharedAudioSource::create(decoder);
+    }
+    std::shared_ptr<Mlt::Producer> cursor = source->createCursor(*model.get());
+    return cursor ? cursor : model;
+}
+
 std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducer(bool removeEffects, bool timelineProducer)
 {
     Q_UNUSED(timelineProducer);
@@ -1909,6 +1973,18 @@ void ProjectClip::setProperties(const QMap<QString, QString> &properties, bool r
         // Some of the clip properties have changed through a command, update properties panel
         Q_EMIT refreshPropertiesPanel();
     }
+    // The audio cursors decode nothing, the properties changing the decoded audio go to their shared decoders
+    QMap<QString, QString> decoderProperties = passProperties;
+    for (const QString &key : {QStringLiteral("force_fps"), QStringLiteral("set.test_audio")}) {
+        if (properties.contains(key)) {
+            decoderProperties.insert(key, properties.value(key));
+        }
+    }
+    if (!decoderProperties.isEmpty()) {
+        for (auto &source : m_sharedAudioSources) {
+            source.second->setDecoderProperties(decoderProperties);
+        }
+    }
     if (!passProperties.isEmpty() && (!reload || refreshOnly)) {
         for (auto &p : m_audioProducers) {
             QMapIterator<QString, QString> pr(passProperties);
@@ -2057,6 +2133,16 @@ const QVariant ProjectClip::getData(DataType type) const
             return QVariant("emblem-warning");
         }
         return m_effectStack && m_effectStack->hasEffects() > 0 ? QVariant("kdenlive-track_has_effect") : QVariant();
+    case AbstractProjectItem::DataMarkers: {
+        QStringList comments;
+        if (m_markerModel) {
+            const QList<CommentedTime> markers = m_markerModel->getAllMarkers();
+            for (const CommentedTime &marker : markers) {
+                comments << marker.comment();
+            }
+        }
+        return comments.join(QLatin1Char('\n'));
+    }
     default:
         return AbstractProjectItem::getData(type);
     }
@@ -2098,7 +2184,7 @@ void ProjectClip::discardAudioThumb()
     }
     // Delete thumbnail
     for (int &st : streams) {
-        audioThumbPath = getAudioThumbPath(st);
+        audioThumbPath = getAudioThumbPath(st, true);
         if (!audioThumbPath.isEmpty()) {
             QFile::remove(audioThumbPath);
         }
@@ -2121,7 +2207,7 @@ int ProjectClip::getAudioStreamFfmpegIndex(int mltStream)
     return -1;
 }
 
-const QString ProjectClip::getAudioThumbPath(int stream)
+const QString ProjectClip::getAudioThumbPath(int stream, bool legacyImage)
 {
     if (audioInfo() == nullptr) {
         return QString();
@@ -2139,7 +2225,7 @@ const QString ProjectClip::getAudioThumbPath(int stream)
     QString audioPath = thumbFolder.absoluteFilePath(clipHash);
     audioPath.append(QLatin1Char('_') + QString::number(stream));
     int roundedFps = int(pCore->getCurrentFps());
-    audioPath.append(QStringLiteral("_%1_audio.png").arg(roundedFps));
+    audioPath.append(QStringLiteral("_%1_audio.%2").arg(roundedFps).arg(legacyImage ? QStringLiteral("png") : QStringLiteral("levels")));
     return audioPath;
 }
 
@@ -2418,6 +2504,7 @@ bool ProjectClip::selfSoftDelete(Fun &undo, Fun &redo)
         m_audioLevels.clear();
         m_disabledProducer.reset();
         m_audioProducers.clear();
+        m_sharedAudioSources.clear();
         m_videoProducers.clear();
         removeSequenceWarpResources();
         m_timewarpProducers.clear();
@@ -2530,6 +2617,7 @@ void ProjectClip::reloadTimeline(std::shared_ptr<EffectStackModel> stack)
     }
     // Release audio producers
     m_audioProducers.clear();
+    m_sharedAudioSources.clear();
     m_videoProducers.clear();
     removeSequenceWarpResources();
     m_timewarpProducers.clear();
@@ -2711,37 +2799,54 @@ int ProjectClip::getAudioMax(int stream)
         return m_masterProducer->get_int(key.toUtf8().constData());
     }
     // Process audio max for the stream
-    const QString key2 = QStringLiteral("_kdenlive:audio%1").arg(stream);
-    if (!m_masterProducer->property_exists(key2.toUtf8().constData())) {
+    const std::shared_ptr<const AudioLevelsBuffer> audioData = audioFrameCache(stream);
+    if (!audioData || audioData->isEmpty()) {
         return 0;
     }
-    const QVector<uint8_t> audioData = *static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key2.toUtf8().constData()));
-    if (audioData.isEmpty()) {
-        return 0;
+    uint8_t max = 0;
+    int count = audioData->size();
+    for (int i = 0; i < count; i++) {
+        max = qMax(max, audioData->at(i));
     }
-    uint max = *std::max_element(audioData.constBegin(), audioData.constEnd());
     m_masterProducer->set(key.toUtf8().constData(), int(max));
     return int(max);
 }
 
-const QVector<uint8_t> ProjectClip::audioFrameCache(int stream)
+std::shared_ptr<const AudioLevelsPyramid> ProjectClip::audioLevelsPyramid(int stream)
 {
-    QVector<uint8_t> audioLevels;
     if (stream == -1) {
         if (m_audioInfo) {
             stream = m_audioInfo->ffmpeg_audio_index();
         } else {
-            return audioLevels;
+            return nullptr;
+        }
+    }
+    const QString key = QStringLiteral("_kdenlive:audiopyramid%1").arg(stream);
+    auto *pyramid = static_cast<std::shared_ptr<const AudioLevelsPyramid> *>(m_masterProducer->get_data(key.toUtf8().constData()));
+    if (pyramid) {
+        return *pyramid;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const AudioLevelsBuffer> ProjectClip::audioFrameCache(int stream)
+{
+    if (stream == -1) {
+        if (m_audioInfo) {
+            stream = m_audioInfo->ffmpeg_audio_index();
+        } else {
+            return nullptr;
         }
     }
     const QString key = QStringLiteral("_kdenlive:audio%1").arg(stream);
-    if (m_masterProducer->get_data(key.toUtf8().constData())) {
-        const QVector<uint8_t> audioData = *static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key.toUtf8().constData()));
-        return audioData;
+    // While the levels are generated, this buffer grows: readers only see the values published so far
+    auto *audioData = static_cast<std::shared_ptr<const AudioLevelsBuffer> *>(m_masterProducer->get_data(key.toUtf8().constData()));
+    if (audioData) {
+        return *audioData;
     } else {
         qDebug() << "=== AUDIO NOT FOUND ";
     }
-    return QVector<uint8_t>();
+    return nullptr;
 
     // TODO
     /*QString key = QStringLiteral("%1:%2").arg(m_binId).arg(stream);
@@ -20,10 +20,13 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QUuid>
 #include <memory>
 
+class AudioLevelsBuffer;
+class AudioLevelsPyramid;
 class ClipPropertiesController;
 class ProjectFolder;
 class ProjectSubClip;
 class QDomElement;
+class SharedAudioSource;
 
 namespace Mlt {
 class Producer;
@@ -199,8 +202,10 @@ public:
     QStringList subClipIds() const;
     /** @brief Delete cached audio thumb - needs to be recreated */
     void discardAudioThumb();
-    /** @brief Get path for this clip's audio thumbnail */
-    const QString getAudioThumbPath(int stream);
+    /** @brief Get path for this clip's audio thumbnail cache
+     *  @param legacyImage if true, return the path of the png cache used by older versions
+     */
+    const QString getAudioThumbPath(int stream, bool legacyImage = false);
     /** @brief Returns true if this producer has audio and can be splitted on timeline*/
     bool isSplittable() const;
 
@@ -241,7 +246,10 @@ public:
 
     /** @brief Return audio cache for a stream
      */
-    const QVector <uint8_t> audioFrameCache(int stream = -1);
+    std::shared_ptr<const AudioLevelsBuffer> audioFrameCache(int stream = -1);
+    /** @brief Return the multi-resolution audio levels for a stream, nullptr if not yet generated
+     */
+    std::shared_ptr<const AudioLevelsPyramid> audioLevelsPyramid(int stream = -1);
     /** @brief Return FFmpeg's audio stream index for an MLT audio stream index
      */
     int getAudioStreamFfmpegIndex(int mltStream);
@@ -315,8 +323,17 @@ protected:
     std::unordered_map<int, std::shared_ptr<Mlt::Producer>> m_audioProducers;
     std::unordered_map<int, std::shared_ptr<Mlt::Producer>> m_videoProducers;
     std::unordered_map<int, std::shared_ptr<Mlt::Producer>> m_timewarpProducers;
+    /** @brief The decoders shared by the audio track producers, by audio stream */
+    std::unordered_map<int, std::shared_ptr<SharedAudioSource>> m_sharedAudioSources;
     std::shared_ptr<Mlt::Producer> m_disabledProducer;
 
+    /** @brief Returns true if the audio track producers of this clip can be cursors on a shared decoder */
+    bool useSharedAudio() const;
+    /** @brief Create an audio track producer for @param audioStream, reading from the decoder shared by the tracks */
+    std::shared_ptr<Mlt::Producer> sharedAudioProducer(int audioStream);
+    /** @brief Select @param audioStream in the audio producer @param producer */
+    void setProducerAudioStream(Mlt::Producer &producer, int audioStream);
+
     /** @brief This is a helper function that creates the disabled producer. This is a clone of the original one, with audio and video disabled */
     virtual void createDisabledMasterProducer();
     virtual const QString getSequenceResource();
@@ -28,6 +28,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "projectsubclip.h"
 #include "sequenceclip.h"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 #include "xml/xml.hpp"
 
 #include <KLocalizedString>
@@ -145,6 +146,7 @@ QList<int> ProjectItemModel::mapDataToColumn(AbstractProjectItem::DataType type)
     case AbstractProjectItem::DataThumbnail:
     case AbstractProjectItem::IconOverlay:
     case AbstractProjectItem::JobProgress:
+    case AbstractProjectItem::DataMarkers:
         return {0};
         break;
     case AbstractProjectItem::DataDate:
@@ -502,14 +504,24 @@ std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &bin
     return nullptr;
 }
 
-const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
+std::shared_ptr<const AudioLevelsBuffer> ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
 {
     READ_LOCK();
     auto search = m_allClipItems.find(binId.toInt());
     if (search != m_allClipItems.end()) {
         return search->second->audioFrameCache(stream);
     }
-    return QVector<uint8_t>();
+    return nullptr;
+}
+
+std::shared_ptr<const AudioLevelsPyramid> ProjectItemModel::getAudioPyramidByBinID(const QString &binId, int stream)
+{
+    READ_LOCK();
+    auto search = m_allClipItems.find(binId.toInt());
+    if (search != m_allClipItems.end()) {
+        return search->second->audioLevelsPyramid(stream);
+    }
+    return nullptr;
 }
 
 double ProjectItemModel::getAudioMaxLevel(const QString &binId, int stream)
@@ -629,6 +641,7 @@ void ProjectItemModel::clean(bool quit)
         buildPlaylist(m_uuid);
     }
     ThumbnailCache::get()->clearCache();
+    ThumbnailProducerPool::get()->clear();
 }
 
 std::shared_ptr<ProjectFolder> ProjectItemModel::getRootFolder() const
@@ -21,6 +21,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QTimer>
 #include <QUuid>
 
+class AudioLevelsBuffer;
+class AudioLevelsPyramid;
 class BinPlaylist;
 class FileWatcher;
 class MarkerListModel;
@@ -63,7 +65,9 @@ public:
     /** @brief Returns a clip from the hierarchy, given its id */
     std::shared_ptr<ProjectClip> getClipByBinID(const QString &binId) const;
     /** @brief Returns audio levels for a clip from its id */
-    const QVector <uint8_t>getAudioLevelsByBinID(const QString &binId, int stream);
+    std::shared_ptr<const AudioLevelsBuffer> getAudioLevelsByBinID(const QString &binId, int stream);
+    /** @brief Returns the multi-resolution audio levels for a clip from its id, nullptr if not available */
+    std::shared_ptr<const AudioLevelsPyramid> getAudioPyramidByBinID(const QString &binId, int stream);
     double getAudioMaxLevel(const QString &binId, int stream);
 
     /** @brief Returns a list of clips using the given url */
@@ -9,6 +9,15 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "abstractprojectitem.h"
 
 #include <QItemSelectionModel>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+// Below this number of scanned items, searching is faster than starting a worker
+constexpr int maxSynchronousScan = 2000;
+// Columns searched by the search string: name, date, description and tag
+constexpr int searchColumns[] = {0, 1, 2, 4};
+} // namespace
 
 ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
     : QSortFilterProxyModel(parent)
@@ -19,6 +28,42 @@ ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
     m_selection = new QItemSelectionModel(this);
     connect(m_selection, &QItemSelectionModel::selectionChanged, this, &ProjectSortProxyModel::onCurrentRowChanged);
     setDynamicSortFilter(true);
+    connect(&m_searchWatcher, &QFutureWatcher<QVector<int>>::finished, this, &ProjectSortProxyModel::onSearchFinished);
+}
+
+void ProjectSortProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    if (sourceModel()) {
+        disconnect(sourceModel(), &QAbstractItemModel::rowsInserted, this, &ProjectSortProxyModel::onSourceRowsInserted);
+        disconnect(sourceModel(), &QAbstractItemModel::rowsAboutToBeRemoved, this, &ProjectSortProxyModel::onSourceRowsAboutToBeRemoved);
+        disconnect(sourceModel(), &QAbstractItemModel::rowsMoved, this, &ProjectSortProxyModel::onSourceRowsMoved);
+        disconnect(sourceModel(), &QAbstractItemModel::dataChanged, this, &ProjectSortProxyModel::onSourceDataChanged);
+        disconnect(sourceModel(), &QAbstractItemModel::modelReset, this, &ProjectSortProxyModel::onSourceReset);
+        disconnect(sourceModel(), &QAbstractItemModel::layoutChanged, this, &ProjectSortProxyModel::onSourceReset);
+    }
+    m_searchWatcher.cancel();
+    m_searchWatcher.waitForFinished();
+    m_pendingCandidates.clear();
+    m_pendingSearch.clear();
+    m_changedDuringSearch.clear();
+    m_searchIndex.clear();
+    m_searchIndexBuilt = false;
+    m_foldedSearch.clear();
+    m_searchMatches.clear();
+    m_matchAncestors.clear();
+    if (model) {
+        // Connected before the proxy's own handlers, so that the index is up to date when rows are filtered
+        connect(model, &QAbstractItemModel::rowsInserted, this, &ProjectSortProxyModel::onSourceRowsInserted);
+        connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &ProjectSortProxyModel::onSourceRowsAboutToBeRemoved);
+        connect(model, &QAbstractItemModel::rowsMoved, this, &ProjectSortProxyModel::onSourceRowsMoved);
+        connect(model, &QAbstractItemModel::dataChanged, this, &ProjectSortProxyModel::onSourceDataChanged);
+        connect(model, &QAbstractItemModel::modelReset, this, &ProjectSortProxyModel::onSourceReset);
+        connect(model, &QAbstractItemModel::layoutChanged, this, &ProjectSortProxyModel::onSourceReset);
+    }
+    QSortFilterProxyModel::setSourceModel(model);
+    if (model && !m_searchString.isEmpty()) {
+        slotSetSearchString(m_searchString);
+    }
 }
 
 // Responsible for item sorting!
@@ -85,16 +130,12 @@ bool ProjectSortProxyModel::filterAcceptsRowItself(int sourceRow, const QModelIn
     if (result && m_searchString.isEmpty()) {
         return true;
     }
-    for (int i = 0; i < 3; i++) {
-        QModelIndex index0 = sourceModel()->index(sourceRow, i, sourceParent);
-        if (!index0.isValid()) {
-            return false;
-        }
-        auto data = sourceModel()->data(index0);
-        if (data.toString().contains(m_searchString, Qt::CaseInsensitive)) {
-            result = true;
-            break;
-        }
+    QModelIndex index0 = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (!index0.isValid()) {
+        return false;
+    }
+    if (m_foldedSearch.isEmpty() || m_searchMatches.contains(index0.internalId())) {
+        result = true;
     }
     return result;
 }
@@ -106,6 +147,11 @@ bool ProjectSortProxyModel::hasAcceptedChildren(int sourceRow, const QModelIndex
         return false;
     }
 
+    if (!m_foldedSearch.isEmpty() && m_searchTag.isEmpty() && m_searchRating.isEmpty() && m_searchType.isEmpty() &&
+        !m_matchAncestors.contains(item.internalId())) {
+        // Without other filters, only the items having a search match below them can have accepted children
+        return false;
+    }
     // check if there are children
     int childCount = item.model()->rowCount(item);
     if (childCount == 0) {
@@ -164,9 +210,270 @@ QItemSelectionModel *ProjectSortProxyModel::selectionModel()
 void ProjectSortProxyModel::slotSetSearchString(const QString &str)
 {
     m_searchString = str;
+    const QString folded = str.toCaseFolded();
+    if (m_searchWatcher.isRunning()) {
+        // The result of the running search will be ignored
+        m_searchWatcher.cancel();
+    }
+    m_pendingCandidates.clear();
+    m_pendingSearch.clear();
+    m_changedDuringSearch.clear();
+    if (folded.isEmpty()) {
+        m_lastScanCount = 0;
+        applySearch(folded, {});
+        return;
+    }
+    buildSearchIndex();
+    QVector<quintptr> candidates;
+    if (!m_foldedSearch.isEmpty() && folded.startsWith(m_foldedSearch)) {
+        // Characters were appended, only the previous matches can still match
+        candidates.reserve(m_searchMatches.size());
+        for (quintptr id : std::as_const(m_searchMatches)) {
+            candidates << id;
+        }
+    } else {
+        candidates.reserve(m_searchIndex.size());
+        for (auto it = m_searchIndex.cbegin(); it != m_searchIndex.cend(); ++it) {
+            candidates << it.key();
+        }
+    }
+    m_lastScanCount = candidates.size();
+    if (candidates.size() < maxSynchronousScan) {
+        QSet<quintptr> matches;
+        for (quintptr id : std::as_const(candidates)) {
+            if (m_searchIndex.value(id).text.contains(folded)) {
+                matches.insert(id);
+            }
+        }
+        applySearch(folded, matches);
+        return;
+    }
+    // Scan on a worker thread, on a copy of the texts since the index can change meanwhile
+    QStringList texts;
+    texts.reserve(candidates.size());
+    for (quintptr id : std::as_const(candidates)) {
+        texts << m_searchIndex.value(id).text;
+    }
+    m_pendingCandidates = candidates;
+    m_pendingSearch = folded;
+    m_searchWatcher.setFuture(QtConcurrent::run([texts, folded]() {
+        QVector<int> matches;
+        for (int i = 0; i < texts.size(); ++i) {
+            if (texts.at(i).contains(folded)) {
+                matches << i;
+            }
+        }
+        return matches;
+    }));
+}
+
+void ProjectSortProxyModel::onSearchFinished()
+{
+    if (m_searchWatcher.isCanceled() || m_pendingSearch.isEmpty()) {
+        return;
+    }
+    const QVector<int> result = m_searchWatcher.result();
+    QSet<quintptr> matches;
+    for (int i : result) {
+        const quintptr id = m_pendingCandidates.at(i);
+        // Items changed or removed during the search are handled below
+        if (m_searchIndex.contains(id)) {
+            matches.insert(id);
+        }
+    }
+    const QString folded = m_pendingSearch;
+    // Items indexed during the search were scanned with their old text, or not at all
+    for (quintptr id : std::as_const(m_changedDuringSearch)) {
+        auto it = m_searchIndex.constFind(id);
+        if (it != m_searchIndex.cend() && it.value().text.contains(folded)) {
+            matches.insert(id);
+        } else {
+            matches.remove(id);
+        }
+    }
+    m_pendingCandidates.clear();
+    m_pendingSearch.clear();
+    m_changedDuringSearch.clear();
+    applySearch(folded, matches);
+}
+
+int ProjectSortProxyModel::lastScanCount() const
+{
+    return m_lastScanCount;
+}
+
+bool ProjectSortProxyModel::isSearching() const
+{
+    return !m_pendingSearch.isEmpty();
+}
+
+void ProjectSortProxyModel::applySearch(const QString &folded, const QSet<quintptr> &matches)
+{
+    m_foldedSearch = folded;
+    m_searchMatches = matches;
+    updateMatchAncestors();
     invalidateFilter();
 }
 
+void ProjectSortProxyModel::updateMatchAncestors()
+{
+    m_matchAncestors.clear();
+    for (quintptr id : std::as_const(m_searchMatches)) {
+        auto it = m_searchIndex.constFind(id);
+        while (it != m_searchIndex.cend() && it.value().hasParent) {
+            const quintptr parent = it.value().parent;
+            if (m_matchAncestors.contains(parent)) {
+                break;
+            }
+            m_matchAncestors.insert(parent);
+            it = m_searchIndex.constFind(parent);
+        }
+    }
+}
+
+void ProjectSortProxyModel::buildSearchIndex()
+{
+    if (m_searchIndexBuilt || sourceModel() == nullptr) {
+        return;
+    }
+    m_searchIndexBuilt = true;
+    const QModelIndex root;
+    for (int i = 0; i < sourceModel()->rowCount(root); ++i) {
+        indexItem(sourceModel()->index(i, 0, root), true);
+    }
+}
+
+void ProjectSortProxyModel::indexItem(const QModelIndex &ix, bool recursive)
+{
+    SearchEntry entry;
+    QStringList texts;
+    for (int column : searchColumns) {
+        texts << sourceModel()->data(ix.siblingAtColumn(column)).toString();
+    }
+    texts << sourceModel()->data(ix, AbstractProjectItem::DataMarkers).toString();
+    entry.text = texts.join(QLatin1Char('\n')).toCaseFolded();
+    const QModelIndex parent = ix.parent();
+    if (parent.isValid()) {
+        entry.parent = parent.internalId();
+        entry.hasParent = true;
+    }
+    m_searchIndex.insert(ix.internalId(), entry);
+    if (!m_pendingSearch.isEmpty()) {
+        m_changedDuringSearch.insert(ix.internalId());
+    }
+    if (recursive) {
+        for (int i = 0; i < sourceModel()->rowCount(ix); ++i) {
+            indexItem(sourceModel()->index(i, 0, ix), true);
+        }
+    }
+}
+
+void ProjectSortProxyModel::unindexItem(const QModelIndex &ix)
+{
+    for (int i = 0; i < sourceModel()->rowCount(ix); ++i) {
+        unindexItem(sourceModel()->index(i, 0, ix));
+    }
+    m_searchIndex.remove(ix.internalId());
+    m_searchMatches.remove(ix.internalId());
+    m_matchAncestors.remove(ix.internalId());
+}
+
+void ProjectSortProxyModel::onSourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if (!m_searchIndexBuilt) {
+        return;
+    }
+    bool matched = false;
+    for (int i = first; i <= last; ++i) {
+        const QModelIndex ix = sourceModel()->index(i, 0, parent);
+        indexItem(ix, true);
+        if (!m_foldedSearch.isEmpty() && m_searchIndex.value(ix.internalId()).text.contains(m_foldedSearch)) {
+            m_searchMatches.insert(ix.internalId());
+            matched = true;
+        }
+    }
+    if (matched) {
+        updateMatchAncestors();
+    }
+}
+
+void ProjectSortProxyModel::onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if (!m_searchIndexBuilt) {
+        return;
+    }
+    for (int i = first; i <= last; ++i) {
+        unindexItem(sourceModel()->index(i, 0, parent));
+    }
+}
+
+void ProjectSortProxyModel::onSourceRowsMoved(const QModelIndex &parent, int start, int end, const QModelIndex &destination, int row)
+{
+    Q_UNUSED(parent)
+    if (!m_searchIndexBuilt) {
+        return;
+    }
+    for (int i = 0; i <= end - start; ++i) {
+        const QModelIndex ix = sourceModel()->index(row + i, 0, destination);
+        auto it = m_searchIndex.find(ix.internalId());
+        if (it != m_searchIndex.end()) {
+            it->hasParent = destination.isValid();
+            it->parent = destination.isValid() ? destination.internalId() : 0;
+        }
+    }
+    updateMatchAncestors();
+}
+
+void ProjectSortProxyModel::onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    if (!m_searchIndexBuilt) {
+        return;
+    }
+    static const QVector<int> searchRoles = {Qt::DisplayRole,
+                                             AbstractProjectItem::DataDate,
+                                             AbstractProjectItem::DataDescription,
+                                             AbstractProjectItem::DataTag,
+                                             AbstractProjectItem::DataMarkers};
+    if (!roles.isEmpty() && std::none_of(roles.cbegin(), roles.cend(), [](int role) { return searchRoles.contains(role); })) {
+        return;
+    }
+    bool changed = false;
+    for (int i = topLeft.row(); i <= bottomRight.row(); ++i) {
+        const QModelIndex ix = sourceModel()->index(i, 0, topLeft.parent());
+        indexItem(ix, false);
+        if (m_foldedSearch.isEmpty()) {
+            continue;
+        }
+        const bool match = m_searchIndex.value(ix.internalId()).text.contains(m_foldedSearch);
+        if (match != m_searchMatches.contains(ix.internalId())) {
+            if (match) {
+                m_searchMatches.insert(ix.internalId());
+            } else {
+                m_searchMatches.remove(ix.internalId());
+            }
+            changed = true;
+        }
+    }
+    if (changed) {
+        updateMatchAncestors();
+    }
+}
+
+void ProjectSortProxyModel::onSourceReset()
+{
+    m_searchIndex.clear();
+    m_searchIndexBuilt = false;
+    if (!m_foldedSearch.isEmpty() && sourceModel()) {
+        // Search again from scratch on the new content
+        m_foldedSearch.clear();
+        m_searchMatches.clear();
+        slotSetSearchString(m_searchString);
+    } else {
+        m_searchMatches.clear();
+        m_matchAncestors.clear();
+    }
+}
+
 void ProjectSortProxyModel::slotSetFilters(const QStringList &tagFilters, const QList<int> rateFilters, const QList<int> typeFilters, UsageFilter unusedFilter)
 {
     m_searchType = typeFilters;
@@ -8,13 +8,23 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #pragma once
 
 #include <QCollator>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QPersistentModelIndex>
+#include <QSet>
 #include <QSortFilterProxyModel>
+#include <QVector>
 
 class QItemSelectionModel;
 
 /**
  * @class ProjectSortProxyModel
  * @brief Acts as an filtering proxy for the Bin Views, used when triggering the lineedit filter.
+ * The text searched for each item (name, date, description, tags and marker comments) is kept in a search
+ * index, built on the first search and then updated from the source model changes. When characters are
+ * appended to the search string, only the items matching the previous string are scanned again. Scans of
+ * many items run on a worker thread, the previous result stays displayed until the new one is ready.
+ * Items are identified by the internal id of their source index, which is stable in the bin model.
  */
 class ProjectSortProxyModel : public QSortFilterProxyModel
 {
@@ -25,6 +35,11 @@ public:
 
     explicit ProjectSortProxyModel(QObject *parent = nullptr);
     QItemSelectionModel *selectionModel();
+    void setSourceModel(QAbstractItemModel *model) override;
+    /** @brief Number of items scanned by the last search string change */
+    int lastScanCount() const;
+    /** @brief Returns true if a search is running on a worker thread */
+    bool isSearching() const;
 
 public Q_SLOTS:
     /** @brief Set search string that will filter the view */
@@ -41,6 +56,14 @@ public Q_SLOTS:
 private Q_SLOTS:
     /** @brief Called when a row change is detected by selection model */
     void onCurrentRowChanged(const QItemSelection &current, const QItemSelection &previous);
+    /** @brief Keep the search index in sync with the source model */
+    void onSourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void onSourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void onSourceRowsMoved(const QModelIndex &parent, int start, int end, const QModelIndex &destination, int row);
+    void onSourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+    void onSourceReset();
+    /** @brief Apply the result of a search run on a worker thread */
+    void onSearchFinished();
 
 protected:
     /** @brief Decide which items should be displayed depending on the search string  */
@@ -52,8 +75,39 @@ protected:
     bool hasAcceptedChildren(int source_row, const QModelIndex &source_parent) const;
 
 private:
+    struct SearchEntry
+    {
+        // Case folded searchable text
+        QString text;
+        // Internal id of the parent item, only valid if hasParent is true
+        quintptr parent{0};
+        bool hasParent{false};
+    };
+    /** @brief Build the search index of all items, if not done yet */
+    void buildSearchIndex();
+    /** @brief (Re)index the item at @param ix and its children */
+    void indexItem(const QModelIndex &ix, bool recursive);
+    /** @brief Remove the item at @param ix and its children from the index and search results */
+    void unindexItem(const QModelIndex &ix);
+    /** @brief Use @param matches as the result for search string @param folded and refilter */
+    void applySearch(const QString &folded, const QSet<quintptr> &matches);
+    /** @brief Rebuild the list of items that have a matching descendant */
+    void updateMatchAncestors();
     QItemSelectionModel *m_selection;
     QString m_searchString;
+    bool m_searchIndexBuilt{false};
+    QHash<quintptr, SearchEntry> m_searchIndex;
+    // Case folded search string of m_searchMatches
+    QString m_foldedSearch;
+    QSet<quintptr> m_searchMatches;
+    QSet<quintptr> m_matchAncestors;
+    QFutureWatcher<QVector<int>> m_searchWatcher;
+    // Items and search string of the running worker search
+    QVector<quintptr> m_pendingCandidates;
+    QString m_pendingSearch;
+    // Items indexed while the worker search was running
+    QSet<quintptr> m_changedDuringSearch;
+    int m_lastScanCount{0};
     QStringList m_searchTag;
     QList<int> m_searchType;
     QList<int> m_searchRating;
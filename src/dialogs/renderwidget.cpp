@@ -19,6 +19,7 @@
 #include "profiles/profilerepository.hpp"
 #include "project/projectmanager.h"
 #include "render/renderrequest.h"
+#include "render/renderscheduler.h"
 #include "utils/qstringutils.h"
 #include "utils/timecode.h"
 #include "xml/xml.hpp"
@@ -40,6 +41,7 @@
 #ifndef NODBUS
 #include <QDBusConnectionInterface>
 #endif
+#include <QActionGroup>
 #include <QDir>
 #include <QDomDocument>
 #include <QFileIconProvider>
@@ -79,7 +81,8 @@ enum {
     LastTimeRole,
     LastFrameRole,
     OpenBrowserRole,
-    PlayAfterRole
+    PlayAfterRole,
+    PriorityRole
 };
 
 // Running job status
@@ -297,6 +300,8 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
         }
         refreshParams();
     });
+    m_view.segmented_render->setChecked(KdenliveSettings::segmentedrender());
+    connect(m_view.segmented_render, &QCheckBox::toggled, this, &KdenliveSettings::setSegmentedrender);
 #if QT_VERSION >= QT_VERSION_CHECK(6, 7, 0)
     connect(m_view.export_meta, &QCheckBox::checkStateChanged, this, &RenderWidget::refreshParams);
     connect(m_view.checkTwoPass, &QCheckBox::checkStateChanged, this, &RenderWidget::refreshParams);
@@ -316,6 +321,12 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
     // ===== "Job Queue" tab =====
     parseScriptFiles();
     m_view.running_jobs->setUniformRowHeights(false);
+    m_view.max_jobs->setValue(KdenliveSettings::maxrenderjobs());
+    connect(m_view.max_jobs, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, [this](int value) {
+        KdenliveSettings::setMaxrenderjobs(value);
+        checkRenderStatus();
+    });
+    m_view.queue_info->clear();
     m_view.running_jobs->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(m_view.running_jobs, &QTreeWidget::customContextMenuRequested, this, &RenderWidget::prepareJobContextMenu);
     m_view.scripts_list->setUniformRowHeights(false);
@@ -718,6 +729,7 @@ void RenderWidget::slotPrepareExport2(bool delayedRendering)
     request->setProxyRendering(m_view.proxy_render->isChecked());
     request->setEmbedSubtitles(m_view.embed_subtitles->isEnabled() && m_view.embed_subtitles->isChecked());
     request->setTwoPass(m_view.checkTwoPass->isChecked());
+    request->setSegmentedRendering(m_view.segmented_render->isChecked());
     request->setAudioFilePerTrack(m_view.stemAudioExport->isChecked() && m_view.stemAudioExport->isEnabled());
 
     bool guideMultiExport = m_view.guide_multi_box->isChecked();
@@ -822,47 +834,70 @@ void RenderWidget::checkRenderStatus()
         return;
     }
 
-    // Make sure no other rendering is running
-    if (runningJobsCount() > 0) {
-        return;
-    }
-
+    std::vector<RenderJobItem *> waitingItems;
+    std::vector<RenderScheduler::Job> waiting;
+    std::vector<RenderScheduler::Job> running;
     auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
-
-    bool waitingJob = false;
-
-    // Find first waiting job
     while (item != nullptr) {
         if (item->status() == WAITINGJOB) {
-            QDateTime t = QDateTime::currentDateTime();
-            item->setData(1, StartTimeRole, t);
-            item->setData(1, LastTimeRole, t);
-            waitingJob = true;
-            startRendering(item);
-            // Check for 2 pass encoding
-            QStringList jobData = item->data(1, ParametersRole).toStringList();
-            if (jobData.size() > 2 && jobData.at(1).endsWith(QStringLiteral("-pass2.mlt"))) {
-                // Find and remove 1st pass job
-                QTreeWidgetItem *above = m_view.running_jobs->itemAbove(item);
-                QString firstPassName = jobData.at(1).section(QLatin1Char('-'), 0, -2) + QStringLiteral(".mlt");
-                while (above) {
-                    QStringList aboveData = above->data(1, ParametersRole).toStringList();
-                    qDebug() << "// GOT  JOB: " << aboveData.at(1);
-                    if (aboveData.size() > 2 && aboveData.at(1) == firstPassName) {
-                        delete above;
-                        break;
-                    }
-                    above = m_view.running_jobs->itemAbove(above);
+            waitingItems.push_back(item);
+            waiting.push_back(schedulerJob(item));
+        } else if (item->status() == RUNNINGJOB || item->status() == STARTINGJOB) {
+            running.push_back(schedulerJob(item));
+        }
+        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+    }
+    if (waiting.empty()) {
+        if (running.empty() && m_view.shutdown->isChecked()) {
+            Q_EMIT shutdown();
+        }
+        return;
+    }
+
+    // Start as many waiting jobs as the thread and memory budget allows
+    const std::vector<size_t> toStart = RenderScheduler::fromSettings().jobsToStart(waiting, running);
+    for (size_t ix : toStart) {
+        item = waitingItems.at(ix);
+        QDateTime t = QDateTime::currentDateTime();
+        item->setData(1, StartTimeRole, t);
+        item->setData(1, LastTimeRole, t);
+        startRendering(item);
+        // Check for 2 pass encoding
+        QStringList jobData = item->data(1, ParametersRole).toStringList();
+        if (jobData.size() > 2 && jobData.at(1).endsWith(QStringLiteral("-pass2.mlt"))) {
+            // Find and remove 1st pass job
+            QTreeWidgetItem *above = m_view.running_jobs->itemAbove(item);
+            QString firstPassName = jobData.at(1).section(QLatin1Char('-'), 0, -2) + QStringLiteral(".mlt");
+            while (above) {
+                QStringList aboveData = above->data(1, ParametersRole).toStringList();
+                qDebug() << "// GOT  JOB: " << aboveData.at(1);
+                if (aboveData.size() > 2 && aboveData.at(1) == firstPassName) {
+                    delete above;
+                    break;
                 }
+                above = m_view.running_jobs->itemAbove(above);
             }
+        }
+        if (item->status() == WAITINGJOB) {
             item->setStatus(STARTINGJOB);
-            break;
         }
-        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
     }
-    if (!waitingJob && m_view.shutdown->isChecked()) {
-        Q_EMIT shutdown();
+}
+
+RenderScheduler::Job RenderWidget::schedulerJob(RenderJobItem *item) const
+{
+    RenderScheduler::Job job;
+    job.output = item->text(1);
+    job.priority = item->data(1, PriorityRole).toInt();
+    // Arguments are: delivery, melt path, playlist and options
+    const QStringList args = item->data(1, ParametersRole).toStringList();
+    int segments = 0;
+    const int segmentsIndex = args.indexOf(QStringLiteral("--segments"));
+    if (segmentsIndex > 0 && segmentsIndex + 1 < args.size()) {
+        segments = int(args.at(segmentsIndex + 1).count(QLatin1Char(','))) + 1;
     }
+    job.cost = RenderScheduler::estimateCost(args.size() > 2 ? args.at(2) : QString(), segments);
+    return job;
 }
 
 void RenderWidget::startRendering(RenderJobItem *item)
@@ -1320,6 +1355,15 @@ void RenderWidget::setRenderProgress(const QString &dest, int progress, int fram
     }
 }
 
+void RenderWidget::setRenderThroughput(int jobs, int fps)
+{
+    if (jobs == 0) {
+        m_view.queue_info->clear();
+        return;
+    }
+    m_view.queue_info->setText(i18np("%1 job rendering at %2 fps", "%1 jobs rendering at %2 fps", jobs, fps));
+}
+
 void RenderWidget::setRenderStatus(const QString &dest, int status, const QString &error)
 {
     RenderJobItem *item = nullptr;
@@ -1922,6 +1966,26 @@ void RenderWidget::prepareJobContextMenu(const QPoint &pos)
     if (!renderItem) {
         return;
     }
+    if (renderItem->status() == WAITINGJOB) {
+        QMenu menu(this);
+        auto *group = new QActionGroup(&menu);
+        const int current = renderItem->data(1, PriorityRole).toInt();
+        const QList<std::pair<int, QString>> priorities = {{RenderScheduler::HighPriority, i18n("High Priority")},
+                                                           {RenderScheduler::NormalPriority, i18n("Normal Priority")},
+                                                           {RenderScheduler::LowPriority, i18n("Low Priority")}};
+        for (const auto &priority : priorities) {
+            QAction *action = menu.addAction(priority.second);
+            action->setCheckable(true);
+            action->setChecked(priority.first == current);
+            group->addAction(action);
+            connect(action, &QAction::triggered, this, [this, renderItem, value = priority.first]() {
+                renderItem->setData(1, PriorityRole, value);
+                checkRenderStatus();
+            });
+        }
+        menu.exec(m_view.running_jobs->mapToGlobal(pos));
+        return;
+    }
     if (renderItem->status() != FINISHEDJOB) {
         return;
     }
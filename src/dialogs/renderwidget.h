@@ -16,6 +16,7 @@ class Menu;
 #include "bin/model/markerlistmodel.hpp"
 #include "definitions.h"
 #include "render/renderrequest.h"
+#include "render/renderscheduler.h"
 #include "renderpresets/renderpresetmodel.hpp"
 #include "renderpresets/tree/renderpresettreemodel.hpp"
 #include "ui_renderwidget_ui.h"
@@ -115,6 +116,8 @@ public:
     void focusItem(const QString &profile = QString());
     void setRenderProgress(const QString &dest, int progress = 0, int frame = 0);
     void setRenderStatus(const QString &dest, int status, const QString &error);
+    /** @brief Display the number of running jobs and their combined speed. */
+    void setRenderThroughput(int jobs, int fps);
     void setRenderProfile(const QMap<QString, QString> &props);
     void saveRenderProfile();
     void updateDocumentPath();
@@ -223,6 +226,8 @@ private:
     /** @brief Check if a job needs to be started. */
     void checkRenderStatus();
     void startRendering(RenderJobItem *item);
+    /** @brief Build the scheduler description of a queued job. */
+    RenderScheduler::Job schedulerJob(RenderJobItem *item) const;
     /** @brief Create a rendering profile from MLT preset. */
     QTreeWidgetItem *loadFromMltPreset(const QString &groupName, const QString &path, QString profileName, bool codecInName = false);
     RenderJobItem *createRenderJob(const RenderRequest::RenderJob &job);
@@ -0,0 +1,342 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "autosavejournal.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QStandardPaths>
+#include <algorithm>
+#include <vector>
+
+namespace {
+constexpr quint32 journalMagic = 0x4b41534a; // KASJ
+constexpr quint32 journalVersion = 1;
+constexpr quint32 recordMagic = 0x4a524543; // JREC
+
+struct Hunk
+{
+    // Replace lines [start, start + removed[ of the old lines by lines [insertStart, insertStart + inserted[ of the new ones
+    int start;
+    int removed;
+    int insertStart;
+    int inserted;
+};
+
+/** @brief Compute the hunks between ranges [a0, a1[ of @param a and [b0, b1[ of @param b.
+    Lines appearing exactly once on both sides are matched first, and the ranges between them compared recursively */
+void diffRange(const AutoSaveJournal::Lines &a, int a0, int a1, const AutoSaveJournal::Lines &b, int b0, int b1, std::vector<Hunk> &hunks)
+{
+    while (a0 < a1 && b0 < b1 && a.at(a0) == b.at(b0)) {
+        a0++;
+        b0++;
+    }
+    while (a0 < a1 && b0 < b1 && a.at(a1 - 1) == b.at(b1 - 1)) {
+        a1--;
+        b1--;
+    }
+    if (a0 == a1 && b0 == b1) {
+        return;
+    }
+    if (a0 == a1 || b0 == b1) {
+        hunks.push_back({a0, a1 - a0, b0, b1 - b0});
+        return;
+    }
+    struct Occurrences
+    {
+        int countA{0};
+        int countB{0};
+        int posB{-1};
+    };
+    QHash<QByteArray, Occurrences> occurrences;
+    occurrences.reserve(a1 - a0);
+    for (int i = a0; i < a1; ++i) {
+        occurrences[a.at(i)].countA++;
+    }
+    for (int j = b0; j < b1; ++j) {
+        auto it = occurrences.find(b.at(j));
+        if (it != occurrences.end()) {
+            it->countB++;
+            it->posB = j;
+        }
+    }
+    // Unique matching lines, in the order of a
+    std::vector<std::pair<int, int>> matches;
+    for (int i = a0; i < a1; ++i) {
+        const Occurrences &occ = occurrences[a.at(i)];
+        if (occ.countA == 1 && occ.countB == 1) {
+            matches.emplace_back(i, occ.posB);
+        }
+    }
+    if (matches.empty()) {
+        hunks.push_back({a0, a1 - a0, b0, b1 - b0});
+        return;
+    }
+    // Keep the longest subsequence of matches also ordered in b
+    std::vector<int> tails;
+    std::vector<int> previous(matches.size(), -1);
+    for (int k = 0; k < int(matches.size()); ++k) {
+        auto pos = std::lower_bound(tails.begin(), tails.end(), matches[size_t(k)].second,
+                                    [&matches](int index, int posB) { return matches[size_t(index)].second < posB; });
+        if (pos != tails.begin()) {
+            previous[size_t(k)] = *(pos - 1);
+        }
+        if (pos == tails.end()) {
+            tails.push_back(k);
+        } else {
+            *pos = k;
+        }
+    }
+    std::vector<std::pair<int, int>> anchors;
+    for (int k = tails.back(); k != -1; k = previous[size_t(k)]) {
+        anchors.push_back(matches[size_t(k)]);
+    }
+    std::reverse(anchors.begin(), anchors.end());
+    for (const auto &anchor : anchors) {
+        diffRange(a, a0, anchor.first, b, b0, anchor.second, hunks);
+        a0 = anchor.first + 1;
+        b0 = anchor.second + 1;
+    }
+    diffRange(a, a0, a1, b, b0, b1, hunks);
+}
+} // namespace
+
+AutoSaveJournal::AutoSaveJournal(int maxRecords)
+    : m_maxRecords(maxRecords)
+{
+}
+
+AutoSaveJournal::~AutoSaveJournal() = default;
+
+QString AutoSaveJournal::journalPath(const QString &autoSaveFile)
+{
+    // Not next to the autosave file, KAutoSaveFile::staleFiles() would list it as an autosave
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/autosave-journals/");
+    return dir + QFileInfo(autoSaveFile).fileName() + QStringLiteral(".journal");
+}
+
+bool AutoSaveJournal::write(QFile *file, const QByteArray &scene)
+{
+    Lines lines = scene.split('\n');
+    if (m_journal && m_fileName == file->fileName() && m_records < m_maxRecords && m_journalSize < m_snapshotSize / 2) {
+        const QByteArray delta = diff(m_lines, lines);
+        if (delta.isEmpty()) {
+            m_lastWasSnapshot = false;
+            m_lastWriteSize = 0;
+            return true;
+        }
+        if (appendRecord(delta)) {
+            m_lines = std::move(lines);
+            return true;
+        }
+        qWarning() << "Cannot write autosave journal, saving full scene";
+    }
+    return writeSnapshot(file, scene, std::move(lines));
+}
+
+bool AutoSaveJournal::writeSnapshot(QFile *file, const QByteArray &scene, Lines lines)
+{
+    if (!m_fileName.isEmpty() && m_fileName != file->fileName()) {
+        remove(m_fileName);
+    }
+    reset();
+    file->resize(0);
+    if (!file->seek(0) || file->write(scene) < 0) {
+        return false;
+    }
+    file->flush();
+    m_lastWasSnapshot = true;
+    m_lastWriteSize = scene.size();
+    // Start a new journal for this snapshot. Without journal, all the next autosaves are snapshots
+    auto journal = std::make_unique<QFile>(journalPath(file->fileName()));
+    QDir().mkpath(QFileInfo(journal->fileName()).absolutePath());
+    if (!journal->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot create autosave journal" << journal->fileName();
+        return true;
+    }
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << journalMagic << journalVersion << QCryptographicHash::hash(scene, QCryptographicHash::Md5);
+    if (journal->write(header) != header.size() || !journal->flush()) {
+        return true;
+    }
+    m_journal = std::move(journal);
+    m_fileName = file->fileName();
+    m_lines = std::move(lines);
+    m_snapshotSize = scene.size();
+    m_journalSize = header.size();
+    return true;
+}
+
+bool AutoSaveJournal::appendRecord(const QByteArray &delta)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << recordMagic << delta << qChecksum(delta);
+    if (m_journal->write(record) != record.size() || !m_journal->flush()) {
+        return false;
+    }
+    m_records++;
+    m_journalSize += record.size();
+    m_lastWasSnapshot = false;
+    m_lastWriteSize = record.size();
+    return true;
+}
+
+void AutoSaveJournal::reset()
+{
+    m_journal.reset();
+    m_fileName.clear();
+    m_lines.clear();
+    m_snapshotSize = 0;
+    m_journalSize = 0;
+    m_records = 0;
+}
+
+bool AutoSaveJournal::lastWriteWasSnapshot() const
+{
+    return m_lastWasSnapshot;
+}
+
+qint64 AutoSaveJournal::lastWriteSize() const
+{
+    return m_lastWriteSize;
+}
+
+QByteArray AutoSaveJournal::diff(const Lines &from, const Lines &to)
+{
+    std::vector<Hunk> hunks;
+    diffRange(from, 0, int(from.size()), to, 0, int(to.size()), hunks);
+    if (hunks.empty()) {
+        return QByteArray();
+    }
+    QByteArray delta;
+    QDataStream out(&delta, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << quint32(hunks.size());
+    for (const Hunk &hunk : hunks) {
+        out << quint32(hunk.start) << quint32(hunk.removed) << quint32(hunk.inserted);
+        for (int i = hunk.insertStart; i < hunk.insertStart + hunk.inserted; ++i) {
+            out << to.at(i);
+        }
+    }
+    return delta;
+}
+
+bool AutoSaveJournal::patch(Lines &lines, const QByteArray &delta)
+{
+    QDataStream in(delta);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 count = 0;
+    in >> count;
+    Lines result;
+    result.reserve(lines.size());
+    qsizetype position = 0;
+    for (quint32 h = 0; h < count; ++h) {
+        quint32 start = 0;
+        quint32 removed = 0;
+        quint32 inserted = 0;
+        in >> start >> removed >> inserted;
+        // Hunks are sorted and don't overlap
+        if (in.status() != QDataStream::Ok || qsizetype(start) < position || qsizetype(start) + qsizetype(removed) > lines.size()) {
+            return false;
+        }
+        result.append(lines.mid(position, qsizetype(start) - position));
+        for (quint32 i = 0; i < inserted; ++i) {
+            QByteArray line;
+            in >> line;
+            if (in.status() != QDataStream::Ok) {
+                return false;
+            }
+            result.append(line);
+        }
+        position = qsizetype(start) + qsizetype(removed);
+    }
+    if (in.status() != QDataStream::Ok) {
+        return false;
+    }
+    result.append(lines.mid(position));
+    lines = std::move(result);
+    return true;
+}
+
+int AutoSaveJournal::recover(QFile *file)
+{
+    const QString path = journalPath(file->fileName());
+    QFile journal(path);
+    if (!journal.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    if (!file->isOpen() && !file->open(QIODevice::ReadWrite)) {
+        return 0;
+    }
+    file->seek(0);
+    const QByteArray snapshot = file->readAll();
+    QDataStream in(&journal);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray hash;
+    in >> magic >> version >> hash;
+    if (in.status() != QDataStream::Ok || magic != journalMagic || version != journalVersion ||
+        hash != QCryptographicHash::hash(snapshot, QCryptographicHash::Md5)) {
+        // The journal belongs to another snapshot
+        qWarning() << "Ignoring autosave journal" << path;
+        return 0;
+    }
+    Lines lines = snapshot.split('\n');
+    int replayed = 0;
+    while (!in.atEnd()) {
+        quint32 magicRecord = 0;
+        QByteArray delta;
+        quint16 checksum = 0;
+        in >> magicRecord >> delta >> checksum;
+        if (in.status() != QDataStream::Ok || magicRecord != recordMagic || checksum != qChecksum(delta)) {
+            // Truncated or corrupted tail
+            break;
+        }
+        if (!patch(lines, delta)) {
+            qWarning() << "Cannot apply autosave journal record" << replayed << "from" << path;
+            break;
+        }
+        replayed++;
+    }
+    journal.close();
+    if (replayed > 0) {
+        const QByteArray scene = lines.join('\n');
+        file->resize(0);
+        if (!file->seek(0) || file->write(scene) != scene.size() || !file->flush()) {
+            qWarning() << "Cannot write recovered autosave" << file->fileName();
+            return 0;
+        }
+    }
+    // The snapshot now includes the journal, whose hash no longer matches anyway
+    QFile::remove(path);
+    return replayed;
+}
+
+QDateTime AutoSaveJournal::lastModified(const QString &autoSaveFile)
+{
+    const QDateTime snapshotTime = QFileInfo(autoSaveFile).lastModified();
+    const QFileInfo journal(journalPath(autoSaveFile));
+    if (journal.exists() && journal.lastModified() > snapshotTime) {
+        return journal.lastModified();
+    }
+    return snapshotTime;
+}
+
+void AutoSaveJournal::remove(const QString &autoSaveFile)
+{
+    const QString path = journalPath(autoSaveFile);
+    if (QFile::exists(path)) {
+        QFile::remove(path);
+    }
+}
@@ -0,0 +1,76 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayList>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <memory>
+
+/** @class AutoSaveJournal
+    @brief Writes the autosaves of a project as a full snapshot followed by a journal of changes.
+    The first autosave, and then one every maxRecords autosaves, writes the full scene to the autosave
+    file. The next autosaves only append the lines that changed since the previous one to a journal
+    file, so an edit costs the size of its changes instead of the size of the project. The journal is
+    kept in the application data folder, named after the autosave file, see journalPath().
+    The journal starts with a hash of the snapshot it applies to, so a journal left behind by an
+    interrupted snapshot is ignored. A truncated last record, left by a crash while appending, is
+    ignored too.
+    On recovery, the journal is replayed on top of the snapshot, see recover().
+    An instance must only be used by one thread at a time.
+ */
+class AutoSaveJournal
+{
+
+public:
+    using Lines = QByteArrayList;
+
+    explicit AutoSaveJournal(int maxRecords = 100);
+    ~AutoSaveJournal();
+
+    /** @brief Save @param scene, either as a full snapshot in @param file, which must be open, or as a journal record.
+        @returns false on write error */
+    bool write(QFile *file, const QByteArray &scene);
+    /** @brief Close the journal, the next write will be a full snapshot */
+    void reset();
+    /** @brief True if the last write was a full snapshot */
+    bool lastWriteWasSnapshot() const;
+    /** @brief Number of bytes written by the last write */
+    qint64 lastWriteSize() const;
+
+    /** @brief The journal of the autosave file @param autoSaveFile, outside of the autosave folder */
+    static QString journalPath(const QString &autoSaveFile);
+    /** @brief Replay the journal of the autosave @param file on top of it, then delete the journal.
+        @returns the number of replayed records */
+    static int recover(QFile *file);
+    /** @brief Last modification of an autosave, including its journal */
+    static QDateTime lastModified(const QString &autoSaveFile);
+    /** @brief Delete the journal of an autosave file */
+    static void remove(const QString &autoSaveFile);
+
+    /** @brief Returns the changes needed to turn @param from into @param to, empty if they are equal */
+    static QByteArray diff(const Lines &from, const Lines &to);
+    /** @brief Apply changes returned by diff() to @param lines. @returns false if they don't apply, lines are then unchanged */
+    static bool patch(Lines &lines, const QByteArray &delta);
+
+private:
+    bool writeSnapshot(QFile *file, const QByteArray &scene, Lines lines);
+    bool appendRecord(const QByteArray &delta);
+
+    int m_maxRecords;
+    /** @brief The autosave file holding the current snapshot */
+    QString m_fileName;
+    /** @brief The scene as of the last write */
+    Lines m_lines;
+    std::unique_ptr<QFile> m_journal;
+    qint64 m_snapshotSize{0};
+    qint64 m_journalSize{0};
+    int m_records{0};
+    bool m_lastWasSnapshot{false};
+    qint64 m_lastWriteSize{0};
+};
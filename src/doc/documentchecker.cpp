@@ -9,6 +9,7 @@
 #include "dcresolvedialog.h"
 #include "effects/effectsrepository.hpp"
 #include "kdenlivesettings.h"
+#include "mediarelocator.h"
 #include "titler/titlewidget.h"
 #include "transitions/transitionsrepository.hpp"
 #include "xml/xml.hpp"
@@ -1249,47 +1250,10 @@ QString DocumentChecker::searchFileRecursively(const QDir &dir, const QString &m
     if (matchSize.isEmpty() && matchHash.isEmpty()) {
         return searchPathRecursively(dir, QUrl::fromLocalFile(fileName).fileName());
     }
-    QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
-    QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        qApp->processEvents();
-        /*if (m_abortSearch) {
-            return QString();
-        }*/
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (QString::number(file.size()) == matchSize) {
-            if (file.open(QIODevice::ReadOnly)) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-            }
-        }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
-    }
-    filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        foundFileName = searchFileRecursively(dir.absoluteFilePath(filesAndDirs.at(i)), matchSize, matchHash, fileName);
-        if (!foundFileName.isEmpty()) {
-            break;
-        }
-    }
-    return foundFileName;
+    bool ok;
+    const qint64 size = matchSize.toLongLong(&ok);
+    MediaRelocator relocator(dir);
+    return relocator.relocate({{0, {QFileInfo(fileName).fileName(), ok ? size : -1, matchHash}}}, false).value(0);
 }
 
 QString DocumentChecker::ensureAbsolutePath(QString filepath)
@@ -6,6 +6,7 @@
 #include "documentcheckertreemodel.h"
 
 #include "abstractmodel/treeitem.hpp"
+#include "mediarelocator.h"
 
 #include <KColorScheme>
 
@@ -67,6 +68,19 @@ void DocumentCheckerTreeModel::slotSearchRecursively(const QString &newpath)
 {
     QDir searchDir(newpath);
     QMap<QModelIndex, QString> fixedMap;
+    // Relocate all missing clips at once, so that the folder is only walked one time
+    QMap<int, MediaRelocator::Target> targets;
+    for (auto it = m_resourceItems.cbegin(); it != m_resourceItems.cend(); ++it) {
+        const DocumentChecker::DocumentResource &item = it.value();
+        if ((item.status == DocumentChecker::MissingStatus::Missing || item.status == DocumentChecker::MissingStatus::MissingButProxy) &&
+            item.type == DocumentChecker::MissingType::Clip && item.clipType != ClipType::SlideShow) {
+            bool ok;
+            const qint64 size = item.fileSize.toLongLong(&ok);
+            targets.insert(it.key(), {QFileInfo(item.originalFilePath).fileName(), ok ? size : -1, item.hash});
+        }
+    }
+    MediaRelocator relocator(searchDir);
+    const QMap<int, QString> relocated = relocator.relocate(targets);
     QMapIterator<int, DocumentChecker::DocumentResource> i(m_resourceItems);
     int counter = 1;
     while (i.hasNext()) {
@@ -82,11 +96,11 @@ void DocumentCheckerTreeModel::slotSearchRecursively(const QString &newpath)
             if (type == ClipType::SlideShow) {
                 // Slideshows cannot be found with hash / size
                 newPath = DocumentChecker::searchDirRecursively(searchDir, i.value().hash, i.value().originalFilePath);
+                if (newPath.isEmpty()) {
+                    newPath = DocumentChecker::searchPathRecursively(searchDir, QUrl::fromLocalFile(i.value().originalFilePath).fileName(), type);
+                }
             } else {
-                newPath = DocumentChecker::searchFileRecursively(searchDir, i.value().fileSize, i.value().hash, i.value().originalFilePath);
-            }
-            if (newPath.isEmpty()) {
-                newPath = DocumentChecker::searchPathRecursively(searchDir, QUrl::fromLocalFile(i.value().originalFilePath).fileName(), type);
+                newPath = relocated.value(i.key());
             }
         } else if (i.value().type == DocumentChecker::MissingType::Luma) {
             newPath = DocumentChecker::searchLuma(searchDir, i.value().originalFilePath);
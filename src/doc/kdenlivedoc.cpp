@@ -5,6 +5,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "kdenlivedoc.h"
+#include "autosavejournal.h"
 #include "bin/bin.h"
 #include "bin/bincommands.h"
 #include "bin/binplaylist.hpp"
@@ -23,6 +24,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "effects/effectsrepository.hpp"
 #include "kdenlivesettings.h"
 #include "mainwindow.h"
+#include "mediarelocator.h"
 #include "mltcontroller/clipcontroller.h"
 #include "profiles/profilemodel.hpp"
 #include "profiles/profilerepository.hpp"
@@ -43,6 +45,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kdenlive_debug.h"
 #include <QCryptographicHash>
 #include <QDomImplementation>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileDialog>
 #include <QJsonArray>
@@ -51,6 +54,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QStandardPaths>
 #include <QUndoGroup>
 #include <QUndoStack>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 #include <QtConcurrent>
 #include <memory>
 #include <mlt++/Mlt.h>
@@ -335,8 +340,11 @@ KdenliveDoc::~KdenliveDoc()
     m_commandStack->clear();
     m_timelines.clear();
     // qCDebug(KDENLIVE_LOG) << "// DEL CLP MAN done";
+    waitForAutoSave();
+    m_autoSaveJournal.reset();
     if (m_autosave) {
         if (!m_autosave->fileName().isEmpty()) {
+            AutoSaveJournal::remove(m_autosave->fileName());
             m_autosave->remove();
         }
         delete m_autosave;
@@ -569,25 +577,95 @@ bool KdenliveDoc::autoGenerateImageProxy(int width) const
            (width < 0 || width > m_documentProperties.value(QStringLiteral("proxyimageminsize")).toInt());
 }
 
-void KdenliveDoc::slotAutoSave(const QString &scene)
+void KdenliveDoc::slotAutoSave(const QString &scene, const QMap<QString, QString> &replacements)
 {
     if (m_autosave != nullptr) {
-        if (!m_autosave->isOpen() && !m_autosave->open(QIODevice::ReadWrite)) {
-            // show error: could not open the autosave file
-            qCDebug(KDENLIVE_LOG) << "ERROR; CANNOT CREATE AUTOSAVE FILE";
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
-            return;
-        }
         if (scene.isEmpty()) {
             // Make sure we don't save if scenelist is corrupted
             KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", m_autosave->fileName()));
             return;
         }
+        waitForAutoSave();
+        if (!m_autoSaveJournal) {
+            m_autoSaveJournal = std::make_unique<AutoSaveJournal>();
+        }
+        // The file and journal are only used by the worker until the autosave is finished, see waitForAutoSave()
+        KAutoSaveFile *file = m_autosave;
+        AutoSaveJournal *journal = m_autoSaveJournal.get();
+        m_autoSaveFuture = QtConcurrent::run([this, file, journal, scene, replacements]() {
+            QElapsedTimer timer;
+            timer.start();
+            AutoSaveStatus status = writeAutoSave(file, journal, scene, replacements);
+            const qint64 duration = timer.elapsed();
+            if (status == AutoSaveStatus::Saved) {
+                qCDebug(KDENLIVE_LOG) << "Autosave wrote" << journal->lastWriteSize() << "bytes"
+                                      << (journal->lastWriteWasSnapshot() ? "in a full snapshot" : "in the journal");
+            }
+            QMetaObject::invokeMethod(this, [this, status, duration]() { autoSaveFinished(status, duration); }, Qt::QueuedConnection);
+        });
+    }
+}
+
+KdenliveDoc::AutoSaveStatus KdenliveDoc::writeAutoSave(KAutoSaveFile *file, AutoSaveJournal *journal, QString scene,
+                                                       const QMap<QString, QString> &replacements)
+{
+    QMapIterator<QString, QString> i(replacements);
+    while (i.hasNext()) {
+        i.next();
+        scene.replace(i.key(), i.value());
+    }
+    if (!scene.contains(QLatin1String("<track "))) {
+        // In some unexplained cases, the MLT playlist is corrupted and all tracks are deleted. Don't save in that case.
+        return AutoSaveStatus::Corrupted;
+    }
+    if (!file->isOpen() && !file->open(QIODevice::ReadWrite)) {
+        return AutoSaveStatus::CannotOpen;
+    }
+    if (!journal->write(file, scene.toUtf8())) {
+        return AutoSaveStatus::CannotWrite;
+    }
+    return AutoSaveStatus::Saved;
+}
+
+void KdenliveDoc::autoSaveFinished(AutoSaveStatus status, qint64 duration)
+{
+    switch (status) {
+    case AutoSaveStatus::Corrupted:
+        pCore->displayMessage(i18n("Project was corrupted, cannot backup. Please close and reopen your project file to recover last backup"), ErrorMessage);
+        break;
+    case AutoSaveStatus::CannotOpen:
+        // show error: could not open the autosave file
+        qCDebug(KDENLIVE_LOG) << "ERROR; CANNOT CREATE AUTOSAVE FILE";
+        pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
+        break;
+    case AutoSaveStatus::CannotWrite:
+        pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
+        break;
+    default:
+        qCDebug(KDENLIVE_LOG) << "Autosave written in background in" << duration << "ms";
+        break;
+    }
+}
+
+bool KdenliveDoc::isAutoSaving() const
+{
+    return m_autoSaveFuture.isRunning();
+}
+
+void KdenliveDoc::waitForAutoSave()
+{
+    m_autoSaveFuture.waitForFinished();
+}
+
+void KdenliveDoc::clearAutoSave()
+{
+    waitForAutoSave();
+    if (m_autoSaveJournal) {
+        m_autoSaveJournal->reset();
+    }
+    if (m_autosave) {
         m_autosave->resize(0);
-        if (m_autosave->write(scene.toUtf8()) < 0) {
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
-        }
-        m_autosave->flush();
+        AutoSaveJournal::remove(m_autosave->fileName());
     }
 }
 
@@ -713,12 +791,72 @@ QDomDocument KdenliveDoc::xmlSceneList(const QString &scene)
     return sceneList;
 }
 
+bool KdenliveDoc::writeSceneList(const QString &scene, QIODevice *device)
+{
+    QXmlStreamReader reader(scene);
+    QXmlStreamWriter writer(device);
+    int depth = 0;
+    bool isMlt = false;
+    bool hasTrack = false;
+    // Depth of the main tractor element while we are inside it
+    int mainTractorDepth = -1;
+    bool foundMainTractor = false;
+    bool volumeReset = false;
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            if (depth == 0) {
+                isMlt = reader.name() == QLatin1String("mlt");
+            } else if (reader.name() == QLatin1String("track")) {
+                hasTrack = true;
+            } else if (!foundMainTractor && reader.name() == QLatin1String("tractor") && reader.attributes().hasAttribute(QLatin1String("global_feed"))) {
+                // This is our main tractor
+                foundMainTractor = true;
+                mainTractorDepth = depth;
+            } else if (mainTractorDepth >= 0 && !volumeReset && reader.name() == QLatin1String("property") &&
+                       reader.attributes().value(QLatin1String("name")) == QLatin1String("meta.volume")) {
+                // Set playlist audio volume to 100%
+                writer.writeCurrentToken(reader);
+                reader.readElementText(QXmlStreamReader::IncludeChildElements);
+                writer.writeCharacters(QStringLiteral("1"));
+                writer.writeEndElement();
+                volumeReset = true;
+                continue;
+            }
+            depth++;
+        } else if (reader.isEndElement()) {
+            depth--;
+            if (depth == mainTractorDepth) {
+                mainTractorDepth = -1;
+            }
+        }
+        writer.writeCurrentToken(reader);
+    }
+    if (reader.hasError() || !isMlt || !hasTrack) {
+        // scenelist is corrupted
+        qCWarning(KDENLIVE_LOG) << "Corrupted scene list" << reader.errorString();
+        return false;
+    }
+    return !writer.hasError();
+}
+
 bool KdenliveDoc::saveSceneList(const QString &path, const QString &scene, bool saveOverExistingFile)
 {
-    QDomDocument sceneList = xmlSceneList(scene);
-    if (sceneList.isNull()) {
-        // Make sure we don't save if scenelist is corrupted
-        KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", path));
+    // The scene is streamed to a temporary file, which only replaces the project file after the backups are done
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        qCWarning(KDENLIVE_LOG) << "//////  ERROR writing to file: " << path;
+        KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1", path));
+        return false;
+    }
+    if (!writeSceneList(scene, &file)) {
+        file.cancelWriting();
+        if (file.error() != QFileDevice::NoError) {
+            KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1", path));
+        } else {
+            // Make sure we don't save if scenelist is corrupted
+            KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", path));
+        }
         return false;
     }
 
@@ -754,16 +892,6 @@ bool KdenliveDoc::saveSceneList(const QString &path, const QString &scene, bool
                      backupFile));
         }
     }
-    QSaveFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qCWarning(KDENLIVE_LOG) << "//////  ERROR writing to file: " << path;
-        KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1", path));
-        return false;
-    }
-
-    const QByteArray sceneData = sceneList.toString().toUtf8();
-
-    file.write(sceneData);
     if (!file.commit()) {
         KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1", path));
         return false;
@@ -1111,44 +1239,13 @@ const QString KdenliveDoc::description(const QString suffix) const
 
 QString KdenliveDoc::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash) const
 {
-    QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
-    QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (file.open(QIODevice::ReadOnly)) {
-            if (QString::number(file.size()) == matchSize) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-                qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << "size match but not hash";
-            }
-        }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
-    }
-    filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        foundFileName = searchFileRecursively(dir.absoluteFilePath(filesAndDirs.at(i)), matchSize, matchHash);
-        if (!foundFileName.isEmpty()) {
-            break;
-        }
+    bool ok;
+    const qint64 size = matchSize.toLongLong(&ok);
+    if (!ok || matchHash.isEmpty()) {
+        return QString();
     }
-    return foundFileName;
+    MediaRelocator relocator(dir);
+    return relocator.relocate({{0, {QString(), size, matchHash}}}, false).value(0);
 }
 
 QStringList KdenliveDoc::getBinFolderClipIds(const QString &folderId) const
@@ -15,6 +15,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <KJob>
 #include <QAction>
 #include <QDir>
+#include <QFuture>
 #include <QList>
 #include <QMap>
 #include <QObject>
@@ -29,6 +30,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "utils/gentime.h"
 #include "utils/timecode.h"
 
+class AutoSaveJournal;
 class MainWindow;
 class TrackInfo;
 class ProjectClip;
@@ -163,6 +165,10 @@ public:
     QDomDocument xmlSceneList(const QString &scene);
     /** @brief Saves the project file xml to a file. */
     bool saveSceneList(const QString &path, const QString &scene, bool saveOverExistingFile = true);
+    /** @brief Writes the project file xml to @param device, streaming the @param scene without building a document.
+     *  The changes made to the scene are the same as in xmlSceneList().
+     *  @returns false if the scene is corrupted or cannot be written */
+    static bool writeSceneList(const QString &scene, QIODevice *device);
     void setProjectFolder(const QUrl &url);
     void setZone(const QUuid &uuid, int start, int end);
     QPoint zone(const QUuid &uuid) const;
@@ -335,6 +341,12 @@ public:
     bool checkConsistency();
     /** @brief Returns true if the document is loading or closing */
     bool isBusy() const;
+    /** @brief Returns true if an autosave is being written */
+    bool isAutoSaving() const;
+    /** @brief Wait until the autosave being written, if any, is finished */
+    void waitForAutoSave();
+    /** @brief Empty the autosave file and its journal, for example after the project was saved */
+    void clearAutoSave();
     /** @brief Returns a valid {fps_num, fps_den} based on a fps */
     static std::pair<int, int> getFpsFraction(double fps, bool *adjusted);
     enum RENDERLOCATION { SaveToVideoFolder = 0, SaveToProjectFolder, SaveToCustomFolder, SaveToProjectSubFolder };
@@ -403,6 +415,16 @@ private:
     /** @brief initialize proxy settings based on hw status */
     void initProxySettings();
 
+    enum class AutoSaveStatus { Saved, Corrupted, CannotOpen, CannotWrite };
+    /** @brief The autosave being written on a worker thread */
+    QFuture<void> m_autoSaveFuture;
+    /** @brief Writes the autosaves as snapshots and journal records, only used by the autosave worker */
+    std::unique_ptr<AutoSaveJournal> m_autoSaveJournal;
+    /** @brief Apply the @param replacements to @param scene and write it to @param file through @param journal. Runs on a worker thread */
+    static AutoSaveStatus writeAutoSave(KAutoSaveFile *file, AutoSaveJournal *journal, QString scene, const QMap<QString, QString> &replacements);
+    /** @brief Report the result of an autosave, on the GUI thread */
+    void autoSaveFinished(AutoSaveStatus status, qint64 duration);
+
 public Q_SLOTS:
     void slotCreateTextTemplateClip(const QString &group, const QString &groupId, QUrl path);
 
@@ -418,8 +440,10 @@ public Q_SLOTS:
                               QUndoCommand *masterCommand = nullptr);
     /** @brief Saves the current project at the autosave location.
      *
-     * The autosave files are in ~/.kde/data/stalefiles/kdenlive/ */
-    void slotAutoSave(const QString &scene);
+     * The autosave files are in ~/.kde/data/stalefiles/kdenlive/
+     * The @param replacements are applied to @param scene, and the result is written, on a worker thread.
+     * Should not be called while isAutoSaving() */
+    void slotAutoSave(const QString &scene, const QMap<QString, QString> &replacements = {});
     void switchProfile(ProfileParam* pf, const QString &clipName);
 
 private Q_SLOTS:
@@ -0,0 +1,186 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "mediarelocator.h"
+#include "bin/projectclip.h"
+
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QtConcurrent>
+#include <vector>
+
+namespace {
+struct FolderListing
+{
+    QString path;
+    std::vector<std::pair<QString, qint64>> files;
+    // Sub folders, with their canonical path to detect symlink loops
+    std::vector<std::pair<QString, QString>> folders;
+    // Names of the missing files matching each of the files, by file index
+    std::vector<QStringList> names;
+};
+
+/** @brief Matches file names like a QDir name filter: wildcards allowed, case insensitive */
+class NameMatcher
+{
+public:
+    explicit NameMatcher(const QSet<QString> &names)
+    {
+        for (const QString &name : names) {
+            if (name.contains(QLatin1Char('*')) || name.contains(QLatin1Char('?')) || name.contains(QLatin1Char('['))) {
+                m_wildcards.append({QRegularExpression(QRegularExpression::wildcardToRegularExpression(name), QRegularExpression::CaseInsensitiveOption), name});
+            } else {
+                m_exact[name.toLower()] << name;
+            }
+        }
+    }
+    QStringList match(const QString &fileName) const
+    {
+        QStringList matched = m_exact.value(fileName.toLower());
+        for (const auto &wildcard : m_wildcards) {
+            if (wildcard.first.match(fileName).hasMatch()) {
+                matched << wildcard.second;
+            }
+        }
+        return matched;
+    }
+
+private:
+    QHash<QString, QStringList> m_exact;
+    QList<std::pair<QRegularExpression, QString>> m_wildcards;
+};
+} // namespace
+
+MediaRelocator::MediaRelocator(const QDir &root)
+    : m_root(root)
+{
+}
+
+int MediaRelocator::scannedFolders() const
+{
+    return m_scannedFolders;
+}
+
+int MediaRelocator::hashedFiles() const
+{
+    return m_hashedFiles;
+}
+
+QString MediaRelocator::fileHash(const QString &path)
+{
+    return QString::fromLatin1(ProjectClip::calculateHash(path).first.toHex());
+}
+
+void MediaRelocator::scan(const QSet<qint64> &sizes, const QSet<QString> &names)
+{
+    m_bySize.clear();
+    m_byName.clear();
+    m_scannedFolders = 0;
+    QSet<QString> visited = {m_root.canonicalPath()};
+    QStringList level = {m_root.absolutePath()};
+    const NameMatcher matcher(names);
+    const auto listFolder = [&sizes, &matcher](const QString &path) {
+        FolderListing listing;
+        listing.path = path;
+        QDir dir(path);
+        const QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::Readable);
+        for (const QFileInfo &info : files) {
+            QStringList matched = matcher.match(info.fileName());
+            if (sizes.contains(info.size()) || !matched.isEmpty()) {
+                listing.files.emplace_back(info.absoluteFilePath(), info.size());
+                listing.names.push_back(std::move(matched));
+            }
+        }
+        const QFileInfoList folders = dir.entryInfoList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
+        for (const QFileInfo &info : folders) {
+            listing.folders.emplace_back(info.absoluteFilePath(), info.canonicalFilePath());
+        }
+        return listing;
+    };
+    while (!level.isEmpty()) {
+        // Directory listing is mostly waiting on the file system, so list the whole level at once
+        const QList<FolderListing> listings = QtConcurrent::blockingMapped<QList<FolderListing>>(level, listFolder);
+        m_scannedFolders += level.size();
+        level.clear();
+        for (const FolderListing &listing : listings) {
+            for (size_t i = 0; i < listing.files.size(); ++i) {
+                const auto &file = listing.files.at(i);
+                if (sizes.contains(file.second)) {
+                    m_bySize[file.second] << file.first;
+                }
+                for (const QString &name : listing.names.at(i)) {
+                    m_byName[name] << file.first;
+                }
+            }
+            for (const auto &folder : listing.folders) {
+                if (!visited.contains(folder.second)) {
+                    visited.insert(folder.second);
+                    level << folder.first;
+                }
+            }
+        }
+    }
+}
+
+QMap<int, QString> MediaRelocator::relocate(const QMap<int, Target> &targets, bool nameFallback)
+{
+    QMap<int, QString> result;
+    m_hashedFiles = 0;
+    QSet<qint64> sizes;
+    QSet<QString> names;
+    for (const Target &target : targets) {
+        if (target.size >= 0 && !target.hash.isEmpty()) {
+            sizes.insert(target.size);
+        }
+        if (nameFallback && !target.fileName.isEmpty()) {
+            names.insert(target.fileName);
+        }
+    }
+    scan(sizes, names);
+
+    // Hash all the candidates of the searched sizes
+    QSet<QString> toHash;
+    for (const Target &target : targets) {
+        if (target.size < 0 || target.hash.isEmpty()) {
+            continue;
+        }
+        auto candidates = m_bySize.find(target.size);
+        if (candidates == m_bySize.end()) {
+            continue;
+        }
+        for (const QString &path : std::as_const(candidates->second)) {
+            toHash.insert(path);
+        }
+    }
+    const QStringList hashPaths(toHash.cbegin(), toHash.cend());
+    const QStringList hashes = QtConcurrent::blockingMapped<QStringList>(hashPaths, &MediaRelocator::fileHash);
+    m_hashedFiles = hashPaths.size();
+    QHash<QString, QString> hashByPath;
+    for (int i = 0; i < hashPaths.size(); ++i) {
+        hashByPath.insert(hashPaths.at(i), hashes.at(i));
+    }
+
+    for (auto it = targets.cbegin(); it != targets.cend(); ++it) {
+        const Target &target = it.value();
+        if (target.size >= 0 && !target.hash.isEmpty()) {
+            auto candidates = m_bySize.find(target.size);
+            if (candidates != m_bySize.end()) {
+                for (const QString &path : std::as_const(candidates->second)) {
+                    if (hashByPath.value(path) == target.hash) {
+                        result.insert(it.key(), path);
+                        break;
+                    }
+                }
+            }
+        }
+        if (nameFallback && !result.contains(it.key())) {
+            const QStringList named = m_byName.value(target.fileName);
+            if (!named.isEmpty()) {
+                result.insert(it.key(), named.first());
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QDir>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <unordered_map>
+
+/** @class MediaRelocator
+    @brief Finds the new location of several missing media files under a search folder in one pass.
+    The folder tree is walked only once, one directory level at a time with the directories of a level
+    listed in parallel. Only the files whose size or name matches one of the missing files are indexed.
+    A missing file is then matched by size and kdenlive:file_hash, all the candidates of a size being
+    hashed in parallel on the global thread pool. File names are matched like a QDir name filter.
+ */
+class MediaRelocator
+{
+public:
+    struct Target
+    {
+        /** @brief File name of the missing file, without its folder */
+        QString fileName;
+        /** @brief File size, -1 if unknown */
+        qint64 size{-1};
+        /** @brief Hexadecimal file hash as computed by ProjectClip::calculateHash, empty if unknown */
+        QString hash;
+    };
+
+    explicit MediaRelocator(const QDir &root);
+
+    /** @brief Search all @param targets, returns the new path of the found ones, by target key.
+        @param nameFallback if true, targets that cannot be found by size and hash are matched by file name */
+    QMap<int, QString> relocate(const QMap<int, Target> &targets, bool nameFallback = true);
+
+    /** @brief Number of directories listed by the last search */
+    int scannedFolders() const;
+    /** @brief Number of files hashed by the last search */
+    int hashedFiles() const;
+
+    /** @brief Returns the hexadecimal hash of @param path, comparable to kdenlive:file_hash */
+    static QString fileHash(const QString &path);
+
+private:
+    /** @brief Walk the tree and index the files matching @param sizes or @param names */
+    void scan(const QSet<qint64> &sizes, const QSet<QString> &names);
+
+    QDir m_root;
+    // Candidate paths, in walk order
+    std::unordered_map<qint64, QStringList> m_bySize;
+    QHash<QString, QStringList> m_byName;
+    int m_scannedFolders{0};
+    int m_hashedFiles{0};
+};
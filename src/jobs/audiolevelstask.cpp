@@ -6,10 +6,13 @@
 */
 
 #include "audiolevelstask.h"
+#include "audio/audioLevelsBuffer.h"
+#include "audio/audioLevelsPyramid.h"
 #include "audio/audioStreamInfo.h"
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
 #include "core.h"
+#include "kdenlivesettings.h"
 
 #include <KLocalizedString>
 #include <KMessageWidget>
@@ -19,6 +22,7 @@
 #include <QList>
 #include <QMutex>
 #include <QRgb>
+#include <QSemaphore>
 #include <QString>
 #include <QThreadPool>
 #include <QTime>
@@ -27,9 +31,63 @@
 static QList<AudioLevelsTask *> tasksList;
 static QMutex tasksListMutex;
 
-static void deleteQVariantList(QVector<uint8_t> *list)
+static void deleteLevelsBuffer(std::shared_ptr<const AudioLevelsBuffer> *buffer)
 {
-    delete list;
+    delete buffer;
+}
+
+static void deletePyramid(std::shared_ptr<const AudioLevelsPyramid> *pyramid)
+{
+    delete pyramid;
+}
+
+struct AudioLevelsTask::LevelsSegment
+{
+    /** @brief Index of the stream in the pending streams list */
+    int owner;
+    int stream;
+    int streamIndex;
+    int channels;
+    int start;
+    int end;
+    /** @brief Where the levels are appended, for the first segment this is the published buffer of the stream */
+    std::shared_ptr<AudioLevelsBuffer> levels;
+    uint maxLevel{1};
+    bool valid{true};
+};
+
+struct AudioLevelsTask::PendingStream
+{
+    int stream;
+    int channels;
+    QString cachePath;
+    std::shared_ptr<AudioLevelsBuffer> levels;
+};
+
+/** @brief Attach the levels of an audio stream to the clip's producer.
+ *  The buffer can still be growing, in which case no pyramid is passed.
+ */
+static void storeLevels(const std::shared_ptr<ProjectClip> &binClip, int stream, const std::shared_ptr<const AudioLevelsBuffer> &levels,
+                        const std::shared_ptr<const AudioLevelsPyramid> &pyramid = nullptr)
+{
+    std::shared_ptr<Mlt::Producer> producer = binClip->originalProducer();
+    producer->lock();
+    QString key = QStringLiteral("_kdenlive:audio%1").arg(stream);
+    producer->set(key.toUtf8().constData(), new std::shared_ptr<const AudioLevelsBuffer>(levels), 0, (mlt_destructor)deleteLevelsBuffer);
+    if (pyramid) {
+        key = QStringLiteral("_kdenlive:audiopyramid%1").arg(stream);
+        producer->set(key.toUtf8().constData(), new std::shared_ptr<const AudioLevelsPyramid>(pyramid), 0, (mlt_destructor)deletePyramid);
+    }
+    producer->unlock();
+}
+
+/** @brief Detach the levels of an audio stream that were published while growing and will not be completed */
+static void clearLevels(const std::shared_ptr<ProjectClip> &binClip, int stream)
+{
+    std::shared_ptr<Mlt::Producer> producer = binClip->originalProducer();
+    producer->lock();
+    producer->clear(QStringLiteral("_kdenlive:audio%1").arg(stream).toUtf8().constData());
+    producer->unlock();
 }
 
 AudioLevelsTask::AudioLevelsTask(const ObjectId &owner, QObject *object)
@@ -103,6 +161,18 @@ void AudioLevelsTask::run()
     QMapIterator<int, QString> st(streams);
     bool audioCreated = false;
     int streamIndex = -1;
+    m_service = service;
+    m_resource = res;
+    m_frequency = frequency;
+    // Streams are decoded in parallel, and long streams are split in segments decoded on separate producers
+    bool parallel = KdenliveSettings::parallelaudiothumbs() && pCore->taskManager.threadBudget() > 1;
+    int segmentCount = 1;
+    if (parallel) {
+        int minSegmentLength = qMax(1, int(pCore->getCurrentFps() * MinSegmentSeconds));
+        segmentCount = qBound(1, lengthInFrames / minSegmentLength, pCore->taskManager.threadBudget());
+    }
+    std::vector<PendingStream> pending;
+    std::vector<LevelsSegment> segments;
     while (st.hasNext() && !m_isCanceled) {
         st.next();
         int stream = st.key();
@@ -112,140 +182,130 @@ void AudioLevelsTask::run()
         streamIndex++;
         // Generate one thumb per stream
         const QString cachePath = binClip->getAudioThumbPath(stream);
-        QVector<uint8_t> mltLevels;
-        if (!m_isForce && QFile::exists(cachePath)) {
+        if (!m_isForce) {
             // Audio thumb already exists
-            QImage image(cachePath);
-            if (!m_isCanceled && !image.isNull()) {
-                // convert cached image
-                int n = image.width() * image.height();
-                for (int i = 0; n > 1 && i < n; i++) {
-                    QRgb p = image.pixel(i / channels, i % channels);
-                    mltLevels << qRed(p);
-                    mltLevels << qGreen(p);
-                    mltLevels << qBlue(p);
-                    mltLevels << qAlpha(p);
+            std::shared_ptr<AudioLevelsPyramid> cached = AudioLevelsPyramid::load(cachePath);
+            const QString legacyPath = binClip->getAudioThumbPath(stream, true);
+            if (!cached && QFile::exists(legacyPath)) {
+                // Convert the image cache of older versions
+                QVector<uint8_t> mltLevels;
+                QImage image(legacyPath);
+                if (!m_isCanceled && !image.isNull()) {
+                    int n = image.width() * image.height();
+                    for (int i = 0; n > 1 && i < n; i++) {
+                        QRgb p = image.pixel(i / channels, i % channels);
+                        mltLevels << qRed(p);
+                        mltLevels << qGreen(p);
+                        mltLevels << qBlue(p);
+                        mltLevels << qAlpha(p);
+                    }
                 }
                 if (mltLevels.size() > 0) {
-                    QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-                    producer = binClip->originalProducer();
-                    producer->lock();
-                    QString key = QStringLiteral("_kdenlive:audio%1").arg(stream);
-                    producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-                    producer->unlock();
-                    producer.reset();
-                    continue;
+                    cached = std::make_shared<AudioLevelsPyramid>(std::make_shared<AudioLevelsBuffer>(mltLevels), channels);
+                    if (cached->save(cachePath)) {
+                        QFile::remove(legacyPath);
+                    }
                 }
             }
+            if (!m_isCanceled && cached && cached->frames() > 0) {
+                storeLevels(binClip, stream, cached->baseLevels(), cached);
+                continue;
+            }
         }
 
-        Mlt::Producer *aProd = new Mlt::Producer(pCore->getProjectProfile(), service.toUtf8().constData(), res.toUtf8().constData());
-        if (!aProd->is_valid()) {
-            QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection, Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", res)),
-                                      Q_ARG(int, int(KMessageWidget::Warning)));
-            delete aProd;
-            return;
+        auto streamLevels = std::make_shared<AudioLevelsBuffer>(lengthInFrames * channels);
+        // Publish the growing levels right away, readers see the generated part without any copy
+        storeLevels(binClip, stream, streamLevels);
+        pending.push_back({stream, channels, cachePath, streamLevels});
+        for (int i = 0; i < segmentCount; i++) {
+            LevelsSegment segment;
+            segment.owner = int(pending.size()) - 1;
+            segment.stream = stream;
+            segment.streamIndex = streamIndex;
+            segment.channels = channels;
+            segment.start = int(qint64(lengthInFrames) * i / segmentCount);
+            segment.end = int(qint64(lengthInFrames) * (i + 1) / segmentCount);
+            // The first segment writes directly in the published buffer, the others are stitched once done
+            segment.levels = i == 0 ? streamLevels : std::make_shared<AudioLevelsBuffer>((segment.end - segment.start) * channels);
+            segments.push_back(segment);
         }
-        aProd->set("video_index", -1);
-        aProd->set("audio_index", stream);
-        aProd->set("vstream", -1);
-        aProd->set("astream", streamIndex);
-        Mlt::Filter chans(pCore->getProjectProfile(), "audiochannels");
-        Mlt::Filter converter(pCore->getProjectProfile(), "audioconvert");
-        Mlt::Filter levels(pCore->getProjectProfile(), "audiolevel");
-        aProd->attach(chans);
-        aProd->attach(converter);
-        aProd->attach(levels);
-        std::unique_ptr<Mlt::Producer> audioProducer;
-        audioProducer.reset(aProd);
+    }
 
-        double framesPerSecond = audioProducer->get_fps();
-        mlt_audio_format audioFormat = mlt_audio_s16;
-        QStringList keys;
-        keys.reserve(channels);
-        for (int i = 0; i < channels; i++) {
-            keys << "meta.media.audio_level." + QString::number(i);
+    if (!segments.empty() && !m_isCanceled) {
+        m_framesToProcess = lengthInFrames * int(pending.size());
+        m_updateTime.start();
+        // Segments are only handed to the task pool if it has a free thread, the others are processed here
+        QSemaphore finished;
+        int helpers = 0;
+        std::vector<size_t> localSegments;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            LevelsSegment *segment = &segments[i];
+            if (i > 0 && parallel && pCore->taskManager.tryStartHelper([this, segment, &finished]() {
+                    extractSegment(*segment, false);
+                    finished.release();
+                })) {
+                helpers++;
+            } else {
+                localSegments.push_back(i);
+            }
         }
-        uint maxLevel = 1;
-        QElapsedTimer updateTime;
-        updateTime.start();
-        for (int z = 0; z < lengthInFrames && !m_isCanceled; ++z) {
-            int val = int(100.0 * z / lengthInFrames);
-            if (m_progress != val) {
-                m_progress = val;
-                QMetaObject::invokeMethod(m_object, "updateJobProgress");
+        for (size_t i : localSegments) {
+            if (m_isCanceled) {
+                break;
             }
-            QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
-            if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
-                int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
-                mltFrame->get_audio(audioFormat, frequency, channels, samples);
-                for (int channel = 0; channel < channels; ++channel) {
-                    uint lev = 256 * qMin(mltFrame->get_double(keys.at(channel).toUtf8().constData()) * 0.9, 1.0);
-                    mltLevels << lev;
-                    // double lev = mltFrame->get_double(keys.at(channel).toUtf8().constData());
-                    // mltLevels << lev;
-                    maxLevel = qMax(lev, maxLevel);
-                }
-            } else if (!mltLevels.isEmpty()) {
-                for (int channel = 0; channel < channels; channel++) {
-                    mltLevels << mltLevels.last();
+            extractSegment(segments[i], true);
+        }
+        // Wait for the segments processed in other threads
+        while (helpers > 0 && !finished.tryAcquire(helpers, 200)) {
+            updateProgress();
+        }
+        for (const LevelsSegment &segment : segments) {
+            if (!segment.valid) {
+                for (const PendingStream &streamLevels : pending) {
+                    clearLevels(binClip, streamLevels.stream);
                 }
-            }
-            // Incrementally update the audio levels every 3 seconds.
-            if (updateTime.elapsed() > 3000 && !m_isCanceled) {
-                updateTime.restart();
-                QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-                producer = binClip->originalProducer();
-                producer->lock();
-                QString key = QStringLiteral("_kdenlive:audio%1").arg(stream);
-                producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-                producer->unlock();
-                producer.reset();
-                QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+                QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection,
+                                          Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", res)), Q_ARG(int, int(KMessageWidget::Warning)));
+                return;
             }
         }
+    }
 
-        /*// Normalize
-        for (double &v : mltLevels) {
-            m_audioLevels << uchar(255 * v / maxLevel);
-        }*/
-        if (m_isCanceled) {
-            mltLevels.clear();
-            m_progress = 100;
-            QMetaObject::invokeMethod(m_object, "updateJobProgress");
+    /*// Normalize
+    for (double &v : mltLevels) {
+        m_audioLevels << uchar(255 * v / maxLevel);
+    }*/
+    if (m_isCanceled) {
+        for (const PendingStream &streamLevels : pending) {
+            clearLevels(binClip, streamLevels.stream);
+        }
+        m_progress = 100;
+        QMetaObject::invokeMethod(m_object, "updateJobProgress");
+    } else {
+        // Stitch the segments of each stream
+        std::vector<uint> maxLevels(pending.size(), 1);
+        for (const LevelsSegment &segment : segments) {
+            const std::shared_ptr<AudioLevelsBuffer> &mltLevels = pending.at(size_t(segment.owner)).levels;
+            maxLevels[size_t(segment.owner)] = qMax(maxLevels.at(size_t(segment.owner)), segment.maxLevel);
+            stitchSegment(*mltLevels, segment.levels == mltLevels ? nullptr : segment.levels.get(), segment.start, segment.end, segment.channels);
         }
-        if (mltLevels.size() > 0) {
-            QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
+        for (size_t ix = 0; ix < pending.size(); ++ix) {
+            const PendingStream &streamLevels = pending.at(ix);
+            if (streamLevels.levels->isEmpty()) {
+                continue;
+            }
+            auto pyramid = std::make_shared<AudioLevelsPyramid>(streamLevels.levels, streamLevels.channels);
             producer = binClip->originalProducer();
             producer->lock();
-            QString key = QStringLiteral("_kdenlive:audio%1").arg(stream);
-            QString key2 = QStringLiteral("kdenlive:audio_max%1").arg(stream);
-            producer->set(key2.toUtf8().constData(), int(maxLevel));
-            producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
+            QString key2 = QStringLiteral("kdenlive:audio_max%1").arg(streamLevels.stream);
+            producer->set(key2.toUtf8().constData(), int(maxLevels.at(ix)));
             producer->unlock();
             producer.reset();
-            // qDebug()<<"=== FINISHED PRODUCING AUDIO FOR: "<<key<<", SIZE: "<<levelsCopy->size();
+            storeLevels(binClip, streamLevels.stream, streamLevels.levels, pyramid);
             m_progress = 100;
             QMetaObject::invokeMethod(m_object, "updateJobProgress");
-            // Put into an image for caching.
-            int count = mltLevels.size();
-            QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
-            int n = image.width() * image.height();
-            for (int i = 0; i < n; i++) {
-                QRgb p;
-                if ((4 * i + 3) < count) {
-                    p = qRgba(mltLevels.at(4 * i), mltLevels.at(4 * i + 1), mltLevels.at(4 * i + 2), mltLevels.at(4 * i + 3));
-                } else {
-                    int last = mltLevels.last();
-                    int r = (4 * i + 0) < count ? mltLevels.at(4 * i + 0) : last;
-                    int g = (4 * i + 1) < count ? mltLevels.at(4 * i + 1) : last;
-                    int b = (4 * i + 2) < count ? mltLevels.at(4 * i + 2) : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / channels, i % channels, p);
-            }
-            image.save(cachePath);
+            // Store the levels and their decimations for caching.
+            pyramid->save(streamLevels.cachePath);
             audioCreated = true;
             QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
         }
@@ -256,3 +316,96 @@ void AudioLevelsTask::run()
     }
     QMetaObject::invokeMethod(m_object, "updateJobProgress");
 }
+
+bool AudioLevelsTask::extractSegment(LevelsSegment &segment, bool reportProgress)
+{
+    Mlt::Producer *aProd = new Mlt::Producer(pCore->getProjectProfile(), m_service.toUtf8().constData(), m_resource.toUtf8().constData());
+    if (!aProd->is_valid()) {
+        delete aProd;
+        segment.valid = false;
+        return false;
+    }
+    aProd->set("video_index", -1);
+    aProd->set("audio_index", segment.stream);
+    aProd->set("vstream", -1);
+    aProd->set("astream", segment.streamIndex);
+    Mlt::Filter chans(pCore->getProjectProfile(), "audiochannels");
+    Mlt::Filter converter(pCore->getProjectProfile(), "audioconvert");
+    Mlt::Filter levels(pCore->getProjectProfile(), "audiolevel");
+    aProd->attach(chans);
+    aProd->attach(converter);
+    aProd->attach(levels);
+    std::unique_ptr<Mlt::Producer> audioProducer;
+    audioProducer.reset(aProd);
+    if (segment.start > 0) {
+        audioProducer->seek(segment.start);
+    }
+
+    double framesPerSecond = audioProducer->get_fps();
+    mlt_audio_format audioFormat = mlt_audio_s16;
+    int frequency = m_frequency;
+    int channels = segment.channels;
+    QList<QByteArray> keys;
+    keys.reserve(channels);
+    for (int i = 0; i < channels; i++) {
+        keys << QByteArrayLiteral("meta.media.audio_level.") + QByteArray::number(i);
+    }
+    AudioLevelsBuffer &mltLevels = *segment.levels;
+    for (int z = segment.start; z < segment.end && !m_isCanceled; ++z) {
+        if (reportProgress) {
+            updateProgress();
+        }
+        QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
+        if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
+            int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
+            mltFrame->get_audio(audioFormat, frequency, channels, samples);
+            for (int channel = 0; channel < segment.channels; ++channel) {
+                uint lev = 256 * qMin(mltFrame->get_double(keys.at(channel).constData()) * 0.9, 1.0);
+                mltLevels.append(uint8_t(lev));
+                segment.maxLevel = qMax(lev, segment.maxLevel);
+            }
+        } else {
+            // Keep one value per frame so that the segments are stitched at the right position
+            uint8_t last = mltLevels.isEmpty() ? 0 : mltLevels.last();
+            for (int channel = 0; channel < segment.channels; channel++) {
+                mltLevels.append(last);
+            }
+        }
+        m_processedFrames.fetchAndAddRelaxed(1);
+    }
+    return true;
+}
+
+void AudioLevelsTask::stitchSegment(AudioLevelsBuffer &levels, const AudioLevelsBuffer *segment, int start, int end, int channels)
+{
+    // Values past the capacity would be dropped
+    const int first = qMin(start * channels, levels.capacity());
+    const int last = qMin(end * channels, levels.capacity());
+    while (levels.size() < first) {
+        levels.append(levels.isEmpty() ? 0 : levels.last());
+    }
+    if (segment != nullptr) {
+        const int count = qMin(segment->size(), last - first);
+        for (int i = levels.size() - first; i < count; i++) {
+            levels.append(segment->at(i));
+        }
+    }
+    while (levels.size() < last) {
+        levels.append(levels.isEmpty() ? 0 : levels.last());
+    }
+}
+
+void AudioLevelsTask::updateProgress()
+{
+    int val = m_framesToProcess > 0 ? int(100.0 * m_processedFrames.loadRelaxed() / m_framesToProcess) : 0;
+    if (m_progress != val) {
+        m_progress = val;
+        QMetaObject::invokeMethod(m_object, "updateJobProgress");
+    }
+    // Incrementally refresh the waveforms, first after 1 second then every 3 seconds.
+    if (m_updateTime.elapsed() > m_updateInterval && !m_isCanceled) {
+        m_updateTime.restart();
+        m_updateInterval = 3000;
+        QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+    }
+}
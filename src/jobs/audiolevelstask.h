@@ -10,16 +10,44 @@
 
 #include "abstracttask.h"
 
+#include <QElapsedTimer>
 #include <QRunnable>
 #include <QObject>
 
+class AudioLevelsBuffer;
+
 class AudioLevelsTask : public AbstractTask
 {
 public:
     AudioLevelsTask(const ObjectId &owner, QObject* object);
     static void start(const ObjectId &owner, QObject* object, bool force = false);
+    /** @brief Append the levels of the segment covering frames [start, end[ to the levels of the stream, so that they start at frame @param start.
+     *  A short previous segment is padded with its last value, values already written past @param start are skipped and the segment is
+     *  padded or truncated to end at frame @param end.
+     *  @param segment the levels of the segment, nullptr if they were written in @param levels directly
+     */
+    static void stitchSegment(AudioLevelsBuffer &levels, const AudioLevelsBuffer *segment, int start, int end, int channels);
 
 protected:
     void run() override;
 
+private:
+    struct LevelsSegment;
+    struct PendingStream;
+    QString m_service;
+    QString m_resource;
+    int m_frequency{48000};
+    /** @brief Frames decoded by all segments, used to report progress */
+    QAtomicInt m_processedFrames{0};
+    int m_framesToProcess{0};
+    QElapsedTimer m_updateTime;
+    int m_updateInterval{1000};
+    /** @brief Shortest part of a stream decoded on its own producer when generating in parallel, in seconds */
+    static constexpr int MinSegmentSeconds = 5 * 60;
+    /** @brief Decode the frames of @param segment and append their levels to its buffer, returns false if the file cannot be opened
+     *  @param reportProgress true if called from the task thread, which is responsible for progress and waveform updates
+     */
+    bool extractSegment(LevelsSegment &segment, bool reportProgress);
+    /** @brief Update the task progress and periodically refresh the partial waveforms */
+    void updateProgress();
 };
@@ -12,6 +12,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "doc/kthumb.h"
 #include "kdenlivesettings.h"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 
 #include "xml/xml.hpp"
 #include <KLocalizedString>
@@ -51,7 +52,7 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
 {
     // Fetch thumbnail
     if (binClip->clipType() != ClipType::Audio) {
-        std::unique_ptr<Mlt::Producer> thumbProd(nullptr);
+        std::shared_ptr<Mlt::Producer> thumbProd(nullptr);
         int duration = m_out > 0 ? m_out - m_in : binClip->getFramePlaytime();
         std::set<int> frames;
         int steps = qCeil(qMax(pCore->getCurrentFps(), double(duration) / m_thumbsCount));
@@ -60,10 +61,12 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
             frames.insert(pos);
             pos = m_in + (steps * i);
         }
-        int size = int(frames.size());
-        int count = 0;
         const QString clipId = QString::number(m_owner.itemId);
-        for (int i : frames) {
+        // Only extract the frames that are not cached yet, looked up all at once
+        const std::vector<int> missing = ThumbnailCache::get()->missingThumbnails(clipId, std::vector<int>(frames.begin(), frames.end()));
+        int size = int(missing.size());
+        int count = 0;
+        for (int i : missing) {
             int val = 100 * count / size;
             if (m_progress != val) {
                 m_progress = val;
@@ -73,11 +76,8 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
             if (m_isCanceled || pCore->taskManager.isBlocked()) {
                 break;
             }
-            if (ThumbnailCache::get()->hasThumbnail(clipId, i)) {
-                continue;
-            }
             if (thumbProd == nullptr) {
-                thumbProd = binClip->getThumbProducer();
+                thumbProd = ThumbnailProducerPool::get()->acquire(binClip);
             }
             if (thumbProd == nullptr) {
                 // Thumb producer not available
@@ -15,6 +15,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kdenlivesettings.h"
 #include "mltcontroller/clipcontroller.h"
 #include "project/dialogs/slideshowclip.h"
+#include "utils/mediaprobecache.hpp"
 #include "utils/thumbnailcache.hpp"
 
 #include "xml/xml.hpp"
@@ -51,6 +52,22 @@ ClipLoadTask::ClipLoadTask(const ObjectId &owner, const QDomElement &xml, bool t
 
 ClipLoadTask::~ClipLoadTask() {}
 
+namespace {
+// Collect the properties set by probing an avformat producer, to restore them without opening the file on next load
+MediaProbeCache::Properties probedProperties(Mlt::Producer &producer)
+{
+    static const QByteArrayList probedNames = {"length", "seekable", "video_index", "audio_index", "set.test_image", "source_fps"};
+    MediaProbeCache::Properties properties;
+    for (int i = 0; i < producer.count(); ++i) {
+        const QByteArray name(producer.get_name(i));
+        if (name.startsWith("meta.") || probedNames.contains(name)) {
+            properties.insert(name, QByteArray(producer.get(i)));
+        }
+    }
+    return properties;
+}
+} // namespace
+
 void ClipLoadTask::start(const ObjectId &owner, const QDomElement &xml, bool thumbOnly, int in, int out, QObject *object, bool force,
                          const std::function<void()> &readyCallBack)
 {
@@ -327,6 +344,8 @@ void ClipLoadTask::run()
         service.clear();
     }
     std::shared_ptr<Mlt::Producer> producer;
+    MediaProbeCache::Key probeKey;
+    bool cachedProbe = false;
     switch (type) {
     case ClipType::Color:
         producer = loadResource(resource, QStringLiteral("color:"));
@@ -460,7 +479,26 @@ void ClipLoadTask::run()
             if (service == QLatin1String("avformat-novalidate:")) {
                 service = QStringLiteral("avformat:");
             }
-            producer = loadResource(resource, service);
+            if (service == QLatin1String("avformat:") && !pCore->currentDoc()->useExternalProxy()) {
+                probeKey = MediaProbeCache::key(resource, Xml::getXmlProperty(m_xml, QStringLiteral("kdenlive:file_hash")));
+                MediaProbeCache::Properties probed;
+                if (MediaProbeCache::get()->lookup(probeKey, probed)) {
+                    // File did not change since it was last probed, MLT will only open it when the first frame is requested
+                    producer = loadResource(resource, QStringLiteral("avformat-novalidate:"));
+                    for (auto it = probed.cbegin(); it != probed.cend(); ++it) {
+                        producer->set(it.key().constData(), it.value().constData());
+                    }
+                    producer->set("out", producer->get_int("length") - 1);
+                    if (producer->get_int("video_index") > -1) {
+                        // ClipController only sets this for clips loaded through the avformat service
+                        producer->set("mute_on_pause", 0);
+                    }
+                    cachedProbe = true;
+                }
+            }
+            if (!cachedProbe) {
+                producer = loadResource(resource, service);
+            }
         } else {
             producer = std::make_shared<Mlt::Producer>(pCore->getProjectProfile(), nullptr, resource.toUtf8().constData());
         }
@@ -476,6 +514,10 @@ void ClipLoadTask::run()
         if (producer) {
             producer.reset();
         }
+        if (probeKey.isValid()) {
+            // Don't reuse the probe of a file that cannot be loaded
+            MediaProbeCache::get()->remove(resource);
+        }
         auto binClip = pCore->projectItemModel()->getClipByBinID(QString::number(m_owner.itemId));
         if (binClip && !binClip->isReloading) {
             QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection,
@@ -489,6 +531,9 @@ void ClipLoadTask::run()
     const QString mltService = producer->get("mlt_service");
     if (producer->get_length() == INT_MAX && producer->get("eof") == QLatin1String("loop")) {
         // This is a live source or broken clip
+        if (probeKey.isValid()) {
+            MediaProbeCache::get()->remove(resource);
+        }
         // Check for AV
         ClipType::ProducerType cType = type;
         if (producer) {
@@ -665,7 +710,9 @@ void ClipLoadTask::run()
             }
         }
         // Check audio / video
-        producer->probe();
+        if (!cachedProbe) {
+            producer->probe();
+        }
         hasAudio = producer->get_int("audio_index") > -1;
         hasVideo = producer->get_int("video_index") > -1;
         if (hasAudio) {
@@ -738,6 +785,9 @@ void ClipLoadTask::run()
                 fps = producer->get_double("source_fps");
             }
         }
+        if (!cachedProbe && probeKey.isValid() && !m_isCanceled.loadAcquire()) {
+            MediaProbeCache::get()->store(probeKey, probedProperties(*producer.get()));
+        }
     }
     if (fps <= 0 && type == ClipType::Unknown) {
         // something wrong, maybe audio file with embedded image
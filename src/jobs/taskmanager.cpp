@@ -13,6 +13,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kdenlivesettings.h"
 #include "macros.hpp"
 #include "undohelper.hpp"
+#include "utils/mediaprobecache.hpp"
 
 #include <KMessageWidget>
 #include <QFuture>
@@ -44,6 +45,19 @@ void TaskManager::updateConcurrency()
     m_transcodePool.setMaxThreadCount(KdenliveSettings::proxythreads());
 }
 
+int TaskManager::threadBudget() const
+{
+    return m_taskPool.maxThreadCount();
+}
+
+bool TaskManager::tryStartHelper(std::function<void()> work)
+{
+    if (m_blockUpdates) {
+        return false;
+    }
+    return m_taskPool.tryStart(std::move(work));
+}
+
 void TaskManager::discardJobs(const ObjectId &owner, AbstractTask::JOBTYPE type, bool softDelete, const QVector<AbstractTask::JOBTYPE> exceptions)
 {
     if (m_blockUpdates) {
@@ -206,6 +220,10 @@ void TaskManager::taskDone(int cid, AbstractTask *task)
     m_tasksListLock.unlock();
     // Set jobs count
     Q_EMIT jobCount(count);
+    if (count == 0) {
+        // All clips are loaded, persist their probed properties
+        MediaProbeCache::get()->save();
+    }
     task->deleteLater();
 }
 
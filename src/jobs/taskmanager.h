@@ -17,6 +17,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QReadWriteLock>
 #include <QThreadPool>
 #include <QUuid>
+#include <functional>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -65,6 +66,15 @@ public:
     /** @brief Update the number of concurrent jobs allowed */
     void updateConcurrency();
 
+    /** @brief The maximum number of tasks running at the same time */
+    int threadBudget() const;
+
+    /** @brief Run some work of a running task on the task pool, only if a thread is free right now.
+     *  This lets a task split its work without exceeding the concurrency budget.
+     *  @returns false if no thread is available, the caller should then do the work itself
+     */
+    bool tryStartHelper(std::function<void()> work);
+
     /** @brief We are aborting all tasks and don't want them to send any updates */
     bool isBlocked() const;
 
@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audioLevelsBuffer.h"
+
+#include <QDebug>
+#include <cstring>
+
+AudioLevelsBuffer::AudioLevelsBuffer(int capacity)
+    : m_capacity(qMax(0, capacity))
+    , m_chunks(size_t((m_capacity + ChunkSize - 1) / ChunkSize))
+{
+}
+
+AudioLevelsBuffer::AudioLevelsBuffer(const QVector<uint8_t> &levels)
+    : AudioLevelsBuffer(int(levels.size()))
+{
+    for (int offset = 0; offset < levels.size(); offset += ChunkSize) {
+        int count = qMin(ChunkSize, int(levels.size()) - offset);
+        auto &chunk = m_chunks[size_t(offset >> ChunkBits)];
+        chunk.reset(new uint8_t[ChunkSize]);
+        memcpy(chunk.get(), levels.constData() + offset, size_t(count));
+    }
+    m_size.store(int(levels.size()), std::memory_order_release);
+}
+
+void AudioLevelsBuffer::append(uint8_t value)
+{
+    int index = m_size.load(std::memory_order_relaxed);
+    if (index >= m_capacity) {
+        qWarning() << "Audio levels buffer full, dropping value";
+        return;
+    }
+    auto &chunk = m_chunks[size_t(index >> ChunkBits)];
+    if (!chunk) {
+        chunk.reset(new uint8_t[ChunkSize]);
+    }
+    chunk[index & (ChunkSize - 1)] = value;
+    // Publish the value (and a newly allocated chunk) to the readers
+    m_size.store(index + 1, std::memory_order_release);
+}
+
+int AudioLevelsBuffer::size() const
+{
+    return m_size.load(std::memory_order_acquire);
+}
+
+bool AudioLevelsBuffer::isEmpty() const
+{
+    return size() == 0;
+}
+
+int AudioLevelsBuffer::capacity() const
+{
+    return m_capacity;
+}
+
+uint8_t AudioLevelsBuffer::last() const
+{
+    return at(size() - 1);
+}
+
+const uint8_t *AudioLevelsBuffer::chunkData(int chunk) const
+{
+    return m_chunks[size_t(chunk)].get();
+}
+
+QVector<uint8_t> AudioLevelsBuffer::toVector() const
+{
+    int count = size();
+    QVector<uint8_t> result(count);
+    for (int offset = 0; offset < count; offset += ChunkSize) {
+        memcpy(result.data() + offset, chunkData(offset >> ChunkBits), size_t(qMin(ChunkSize, count - offset)));
+    }
+    return result;
+}
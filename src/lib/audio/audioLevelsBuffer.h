@@ -0,0 +1,53 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+  Append-only storage for audio levels, filled by a single writer while
+  other threads read the already published values.
+
+  Values are stored in fixed size chunks that are never moved once
+  allocated, so appending does not copy the existing data and readers
+  never need to take a lock: they only access indexes below size().
+  */
+class AudioLevelsBuffer
+{
+public:
+    static constexpr int ChunkBits = 16;
+    static constexpr int ChunkSize = 1 << ChunkBits;
+
+    /** @brief Create an empty buffer that can hold up to @param capacity values */
+    explicit AudioLevelsBuffer(int capacity);
+    /** @brief Create a complete buffer holding a copy of @param levels */
+    explicit AudioLevelsBuffer(const QVector<uint8_t> &levels);
+
+    /** @brief Append a value. Must only be called from one thread, values past the capacity are dropped */
+    void append(uint8_t value);
+    /** @brief Number of values published so far, can be called from any thread */
+    int size() const;
+    bool isEmpty() const;
+    int capacity() const;
+    /** @brief Returns the value at @param index, which must be lower than a previously read size() */
+    uint8_t at(int index) const { return m_chunks[size_t(index >> ChunkBits)][index & (ChunkSize - 1)]; }
+    /** @brief Returns the last published value, the buffer must not be empty */
+    uint8_t last() const;
+    /** @brief Returns the start of chunk @param chunk, which holds up to ChunkSize values */
+    const uint8_t *chunkData(int chunk) const;
+    /** @brief Returns a copy of the published values */
+    QVector<uint8_t> toVector() const;
+
+private:
+    int m_capacity;
+    /** @brief Sized on construction and never resized, so the chunk pointers stay valid for readers */
+    std::vector<std::unique_ptr<uint8_t[]>> m_chunks;
+    std::atomic<int> m_size{0};
+};
@@ -0,0 +1,263 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audioLevelsPyramid.h"
+#include "audioLevelsBuffer.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QtMath>
+
+namespace {
+// "KDLV" in ASCII, followed by the format version
+constexpr quint32 cacheMagic = 0x4b444c56;
+constexpr quint32 cacheVersion = 1;
+// Magic, version, channels, base size and level count
+constexpr qint64 cacheHeaderSize = 5 * sizeof(quint32);
+
+/** @brief Number of levels built above a base level of @param frames frames, each halving the previous one */
+quint32 decimationCount(quint32 frames)
+{
+    quint32 count = 0;
+    while (frames > 1) {
+        frames = (frames + 1) / 2;
+        count++;
+    }
+    return count;
+}
+} // namespace
+
+AudioLevelsPyramid::AudioLevelsPyramid(std::shared_ptr<const AudioLevelsBuffer> levels, int channels)
+    : m_channels(qMax(1, channels))
+    , m_base(std::move(levels))
+{
+    buildLevels();
+}
+
+void AudioLevelsPyramid::buildLevels()
+{
+    m_levels.clear();
+    int blocks = frames();
+    if (blocks < 2) {
+        return;
+    }
+    // The first decimation reads from the base buffer, the following ones from the previous level
+    Level first;
+    int count = (blocks + 1) / 2;
+    first.min.resize(count * m_channels);
+    first.max.resize(count * m_channels);
+    first.rms.resize(count * m_channels);
+    for (int b = 0; b < count; ++b) {
+        int ix1 = 2 * b * m_channels;
+        int ix2 = 2 * b + 1 < blocks ? ix1 + m_channels : ix1;
+        for (int c = 0; c < m_channels; ++c) {
+            uint8_t v1 = m_base->at(ix1 + c);
+            uint8_t v2 = m_base->at(ix2 + c);
+            int ix = b * m_channels + c;
+            first.min[ix] = qMin(v1, v2);
+            first.max[ix] = qMax(v1, v2);
+            first.rms[ix] = uint8_t(qMin(255., std::sqrt((double(v1) * v1 + double(v2) * v2) / 2.)));
+        }
+    }
+    m_levels.push_back(std::move(first));
+    blocks = count;
+    const QVector<uint8_t> *srcMin = &m_levels.back().min;
+    const QVector<uint8_t> *srcMax = &m_levels.back().max;
+    const QVector<uint8_t> *srcRms = &m_levels.back().rms;
+    while (blocks > 1) {
+        int count = (blocks + 1) / 2;
+        Level level;
+        level.min.resize(count * m_channels);
+        level.max.resize(count * m_channels);
+        level.rms.resize(count * m_channels);
+        for (int b = 0; b < count; ++b) {
+            int first = 2 * b * m_channels;
+            // The last block may only cover one source block
+            int second = 2 * b + 1 < blocks ? first + m_channels : first;
+            for (int c = 0; c < m_channels; ++c) {
+                int ix = b * m_channels + c;
+                level.min[ix] = qMin(srcMin->at(first + c), srcMin->at(second + c));
+                level.max[ix] = qMax(srcMax->at(first + c), srcMax->at(second + c));
+                double r1 = srcRms->at(first + c);
+                double r2 = srcRms->at(second + c);
+                level.rms[ix] = uint8_t(qMin(255., std::sqrt((r1 * r1 + r2 * r2) / 2.)));
+            }
+        }
+        m_levels.push_back(std::move(level));
+        const Level &last = m_levels.back();
+        srcMin = &last.min;
+        srcMax = &last.max;
+        srcRms = &last.rms;
+        blocks = count;
+    }
+}
+
+int AudioLevelsPyramid::channels() const
+{
+    return m_channels;
+}
+
+int AudioLevelsPyramid::frames() const
+{
+    return m_base ? m_base->size() / m_channels : 0;
+}
+
+int AudioLevelsPyramid::levelCount() const
+{
+    return int(m_levels.size()) + 1;
+}
+
+const std::shared_ptr<const AudioLevelsBuffer> &AudioLevelsPyramid::baseLevels() const
+{
+    return m_base;
+}
+
+int AudioLevelsPyramid::levelForSpan(int span) const
+{
+    if (span < 2 || m_levels.empty()) {
+        return -1;
+    }
+    // Level k has blocks of 2^(k+1) frames, use the largest block not exceeding the span
+    int level = 0;
+    while ((2 << (level + 1)) <= span && level + 1 < int(m_levels.size())) {
+        level++;
+    }
+    return level;
+}
+
+void AudioLevelsPyramid::visit(int channel, int start, int end, QVector<uint8_t> Level::*values, const std::function<void(uint8_t, int)> &visitor) const
+{
+    int level = levelForSpan(end - start);
+    if (level >= 0) {
+        // Only use the blocks fully contained in the range, the partial blocks at both ends are read from the base level
+        const int shift = level + 1;
+        const int blockFrames = 1 << shift;
+        const int firstBlock = (start + blockFrames - 1) >> shift;
+        const int lastBlock = end >> shift;
+        if (firstBlock < lastBlock) {
+            for (int f = start; f < firstBlock << shift; ++f) {
+                visitor(m_base->at(f * m_channels + channel), 1);
+            }
+            const QVector<uint8_t> &blocks = m_levels.at(size_t(level)).*values;
+            for (int b = firstBlock; b < lastBlock; ++b) {
+                visitor(blocks.at(b * m_channels + channel), blockFrames);
+            }
+            start = lastBlock << shift;
+        }
+    }
+    for (int f = start; f < end; ++f) {
+        visitor(m_base->at(f * m_channels + channel), 1);
+    }
+}
+
+uint8_t AudioLevelsPyramid::peak(int channel, int start, int end) const
+{
+    start = qMax(0, start);
+    end = qMin(end, frames());
+    if (channel < 0 || channel >= m_channels || start >= end) {
+        return 0;
+    }
+    uint8_t result = 0;
+    visit(channel, start, end, &Level::max, [&result](uint8_t value, int) { result = qMax(result, value); });
+    return result;
+}
+
+uint8_t AudioLevelsPyramid::minimum(int channel, int start, int end) const
+{
+    start = qMax(0, start);
+    end = qMin(end, frames());
+    if (channel < 0 || channel >= m_channels || start >= end) {
+        return 0;
+    }
+    uint8_t result = 255;
+    visit(channel, start, end, &Level::min, [&result](uint8_t value, int) { result = qMin(result, value); });
+    return result;
+}
+
+uint8_t AudioLevelsPyramid::rms(int channel, int start, int end) const
+{
+    start = qMax(0, start);
+    end = qMin(end, frames());
+    if (channel < 0 || channel >= m_channels || start >= end) {
+        return 0;
+    }
+    double sum = 0.;
+    int count = 0;
+    // A block holds the RMS of its frames, weight it by its frame count
+    visit(channel, start, end, &Level::rms, [&sum, &count](uint8_t value, int frames) {
+        sum += double(value) * value * frames;
+        count += frames;
+    });
+    return uint8_t(qMin(255., std::sqrt(sum / count)));
+}
+
+bool AudioLevelsPyramid::save(const QString &path) const
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write audio levels cache" << path;
+        return false;
+    }
+    QDataStream out(&file);
+    int baseSize = m_base->size();
+    out << cacheMagic << cacheVersion << quint32(m_channels) << quint32(baseSize) << quint32(m_levels.size());
+    for (int offset = 0; offset < baseSize; offset += AudioLevelsBuffer::ChunkSize) {
+        out.writeRawData(reinterpret_cast<const char *>(m_base->chunkData(offset >> AudioLevelsBuffer::ChunkBits)),
+                         qMin(AudioLevelsBuffer::ChunkSize, baseSize - offset));
+    }
+    for (const Level &level : m_levels) {
+        out.writeRawData(reinterpret_cast<const char *>(level.min.constData()), level.min.size());
+        out.writeRawData(reinterpret_cast<const char *>(level.max.constData()), level.max.size());
+        out.writeRawData(reinterpret_cast<const char *>(level.rms.constData()), level.rms.size());
+    }
+    if (out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+std::shared_ptr<AudioLevelsPyramid> AudioLevelsPyramid::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    QDataStream in(&file);
+    quint32 magic, version, channels, baseSize, levelCount;
+    in >> magic >> version >> channels >> baseSize >> levelCount;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic || version != cacheVersion || channels == 0 || baseSize % channels != 0 ||
+        qint64(baseSize) > file.size() - cacheHeaderSize || levelCount != decimationCount(baseSize / channels)) {
+        qWarning() << "Invalid audio levels cache" << path;
+        return nullptr;
+    }
+    std::shared_ptr<AudioLevelsPyramid> pyramid(new AudioLevelsPyramid());
+    pyramid->m_channels = int(channels);
+    QVector<uint8_t> base(int(baseSize));
+    if (in.readRawData(reinterpret_cast<char *>(base.data()), int(baseSize)) != int(baseSize)) {
+        return nullptr;
+    }
+    pyramid->m_base = std::make_shared<AudioLevelsBuffer>(base);
+    int blocks = int(baseSize / channels);
+    for (quint32 i = 0; i < levelCount; ++i) {
+        blocks = (blocks + 1) / 2;
+        int size = blocks * int(channels);
+        Level level;
+        level.min.resize(size);
+        level.max.resize(size);
+        level.rms.resize(size);
+        if (in.readRawData(reinterpret_cast<char *>(level.min.data()), size) != size ||
+            in.readRawData(reinterpret_cast<char *>(level.max.data()), size) != size ||
+            in.readRawData(reinterpret_cast<char *>(level.rms.data()), size) != size) {
+            qWarning() << "Truncated audio levels cache" << path;
+            return nullptr;
+        }
+        pyramid->m_levels.push_back(std::move(level));
+    }
+    return pyramid;
+}
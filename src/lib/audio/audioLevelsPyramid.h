@@ -0,0 +1,71 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class AudioLevelsBuffer;
+
+/**
+  Multi-resolution store for the audio levels of a clip stream.
+
+  Level 0 holds the levels produced by the audiolevel filter, one value
+  per channel and per frame, interleaved. Each following level halves the
+  resolution and keeps the minimum, maximum and RMS of the two blocks it
+  covers, so that drawing a zoomed out waveform only reads a few values per
+  pixel instead of every frame.
+  */
+class AudioLevelsPyramid
+{
+public:
+    /** @brief Build the pyramid over complete @param levels, which are shared and not copied */
+    AudioLevelsPyramid(std::shared_ptr<const AudioLevelsBuffer> levels, int channels);
+
+    int channels() const;
+    /** @brief Number of frames in the base level */
+    int frames() const;
+    /** @brief Number of levels, including the base level */
+    int levelCount() const;
+    /** @brief The base (one value per frame and channel) levels */
+    const std::shared_ptr<const AudioLevelsBuffer> &baseLevels() const;
+
+    /** @brief Returns the highest level of @param channel in the frame range [start, end[ */
+    uint8_t peak(int channel, int start, int end) const;
+    /** @brief Returns the lowest level of @param channel in the frame range [start, end[ */
+    uint8_t minimum(int channel, int start, int end) const;
+    /** @brief Returns the RMS of the levels of @param channel in the frame range [start, end[ */
+    uint8_t rms(int channel, int start, int end) const;
+
+    /** @brief Write the pyramid to a binary cache file, returns false on error */
+    bool save(const QString &path) const;
+    /** @brief Load a pyramid from a binary cache file, returns nullptr if the file is missing or invalid */
+    static std::shared_ptr<AudioLevelsPyramid> load(const QString &path);
+
+private:
+    AudioLevelsPyramid() = default;
+    struct Level
+    {
+        QVector<uint8_t> min;
+        QVector<uint8_t> max;
+        QVector<uint8_t> rms;
+    };
+    int m_channels{0};
+    std::shared_ptr<const AudioLevelsBuffer> m_base;
+    /** @brief Decimated levels, m_levels[0] has one block per 2 frames */
+    std::vector<Level> m_levels;
+    /** @brief Build the decimated levels from the base level */
+    void buildLevels();
+    /** @brief Returns the level whose block size best matches a range of @param span frames */
+    int levelForSpan(int span) const;
+    /** @brief Call @param visitor with the @param values of @param channel covering the frame range [start, end[ and the number of frames of each.
+        Blocks partially outside of the range are replaced by the base levels of their frames inside it. */
+    void visit(int channel, int start, int end, QVector<uint8_t> Level::*values, const std::function<void(uint8_t, int)> &visitor) const;
+};
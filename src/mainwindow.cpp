@@ -2324,6 +2324,13 @@ void MainWindow::setRenderingFinished(const QString &url, int status, const QStr
     }
 }
 
+void MainWindow::setRenderingThroughput(int jobs, int fps)
+{
+    if (m_renderWidget) {
+        m_renderWidget->setRenderThroughput(jobs, fps);
+    }
+}
+
 void MainWindow::addProjectClip(const QString &url, const QString &folder)
 {
     if (pCore->currentDoc()) {
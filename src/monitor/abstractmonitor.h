@@ -7,6 +7,7 @@
 #pragma once
 
 #include "definitions.h"
+#include "scopes/sharedframe.h"
 
 #include <cstdint>
 
@@ -88,6 +89,8 @@ protected:
 Q_SIGNALS:
     /** @brief Send a frame for analysis or title background display. */
     void frameUpdated(const QImage &);
+    /** @brief Send the displayed frame to the colour scopes, without conversion or copy. */
+    void sharedFrameUpdated(const SharedFrame &);
     /** @brief This signal contains the audio of the current frame. */
     void audioSamplesSignal(const audioShortVector &, int, int, int);
     /** @brief Scopes are ready to receive a new frame. */
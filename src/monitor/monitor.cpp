@@ -33,6 +33,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "bin/model/markersortmodel.h"
 #include "monitormanager.h"
 #include "monitorproxy.h"
+#include "playbackprefetcher.h"
 #include "profiles/profilemodel.hpp"
 #include "project/projectmanager.h"
 #include "qmlmanager.h"
@@ -2114,6 +2115,8 @@ void Monitor::slotPreviewResource(const QString &path, const QString &title)
 
 void Monitor::resetProfile()
 {
+    // The consumer read ahead depends on the frame rate
+    m_prefetcher.reset();
     m_glMonitor->reloadProfile();
     m_glMonitor->rootObject()->setProperty("framesize", QRect(0, 0, m_glMonitor->profileSize().width(), m_glMonitor->profileSize().height()));
     // Update drop frame info
@@ -2263,7 +2266,11 @@ void Monitor::slotSetVolume(int volume)
 
 void Monitor::sendFrameForAnalysis(bool analyse)
 {
-    m_glMonitor->sendFrameForAnalysis = analyse;
+    m_sendFrameToScopes = analyse;
+    if (KdenliveSettings::gpu_accel()) {
+        // GPU frames are textures, the scopes get a copy of the rendered image
+        m_glMonitor->sendFrameForAnalysis = analyse;
+    }
 }
 
 void Monitor::updateAudioForAnalysis()
@@ -2274,14 +2281,50 @@ void Monitor::updateAudioForAnalysis()
 void Monitor::onFrameDisplayed(const SharedFrame &frame)
 {
     Q_EMIT m_monitorManager->frameDisplayed(frame);
+    if (m_sendFrameToScopes && !KdenliveSettings::gpu_accel() && m_glMonitor->acquireAnalyse()) {
+        // The scopes read the frame directly, it stays alive until the last scope is done
+        Q_EMIT sharedFrameUpdated(frame);
+    }
     if (m_id == Kdenlive::ProjectMonitor) {
         Q_EMIT pCore->updateMixerLevels(frame.get_position());
+        updatePrefetch(frame.get_position());
     }
     if (!m_glMonitor->checkFrameNumber(frame.get_position(), m_playAction->isActive())) {
         updatePlayAction(false);
     }
 }
 
+void Monitor::updatePrefetch(int position)
+{
+    if (!KdenliveSettings::playbackprefetch() || !m_playAction->isActive() || !qFuzzyCompare(m_glMonitor->playSpeed(), 1.)) {
+        if (m_prefetcher) {
+            m_prefetcher->reset();
+        }
+        m_nextPrefetch = -1;
+        return;
+    }
+    auto timeline = pCore->window()->getCurrentTimeline();
+    if (!timeline || !timeline->model() || m_glMonitor->producer() != timeline->model()->producer().get()) {
+        return;
+    }
+    const int fps = qRound(pCore->getCurrentFps());
+    // The consumer renders up to its buffer and prefill ahead of the displayed frame, see VideoWidget::reconfigure
+    const int guard = qMax(25, fps) + 6;
+    if (!m_prefetcher) {
+        m_prefetcher = std::make_unique<PlaybackPrefetcher>(6, guard);
+    }
+    m_prefetcher->frameShown(position);
+    if (position < m_nextPrefetch && position > m_nextPrefetch - fps) {
+        return;
+    }
+    // List the upcoming clips twice per second
+    m_nextPrefetch = position + qMax(1, fps / 2);
+    m_prefetcher->setFrameSize(pCore->getCurrentFrameSize() / qMax(1, KdenliveSettings::previewScaling()));
+    // Cuts closer than two read aheads are not prepared anymore
+    const int range = 2 * guard + qMax(1, KdenliveSettings::prefetchlookahead()) * fps;
+    m_prefetcher->prefetch(position, PlaybackPrefetcher::upcomingCuts(timeline->model(), position, range));
+}
+
 void Monitor::checkDrops()
 {
     int dropped = m_glMonitor->droppedFrames();
@@ -2295,6 +2338,10 @@ void Monitor::checkDrops()
         m_qmlManager->setProperty(QStringLiteral("dropped"), true);
         m_qmlManager->setProperty(QStringLiteral("fps"), QString::number(dropped, 'f', 2));
     }
+    if (m_prefetcher) {
+        m_qmlManager->setProperty(QStringLiteral("prefetchHits"), m_prefetcher->hits());
+        m_qmlManager->setProperty(QStringLiteral("prefetchMisses"), m_prefetcher->misses());
+    }
 }
 
 void Monitor::reloadProducer(const QString &id)
@@ -2704,6 +2751,9 @@ void Monitor::updateQmlDisplay(int currentOverlay)
     m_glMonitor->rootObject()->setProperty("showMarkers", currentOverlay & 0x04);
     bool showDropped = currentOverlay & 0x20;
     m_glMonitor->rootObject()->setProperty("showFps", showDropped);
+    if (m_id == Kdenlive::ProjectMonitor) {
+        m_glMonitor->rootObject()->setProperty("showPrefetch", KdenliveSettings::playbackprefetch());
+    }
     m_glMonitor->rootObject()->setProperty("showTimecode", currentOverlay & 0x02);
     if (m_id == Kdenlive::ClipMonitor) {
         m_glMonitor->rootObject()->setProperty("showAudiothumb", currentOverlay & 0x10);
@@ -37,6 +37,7 @@ class VideoWidget;
 class MonitorAudioLevel;
 class MonitorProxy;
 class MarkerSortModel;
+class PlaybackPrefetcher;
 
 namespace Mlt {
 class Profile;
@@ -234,6 +235,10 @@ private:
     MonitorSceneType m_lastMonitorSceneType;
     MonitorAudioLevel *m_audioMeterWidget;
     QTimer m_droppedTimer;
+    /** @brief Prepares the clips starting after the playhead, project monitor only */
+    std::unique_ptr<PlaybackPrefetcher> m_prefetcher;
+    /** @brief Position where the upcoming clips will be listed again */
+    int m_nextPrefetch{-1};
     double m_displayedFps;
     int m_speedIndex;
     QMetaObject::Connection m_switchConnection;
@@ -246,11 +251,15 @@ private:
     void buildSplitEffect(Mlt::Producer *original);
     /** @brief Returns true if monitor is currently visible (not in a tab or hidden)*/
     bool monitorVisible() const;
+    /** @brief Prepare the clips starting after @param position while the timeline is playing */
+    void updatePrefetch(int position);
     /** To easily get them when creating the right click menu */
     QAction *m_markIn;
     QAction *m_markOut;
     QUuid m_displayedUuid;
     bool m_dirty{false};
+    /** @brief True if the colour scopes want the displayed frames */
+    bool m_sendFrameToScopes{false};
 
 private Q_SLOTS:
     void slotSetThumbFrame();
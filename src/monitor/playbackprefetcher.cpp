@@ -0,0 +1,203 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "playbackprefetcher.h"
+#include "definitions.h"
+#include "timeline2/model/timelinemodel.hpp"
+
+#include <QMutexLocker>
+#include <QSet>
+#include <mlt++/MltFrame.h>
+#include <mlt++/MltProducer.h>
+
+namespace {
+constexpr int prefetchFrequency = 48000;
+constexpr int prefetchChannels = 2;
+} // namespace
+
+PlaybackPrefetcher::PlaybackPrefetcher(int framesPerCut, int guard, int threads)
+    : m_framesPerCut(qMax(1, framesPerCut))
+    , m_guard(qMax(0, guard))
+{
+    m_pool.setMaxThreadCount(qMax(1, threads));
+}
+
+PlaybackPrefetcher::~PlaybackPrefetcher()
+{
+    m_generation++;
+    m_pool.waitForDone();
+}
+
+void PlaybackPrefetcher::setFrameSize(const QSize &size)
+{
+    QMutexLocker lock(&m_mutex);
+    m_frameSize = size;
+}
+
+QVector<PlaybackPrefetcher::Cut> PlaybackPrefetcher::upcomingCuts(const std::shared_ptr<TimelineModel> &model, int position, int range)
+{
+    QVector<Cut> cuts;
+    for (bool audio : {false, true}) {
+        const QList<int> tracks = model->getTracksIds(audio);
+        for (int tid : tracks) {
+            const std::unordered_set<int> items = model->getItemsInRange(tid, position, position + range, false);
+            std::map<int, int> clips;
+            for (int itemId : items) {
+                if (model->isClip(itemId)) {
+                    clips.emplace(model->getClipPosition(itemId), itemId);
+                }
+            }
+            // Bin clips played on this track before the cut, their track producer may be in use by the consumer
+            QSet<QString> playedBinIds;
+            for (const auto &clip : clips) {
+                const QString binId = model->getClipBinId(clip.second);
+                if (playedBinIds.contains(binId)) {
+                    continue;
+                }
+                playedBinIds.insert(binId);
+                const PlaylistState::ClipState state = model->getClipState(clip.second);
+                if (clip.first <= position || state == PlaylistState::Disabled) {
+                    continue;
+                }
+                cuts.append({clip.first, clip.second, model->getClipProducer(clip.second), state != PlaylistState::AudioOnly});
+            }
+        }
+    }
+    return cuts;
+}
+
+void PlaybackPrefetcher::prefetch(int position, const QVector<Cut> &cuts)
+{
+    QMutexLocker lock(&m_mutex);
+    m_position = position;
+    const int generation = m_generation;
+    for (const Cut &cut : cuts) {
+        const Key key{cut.position, cut.clipId};
+        if (m_entries.count(key) > 0 || !cut.producer) {
+            continue;
+        }
+        mlt_producer parent = cut.producer->is_cut() ? cut.producer->get_parent() : cut.producer->get_producer();
+        bool busy = false;
+        for (const auto &other : m_entries) {
+            if (other.second.state == Pending && other.second.parent == parent) {
+                busy = true;
+                break;
+            }
+        }
+        if (busy) {
+            // Cuts of the same track producer share its decoder, this one is prepared on a next call
+            continue;
+        }
+        Entry &entry = m_entries[key];
+        if (cut.position - position <= 2 * m_guard) {
+            // Too late, the consumer may reach this clip before the job is done
+            entry.state = Skipped;
+            continue;
+        }
+        entry.parent = parent;
+        m_runningJobs++;
+        const QSize size = m_frameSize;
+        m_pool.start([this, cut, generation, size]() { render(cut, generation, size); });
+    }
+}
+
+bool PlaybackPrefetcher::renderFrame(const Cut &cut, int frame, QSize size)
+{
+    cut.producer->seek(frame);
+    std::unique_ptr<Mlt::Frame> rendered(cut.producer->get_frame());
+    if (!rendered || !rendered->is_valid()) {
+        return false;
+    }
+    // The frame is not kept, rendering it is enough to open the decoders and initialize the effects
+    if (cut.hasVideo) {
+        mlt_image_format format = mlt_image_yuv422;
+        int width = size.width();
+        int height = size.height();
+        rendered->get_image(format, width, height);
+    } else {
+        mlt_audio_format format = mlt_audio_s16;
+        int frequency = prefetchFrequency;
+        int channels = prefetchChannels;
+        int samples = mlt_audio_calculate_frame_samples(float(cut.producer->get_fps()), frequency, frame);
+        rendered->get_audio(format, frequency, channels, samples);
+    }
+    return true;
+}
+
+void PlaybackPrefetcher::render(const Cut &cut, int generation, QSize size)
+{
+    // Stop while the consumer is still a read ahead away from the cut, so that the frame in progress is done before it gets there
+    const auto cancelled = [this, &cut, generation]() { return generation != m_generation || m_position + 2 * m_guard >= cut.position; };
+    bool done = true;
+    for (int i = 1; i <= m_framesPerCut; ++i) {
+        // The first frame is rendered last, leaving the decoder where the consumer starts the clip
+        if (cancelled() || !renderFrame(cut, i % m_framesPerCut, size)) {
+            done = false;
+            break;
+        }
+    }
+    QMutexLocker lock(&m_mutex);
+    m_runningJobs--;
+    m_jobDone.wakeAll();
+    if (generation != m_generation) {
+        return;
+    }
+    auto it = m_entries.find({cut.position, cut.clipId});
+    if (it == m_entries.end()) {
+        // Released by a seek or crossed before the job was done
+        return;
+    }
+    it->second.parent = nullptr;
+    it->second.state = done ? Ready : Skipped;
+}
+
+void PlaybackPrefetcher::frameShown(int position)
+{
+    QMutexLocker lock(&m_mutex);
+    const bool seek = m_lastPosition < 0 || position < m_lastPosition || position - m_lastPosition > m_guard;
+    m_lastPosition = position;
+    m_position = position;
+    auto it = m_entries.begin();
+    while (it != m_entries.end() && it->first.first <= position) {
+        if (!seek) {
+            if (it->second.state == Ready) {
+                m_hits++;
+            } else {
+                m_misses++;
+            }
+        }
+        it = m_entries.erase(it);
+    }
+}
+
+void PlaybackPrefetcher::reset()
+{
+    QMutexLocker lock(&m_mutex);
+    m_generation++;
+    m_entries.clear();
+    m_lastPosition = -1;
+    m_position = -1;
+    // The jobs check the generation before each frame, wait for the frame they may be rendering
+    while (m_runningJobs > 0) {
+        m_jobDone.wait(&m_mutex);
+    }
+}
+
+void PlaybackPrefetcher::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+int PlaybackPrefetcher::hits() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_hits;
+}
+
+int PlaybackPrefetcher::misses() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_misses;
+}
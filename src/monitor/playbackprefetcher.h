@@ -0,0 +1,110 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QMutex>
+#include <QSize>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <map>
+#include <memory>
+
+#include <framework/mlt_types.h>
+
+namespace Mlt {
+class Producer;
+}
+class TimelineModel;
+
+/** @class PlaybackPrefetcher
+    @brief Prepares the clips starting a little after the playhead during project monitor playback.
+    When playback reaches a cut, the clip starting there opens its decoders, seeks them and initializes its
+    effects, which often takes longer than one frame and makes the monitor stutter. For each upcoming cut,
+    the prefetcher renders the first frames of the clip on worker threads through the timeline producer of
+    that clip, so that its decoders and effects are ready when the consumer reaches the cut. The rendered
+    frames are dropped right away, only the state of the producer matters, and the first frame is rendered
+    last so that the decoder is left at the start of the clip. Cuts sharing a track producer are prepared one
+    after the other, and a cut is not prepared while its track producer plays an earlier clip.
+    A job stops once the consumer is less than two read aheads away from its cut, so that the worker
+    threads never render a clip at the same time as the consumer.
+    Crossing a prepared cut counts a hit, crossing a cut that could not be prepared in time counts a miss.
+ */
+class PlaybackPrefetcher
+{
+
+public:
+    struct Cut
+    {
+        /** @brief Timeline position where the clip starts */
+        int position;
+        int clipId;
+        /** @brief The producer playing the clip in the timeline */
+        std::shared_ptr<Mlt::Producer> producer;
+        bool hasVideo;
+    };
+
+    /** @param framesPerCut the number of frames rendered after each cut
+        @param guard the number of frames the consumer may render ahead of the displayed frame */
+    PlaybackPrefetcher(int framesPerCut, int guard, int threads = 2);
+    ~PlaybackPrefetcher();
+
+    /** @brief Size of the rendered images, usually the project size divided by the preview scaling */
+    void setFrameSize(const QSize &size);
+
+    /** @brief List the clips starting after @param position and up to @param range frames later, except clips
+        of a bin clip already played on the same track before them, which share their decoder with it. */
+    static QVector<Cut> upcomingCuts(const std::shared_ptr<TimelineModel> &model, int position, int range);
+
+    /** @brief Start preparing the @param cuts that were not seen before, the displayed frame being @param position */
+    void prefetch(int position, const QVector<Cut> &cuts);
+    /** @brief Account for the display of frame @param position: cuts crossed since the previous frame are counted and released.
+        A jump backwards or further than the consumer read ahead is a seek, the cuts are then released without being counted. */
+    void frameShown(int position);
+    /** @brief Cancel the running jobs and release all cuts, for example when playback stops.
+        Blocks until the running jobs are done. */
+    void reset();
+    /** @brief Wait until the running jobs are finished */
+    void waitForDone();
+
+    /** @brief Number of cuts crossed while prepared */
+    int hits() const;
+    /** @brief Number of cuts crossed while not prepared */
+    int misses() const;
+
+protected:
+    enum State { Pending, Ready, Skipped };
+    struct Entry
+    {
+        State state{Pending};
+        // The producer decoding for the cut, only set while pending
+        mlt_producer parent{nullptr};
+    };
+    using Key = std::pair<int, int>;
+
+    /** @brief Render the first frames of @param cut, called on a worker thread */
+    void render(const Cut &cut, int generation, QSize size);
+    /** @brief Render frame @param frame of @param cut and drop it */
+    static bool renderFrame(const Cut &cut, int frame, QSize size);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_jobDone;
+    QThreadPool m_pool;
+    int m_framesPerCut;
+    int m_guard;
+    QSize m_frameSize;
+    // Cuts by timeline position and clip id
+    std::map<Key, Entry> m_entries;
+    // Number of queued or running jobs, entries may be released before their job is done
+    int m_runningJobs{0};
+    int m_lastPosition{-1};
+    std::atomic<int> m_position{-1};
+    // Increased on reset, jobs of older generations are dropped
+    std::atomic<int> m_generation{0};
+    int m_hits{0};
+    int m_misses{0};
+};
@@ -0,0 +1,290 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "shuttlecache.h"
+
+#include <QHashFunctions>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+#include <mlt++/MltFrame.h>
+#include <mlt++/MltProducer.h>
+#include <vector>
+
+namespace {
+constexpr char cacheProperty[] = "_kdenlive_shuttle_cache";
+constexpr char positionProperty[] = "_kdenlive_shuttle_position";
+constexpr char sourceFrameProperty[] = "_kdenlive_shuttle_source_frame";
+
+void releaseCache(void *data)
+{
+    delete static_cast<std::shared_ptr<ShuttleCache> *>(data);
+}
+
+void releaseWeakCache(void *data)
+{
+    delete static_cast<std::weak_ptr<ShuttleCache> *>(data);
+}
+
+int shuttleGetImage(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int)
+{
+    mlt_properties properties = MLT_FRAME_PROPERTIES(frame);
+    auto *cache = static_cast<std::shared_ptr<ShuttleCache> *>(mlt_properties_get_data(properties, cacheProperty, nullptr));
+    const int position = mlt_properties_get_int(properties, positionProperty);
+    if (cache == nullptr || !(*cache)->image(frame, position, format, width, height, image)) {
+        return 1;
+    }
+    mlt_frame_set_image(frame, *image, mlt_image_format_size(*format, *width, *height, nullptr), mlt_pool_release);
+    return 0;
+}
+
+int shuttleGetAudio(mlt_frame frame, void **buffer, mlt_audio_format *format, int *frequency, int *channels, int *samples)
+{
+    auto sourceFrame = static_cast<mlt_frame>(mlt_properties_get_data(MLT_FRAME_PROPERTIES(frame), sourceFrameProperty, nullptr));
+    void *audio = nullptr;
+    if (sourceFrame == nullptr || mlt_frame_get_audio(sourceFrame, &audio, format, frequency, channels, samples) != 0 || audio == nullptr) {
+        return 1;
+    }
+    // The audio belongs to the source frame, the cache frame gets its own copy
+    const int size = mlt_audio_format_size(*format, *samples, *channels);
+    *buffer = mlt_pool_alloc(size);
+    memcpy(*buffer, audio, size_t(size));
+    mlt_frame_set_audio(frame, *buffer, *format, size, mlt_pool_release);
+    return 0;
+}
+
+int shuttleGetFrame(mlt_producer producer, mlt_frame_ptr frame, int)
+{
+    auto *weakCache = static_cast<std::weak_ptr<ShuttleCache> *>(mlt_properties_get_data(MLT_PRODUCER_PROPERTIES(producer), cacheProperty, nullptr));
+    std::shared_ptr<ShuttleCache> cache = weakCache ? weakCache->lock() : nullptr;
+    *frame = mlt_frame_init(MLT_PRODUCER_SERVICE(producer));
+    if (!cache) {
+        mlt_producer_prepare_next(producer);
+        return 0;
+    }
+    mlt_properties properties = MLT_FRAME_PROPERTIES(*frame);
+    int position = 0;
+    double speed = 0.;
+    mlt_frame sourceFrame = cache->nextSourceFrame(&position, &speed);
+    mlt_frame_set_position(*frame, position);
+    // The frame keeps the cache alive, it may outlive the producer
+    mlt_properties_set_data(properties, cacheProperty, new std::shared_ptr<ShuttleCache>(cache), 0, releaseCache, nullptr);
+    mlt_properties_set_int(properties, positionProperty, position);
+    mlt_properties_set_double(properties, "_speed", speed);
+    mlt_frame_push_get_image(*frame, shuttleGetImage);
+    if (sourceFrame != nullptr) {
+        // The image of the source frame is never requested, only its audio is used
+        mlt_properties_set_int(properties, "test_audio", mlt_properties_get_int(MLT_FRAME_PROPERTIES(sourceFrame), "test_audio"));
+        mlt_properties_set_data(properties, sourceFrameProperty, sourceFrame, 0, reinterpret_cast<mlt_destructor>(mlt_frame_close), nullptr);
+        mlt_frame_push_audio(*frame, reinterpret_cast<void *>(shuttleGetAudio));
+    } else {
+        mlt_properties_set_int(properties, "test_audio", 1);
+    }
+    mlt_producer_set_speed(producer, speed);
+    return 0;
+}
+} // namespace
+
+size_t ShuttleCache::ImageKeyHash::operator()(const ImageKey &key) const
+{
+    return qHashMulti(0, key.position, key.format, key.width, key.height);
+}
+
+ShuttleCache::ShuttleCache(std::shared_ptr<Mlt::Producer> source, qint64 maxBytes, int blockFrames)
+    : m_source(std::move(source))
+    , m_maxBytes(maxBytes)
+    , m_blockFrames(blockFrames)
+{
+    if (m_blockFrames < 1) {
+        m_blockFrames = qMax(1, qRound(m_source->get_fps()));
+    }
+}
+
+std::shared_ptr<ShuttleCache> ShuttleCache::create(std::shared_ptr<Mlt::Producer> source, qint64 maxBytes, int blockFrames)
+{
+    std::shared_ptr<ShuttleCache> cache(new ShuttleCache(std::move(source), maxBytes, blockFrames));
+    mlt_producer raw = mlt_producer_new(cache->m_source->get_profile());
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    mlt_properties properties = MLT_PRODUCER_PROPERTIES(raw);
+    mlt_properties_set_position(properties, "length", cache->m_source->get_length());
+    mlt_properties_set_position(properties, "out", cache->m_source->get_length() - 1);
+    // The producer only holds a weak reference, the cache owns the producer
+    mlt_properties_set_data(properties, cacheProperty, new std::weak_ptr<ShuttleCache>(cache), 0, releaseWeakCache, nullptr);
+    raw->get_frame = shuttleGetFrame;
+    cache->m_producer = std::make_shared<Mlt::Producer>(raw);
+    // Drop the reference of mlt_producer_new, the Mlt::Producer holds its own
+    mlt_producer_close(raw);
+    return cache;
+}
+
+std::shared_ptr<Mlt::Producer> ShuttleCache::producer()
+{
+    return m_producer;
+}
+
+std::shared_ptr<Mlt::Producer> ShuttleCache::source() const
+{
+    return m_source;
+}
+
+mlt_frame ShuttleCache::nextSourceFrame(int *position, double *speed)
+{
+    QMutexLocker lock(&m_mutex);
+    mlt_producer source = m_source->get_producer();
+    *position = int(mlt_producer_position(source));
+    *speed = mlt_producer_get_speed(source);
+    // Getting the frame advances the monitor producer like the consumer does when connected to it
+    mlt_frame frame = nullptr;
+    if (mlt_service_get_frame(MLT_PRODUCER_SERVICE(source), &frame, 0) != 0) {
+        return nullptr;
+    }
+    return frame;
+}
+
+bool ShuttleCache::image(mlt_frame frame, int position, mlt_image_format *format, int *width, int *height, uint8_t **image)
+{
+    if (*format == mlt_image_none) {
+        *format = mlt_image_yuv422;
+    }
+    const int length = m_source->get_length();
+    if (length < 1) {
+        return false;
+    }
+    const ImageKey key{qBound(0, position, length - 1), int(*format), *width, *height};
+    QMutexLocker lock(&m_mutex);
+    auto it = m_images.find(key);
+    if (it == m_images.end()) {
+        m_misses++;
+        decode(frame, key);
+        it = m_images.find(key);
+        if (it == m_images.end()) {
+            return false;
+        }
+    } else {
+        m_hits++;
+    }
+    Image &cached = it->second;
+    cached.lastUsed = ++m_clock;
+    *format = cached.format;
+    *width = cached.width;
+    *height = cached.height;
+    *image = static_cast<uint8_t *>(mlt_pool_alloc(int(cached.data.size())));
+    memcpy(*image, cached.data.constData(), size_t(cached.data.size()));
+    return true;
+}
+
+void ShuttleCache::decode(mlt_frame frame, const ImageKey &key)
+{
+    const int length = m_source->get_length();
+    const bool backwards = m_source->get_speed() < 0;
+    // Keep room for the previous block, which is still being played
+    const qint64 imageSize = qMax(1, mlt_image_format_size(mlt_image_format(key.format), key.width, key.height, nullptr));
+    const int blockFrames = int(qBound(qint64(1), m_maxBytes / imageSize / 2, qint64(m_blockFrames)));
+    const int first = backwards ? qMax(0, key.position - blockFrames + 1) : key.position;
+    const int last = backwards ? key.position : qMin(length - 1, key.position + blockFrames - 1);
+    // Consumer settings like the rescale method are set on the requested frame
+    std::vector<const char *> consumerProperties;
+    mlt_properties requested = MLT_FRAME_PROPERTIES(frame);
+    for (int i = 0; i < mlt_properties_count(requested); ++i) {
+        const char *name = mlt_properties_get_name(requested, i);
+        if (name && strncmp(name, "consumer", 8) == 0) {
+            consumerProperties.push_back(name);
+        }
+    }
+    int restorePosition = m_source->position();
+    int expected = restorePosition;
+    for (int pos = first; pos <= last; ++pos) {
+        ImageKey blockKey = key;
+        blockKey.position = pos;
+        if (pos != key.position && m_images.count(blockKey) > 0) {
+            continue;
+        }
+        if (m_source->position() != expected) {
+            // The monitor producer was seeked meanwhile, stop here and keep the new position
+            restorePosition = m_source->position();
+            expected = restorePosition;
+            break;
+        }
+        m_source->seek(pos);
+        std::unique_ptr<Mlt::Frame> decoded(m_source->get_frame());
+        expected = m_source->position();
+        if (!decoded || !decoded->is_valid()) {
+            break;
+        }
+        for (const char *name : consumerProperties) {
+            mlt_properties_pass_property(decoded->get_properties(), requested, name);
+        }
+        Image image;
+        image.format = mlt_image_format(key.format);
+        image.width = key.width;
+        image.height = key.height;
+        const uint8_t *data = decoded->get_image(image.format, image.width, image.height);
+        if (data == nullptr) {
+            break;
+        }
+        image.data = QByteArray(reinterpret_cast<const char *>(data), mlt_image_format_size(image.format, image.width, image.height, nullptr));
+        image.lastUsed = ++m_clock;
+        m_decodedFrames++;
+        auto previous = m_images.find(blockKey);
+        if (previous != m_images.end()) {
+            m_bytes -= previous->second.data.size();
+        }
+        m_bytes += image.data.size();
+        m_images[blockKey] = std::move(image);
+    }
+    if (m_source->position() == expected) {
+        m_source->seek(restorePosition);
+    }
+    shrink();
+}
+
+void ShuttleCache::shrink()
+{
+    if (m_bytes <= m_maxBytes) {
+        return;
+    }
+    std::vector<std::pair<quint64, ImageKey>> byAge;
+    byAge.reserve(m_images.size());
+    for (const auto &image : m_images) {
+        byAge.emplace_back(image.second.lastUsed, image.first);
+    }
+    std::sort(byAge.begin(), byAge.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    // Free a quarter of the cache at once so that eviction does not run on every miss
+    const qint64 target = m_maxBytes * 3 / 4;
+    for (const auto &item : byAge) {
+        if (m_bytes <= target) {
+            break;
+        }
+        auto it = m_images.find(item.second);
+        m_bytes -= it->second.data.size();
+        m_images.erase(it);
+    }
+}
+
+int ShuttleCache::hits() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_hits;
+}
+
+int ShuttleCache::misses() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_misses;
+}
+
+int ShuttleCache::decodedFrames() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_decodedFrames;
+}
+
+qint64 ShuttleCache::cachedBytes() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_bytes;
+}
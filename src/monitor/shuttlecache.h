@@ -0,0 +1,109 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QMutex>
+#include <QtGlobal>
+#include <framework/mlt_types.h>
+#include <memory>
+#include <unordered_map>
+
+namespace Mlt {
+class Producer;
+}
+
+/** @class ShuttleCache
+    @brief Decoded frame cache used by the monitors during reverse and fast playback.
+    Playing backwards, or faster than real time, makes the decoder seek back to a keyframe for each
+    displayed frame, which is very slow with long GOP footage. During such playback, the monitor consumer
+    is connected to the producer returned by producer(), which serves the frames of the monitor producer
+    from this cache. On a miss, a block of frames is decoded forward in one pass, ending at the requested
+    frame when playing backwards, starting from it otherwise, and kept in a ring of decoded images bounded
+    by the memory cap. The following frames are then served from memory in playback order.
+    The monitor producer keeps its position and speed: the cache producer gets the frames of the monitor producer
+    like the consumer would, which advances it, so seeks and speed changes keep working while the cache is used.
+    Only the audio of these frames is used, so that audio scrubbing keeps working, their image is never decoded.
+    All methods are thread safe.
+ */
+class ShuttleCache : public std::enable_shared_from_this<ShuttleCache>
+{
+
+public:
+    /** @param source the monitor producer
+        @param maxBytes the size of the decoded frames cache
+        @param blockFrames the number of frames decoded on a miss, one second of frames if -1 */
+    static std::shared_ptr<ShuttleCache> create(std::shared_ptr<Mlt::Producer> source, qint64 maxBytes, int blockFrames = -1);
+
+    /** @brief The producer to connect to the consumer while the cache is used */
+    std::shared_ptr<Mlt::Producer> producer();
+    /** @brief The monitor producer */
+    std::shared_ptr<Mlt::Producer> source() const;
+
+    /** @brief Get the frame of the monitor producer at its @param position and @param speed, and advance it.
+        The image of the returned frame should not be requested, it is not cached.
+        @returns a frame to close with mlt_frame_close, or nullptr */
+    mlt_frame nextSourceFrame(int *position, double *speed);
+
+    /** @brief Get the image of frame @param position, decoding a block of frames if needed.
+        The parameters are updated to the returned image, the @param image is allocated with mlt_pool_alloc.
+        @param frame the frame requested by the consumer, its consumer properties are passed to the decoded frames
+        @returns false if the image could not be decoded */
+    bool image(mlt_frame frame, int position, mlt_image_format *format, int *width, int *height, uint8_t **image);
+
+    /** @brief Number of images served from the cache */
+    int hits() const;
+    /** @brief Number of images that needed to decode */
+    int misses() const;
+    /** @brief Number of frames decoded */
+    int decodedFrames() const;
+    /** @brief Size of the cached images */
+    qint64 cachedBytes() const;
+
+protected:
+    ShuttleCache(std::shared_ptr<Mlt::Producer> source, qint64 maxBytes, int blockFrames);
+
+    struct ImageKey
+    {
+        int position;
+        int format;
+        int width;
+        int height;
+        bool operator==(const ImageKey &other) const
+        {
+            return position == other.position && format == other.format && width == other.width && height == other.height;
+        }
+    };
+    struct ImageKeyHash
+    {
+        size_t operator()(const ImageKey &key) const;
+    };
+    struct Image
+    {
+        QByteArray data;
+        mlt_image_format format;
+        int width;
+        int height;
+        quint64 lastUsed;
+    };
+    /** @brief Decode a block of frames containing @param key, in the direction of playback.
+        Must be called with the mutex locked, which also keeps the monitor producer from being advanced meanwhile */
+    void decode(mlt_frame frame, const ImageKey &key);
+    /** @brief Drop the least recently used images until the cache fits its capacity. Must be called with the mutex locked */
+    void shrink();
+
+    mutable QMutex m_mutex;
+    std::shared_ptr<Mlt::Producer> m_source;
+    std::shared_ptr<Mlt::Producer> m_producer;
+    qint64 m_maxBytes;
+    int m_blockFrames;
+    std::unordered_map<ImageKey, Image, ImageKeyHash> m_images;
+    qint64 m_bytes{0};
+    quint64 m_clock{0};
+    int m_hits{0};
+    int m_misses{0};
+    int m_decodedFrames{0};
+};
@@ -35,6 +35,7 @@
 #include "core.h"
 #include "monitorproxy.h"
 #include "profiles/profilemodel.hpp"
+#include "shuttlecache.h"
 #include "timeline2/view/qml/timelineitems.h"
 #include "timeline2/view/qmltypes/thumbnailprovider.h"
 #include "videowidget.h"
@@ -253,6 +254,11 @@ void VideoWidget::releaseAnalyse()
     m_analyseSem.release();
 }
 
+bool VideoWidget::acquireAnalyse()
+{
+    return m_analyseSem.tryAcquire(1);
+}
+
 bool VideoWidget::initGPUAccel()
 {
     if (!KdenliveSettings::gpu_accel()) return false;
@@ -728,6 +734,8 @@ int VideoWidget::reconfigure()
     if (m_consumer->is_valid()) {
         // Connect the producer to the consumer - tell it to "run" later
         if (m_producer) {
+            // Back to the monitor producer if the shuttle cache was used
+            m_shuttleCache.reset();
             m_consumer->connect(*m_producer.get());
             // m_producer->set_speed(0.0);
         }
@@ -1042,6 +1050,7 @@ bool VideoWidget::switchPlay(bool play, double speed)
         }
         qDebug() << "pos: " << m_consumer->position() << "out: " << m_producer->get_playtime() - 1;
         double current_speed = m_producer->get_speed();
+        const bool reconnected = updateShuttleCache(speed);
         m_producer->set_speed(speed);
         m_proxy->setSpeed(speed);
         if (qFuzzyCompare(speed, 1.0) || speed < -6. || speed > 6.) {
@@ -1049,7 +1058,13 @@ bool VideoWidget::switchPlay(bool play, double speed)
         } else if (KdenliveSettings::audio_scrub()) {
             m_consumer->set("scrub_audio", 1);
         }
-        if (qFuzzyIsNull(current_speed)) {
+        if (reconnected) {
+            // The consumer was stopped to switch between the monitor producer and the shuttle cache
+            m_producer->seek(m_consumer->position() + (speed > 1. ? 1 : 0));
+            m_consumer->start();
+            m_consumer->set("refresh", 1);
+            m_consumer->set("volume", KdenliveSettings::volume() / 100.);
+        } else if (qFuzzyIsNull(current_speed)) {
             m_consumer->start();
             m_consumer->set("refresh", 1);
             m_consumer->set("volume", KdenliveSettings::volume() / 100.);
@@ -1060,6 +1075,7 @@ bool VideoWidget::switchPlay(bool play, double speed)
         }
     } else {
         Q_EMIT paused();
+        updateShuttleCache(0.);
         m_producer->set_speed(0);
         m_consumer->set("volume", 0);
         m_proxy->setSpeed(0);
@@ -1071,6 +1087,28 @@ bool VideoWidget::switchPlay(bool play, double speed)
     return true;
 }
 
+bool VideoWidget::updateShuttleCache(double speed)
+{
+    const bool useCache = KdenliveSettings::shuttlecachememory() > 0 && !m_glslManager && (speed < 0. || speed > 1.);
+    if (useCache == (m_shuttleCache != nullptr) && (!m_shuttleCache || m_shuttleCache->source() == m_producer)) {
+        return false;
+    }
+    if (!m_consumer->is_stopped()) {
+        m_consumer->stop();
+    }
+    m_consumer->purge();
+    m_shuttleCache.reset();
+    if (useCache) {
+        m_shuttleCache = ShuttleCache::create(m_producer, qint64(KdenliveSettings::shuttlecachememory()) * 1024 * 1024);
+    }
+    if (m_shuttleCache) {
+        m_consumer->connect(*m_shuttleCache->producer().get());
+    } else {
+        m_consumer->connect(*m_producer.get());
+    }
+    return true;
+}
+
 bool VideoWidget::playZone(bool startFromIn, bool loop)
 {
     if (!m_producer || m_proxy->zoneOut() <= m_proxy->zoneIn()) {
@@ -37,6 +37,7 @@ class RenderThread;
 class FrameRenderer;
 class MonitorProxy;
 class MarkerSortModel;
+class ShuttleCache;
 
 typedef void *(*thread_function_t)(void *);
 
@@ -151,6 +152,8 @@ public Q_SLOTS:
     void setOffsetY(int y, int max);
     void slotZoom(bool zoomIn);
     void releaseAnalyse();
+    /** @brief Returns true if the scopes are ready for a new frame, they then have to call releaseAnalyse() */
+    bool acquireAnalyse();
     bool switchPlay(bool play, double speed = 1.0);
     void reloadProfile();
     /** @brief Update MLT's consumer scaling
@@ -234,6 +237,8 @@ private:
     MonitorProxy *m_proxy;
     std::unique_ptr<RenderThread> m_renderThread;
     std::shared_ptr<Mlt::Producer> m_blackClip;
+    /** @brief Serves the frames to the consumer during reverse and fast playback */
+    std::shared_ptr<ShuttleCache> m_shuttleCache;
     static void on_frame_show(mlt_consumer, VideoWidget *widget, mlt_event_data);
     static void on_frame_render(mlt_consumer, VideoWidget *widget, mlt_frame frame);
     /*static void on_gl_frame_show(mlt_consumer, VideoWidget *widget, mlt_event_data data);
@@ -253,6 +258,10 @@ private:
      *  @param loop if true, we seek to zone start when reaching end
      */
     bool playZone(int in, int out, bool startFromIn, bool loop, bool zoneMode);
+    /** @brief Connect the consumer to the shuttle cache when playing at @param speed backwards or faster than real time,
+     *  to the monitor producer otherwise.
+     *  @returns true if the consumer was stopped to change its producer */
+    bool updateShuttleCache(double speed);
 
 private Q_SLOTS:
     void resizeVideo(int width, int height);
@@ -28,6 +28,9 @@ Item {
     property bool showMarkers: false
     property bool showTimecode: false
     property bool showFps: false
+    property bool showPrefetch: false
+    property int prefetchHits: 0
+    property int prefetchMisses: 0
     property bool showSafezone: false
     property bool showAudiothumb: false
     // Zoombar properties
@@ -204,6 +207,24 @@ Item {
                     bottomMargin: root.zoomOffset
                 }
             }
+            Label {
+                id: prefetchInfo
+                font.family: fontMetrics.font.family
+                font.pointSize: 1.5 * fontMetrics.font.pointSize
+                objectName: "prefetchinfo"
+                color: "#ffffff"
+                padding: 2
+                background: Rectangle {
+                    color: "#66000000"
+                }
+                text: i18n("Prefetch %1/%2", root.prefetchHits, root.prefetchHits + root.prefetchMisses)
+                visible: root.showFps && root.showPrefetch
+                anchors {
+                    right: fpsdropped.left
+                    bottom: parent.bottom
+                    bottomMargin: root.zoomOffset
+                }
+            }
             Label {
                 id: labelSpeed
                 font: fixedFont
@@ -10,6 +10,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "core.h"
 #include "doc/kdenlivedoc.h"
 #include "kdenlivesettings.h"
+#include "utils/thumbnailcache.hpp"
 
 #include <KLocalizedString>
 #include <KMessageBox>
@@ -510,6 +511,8 @@ void TemporaryData::deleteThumbs()
         return;
     }
     if (dir.dirName() == QLatin1String("videothumbs")) {
+        // Close the thumbnail packs before deleting them
+        ThumbnailCache::get()->clearCache();
         dir.removeRecursively();
         dir.mkpath(QStringLiteral("."));
         updateDataInfo();
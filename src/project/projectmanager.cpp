@@ -8,6 +8,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
 #include "core.h"
+#include "doc/autosavejournal.h"
 #include "doc/docundostack.hpp"
 #include "doc/kdenlivedoc.h"
 #include "jobs/cliploadtask.h"
@@ -22,8 +23,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "project/dialogs/noteswidget.h"
 #include "project/dialogs/projectsettings.h"
 #include "timeline2/model/timelinefunctions.hpp"
+#include "utils/mediaprobecache.hpp"
 #include "utils/qstringutils.h"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 #include "xml/xml.hpp"
 #include <audiomixer/mixermanager.hpp>
 #include <bin/clipcreator.hpp>
@@ -267,6 +270,7 @@ void ProjectManager::newFile(QString profileName, bool showProjectSettings)
     doc->m_autosave = new KAutoSaveFile(startFile, doc);
     doc->m_sameProjectFolder = sameProjectFolder;
     ThumbnailCache::get()->clearCache();
+    ThumbnailProducerPool::get()->clear();
     m_project = doc;
     initSequenceProperties(m_project->uuid(), {KdenliveSettings::audiotracks(), KdenliveSettings::videotracks()});
     updateTimeline(true, QString(), QString(), QDateTime(), 0);
@@ -436,6 +440,10 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
 {
     // Disable autosave
     m_autoSaveTimer.stop();
+    if (m_project) {
+        m_project->waitForAutoSave();
+    }
+    MediaProbeCache::get()->save();
     if ((m_project != nullptr) && m_project->isModified() && saveChanges) {
         QString message;
         if (m_project->url().fileName().isEmpty()) {
@@ -525,6 +533,7 @@ bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveOverExis
 {
     // Disable autosave while saving
     m_autoSaveTimer.stop();
+    m_project->waitForAutoSave();
     pCore->monitorManager()->pauseActiveMonitor();
     QString oldProjectFolder =
         m_project->url().isEmpty() ? QString() : QFileInfo(m_project->url().toLocalFile()).absolutePath() + QStringLiteral("/cachefiles");
@@ -679,7 +688,7 @@ bool ProjectManager::saveFile()
         return saveFileAs();
     }
     bool result = saveFileAs(m_project->url().toLocalFile());
-    m_project->m_autosave->resize(0);
+    m_project->clearAutoSave();
     return result;
 }
 
@@ -738,7 +747,7 @@ bool ProjectManager::checkForBackupFile(const QUrl &url, bool newFile)
         for (KAutoSaveFile *stale : std::as_const(staleFiles)) {
             if (stale->open(QIODevice::QIODevice::ReadWrite)) {
                 // Found orphaned autosave file
-                if (!sourceTime.isValid() || QFileInfo(stale->fileName()).lastModified() > sourceTime) {
+                if (!sourceTime.isValid() || AutoSaveJournal::lastModified(stale->fileName()) > sourceTime) {
                     orphanedFile = stale;
                     break;
                 }
@@ -756,6 +765,7 @@ bool ProjectManager::checkForBackupFile(const QUrl &url, bool newFile)
     // remove the stale files
     for (KAutoSaveFile *stale : std::as_const(staleFiles)) {
         stale->open(QIODevice::ReadWrite);
+        AutoSaveJournal::remove(stale->fileName());
         delete stale;
     }
     return false;
@@ -819,6 +829,7 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale, bool isBa
     Q_ASSERT(m_project == nullptr);
     m_fileRevert->setEnabled(true);
     ThumbnailCache::get()->clearCache();
+    ThumbnailProducerPool::get()->clear();
     pCore->monitorManager()->resetDisplay();
     pCore->monitorManager()->activateMonitor(Kdenlive::ProjectMonitor);
     Q_EMIT pCore->loadingMessageNewStage(i18n("Loading project…"));
@@ -828,6 +839,11 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale, bool isBa
         return;
     }
 
+    if (stale) {
+        // Bring the last full autosave up to date with the changes journaled since
+        int replayed = AutoSaveJournal::recover(stale);
+        qCDebug(KDENLIVE_LOG) << "Recovered" << replayed << "autosave journal records";
+    }
     DocOpenResult openResult =
         KdenliveDoc::Open(stale ? QUrl::fromLocalFile(stale->fileName()) : url, QString(), pCore->window()->m_commandStack, false, pCore->window());
 
@@ -1212,23 +1228,25 @@ void ProjectManager::slotAutoSave()
         // Dont start autosave if the project is still loading
         return;
     }
+    if (m_project->isAutoSaving()) {
+        // Previous autosave is still being written, try again later
+        m_autoSaveTimer.start();
+        return;
+    }
+    // Only the scene list is built on the GUI thread, the rest of the autosave runs in background
+    QElapsedTimer stall;
+    stall.start();
     prepareSave();
     QString saveFolder = m_project->url().adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile();
     QString scene = projectSceneList(saveFolder).first;
-    if (!m_replacementPattern.isEmpty()) {
-        QMapIterator<QString, QString> i(m_replacementPattern);
-        while (i.hasNext()) {
-            i.next();
-            scene.replace(i.key(), i.value());
-        }
-    }
-    if (!scene.contains(QLatin1String("<track "))) {
-        // In some unexplained cases, the MLT playlist is corrupted and all tracks are deleted. Don't save in that case.
-        pCore->displayMessage(i18n("Project was corrupted, cannot backup. Please close and reopen your project file to recover last backup"), ErrorMessage);
-        return;
-    }
-    m_project->slotAutoSave(scene);
+    m_project->slotAutoSave(scene, m_replacementPattern);
     m_lastSave.start();
+    const qint64 duration = stall.elapsed();
+    if (duration > 100) {
+        qCWarning(KDENLIVE_LOG) << "Autosave blocked the interface for" << duration << "ms";
+    } else {
+        qCDebug(KDENLIVE_LOG) << "Autosave blocked the interface for" << duration << "ms";
+    }
 }
 
 std::pair<QString, QString> ProjectManager::projectSceneList(const QString &outputFolder, const QString &overlayData, const QString &aspectRatio)
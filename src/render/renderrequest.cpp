@@ -14,6 +14,7 @@
 #include "xml/xml.hpp"
 
 #include <QTemporaryFile>
+#include <QThread>
 
 // TODO: remove, see generatePlaylistFile()
 #include <KMessageBox>
@@ -33,9 +34,41 @@ QStringList RenderRequest::argsByJob(const RenderJob &job, bool addPid)
     if (!job.subtitlePath.isEmpty()) {
         args << QStringLiteral("--subtitle") << job.subtitlePath;
     }
+    if (!job.segments.isEmpty()) {
+        QStringList ranges;
+        for (const auto &segment : job.segments) {
+            ranges << QStringLiteral("%1-%2").arg(segment.first).arg(segment.second);
+        }
+        args << QStringLiteral("--segments") << ranges.join(QLatin1Char(','));
+    }
     return args;
 }
 
+QVector<std::pair<int, int>> RenderRequest::segmentRanges(int in, int out, int gop, int maxSegments, int minLength)
+{
+    const int length = out - in + 1;
+    if (gop < 1 || maxSegments < 2 || length < 2 * qMax(1, minLength)) {
+        return {};
+    }
+    const int count = qMin(maxSegments, length / qMax(1, minLength));
+    // Round the segment length up to a whole number of GOPs
+    int segmentLength = (length + count - 1) / count;
+    segmentLength = (segmentLength + gop - 1) / gop * gop;
+    QVector<std::pair<int, int>> ranges;
+    for (int start = in; start <= out; start += segmentLength) {
+        ranges.append({start, qMin(out, start + segmentLength - 1)});
+    }
+    // Don't start a worker for a last segment shorter than a GOP
+    if (ranges.size() > 1 && ranges.last().second - ranges.last().first + 1 < gop) {
+        ranges.removeLast();
+        ranges.last().second = out;
+    }
+    if (ranges.size() < 2) {
+        return {};
+    }
+    return ranges;
+}
+
 RenderRequest::RenderRequest()
 {
     setBounds(-1, -1);
@@ -102,6 +135,11 @@ void RenderRequest::setTwoPass(bool enabled)
     m_twoPass = enabled;
 }
 
+void RenderRequest::setSegmentedRendering(bool enabled)
+{
+    m_segmentedRendering = enabled;
+}
+
 void RenderRequest::setAudioFilePerTrack(bool enabled)
 {
     m_audioFilePerTrack = enabled;
@@ -285,6 +323,7 @@ void RenderRequest::createRenderJobs(std::vector<RenderJob> &jobs, const QDomDoc
     }
 
     int passes = m_twoPass ? 2 : 1;
+    const QVector<std::pair<int, int>> segments = segmentsForDoc(doc);
 
     for (int i = 0; i < passes; i++) {
         // clone the dom if this is not the first iteration (happens with two pass)
@@ -295,6 +334,7 @@ void RenderRequest::createRenderJobs(std::vector<RenderJob> &jobs, const QDomDoc
         job.playlistPath = playlistPath;
         job.outputPath = outputPath;
         job.subtitlePath = subtitlePath;
+        job.segments = segments;
         if (pass == 2) {
             job.playlistPath = QStringUtils::appendToFilename(job.playlistPath, QStringLiteral("-pass%1").arg(2));
         }
@@ -316,6 +356,30 @@ void RenderRequest::createRenderJobs(std::vector<RenderJob> &jobs, const QDomDoc
     }
 }
 
+QVector<std::pair<int, int>> RenderRequest::segmentsForDoc(const QDomDocument &doc) const
+{
+    // Scripts are started without the job arguments, two pass encoding needs the stats of the whole range
+    // and image sequences are numbered by a single encoder
+    if (!m_segmentedRendering || m_delayedRendering || m_twoPass || m_presetParams.isImageSequence()) {
+        return {};
+    }
+    QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+    if (consumer.isNull() || consumer.hasAttribute(QLatin1String("vn")) || consumer.hasAttribute(QLatin1String("video_off"))) {
+        // Nothing to gain on audio only exports
+        return {};
+    }
+    const double fps = pCore->getCurrentFps();
+    // Without an explicit GOP size, keep the segment boundaries on whole seconds
+    int gop = m_presetParams.value(QStringLiteral("g")).toInt();
+    if (gop < 1) {
+        gop = qMax(1, qRound(fps));
+    }
+    // Every worker process pays the startup cost of loading the project, don't split short renders
+    const int minLength = qMax(2 * gop, qRound(fps * 30));
+    const int maxSegments = qMax(1, QThread::idealThreadCount() / 2);
+    return segmentRanges(consumer.attribute(QStringLiteral("in")).toInt(), consumer.attribute(QStringLiteral("out")).toInt(), gop, maxSegments, minLength);
+}
+
 QString RenderRequest::createEmptyTempFile(const QString &extension)
 {
     QTemporaryFile tmp(QDir::temp().absoluteFilePath(QStringLiteral("kdenlive-XXXXXX.%1").arg(extension)));
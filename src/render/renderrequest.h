@@ -20,6 +20,8 @@ public:
         QString playlistPath;
         QString outputPath;
         QString subtitlePath;
+        /** @brief Frame ranges whose video is encoded by parallel worker processes, empty if the job is rendered in one piece */
+        QVector<std::pair<int, int>> segments;
     };
 
     /** @brief Set frame range that should be rendered
@@ -35,6 +37,8 @@ public:
     void setProxyRendering(bool enabled);
     void setEmbedSubtitles(bool enabled);
     void setTwoPass(bool enabled);
+    /** @brief Split the video encoding of each job in segments rendered in parallel and joined without reencoding */
+    void setSegmentedRendering(bool enabled);
     void setAspectRatio(const QString &aspectRatio);
     void setAudioFilePerTrack(bool enabled);
     void setGuideParams(std::weak_ptr<MarkerListModel> model, bool enableMultiExport, int filterCategory);
@@ -46,6 +50,12 @@ public:
 
     static QStringList argsByJob(const RenderJob &job, bool addPid = true);
 
+    /** @brief Split the range [@param in, @param out] in at most @param maxSegments ranges of at least @param minLength frames.
+     *  Every range starts a multiple of @param gop frames after @param in, so the keyframes of the joined file are where a
+     *  single encoder would have placed them.
+     *  @returns an empty list if the range is too short to be split */
+    static QVector<std::pair<int, int>> segmentRanges(int in, int out, int gop, int maxSegments, int minLength);
+
     /** @brief Some methods used for tests */
     int guideSectionsCount();
     QVector<std::pair<int, int>> getSectionsInOut();
@@ -75,6 +85,7 @@ private:
     bool m_guideMultiExport = false;
     int m_guideCategory = -1; /// category used as filter if @variable guideMultiExport is @value true
     bool m_twoPass = false;
+    bool m_segmentedRendering = false;
 
     QStringList m_errors;
 
@@ -85,6 +96,9 @@ private:
     static void prepareMultiAudioFiles(std::vector<RenderJob> &jobs, const QDomDocument &doc, const QString &playlistFile, const QString &targetFile,
                                        const QUuid &uuid);
 
+    /** @brief Returns the segments for the video of the consumer in @param doc, empty if it cannot be segmented */
+    QVector<std::pair<int, int>> segmentsForDoc(const QDomDocument &doc) const;
+
     static QString createEmptyTempFile(const QString &extension);
 
     /** @brief Create a new empty playlist (*.mlt) file and @returns the filename of the created file.
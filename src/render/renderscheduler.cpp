@@ -0,0 +1,145 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "renderscheduler.h"
+#include "kdenlivesettings.h"
+
+#include <kmemoryinfo.h>
+
+#include <QFile>
+#include <QThread>
+#include <QXmlStreamReader>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+// Memory used by a melt process before it renders any frame: project, producers and caches
+constexpr int baseMemory = 256;
+// Frames kept per thread in the consumer and encoder queues
+constexpr int framesPerThread = 4;
+constexpr int extraFrames = 8;
+} // namespace
+
+RenderScheduler::RenderScheduler(int threads, int memory, int maxJobs)
+    : m_threads(qMax(1, threads))
+    , m_memory(qMax(0, memory))
+    , m_maxJobs(qMax(1, maxJobs))
+{
+}
+
+RenderScheduler RenderScheduler::fromSettings()
+{
+    int threads = KdenliveSettings::renderthreadbudget();
+    if (threads < 1) {
+        threads = QThread::idealThreadCount();
+    }
+    int memory = KdenliveSettings::rendermemorybudget();
+    if (memory < 1) {
+        // Leave a quarter of the memory to the system and Kdenlive itself
+        KMemoryInfo memInfo;
+        memory = memInfo.isNull() ? 0 : int(memInfo.totalPhysical() / 1024 / 1024 * 3 / 4);
+    }
+    return RenderScheduler(threads, memory, KdenliveSettings::maxrenderjobs());
+}
+
+std::vector<size_t> RenderScheduler::jobsToStart(const std::vector<Job> &waiting, const std::vector<Job> &running) const
+{
+    std::vector<size_t> result;
+    int slots = m_maxJobs - int(running.size());
+    if (slots <= 0) {
+        return result;
+    }
+    int threads = 0;
+    int memory = 0;
+    QStringList outputs;
+    for (const Job &job : running) {
+        threads += job.cost.threads;
+        memory += job.cost.memory;
+        outputs << job.output;
+    }
+    std::vector<size_t> order(waiting.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&waiting](size_t a, size_t b) { return waiting[a].priority > waiting[b].priority; });
+    for (size_t ix : order) {
+        const Job &job = waiting[ix];
+        if (outputs.contains(job.output)) {
+            // Wait for the previous pass
+            continue;
+        }
+        const bool idle = running.empty() && result.empty();
+        const bool fits = threads + job.cost.threads <= m_threads && (m_memory == 0 || memory + job.cost.memory <= m_memory);
+        if (!idle && !fits) {
+            break;
+        }
+        result.push_back(ix);
+        threads += job.cost.threads;
+        memory += job.cost.memory;
+        outputs << job.output;
+        if (--slots == 0) {
+            break;
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+RenderScheduler::Cost RenderScheduler::estimateCost(int width, int height, int threads, bool hasVideo, int segments)
+{
+    Cost cost;
+    const int processes = segments > 1 ? segments + 1 : 1;
+    if (!hasVideo) {
+        cost.threads = processes;
+        cost.memory = processes * baseMemory;
+        return cost;
+    }
+    threads = qMax(1, threads);
+    // Consumer threads plus the encoder
+    cost.threads = processes * (threads + 1);
+    const qint64 frameBytes = qint64(width) * height * 4;
+    const qint64 frames = qint64(threads) * framesPerThread + extraFrames;
+    cost.memory = processes * (baseMemory + int(frameBytes * frames / 1024 / 1024));
+    return cost;
+}
+
+RenderScheduler::Cost RenderScheduler::estimateCost(const QString &path, int segments)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return estimateCost(1920, 1080, 1, true, segments);
+    }
+    int width = 0;
+    int height = 0;
+    int threads = 1;
+    bool hasVideo = true;
+    QXmlStreamReader reader(&file);
+    // Profile and consumer are stored before the producers
+    while (!reader.atEnd() && reader.readNext() != QXmlStreamReader::Invalid) {
+        if (!reader.isStartElement()) {
+            continue;
+        }
+        const QXmlStreamAttributes attributes = reader.attributes();
+        if (reader.name() == QLatin1String("profile")) {
+            width = attributes.value(QLatin1String("width")).toInt();
+            height = attributes.value(QLatin1String("height")).toInt();
+        } else if (reader.name() == QLatin1String("consumer")) {
+            if (attributes.hasAttribute(QLatin1String("width")) && attributes.hasAttribute(QLatin1String("height"))) {
+                // Rescaled render
+                width = attributes.value(QLatin1String("width")).toInt();
+                height = attributes.value(QLatin1String("height")).toInt();
+            }
+            // A negative real_time is the number of parallel processing threads
+            threads = qMax(1, qAbs(attributes.value(QLatin1String("real_time")).toInt()));
+            hasVideo = !attributes.hasAttribute(QLatin1String("vn")) && !attributes.hasAttribute(QLatin1String("video_off"));
+            break;
+        } else if (reader.name() == QLatin1String("producer") || reader.name() == QLatin1String("chain")) {
+            break;
+        }
+    }
+    if (width <= 0 || height <= 0) {
+        width = 1920;
+        height = 1080;
+    }
+    return estimateCost(width, height, threads, hasVideo, segments);
+}
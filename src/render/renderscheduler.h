@@ -0,0 +1,62 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+/** @class RenderScheduler
+    @brief Decides which queued render jobs can run side by side.
+    Every job is given an estimated cost in threads and memory, read from its playlist. Waiting jobs are
+    considered by priority, then in queue order, and started as long as the running jobs and the new one
+    fit in the thread and memory budget. A job that does not fit blocks the jobs queued after it, so that
+    large renders are not delayed forever by smaller ones. When nothing is running, the first job is always
+    started, even if it exceeds the budget on its own.
+ */
+class RenderScheduler
+{
+public:
+    enum Priority { LowPriority = -1, NormalPriority = 0, HighPriority = 1 };
+
+    struct Cost
+    {
+        int threads{1};
+        /** @brief Memory in MiB */
+        int memory{0};
+    };
+
+    struct Job
+    {
+        /** @brief The rendered file, jobs writing the same file are never run together (two pass) */
+        QString output;
+        int priority{NormalPriority};
+        Cost cost;
+    };
+
+    /** @param threads the number of threads that can be used by all jobs
+        @param memory the memory in MiB that can be used by all jobs
+        @param maxJobs the maximum number of jobs running at once */
+    RenderScheduler(int threads, int memory, int maxJobs);
+
+    /** @brief Returns the indexes in @param waiting, sorted in queue order, of the jobs to start now
+        while the @param running jobs are rendering */
+    std::vector<size_t> jobsToStart(const std::vector<Job> &waiting, const std::vector<Job> &running) const;
+
+    /** @brief Estimate the cost of rendering the MLT playlist @param path.
+        @param segments the number of parallel segments of a segmented render, 0 otherwise */
+    static Cost estimateCost(const QString &path, int segments = 0);
+    /** @brief Estimate the cost of a render from its frame size and consumer threads */
+    static Cost estimateCost(int width, int height, int threads, bool hasVideo, int segments = 0);
+
+    /** @brief The scheduler configured by the user settings */
+    static RenderScheduler fromSettings();
+
+private:
+    int m_threads;
+    int m_memory;
+    int m_maxJobs;
+};
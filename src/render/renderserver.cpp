@@ -8,6 +8,7 @@
 #include "mainwindow.h"
 #include <KLocalizedString>
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QJsonArray>
 #include <QJsonDocument>
 
@@ -26,6 +27,7 @@ RenderServer::RenderServer(QObject *parent)
     connect(pCore->window(), &MainWindow::abortRenderJob, this, &RenderServer::abortJob, Qt::QueuedConnection);
     connect(this, &RenderServer::setRenderingProgress, pCore->window(), &MainWindow::setRenderingProgress);
     connect(this, &RenderServer::setRenderingFinished, pCore->window(), &MainWindow::setRenderingFinished);
+    connect(this, &RenderServer::setRenderingThroughput, pCore->window(), &MainWindow::setRenderingThroughput);
 }
 
 RenderServer::~RenderServer() {}
@@ -67,6 +69,7 @@ void RenderServer::handleJson(const QJsonObject &json, QLocalSocket *socket)
         const auto progress = obj.value("progress").toInt();
         const auto frame = obj.value("frame").toInt();
         Q_EMIT setRenderingProgress(url, progress, frame);
+        updateThroughput(url, frame);
     }
     if (json.contains("setRenderingFinished")) {
         const QJsonObject obj = json.value("setRenderingFinished").toObject();
@@ -75,9 +78,36 @@ void RenderServer::handleJson(const QJsonObject &json, QLocalSocket *socket)
         const auto error = obj.value("error").toString();
         Q_EMIT setRenderingFinished(url, status, error);
         m_jobSocket.remove(url);
+        m_jobSpeed.remove(url);
+        updateThroughput(QString(), 0);
     }
 }
 
+void RenderServer::updateThroughput(const QString &url, int frame)
+{
+    if (!url.isEmpty()) {
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        auto it = m_jobSpeed.find(url);
+        if (it == m_jobSpeed.end()) {
+            m_jobSpeed.insert(url, {frame, now, 0.});
+        } else if (frame > it->frame && now - it->time >= 1000) {
+            const double fps = (frame - it->frame) * 1000. / (now - it->time);
+            // Smooth the speed, encoders don't output frames at a regular pace
+            it->fps = it->fps > 0. ? 0.7 * it->fps + 0.3 * fps : fps;
+            it->frame = frame;
+            it->time = now;
+        } else if (frame < it->frame) {
+            // Job restarted
+            *it = {frame, now, 0.};
+        }
+    }
+    double total = 0.;
+    for (const JobSpeed &speed : std::as_const(m_jobSpeed)) {
+        total += speed.fps;
+    }
+    Q_EMIT setRenderingThroughput(int(m_jobSpeed.size()), qRound(total));
+}
+
 void RenderServer::abortJob(const QString &job)
 {
     if (m_jobSocket.contains(job)) {
@@ -21,6 +21,8 @@ public:
 Q_SIGNALS:
     void setRenderingProgress(const QString &url, int progress, int frame);
     void setRenderingFinished(const QString &url, int status, const QString &error);
+    /** @brief Combined speed in frames per second of the @param jobs rendering at the same time */
+    void setRenderingThroughput(int jobs, int fps);
 
 public Q_SLOTS:
     void abortJob(const QString &job);
@@ -31,6 +33,15 @@ private Q_SLOTS:
     void jobSent();
 
 private:
+    struct JobSpeed
+    {
+        int frame{0};
+        qint64 time{0};
+        double fps{0.};
+    };
     QLocalServer m_server;
     QHash<QString, QLocalSocket*> m_jobSocket;
+    QHash<QString, JobSpeed> m_jobSpeed;
+    /** @brief Update the speed of job @param url and send the combined throughput of all jobs */
+    void updateThroughput(const QString &url, int frame);
 };
@@ -522,6 +522,11 @@ bool AbstractScopeWidget::autoRefreshEnabled() const
     return m_aAutoRefresh->isChecked();
 }
 
+uint AbstractScopeWidget::scopeAccelerationFactor() const
+{
+    return uint(m_accelFactorScope);
+}
+
 void AbstractScopeWidget::slotAutoRefreshToggled(bool autoRefresh)
 {
 #ifdef DEBUG_ASW
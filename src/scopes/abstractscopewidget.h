@@ -79,6 +79,9 @@ public:
 
     bool needsSingleFrame();
 
+    /** The acceleration factor currently used for rendering the scope layer. */
+    uint scopeAccelerationFactor() const;
+
     ///// Unimplemented /////
 
     virtual QString widgetName() const = 0;
@@ -26,7 +26,15 @@ AbstractGfxScopeWidget::~AbstractGfxScopeWidget() = default;
 QImage AbstractGfxScopeWidget::renderScope(uint accelerationFactor)
 {
     QMutexLocker lock(&m_mutex);
-    return renderGfxScope(accelerationFactor, m_scopeImage);
+    if (!m_frameAnalysis) {
+        return renderGfxScope(accelerationFactor, ScopeFrameAnalysis(QImage(), ScopeFrameAnalysis::NoFeature));
+    }
+    const ScopeFrameAnalysis::Features features = analysisFeatures();
+    if (!m_frameAnalysis->provides(features)) {
+        // Settings changed since the frame was distributed, analyse it again for this scope only
+        return renderGfxScope(accelerationFactor, *m_frameAnalysis->reanalyse(features, accelerationFactor));
+    }
+    return renderGfxScope(accelerationFactor, *m_frameAnalysis);
 }
 
 void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
@@ -37,10 +45,10 @@ void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
 
 ///// Slots /////
 
-void AbstractGfxScopeWidget::slotRenderZoneUpdated(const QImage &frame)
+void AbstractGfxScopeWidget::slotRenderZoneUpdated(const std::shared_ptr<ScopeFrameAnalysis> &analysis)
 {
     QMutexLocker lock(&m_mutex);
-    m_scopeImage = frame;
+    m_frameAnalysis = analysis;
     AbstractScopeWidget::slotRenderZoneUpdated();
 }
 
@@ -11,6 +11,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QWidget>
 
 #include "../abstractscopewidget.h"
+#include "scopeframeanalysis.h"
+
+#include <memory>
 
 /**
 * @brief Abstract class for scopes analyzing image frames.
@@ -23,27 +26,32 @@ public:
     explicit AbstractGfxScopeWidget(bool trackMouse = false, QWidget *parent = nullptr);
     ~AbstractGfxScopeWidget() override; // Must be virtual because of inheritance, to avoid memory leaks
 
+    /** @brief The statistics this scope reads from the shared frame analysis with its current settings */
+    virtual ScopeFrameAnalysis::Features analysisFeatures() const = 0;
+
 protected:
     ///// Variables /////
 
     /** @brief Scope renderer. Must emit signalScopeRenderingFinished()
      *  when calculation has finished, to allow multi-threading.
-     *  accelerationFactor hints how much faster than usual the calculation should be accomplished, if possible. */
-    virtual QImage renderGfxScope(uint accelerationFactor, const QImage &) = 0;
+     *  accelerationFactor hints how much faster than usual the calculation should be accomplished, if possible.
+     *  The analysis provides at least analysisFeatures(). */
+    virtual QImage renderGfxScope(uint accelerationFactor, const ScopeFrameAnalysis &analysis) = 0;
 
     QImage renderScope(uint accelerationFactor) override;
 
     void mouseReleaseEvent(QMouseEvent *) override;
 
 private:
-    QImage m_scopeImage;
+    /** @brief Analysis of the last received frame, possibly shared with other scopes */
+    std::shared_ptr<ScopeFrameAnalysis> m_frameAnalysis;
     QMutex m_mutex;
 
 public Q_SLOTS:
     /** @brief Must be called when the active monitor has shown a new frame.
      * This slot must be connected in the implementing class, it is *not*
      * done in this abstract class. */
-    void slotRenderZoneUpdated(const QImage &);
+    void slotRenderZoneUpdated(const std::shared_ptr<ScopeFrameAnalysis> &analysis);
 
 protected Q_SLOTS:
     virtual void slotAutoRefreshToggled(bool autoRefresh);
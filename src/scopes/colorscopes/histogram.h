@@ -23,6 +23,7 @@ public:
     explicit Histogram(QWidget *parent = nullptr);
     ~Histogram() override;
     QString widgetName() const override;
+    ScopeFrameAnalysis::Features analysisFeatures() const override;
 
 protected:
     void readConfig() override;
@@ -35,12 +36,14 @@ private:
     QAction *m_aRec709;
     QActionGroup *m_agRec;
 
+    /** @brief The HistogramGenerator::Components selected in the UI */
+    int componentFlags() const;
     QRect scopeRect() override;
     bool isHUDDependingOnInput() const override;
     bool isScopeDependingOnInput() const override;
     bool isBackgroundDependingOnInput() const override;
     QImage renderHUD(uint accelerationFactor) override;
-    QImage renderGfxScope(uint accelerationFactor, const QImage &) override;
+    QImage renderGfxScope(uint accelerationFactor, const ScopeFrameAnalysis &analysis) override;
     QImage renderBackground(uint accelerationFactor) override;
     Ui::Histogram_UI *m_ui;
 };
@@ -6,6 +6,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "histogramgenerator.h"
+#include "scopeframeanalysis.h"
 
 #include "klocalizedstring.h"
 #include <QDebug>
@@ -19,7 +20,27 @@ HistogramGenerator::HistogramGenerator() = default;
 QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, qreal scalingFactor, const QImage &image, const int &components, ITURec rec,
                                               bool unscaled, bool logScale, uint accelFactor) const
 {
-    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    ScopeFrameAnalysis analysis(image, analysisFeatures(components, rec), accelFactor);
+    return calculateHistogram(paradeSize, scalingFactor, analysis, components, rec, unscaled, logScale);
+}
+
+ScopeFrameAnalysis::Features HistogramGenerator::analysisFeatures(int components, ITURec rec)
+{
+    ScopeFrameAnalysis::Features features;
+    if ((components & (ComponentR | ComponentG | ComponentB | ComponentSum)) != 0) {
+        features |= ScopeFrameAnalysis::RGBHistogram;
+    }
+    if ((components & ComponentY) != 0) {
+        features |= rec == ITURec::Rec_601 ? ScopeFrameAnalysis::LumaHistogram601 : ScopeFrameAnalysis::LumaHistogram709;
+    }
+    return features;
+}
+
+QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, qreal scalingFactor, const ScopeFrameAnalysis &analysis, const int &components,
+                                              ITURec rec, bool unscaled, bool logScale) const
+{
+    const QSize frameSize = analysis.frameSize();
+    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || frameSize.width() <= 0 || frameSize.height() <= 0) {
         return QImage();
     }
 
@@ -29,44 +50,22 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, qreal sca
     bool drawB = (components & HistogramGenerator::ComponentB) != 0;
     bool drawSum = (components & HistogramGenerator::ComponentSum) != 0;
 
-    int r[256], g[256], b[256], y[256], s[766];
-    // Initialize the values to zero
-    std::fill(r, r + 256, 0);
-    std::fill(g, g + 256, 0);
-    std::fill(b, b + 256, 0);
-    std::fill(y, y + 256, 0);
-    std::fill(s, s + 766, 0);
+    // The stats are read from the shared analysis of the input image
+    analysis.analyse();
+    const int *r = analysis.histogram(ScopeFrameAnalysis::Red);
+    const int *g = analysis.histogram(ScopeFrameAnalysis::Green);
+    const int *b = analysis.histogram(ScopeFrameAnalysis::Blue);
+    const int *y = analysis.histogram(rec == ITURec::Rec_601 ? ScopeFrameAnalysis::Luma601 : ScopeFrameAnalysis::Luma709);
+    int s[256];
+    if (drawSum) {
+        for (int i = 0; i < 256; ++i) {
+            s[i] = r[i] + g[i] + b[i];
+        }
+    }
 
     const int ww = paradeSize.width();
     const int wh = paradeSize.height();
 
-    // Read the stats from the input image
-    for (int Y = 0; Y < image.height(); ++Y) {
-        for (int X = 0; X < image.width(); X += accelFactor) {
-
-            QRgb col = image.pixel(X, Y);
-            r[qRed(col)]++;
-            g[qGreen(col)]++;
-            b[qBlue(col)]++;
-
-            if (drawY) {
-                // Use if branch to avoid expensive multiplication if Y disabled
-                if (rec == ITURec::Rec_601) {
-                    y[int(REC_601_R * qRed(col) + REC_601_G * qGreen(col) + REC_601_B * qBlue(col))]++;
-                } else {
-                    y[int(REC_709_R * qRed(col) + REC_709_G * qGreen(col) + REC_709_B * qBlue(col))]++;
-                }
-            }
-
-            if (drawSum) {
-                // Use an if branch here because the sum takes more operations than rgb
-                s[qRed(col)]++;
-                s[qGreen(col)]++;
-                s[qBlue(col)]++;
-            }
-        }
-    }
-
     const int nParts = (drawY ? 1 : 0) + (drawR ? 1 : 0) + (drawG ? 1 : 0) + (drawB ? 1 : 0) + (drawSum ? 1 : 0);
     if (nParts == 0) {
         // Nothing to draw
@@ -79,8 +78,8 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, qreal sca
     // Height of a single histogram box without text
     const int partH = (wh - nParts * d) / nParts;
 
-    // Total number of bytes of the image
-    const int byteCount = int(image.sizeInBytes());
+    // Total number of bytes of the frame as a 32 bit image
+    const int byteCount = 4 * frameSize.width() * frameSize.height();
 
     // Factor for scaling the measured value to the histogram.
     // This factor is used for linear scaling and does not depend
@@ -9,6 +9,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QObject>
 #include "colorconstants.h"
+#include "scopeframeanalysis.h"
 
 class QColor;
 class QImage;
@@ -35,6 +36,11 @@ public:
      */
     QImage calculateHistogram(const QSize &paradeSize, qreal scalingFactor, const QImage &image, const int &components, const ITURec rec, bool unscaled,
                               bool logScale, uint accelFactor = 1) const;
+    /** @brief Same as above, reading the bins from a shared frame analysis which must provide analysisFeatures(components, rec) */
+    QImage calculateHistogram(const QSize &paradeSize, qreal scalingFactor, const ScopeFrameAnalysis &analysis, const int &components, const ITURec rec,
+                              bool unscaled, bool logScale) const;
+    /** @brief The frame analysis features required to draw @param components */
+    static ScopeFrameAnalysis::Features analysisFeatures(int components, ITURec rec);
 
     /**
      * Draws the histogram of a single component.
@@ -134,14 +134,19 @@ QImage RGBParade::renderHUD(uint)
     return hud;
 }
 
-QImage RGBParade::renderGfxScope(uint accelerationFactor, const QImage &qimage)
+ScopeFrameAnalysis::Features RGBParade::analysisFeatures() const
+{
+    return ScopeFrameAnalysis::Parade;
+}
+
+QImage RGBParade::renderGfxScope(uint accelerationFactor, const ScopeFrameAnalysis &analysis)
 {
     QElapsedTimer timer;
     timer.start();
 
     int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
-    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), devicePixelRatioF(), qimage, RGBParadeGenerator::PaintMode(paintmode),
-                                                             m_aAxis->isChecked(), m_aGradRef->isChecked(), accelerationFactor);
+    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), devicePixelRatioF(), analysis, RGBParadeGenerator::PaintMode(paintmode),
+                                                             m_aAxis->isChecked(), m_aGradRef->isChecked());
     Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), accelerationFactor);
     return parade;
 }
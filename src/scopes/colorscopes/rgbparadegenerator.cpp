@@ -34,8 +34,15 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, qreal sca
                                               bool drawAxis, bool drawGradientRef, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
+    ScopeFrameAnalysis analysis(image, ScopeFrameAnalysis::Parade, accelFactor);
+    return calculateRGBParade(paradeSize, scalingFactor, analysis, paintMode, drawAxis, drawGradientRef);
+}
 
-    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, qreal scalingFactor, const ScopeFrameAnalysis &analysis,
+                                              const RGBParadeGenerator::PaintMode paintMode, bool drawAxis, bool drawGradientRef)
+{
+    const QSize frameSize = analysis.frameSize();
+    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || frameSize.width() <= 0 || frameSize.height() <= 0) {
         return QImage();
     }
     QImage parade(paradeSize * scalingFactor, QImage::Format_ARGB32);
@@ -51,60 +58,59 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, qreal sca
 
     const uint ww = uint(paradeSize.width());
     const uint wh = uint(paradeSize.height());
-    const uint iw = uint(image.width());
-    const uint ih = uint(image.height());
 
     const uchar offset = 10;
     const uint partW = (ww - 2 * offset - distRight) / 3;
     const uint partH = wh - distBottom;
 
-    // Statistics
+    analysis.analyse();
+    const int columns = analysis.columns();
+
+    // Statistics, the extreme values are the first and last used bins of the histograms
     uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0;
+    const int *histR = analysis.histogram(ScopeFrameAnalysis::Red);
+    const int *histG = analysis.histogram(ScopeFrameAnalysis::Green);
+    const int *histB = analysis.histogram(ScopeFrameAnalysis::Blue);
+    for (int i = 0; i < 256; ++i) {
+        if (histR[i] > 0) {
+            minR = qMin(minR, uchar(i));
+            maxR = uchar(i);
+        }
+        if (histG[i] > 0) {
+            minG = qMin(minG, uchar(i));
+            maxG = uchar(i);
+        }
+        if (histB[i] > 0) {
+            minB = qMin(minB, uchar(i));
+            maxB = uchar(i);
+        }
+    }
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = float((iw * ih) / accelFactor) / (partW * 255);
+    const float pixelDepth = float(analysis.samples()) / (partW * 255);
     const float gain = 255 / (8 * pixelDepth);
     //        qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
 
     QImage unscaled(int(ww) - distRight, 256, QImage::Format_ARGB32);
     unscaled.fill(qRgba(0, 0, 0, 0));
 
-    const float wPrediv = float(partW - 1) / (iw - 1);
-
-    std::vector<std::vector<StructRGB>> paradeVals(partW, std::vector<StructRGB>(256, {0, 0, 0}));
-
-    const auto totalPixels = image.width() * image.height();
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const auto x = i % image.width();
-        const QRgb pixel = image.pixel(x, i / image.width());
-        auto r = uchar(qRed(pixel));
-        auto g = uchar(qGreen(pixel));
-        auto b = uchar(qBlue(pixel));
-
-        double dx = x * double(wPrediv);
-
-        paradeVals[size_t(dx)][r].r++;
-        paradeVals[size_t(dx)][g].g++;
-        paradeVals[size_t(dx)][b].b++;
-
-        if (r < minR) {
-            minR = r;
-        }
-        if (g < minG) {
-            minG = g;
-        }
-        if (b < minB) {
-            minB = b;
-        }
-        if (r > maxR) {
-            maxR = r;
-        }
-        if (g > maxG) {
-            maxG = g;
-        }
-        if (b > maxB) {
-            maxB = b;
+    const double wPrediv = columns > 1 ? double(float(partW - 1) / (columns - 1)) : 0.;
+
+    // Flat bins, 256 values per parade column
+    std::vector<StructRGB> paradeVals(size_t(partW) * 256, {0, 0, 0});
+
+    // Map the bins of each column bucket of the shared analysis to the parade columns
+    const uint *binsR = analysis.paradeBins(0);
+    const uint *binsG = analysis.paradeBins(1);
+    const uint *binsB = analysis.paradeBins(2);
+    for (int column = 0; column < columns; ++column) {
+        const size_t start = size_t(column) * ScopeFrameAnalysis::Bins;
+        StructRGB *paradeColumn = paradeVals.data() + size_t(column * wPrediv) * 256;
+        for (size_t value = 0; value < 256; ++value) {
+            paradeColumn[value].r += binsR[start + value];
+            paradeColumn[value].g += binsG[start + value];
+            paradeColumn[value].b += binsB[start + value];
         }
     }
 
@@ -114,18 +120,18 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, qreal sca
     case PaintMode_RGB:
         for (int i = 0; i < int(partW); ++i) {
             for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 10, 10, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].r))));
-                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].g))));
-                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].b))));
+                unscaled.setPixel(i, j, qRgba(255, 10, 10, CHOP255(gain * float(paradeVals[size_t(i) * 256 + size_t(j)].r))));
+                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * float(paradeVals[size_t(i) * 256 + size_t(j)].g))));
+                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * float(paradeVals[size_t(i) * 256 + size_t(j)].b))));
             }
         }
         break;
     default:
         for (int i = 0; i < int(partW); ++i) {
             for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].r))));
-                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].g))));
-                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].b))));
+                unscaled.setPixel(i, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i) * 256 + size_t(j)].r))));
+                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i) * 256 + size_t(j)].g))));
+                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i) * 256 + size_t(j)].b))));
             }
         }
         break;
@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #pragma once
 
+#include "scopeframeanalysis.h"
 #include <QObject>
 
 class QColor;
@@ -21,6 +22,9 @@ public:
     RGBParadeGenerator();
     QImage calculateRGBParade(const QSize &paradeSize, qreal scalingFactor, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
                               bool drawGradientRef, uint accelFactor = 1);
+    /** @brief Draws the parade from the bins of a shared frame analysis, which must provide the Parade feature */
+    QImage calculateRGBParade(const QSize &paradeSize, qreal scalingFactor, const ScopeFrameAnalysis &analysis, const RGBParadeGenerator::PaintMode paintMode,
+                              bool drawAxis, bool drawGradientRef);
 
     static const QColor colHighlight;
     static const QColor colLight;
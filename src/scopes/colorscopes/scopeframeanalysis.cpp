@@ -0,0 +1,449 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "scopeframeanalysis.h"
+#include "scopekernels.h"
+
+#include <QSysInfo>
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+
+ScopeFrameAnalysis::ScopeFrameAnalysis(const QImage &image, Features features, uint accelFactor)
+    : m_image(image)
+    , m_size(image.size())
+    , m_features(features)
+    , m_accelFactor(qMax(1u, accelFactor))
+    , m_columns(qBound(1, image.width(), MaxColumns))
+{
+    if (m_features & Parade) {
+        m_features |= RGBHistogram;
+    }
+}
+
+ScopeFrameAnalysis::ScopeFrameAnalysis(const SharedFrame &frame, Features features, uint accelFactor)
+    : m_frame(frame)
+    , m_size(frame.is_valid() ? QSize(frame.get_image_width(), frame.get_image_height()) : QSize())
+    , m_features(features)
+    , m_accelFactor(qMax(1u, accelFactor))
+    , m_columns(qBound(1, m_size.width(), MaxColumns))
+{
+    if (m_features & Parade) {
+        m_features |= RGBHistogram;
+    }
+}
+
+const QImage &ScopeFrameAnalysis::image() const
+{
+    return m_image;
+}
+
+const SharedFrame &ScopeFrameAnalysis::frame() const
+{
+    return m_frame;
+}
+
+QSize ScopeFrameAnalysis::frameSize() const
+{
+    return m_size;
+}
+
+std::shared_ptr<ScopeFrameAnalysis> ScopeFrameAnalysis::reanalyse(Features features, uint accelFactor) const
+{
+    if (m_frame.is_valid()) {
+        return std::make_shared<ScopeFrameAnalysis>(m_frame, features, accelFactor);
+    }
+    return std::make_shared<ScopeFrameAnalysis>(m_image, features, accelFactor);
+}
+
+ScopeFrameAnalysis::Features ScopeFrameAnalysis::features() const
+{
+    return m_features;
+}
+
+bool ScopeFrameAnalysis::provides(Features features) const
+{
+    return (m_features & features) == features;
+}
+
+uint ScopeFrameAnalysis::accelFactor() const
+{
+    return m_accelFactor;
+}
+
+void ScopeFrameAnalysis::analyse() const
+{
+    std::call_once(m_analysed, [this]() { run(); });
+}
+
+int ScopeFrameAnalysis::samples() const
+{
+    return m_samples;
+}
+
+int ScopeFrameAnalysis::columns() const
+{
+    return m_columns;
+}
+
+const int *ScopeFrameAnalysis::histogram(HistogramComponent component) const
+{
+    return m_histograms[size_t(component)].data();
+}
+
+const uint *ScopeFrameAnalysis::waveformBins(ITURec rec) const
+{
+    return m_waveform[rec == ITURec::Rec_601 ? 0 : 1].data();
+}
+
+const uint *ScopeFrameAnalysis::paradeBins(int channel) const
+{
+    return m_parade[channel].data();
+}
+
+const uint *ScopeFrameAnalysis::uvDensity(UVSpace space) const
+{
+    return m_uvDensity[space].data();
+}
+
+const QRgb *ScopeFrameAnalysis::uvColors(UVSpace space) const
+{
+    return m_uvColors[space].data();
+}
+
+double ScopeFrameAnalysis::uvBinCenter(int bin)
+{
+    return ((bin + .5) / (UVBins / 2) - 1) * UVRange;
+}
+
+void ScopeFrameAnalysis::run() const
+{
+    if (m_size.width() <= 0 || m_size.height() <= 0) {
+        return;
+    }
+    const size_t columnBins = size_t(m_columns) * Bins;
+    if (m_features & Waveform601) {
+        m_waveform[0].assign(columnBins, 0);
+    }
+    if (m_features & Waveform709) {
+        m_waveform[1].assign(columnBins, 0);
+    }
+    if (m_features & Parade) {
+        for (auto &bins : m_parade) {
+            bins.assign(columnBins, 0);
+        }
+    }
+    for (int space = UV_YUV; space <= UV_YPbPr; ++space) {
+        if (m_features & (space == UV_YUV ? UVDensityYUV : UVDensityYPbPr)) {
+            m_uvDensity[space].assign(size_t(UVBins) * UVBins, 0);
+            m_uvColors[space].assign(size_t(UVBins) * UVBins, 0);
+        }
+    }
+
+    if (!m_frame.is_valid()) {
+        runRGB(m_image);
+        return;
+    }
+    if (!(m_features & RGBHistogram) && runYUV()) {
+        return;
+    }
+    // The RGBA conversion is cached in the frame, and kept alive by m_frame
+    const uint8_t *rgba = m_frame.get_image(mlt_image_rgba);
+    if (rgba) {
+        runRGB(QImage(rgba, m_size.width(), m_size.height(), QImage::Format_RGBA8888));
+    }
+}
+
+void ScopeFrameAnalysis::runRGB(const QImage &image) const
+{
+    const int width = image.width();
+    const int height = image.height();
+    if (width != m_size.width() || height != m_size.height()) {
+        return;
+    }
+
+    const bool doRGB = m_features & RGBHistogram;
+    const bool doLuma601 = m_features & (LumaHistogram601 | Waveform601);
+    const bool doLuma709 = m_features & (LumaHistogram709 | Waveform709);
+    const bool doWave601 = m_features & Waveform601;
+    const bool doWave709 = m_features & Waveform709;
+    const bool doParade = m_features & Parade;
+    const bool doYUV = m_features & UVDensityYUV;
+    const bool doYPbPr = m_features & UVDensityYPbPr;
+
+    // Frames coming from the monitors are RGBA8888 and can be read as is,
+    // other formats are read as 32 bit QRgb values (converting once if needed).
+    const QImage::Format format = image.format();
+    const bool byteOrder = format == QImage::Format_RGBA8888 || format == QImage::Format_RGBX8888;
+    QImage source = image;
+    if (!byteOrder && format != QImage::Format_RGB32 && format != QImage::Format_ARGB32) {
+        source = image.convertToFormat(QImage::Format_RGB32);
+    }
+    ScopeKernels::PixelLayout layout{0, 1, 2};
+    if (!byteOrder) {
+        layout = QSysInfo::ByteOrder == QSysInfo::LittleEndian ? ScopeKernels::PixelLayout{2, 1, 0} : ScopeKernels::PixelLayout{1, 2, 3};
+    }
+
+    // Column bucket of each image column, computed once instead of per pixel
+    std::vector<int> columnOf(size_t(width), 0);
+    if (width > 1) {
+        for (int x = 0; x < width; ++x) {
+            columnOf[size_t(x)] = int(qint64(x) * (m_columns - 1) / (width - 1)) * Bins;
+        }
+    }
+
+    // Each scanline is first converted to 8 bit planes by the SIMD kernel, then
+    // accumulated one statistic at a time into the flat bin arrays
+    const ScopeKernels::DecodeLineFunction decodeLine = ScopeKernels::decodeLine();
+    std::vector<uint8_t> planeData(size_t(width) * 9);
+    auto plane = [&planeData, width](int index) { return planeData.data() + size_t(index) * size_t(width); };
+    ScopeKernels::LinePlanes planes;
+    if (doRGB || doYUV || doYPbPr) {
+        planes.red = plane(0);
+        planes.green = plane(1);
+        planes.blue = plane(2);
+    }
+    if (doLuma601) {
+        planes.luma601 = plane(3);
+    }
+    if (doLuma709) {
+        planes.luma709 = plane(4);
+    }
+    if (doYUV) {
+        planes.uYUV = plane(5);
+        planes.vYUV = plane(6);
+    }
+    if (doYPbPr) {
+        planes.uYPbPr = plane(7);
+        planes.vYPbPr = plane(8);
+    }
+
+    int *histR = m_histograms[Red].data();
+    int *histG = m_histograms[Green].data();
+    int *histB = m_histograms[Blue].data();
+    int *hist601 = m_histograms[Luma601].data();
+    int *hist709 = m_histograms[Luma709].data();
+    uint *wave601 = m_waveform[0].data();
+    uint *wave709 = m_waveform[1].data();
+    uint *paradeR = m_parade[0].data();
+    uint *paradeG = m_parade[1].data();
+    uint *paradeB = m_parade[2].data();
+    const uint8_t *r = planes.red;
+    const uint8_t *g = planes.green;
+    const uint8_t *b = planes.blue;
+    const int step = int(m_accelFactor);
+    int samples = 0;
+    // The stride runs over the whole image, not per line
+    int first = 0;
+    for (int y = 0; y < height; ++y, first -= width) {
+        if (first >= width) {
+            continue;
+        }
+        decodeLine(source.constScanLine(y), width, layout, planes);
+        samples += (width - first + step - 1) / step;
+        if (doRGB) {
+            for (int x = first; x < width; x += step) {
+                histR[r[x]]++;
+                histG[g[x]]++;
+                histB[b[x]]++;
+            }
+        }
+        if (doParade) {
+            for (int x = first; x < width; x += step) {
+                const int column = columnOf[size_t(x)];
+                paradeR[column + r[x]]++;
+                paradeG[column + g[x]]++;
+                paradeB[column + b[x]]++;
+            }
+        }
+        if (doLuma601) {
+            const uint8_t *luma = planes.luma601;
+            for (int x = first; x < width; x += step) {
+                hist601[luma[x]]++;
+            }
+            if (doWave601) {
+                for (int x = first; x < width; x += step) {
+                    wave601[columnOf[size_t(x)] + luma[x]]++;
+                }
+            }
+        }
+        if (doLuma709) {
+            const uint8_t *luma = planes.luma709;
+            for (int x = first; x < width; x += step) {
+                hist709[luma[x]]++;
+            }
+            if (doWave709) {
+                for (int x = first; x < width; x += step) {
+                    wave709[columnOf[size_t(x)] + luma[x]]++;
+                }
+            }
+        }
+        for (int space = UV_YUV; space <= UV_YPbPr; ++space) {
+            const uint8_t *u = space == UV_YUV ? planes.uYUV : planes.uYPbPr;
+            const uint8_t *v = space == UV_YUV ? planes.vYUV : planes.vYPbPr;
+            if (u == nullptr) {
+                continue;
+            }
+            uint *density = m_uvDensity[space].data();
+            QRgb *colors = m_uvColors[space].data();
+            for (int x = first; x < width; x += step) {
+                const int ix = v[x] * UVBins + u[x];
+                density[ix]++;
+                colors[ix] = qRgb(r[x], g[x], b[x]);
+            }
+        }
+        // Move the start past the end of this line
+        first += ((width - first + step - 1) / step) * step;
+    }
+    m_samples = samples;
+}
+
+bool ScopeFrameAnalysis::runYUV() const
+{
+    const mlt_image_format format = m_frame.get_image_format();
+    if (format != mlt_image_yuv420p && format != mlt_image_yuv422) {
+        return false;
+    }
+    const uint8_t *data = m_frame.get_image(format);
+    if (data == nullptr) {
+        return false;
+    }
+    const int width = m_size.width();
+    const int height = m_size.height();
+    const bool planar = format == mlt_image_yuv420p;
+    uint8_t *planes[4] = {nullptr, nullptr, nullptr, nullptr};
+    int strides[4] = {0, 0, 0, 0};
+    if (planar) {
+        mlt_image_format_planes(format, width, height, const_cast<uint8_t *>(data), planes, strides);
+    }
+
+    const bool doLuma601 = m_features & (LumaHistogram601 | Waveform601);
+    const bool doLuma709 = m_features & (LumaHistogram709 | Waveform709);
+    // The Y plane holds the luma of the frame's colorspace, MLT assumes Rec.601 up to PAL height if it is not set
+    int colorspace = m_frame.get_int("colorspace");
+    if (colorspace <= 0) {
+        colorspace = height > 576 ? 709 : 601;
+    }
+    if ((doLuma601 && colorspace != 601) || (doLuma709 && colorspace != 709)) {
+        // The requested luma must be computed from RGB
+        return false;
+    }
+    const bool rec709 = colorspace == 709;
+    const bool fullRange = m_frame.get_int("full_range") == 1;
+    const bool doWave601 = m_features & Waveform601;
+    const bool doWave709 = m_features & Waveform709;
+    const bool doYUV = m_features & UVDensityYUV;
+    const bool doYPbPr = m_features & UVDensityYPbPr;
+
+    // Luma is shown on the full 0..255 range, like the luma computed from RGB
+    uint8_t lumaLut[256];
+    for (int i = 0; i < 256; ++i) {
+        lumaLut[i] = uint8_t(fullRange ? i : qBound(0, ((i - 16) * 255 + 109) / 219, 255));
+    }
+    // Chroma bins: the YPbPr values are Cb and Cr scaled to [-.5, .5], the YUV ones
+    // are the same values scaled to the U and V ranges (.436 and .615)
+    uint8_t uBinLut[2][256];
+    uint8_t vBinLut[2][256];
+    for (int i = 0; i < 256; ++i) {
+        const double c = fullRange ? (i - 128) / 255. : (i - 128) / 224.;
+        const double scale = (UVBins / 2) / UVRange;
+        uBinLut[UV_YPbPr][i] = uint8_t(qBound(0, int(std::floor(128 + c * scale)), UVBins - 1));
+        vBinLut[UV_YPbPr][i] = uBinLut[UV_YPbPr][i];
+        uBinLut[UV_YUV][i] = uint8_t(qBound(0, int(std::floor(128 + c * 0.872 * scale)), UVBins - 1));
+        vBinLut[UV_YUV][i] = uint8_t(qBound(0, int(std::floor(128 + c * 1.2296 * scale)), UVBins - 1));
+    }
+    auto toRgb = [fullRange, rec709](int y, int cb, int cr) {
+        const double l = fullRange ? y : (y - 16) * 255. / 219.;
+        const double pb = fullRange ? cb - 128 : (cb - 128) * 255. / 224.;
+        const double pr = fullRange ? cr - 128 : (cr - 128) * 255. / 224.;
+        if (rec709) {
+            return qRgb(qBound(0, int(l + 1.5748 * pr), 255), qBound(0, int(l - .187324 * pb - .468124 * pr), 255), qBound(0, int(l + 1.8556 * pb), 255));
+        }
+        return qRgb(qBound(0, int(l + 1.402 * pr), 255), qBound(0, int(l - .344136 * pb - .714136 * pr), 255), qBound(0, int(l + 1.772 * pb), 255));
+    };
+
+    std::vector<int> columnOf(size_t(width), 0);
+    if (width > 1) {
+        for (int x = 0; x < width; ++x) {
+            columnOf[size_t(x)] = int(qint64(x) * (m_columns - 1) / (width - 1)) * Bins;
+        }
+    }
+
+    // Only the luma of the frame's colorspace was requested, see above
+    int *histograms[2] = {doLuma601 ? m_histograms[Luma601].data() : nullptr, doLuma709 ? m_histograms[Luma709].data() : nullptr};
+    uint *waves[2] = {doWave601 ? m_waveform[0].data() : nullptr, doWave709 ? m_waveform[1].data() : nullptr};
+    std::vector<uint8_t> lumaLine(size_t(width));
+    const int step = int(m_accelFactor);
+    int samples = 0;
+    int first = 0;
+    for (int y = 0; y < height; ++y, first -= width) {
+        if (first >= width) {
+            continue;
+        }
+        const uint8_t *line = planar ? planes[0] + size_t(y) * size_t(strides[0]) : data + size_t(y) * size_t(width) * 2;
+        const int lumaStep = planar ? 1 : 2;
+        for (int x = first; x < width; x += step) {
+            lumaLine[size_t(x)] = lumaLut[line[x * lumaStep]];
+        }
+        samples += (width - first + step - 1) / step;
+        for (int i = 0; i < 2; ++i) {
+            if (histograms[i]) {
+                for (int x = first; x < width; x += step) {
+                    histograms[i][lumaLine[size_t(x)]]++;
+                }
+            }
+            if (waves[i]) {
+                for (int x = first; x < width; x += step) {
+                    waves[i][columnOf[size_t(x)] + lumaLine[size_t(x)]]++;
+                }
+            }
+        }
+        first += ((width - first + step - 1) / step) * step;
+    }
+    m_samples = samples;
+
+    if (!doYUV && !doYPbPr) {
+        return true;
+    }
+    // Each chroma sample is counted once for each luma pixel it covers. Like the MLT buffer layout, only
+    // complete pairs have chroma: at odd sizes the last column or row counts for the previous sample
+    const int chromaWidth = width / 2;
+    const int chromaHeight = planar ? height / 2 : height;
+    const auto covered = [](int index, int count, int lumaCount) { return uint(index == count - 1 ? lumaCount - 2 * index : 2); };
+    first = 0;
+    for (int y = 0; y < chromaHeight; ++y, first -= chromaWidth) {
+        if (first >= chromaWidth) {
+            continue;
+        }
+        const int lumaY = planar ? 2 * y : y;
+        const uint rows = planar ? covered(y, chromaHeight, height) : 1;
+        for (int x = first; x < chromaWidth; x += step) {
+            const uint weight = rows * covered(x, chromaWidth, width);
+            int luma, cb, cr;
+            if (planar) {
+                luma = planes[0][size_t(lumaY) * size_t(strides[0]) + size_t(2 * x)];
+                cb = planes[1][size_t(y) * size_t(strides[1]) + size_t(x)];
+                cr = planes[2][size_t(y) * size_t(strides[2]) + size_t(x)];
+            } else {
+                const uint8_t *px = data + (size_t(y) * size_t(width) + size_t(2 * x)) * 2;
+                luma = px[0];
+                cb = px[1];
+                cr = px[3];
+            }
+            for (int space = UV_YUV; space <= UV_YPbPr; ++space) {
+                if (!(m_features & (space == UV_YUV ? UVDensityYUV : UVDensityYPbPr))) {
+                    continue;
+                }
+                const int ix = vBinLut[space][cr] * UVBins + uBinLut[space][cb];
+                m_uvDensity[space][size_t(ix)] += weight;
+                m_uvColors[space][size_t(ix)] = toRgb(luma, cb, cr);
+            }
+        }
+        first += ((chromaWidth - first + step - 1) / step) * step;
+    }
+    return true;
+}
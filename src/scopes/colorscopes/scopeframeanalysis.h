@@ -0,0 +1,136 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "colorconstants.h"
+#include "monitor/scopes/sharedframe.h"
+
+#include <QFlags>
+#include <QImage>
+#include <QRgb>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/** @class ScopeFrameAnalysis
+    @brief Statistics of one monitor frame, shared by all colour scopes.
+
+    Instead of letting every scope walk the frame on its own, the scope manager
+    creates one analysis per frame with the union of the statistics requested by
+    the visible scopes. The frame is then read once, scanline by scanline, and
+    all histograms and bins are accumulated in the same pass.
+
+    The pass is run lazily by the first scope thread calling analyse(), the other
+    scopes wait for it and then only read the results, so the GUI thread never
+    does the work.
+
+    Waveform and parade bins are stored per column bucket rather than per scope
+    column, since each scope has its own size. There is one bucket per image
+    column, up to MaxColumns.
+
+    An analysis can also be created from the monitor's SharedFrame, without
+    copying it. If no RGB statistic is requested, the frame is in a YUV format
+    and the requested luma is the one of the frame's colorspace, the luma and
+    chroma are read directly from its Y, U and V planes. Otherwise the cached
+    RGBA conversion of the frame is used.
+  */
+class ScopeFrameAnalysis
+{
+public:
+    enum Feature {
+        NoFeature = 0x00,
+        /** Red, green and blue histograms */
+        RGBHistogram = 0x01,
+        LumaHistogram601 = 0x02,
+        LumaHistogram709 = 0x04,
+        /** Luma distribution per column bucket */
+        Waveform601 = 0x08,
+        Waveform709 = 0x10,
+        /** Red, green and blue distribution per column bucket. Implies RGBHistogram. */
+        Parade = 0x20,
+        /** Chrominance density on a UVBins x UVBins grid */
+        UVDensityYUV = 0x40,
+        UVDensityYPbPr = 0x80
+    };
+    Q_DECLARE_FLAGS(Features, Feature)
+
+    enum HistogramComponent { Red = 0, Green, Blue, Luma601, Luma709 };
+    enum UVSpace { UV_YUV = 0, UV_YPbPr };
+
+    static constexpr int Bins = 256;
+    static constexpr int MaxColumns = 2048;
+    static constexpr int UVBins = 256;
+    /** Largest absolute U or V value (on [0,1] RGB input) that can be produced, for both color spaces */
+    static constexpr double UVRange = .64;
+
+    /** @param accelFactor only analyse one pixel out of accelFactor */
+    ScopeFrameAnalysis(const QImage &image, Features features, uint accelFactor = 1);
+    ScopeFrameAnalysis(const SharedFrame &frame, Features features, uint accelFactor = 1);
+    ScopeFrameAnalysis(const ScopeFrameAnalysis &) = delete;
+    ScopeFrameAnalysis &operator=(const ScopeFrameAnalysis &) = delete;
+
+    /** @brief The analysed image, null if the analysis was created from a SharedFrame */
+    const QImage &image() const;
+    /** @brief The analysed frame, invalid if the analysis was created from an image */
+    const SharedFrame &frame() const;
+    QSize frameSize() const;
+    /** @brief Returns a new analysis of the same image or frame, with other features */
+    std::shared_ptr<ScopeFrameAnalysis> reanalyse(Features features, uint accelFactor) const;
+    Features features() const;
+    /** @brief Returns true if all of @param features are accumulated by this analysis */
+    bool provides(Features features) const;
+    uint accelFactor() const;
+
+    /** @brief Runs the analysis pass if this was not done yet.
+        Must be called before reading any result. Thread safe, the pass only runs once. */
+    void analyse() const;
+
+    /** @brief Number of pixels that were analysed */
+    int samples() const;
+    /** @brief Number of column buckets of the waveform and parade bins */
+    int columns() const;
+
+    /** @brief Returns the Bins values of a histogram */
+    const int *histogram(HistogramComponent component) const;
+    /** @brief Returns the waveform bins, columns() x Bins values, indexed by column * Bins + luma */
+    const uint *waveformBins(ITURec rec) const;
+    /** @brief Returns the parade bins of @param channel (0 = red, 1 = green, 2 = blue), indexed like waveformBins() */
+    const uint *paradeBins(int channel) const;
+    /** @brief Returns the UV density, UVBins x UVBins values, indexed by vBin * UVBins + uBin */
+    const uint *uvDensity(UVSpace space) const;
+    /** @brief Returns the color of the last pixel that fell in each UV bin, indexed like uvDensity() */
+    const QRgb *uvColors(UVSpace space) const;
+
+    /** @brief The U or V value at the center of @param bin */
+    static double uvBinCenter(int bin);
+
+private:
+    QImage m_image;
+    SharedFrame m_frame;
+    QSize m_size;
+    Features m_features;
+    uint m_accelFactor;
+    int m_columns;
+    mutable std::once_flag m_analysed;
+    mutable int m_samples{0};
+    mutable std::array<std::array<int, Bins>, 5> m_histograms{};
+    mutable std::vector<uint> m_waveform[2];
+    mutable std::vector<uint> m_parade[3];
+    mutable std::vector<uint> m_uvDensity[2];
+    mutable std::vector<QRgb> m_uvColors[2];
+
+    void run() const;
+    /** @brief Accumulates 32 bit pixels, from the image or the RGBA conversion of the frame */
+    void runRGB(const QImage &source) const;
+    /** @brief Accumulates the planes of a YUV frame, returns false if the frame has another format or
+        a luma of another ITU-R recommendation than its colorspace is requested */
+    bool runYUV() const;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ScopeFrameAnalysis::Features)
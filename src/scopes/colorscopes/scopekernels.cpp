@@ -0,0 +1,259 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "scopekernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCOPES_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace ScopeKernels {
+
+namespace {
+
+// Luma factors (see colorconstants.h) on 15 bits
+constexpr int fixedLuma(double factor)
+{
+    return int(factor * 32768 + .5);
+}
+constexpr int Y601R = fixedLuma(.299);
+constexpr int Y601G = fixedLuma(.587);
+constexpr int Y601B = fixedLuma(.114);
+constexpr int Y709R = fixedLuma(.2125);
+constexpr int Y709G = fixedLuma(.7154);
+constexpr int Y709B = fixedLuma(.0721);
+
+// The U and V factors of vectorscopegenerator.cpp, pre-multiplied to map
+// [-UVRange, UVRange] to the 256 chroma bins, on 16 bits
+constexpr double uvScale = 128 / .64 * 65536;
+constexpr int fixedUV(double factor)
+{
+    return int(factor * uvScale + (factor < 0 ? -.5 : .5));
+}
+constexpr int UVOffset = 128 << 16;
+constexpr int UYUV[3] = {fixedUV(-0.0005781), fixedUV(-0.001135), fixedUV(0.001713)};
+constexpr int VYUV[3] = {fixedUV(0.002411), fixedUV(-0.002019), fixedUV(-0.0003921)};
+constexpr int UPbPr[3] = {fixedUV(-0.0006671), fixedUV(-0.001299), fixedUV(0.0019608)};
+constexpr int VPbPr[3] = {fixedUV(0.001961), fixedUV(-0.001642), fixedUV(-0.0003189)};
+
+inline uint8_t uvBin(const int *factors, int r, int g, int b)
+{
+    return uint8_t(std::clamp((factors[0] * r + factors[1] * g + factors[2] * b + UVOffset) >> 16, 0, 255));
+}
+
+void decodeLineScalar(const uint8_t *pixels, int count, const PixelLayout &layout, const LinePlanes &planes)
+{
+    for (int x = 0; x < count; ++x) {
+        const uint8_t *px = pixels + 4 * x;
+        const int r = px[layout.red];
+        const int g = px[layout.green];
+        const int b = px[layout.blue];
+        if (planes.red) {
+            planes.red[x] = uint8_t(r);
+            planes.green[x] = uint8_t(g);
+            planes.blue[x] = uint8_t(b);
+        }
+        if (planes.luma601) {
+            planes.luma601[x] = uint8_t(std::min(255, (Y601R * r + Y601G * g + Y601B * b) >> 15));
+        }
+        if (planes.luma709) {
+            planes.luma709[x] = uint8_t(std::min(255, (Y709R * r + Y709G * g + Y709B * b) >> 15));
+        }
+        if (planes.uYUV) {
+            planes.uYUV[x] = uvBin(UYUV, r, g, b);
+            planes.vYUV[x] = uvBin(VYUV, r, g, b);
+        }
+        if (planes.uYPbPr) {
+            planes.uYPbPr[x] = uvBin(UPbPr, r, g, b);
+            planes.vYPbPr[x] = uvBin(VPbPr, r, g, b);
+        }
+    }
+}
+
+#ifdef SCOPES_X86_KERNELS
+
+/* The SIMD kernels work on 32 bit lanes, one pixel per lane. The results are packed
+ * back to bytes with unsigned saturation, which also clamps the chroma bins. */
+
+__attribute__((target("sse4.1"))) inline void storeBytes(uint8_t *dest, __m128i values)
+{
+    const __m128i packed = _mm_packus_epi16(_mm_packus_epi32(values, values), values);
+    const int bytes = _mm_cvtsi128_si32(packed);
+    memcpy(dest, &bytes, 4);
+}
+
+__attribute__((target("sse4.1"))) inline __m128i weightedSum(__m128i r, __m128i g, __m128i b, const int *factors, int offset)
+{
+    return _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(r, _mm_set1_epi32(factors[0])), _mm_mullo_epi32(g, _mm_set1_epi32(factors[1]))),
+                         _mm_add_epi32(_mm_mullo_epi32(b, _mm_set1_epi32(factors[2])), _mm_set1_epi32(offset)));
+}
+
+__attribute__((target("sse4.1"))) void decodeLineSSE41(const uint8_t *pixels, int count, const PixelLayout &layout, const LinePlanes &planes)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    const __m128i shiftR = _mm_cvtsi32_si128(8 * layout.red);
+    const __m128i shiftG = _mm_cvtsi32_si128(8 * layout.green);
+    const __m128i shiftB = _mm_cvtsi32_si128(8 * layout.blue);
+    const int luma601[3] = {Y601R, Y601G, Y601B};
+    const int luma709[3] = {Y709R, Y709G, Y709B};
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels + 4 * x));
+        const __m128i r = _mm_and_si128(_mm_srl_epi32(px, shiftR), mask);
+        const __m128i g = _mm_and_si128(_mm_srl_epi32(px, shiftG), mask);
+        const __m128i b = _mm_and_si128(_mm_srl_epi32(px, shiftB), mask);
+        if (planes.red) {
+            storeBytes(planes.red + x, r);
+            storeBytes(planes.green + x, g);
+            storeBytes(planes.blue + x, b);
+        }
+        if (planes.luma601) {
+            storeBytes(planes.luma601 + x, _mm_srli_epi32(weightedSum(r, g, b, luma601, 0), 15));
+        }
+        if (planes.luma709) {
+            storeBytes(planes.luma709 + x, _mm_srli_epi32(weightedSum(r, g, b, luma709, 0), 15));
+        }
+        if (planes.uYUV) {
+            storeBytes(planes.uYUV + x, _mm_srai_epi32(weightedSum(r, g, b, UYUV, UVOffset), 16));
+            storeBytes(planes.vYUV + x, _mm_srai_epi32(weightedSum(r, g, b, VYUV, UVOffset), 16));
+        }
+        if (planes.uYPbPr) {
+            storeBytes(planes.uYPbPr + x, _mm_srai_epi32(weightedSum(r, g, b, UPbPr, UVOffset), 16));
+            storeBytes(planes.vYPbPr + x, _mm_srai_epi32(weightedSum(r, g, b, VPbPr, UVOffset), 16));
+        }
+    }
+    if (x < count) {
+        LinePlanes tail = planes;
+        for (uint8_t **plane : {&tail.red, &tail.green, &tail.blue, &tail.luma601, &tail.luma709, &tail.uYUV, &tail.vYUV, &tail.uYPbPr, &tail.vYPbPr}) {
+            if (*plane) {
+                *plane += x;
+            }
+        }
+        decodeLineScalar(pixels + 4 * x, count - x, layout, tail);
+    }
+}
+
+__attribute__((target("avx2"))) inline void storeBytes(uint8_t *dest, __m256i values)
+{
+    // Packing works within each 128 bit half, the 4 bytes of each half are at its start
+    const __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(values, values), values);
+    const int low = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+    const int high = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+    memcpy(dest, &low, 4);
+    memcpy(dest + 4, &high, 4);
+}
+
+__attribute__((target("avx2"))) inline __m256i weightedSum(__m256i r, __m256i g, __m256i b, const int *factors, int offset)
+{
+    return _mm256_add_epi32(
+        _mm256_add_epi32(_mm256_mullo_epi32(r, _mm256_set1_epi32(factors[0])), _mm256_mullo_epi32(g, _mm256_set1_epi32(factors[1]))),
+        _mm256_add_epi32(_mm256_mullo_epi32(b, _mm256_set1_epi32(factors[2])), _mm256_set1_epi32(offset)));
+}
+
+__attribute__((target("avx2"))) void decodeLineAVX2(const uint8_t *pixels, int count, const PixelLayout &layout, const LinePlanes &planes)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    const __m128i shiftR = _mm_cvtsi32_si128(8 * layout.red);
+    const __m128i shiftG = _mm_cvtsi32_si128(8 * layout.green);
+    const __m128i shiftB = _mm_cvtsi32_si128(8 * layout.blue);
+    const int luma601[3] = {Y601R, Y601G, Y601B};
+    const int luma709[3] = {Y709R, Y709G, Y709B};
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        const __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pixels + 4 * x));
+        const __m256i r = _mm256_and_si256(_mm256_srl_epi32(px, shiftR), mask);
+        const __m256i g = _mm256_and_si256(_mm256_srl_epi32(px, shiftG), mask);
+        const __m256i b = _mm256_and_si256(_mm256_srl_epi32(px, shiftB), mask);
+        if (planes.red) {
+            storeBytes(planes.red + x, r);
+            storeBytes(planes.green + x, g);
+            storeBytes(planes.blue + x, b);
+        }
+        if (planes.luma601) {
+            storeBytes(planes.luma601 + x, _mm256_srli_epi32(weightedSum(r, g, b, luma601, 0), 15));
+        }
+        if (planes.luma709) {
+            storeBytes(planes.luma709 + x, _mm256_srli_epi32(weightedSum(r, g, b, luma709, 0), 15));
+        }
+        if (planes.uYUV) {
+            storeBytes(planes.uYUV + x, _mm256_srai_epi32(weightedSum(r, g, b, UYUV, UVOffset), 16));
+            storeBytes(planes.vYUV + x, _mm256_srai_epi32(weightedSum(r, g, b, VYUV, UVOffset), 16));
+        }
+        if (planes.uYPbPr) {
+            storeBytes(planes.uYPbPr + x, _mm256_srai_epi32(weightedSum(r, g, b, UPbPr, UVOffset), 16));
+            storeBytes(planes.vYPbPr + x, _mm256_srai_epi32(weightedSum(r, g, b, VPbPr, UVOffset), 16));
+        }
+    }
+    if (x < count) {
+        LinePlanes tail = planes;
+        for (uint8_t **plane : {&tail.red, &tail.green, &tail.blue, &tail.luma601, &tail.luma709, &tail.uYUV, &tail.vYUV, &tail.uYPbPr, &tail.vYPbPr}) {
+            if (*plane) {
+                *plane += x;
+            }
+        }
+        decodeLineSSE41(pixels + 4 * x, count - x, layout, tail);
+    }
+}
+
+#endif
+
+} // namespace
+
+Kernel bestKernel()
+{
+#ifdef SCOPES_X86_KERNELS
+    static const Kernel best = []() {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return Kernel::AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return Kernel::SSE41;
+        }
+        return Kernel::Scalar;
+    }();
+    return best;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+DecodeLineFunction decodeLine(Kernel kernel)
+{
+#ifdef SCOPES_X86_KERNELS
+    // Never return a kernel the CPU cannot run
+    const Kernel best = bestKernel();
+    if (kernel == Kernel::AVX2 && best == Kernel::AVX2) {
+        return decodeLineAVX2;
+    }
+    if (kernel != Kernel::Scalar && best != Kernel::Scalar) {
+        return decodeLineSSE41;
+    }
+#else
+    (void)kernel;
+#endif
+    return decodeLineScalar;
+}
+
+const char *kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::AVX2:
+        return "AVX2";
+    case Kernel::SSE41:
+        return "SSE4.1";
+    case Kernel::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+} // namespace ScopeKernels
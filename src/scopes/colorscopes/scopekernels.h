@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    This file is part of kdenlive. See www.kdenlive.org.
+
+SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <cstdint>
+
+/**
+  Pixel conversion kernels used by the colour scope analysis.
+
+  A kernel converts a scanline of 32 bit pixels into separate 8 bit planes
+  (red, green, blue, luma and chroma bin indexes), which are then accumulated
+  into flat bin arrays. All kernels use the same fixed point arithmetic and
+  produce identical results. The fastest one supported by the CPU is chosen
+  at runtime: AVX2, SSE4.1, or the portable scalar fallback.
+  */
+namespace ScopeKernels {
+
+/** @brief Byte position of each color component in a 4 byte pixel */
+struct PixelLayout
+{
+    int red;
+    int green;
+    int blue;
+};
+
+/** @brief Output planes of a kernel, one byte per pixel. Planes that are not needed are left null. */
+struct LinePlanes
+{
+    uint8_t *red{nullptr};
+    uint8_t *green{nullptr};
+    uint8_t *blue{nullptr};
+    uint8_t *luma601{nullptr};
+    uint8_t *luma709{nullptr};
+    /** Chroma bins (see ScopeFrameAnalysis::UVBins), for the YUV and YPbPr color spaces */
+    uint8_t *uYUV{nullptr};
+    uint8_t *vYUV{nullptr};
+    uint8_t *uYPbPr{nullptr};
+    uint8_t *vYPbPr{nullptr};
+};
+
+enum class Kernel { Scalar, SSE41, AVX2 };
+
+using DecodeLineFunction = void (*)(const uint8_t *pixels, int count, const PixelLayout &layout, const LinePlanes &planes);
+
+/** @brief Returns the fastest kernel supported by this CPU */
+Kernel bestKernel();
+/** @brief Returns the decoding function of @param kernel, which falls back to the scalar one if it is not supported */
+DecodeLineFunction decodeLine(Kernel kernel = bestKernel());
+const char *kernelName(Kernel kernel);
+
+} // namespace ScopeKernels
@@ -266,7 +266,13 @@ QImage Vectorscope::renderHUD(uint)
     return hud;
 }
 
-QImage Vectorscope::renderGfxScope(uint accelerationFactor, const QImage &qimage)
+ScopeFrameAnalysis::Features Vectorscope::analysisFeatures() const
+{
+    return VectorscopeGenerator::analysisFeatures(m_aColorSpace_YPbPr->isChecked() ? VectorscopeGenerator::ColorSpace_YPbPr
+                                                                                   : VectorscopeGenerator::ColorSpace_YUV);
+}
+
+QImage Vectorscope::renderGfxScope(uint accelerationFactor, const ScopeFrameAnalysis &analysis)
 {
     QElapsedTimer timer;
     timer.start();
@@ -280,8 +286,8 @@ QImage Vectorscope::renderGfxScope(uint accelerationFactor, const QImage &qimage
             m_aColorSpace_YPbPr->isChecked() ? VectorscopeGenerator::ColorSpace_YPbPr : VectorscopeGenerator::ColorSpace_YUV;
         VectorscopeGenerator::PaintMode paintMode = VectorscopeGenerator::PaintMode(m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt());
         qreal dpr = devicePixelRatioF();
-        scope = m_vectorscopeGenerator->calculateVectorscope(m_scopeRect.size() * dpr, dpr, qimage, m_gain, paintMode, colorSpace, m_aAxisEnabled->isChecked(),
-                                                             accelerationFactor);
+        scope = m_vectorscopeGenerator->calculateVectorscope(m_scopeRect.size() * dpr, dpr, analysis, m_gain, paintMode, colorSpace,
+                                                             m_aAxisEnabled->isChecked());
     }
     Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), accelerationFactor);
     return scope;
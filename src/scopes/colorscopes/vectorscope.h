@@ -31,12 +31,13 @@ public:
     ~Vectorscope() override;
 
     QString widgetName() const override;
+    ScopeFrameAnalysis::Features analysisFeatures() const override;
 
 protected:
     ///// Implemented methods /////
     QRect scopeRect() override;
     QImage renderHUD(uint accelerationFactor) override;
-    QImage renderGfxScope(uint accelerationFactor, const QImage &) override;
+    QImage renderGfxScope(uint accelerationFactor, const ScopeFrameAnalysis &analysis) override;
     QImage renderBackground(uint accelerationFactor) override;
     bool isHUDDependingOnInput() const override;
     bool isScopeDependingOnInput() const override;
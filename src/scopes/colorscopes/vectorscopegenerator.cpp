@@ -105,14 +105,27 @@ QPoint VectorscopeGenerator::mapToCircle(const QSize &targetSize, const QPointF
 }
 
 QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, qreal scalingFactor, const QImage &image, const float &gain,
-                                                  const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
+                                                  const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool axis,
                                                   uint accelFactor) const
 {
-    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    ScopeFrameAnalysis analysis(image, analysisFeatures(colorSpace), accelFactor);
+    return calculateVectorscope(vectorscopeSize, scalingFactor, analysis, gain, paintMode, colorSpace, axis);
+}
+
+ScopeFrameAnalysis::Features VectorscopeGenerator::analysisFeatures(const VectorscopeGenerator::ColorSpace &colorSpace)
+{
+    return colorSpace == ColorSpace_YUV ? ScopeFrameAnalysis::UVDensityYUV : ScopeFrameAnalysis::UVDensityYPbPr;
+}
+
+QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, qreal scalingFactor, const ScopeFrameAnalysis &analysis, const float &gain,
+                                                  const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace,
+                                                  bool) const
+{
+    const QSize frameSize = analysis.frameSize();
+    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || frameSize.width() <= 0 || frameSize.height() <= 0) {
         // Invalid size
         return QImage();
     }
-    if (accelFactor < 1) { accelFactor = 1; }
 
     // Prepare the vectorscope data
     const int cw = (vectorscopeSize.width() < vectorscopeSize.height()) ? vectorscopeSize.width() : vectorscopeSize.height();
@@ -123,43 +136,36 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
     double dy, dr, dg, db, dmax;
     double /*y,*/ u, v;
     QPoint pt;
-    QRgb px;
+    QRgb px, npx;
 
-    // Just an average for the number of image pixels per scope pixel.
-    // NOTE: byteCount() has to be replaced by (img.bytesPerLine()*img.height()) for Qt 4.5 to compile, see:
-    // https://doc.qt.io/qt-5/qimage.html#bytesPerLine
-    double avgPxPerPx = double(image.depth()) / 8 * (image.bytesPerLine() * image.height()) / scope.size().width() / scope.size().height() / accelFactor;
+    // Just an average for the number of image pixels per scope pixel,
+    // computed from the byte count of the frame as a 32 bit image.
+    double avgPxPerPx = 16. * frameSize.width() * frameSize.height() / scope.size().width() / scope.size().height() / analysis.accelFactor();
 
     // benchmarking code
     // const auto start = std::chrono::high_resolution_clock::now();
 
-    const auto totalPixels = image.width() * image.height();
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const QRgb pixel = image.pixel(i % image.width(), i / image.width());
-        const int r = qRed(pixel);
-        const int g = qGreen(pixel);
-        const int b = qBlue(pixel);
-
-        switch (colorSpace) {
-        case VectorscopeGenerator::ColorSpace_YUV:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = -0.0005781 * r - 0.001135 * g + 0.001713 * b;
-            v = 0.002411 * r - 0.002019 * g - 0.0003921 * b;
-            break;
-        case VectorscopeGenerator::ColorSpace_YPbPr:
-        default:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = -0.0006671 * r - 0.001299 * g + 0.0019608 * b;
-            v = 0.001961 * r - 0.001642 * g - 0.0003189 * b;
-            break;
-        }
-
-        pt = mapToCircle(vectorscopeSize, QPointF(SCALING * double(gain) * u, SCALING * double(gain) * v));
+    // The shared analysis has accumulated the pixels on a UV grid, paint each used cell
+    analysis.analyse();
+    const ScopeFrameAnalysis::UVSpace uvSpace = colorSpace == ColorSpace_YUV ? ScopeFrameAnalysis::UV_YUV : ScopeFrameAnalysis::UV_YPbPr;
+    const uint *density = analysis.uvDensity(uvSpace);
+    const QRgb *colors = analysis.uvColors(uvSpace);
+    for (int vBin = 0; vBin < ScopeFrameAnalysis::UVBins; ++vBin) {
+        for (int uBin = 0; uBin < ScopeFrameAnalysis::UVBins; ++uBin) {
+            const size_t ix = size_t(vBin) * ScopeFrameAnalysis::UVBins + size_t(uBin);
+            const uint count = density[ix];
+            if (count == 0) {
+                continue;
+            }
+            u = ScopeFrameAnalysis::uvBinCenter(uBin);
+            v = ScopeFrameAnalysis::uvBinCenter(vBin);
 
-        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
-            // Point lies outside (because of scaling), don't plot it
+            pt = mapToCircle(vectorscopeSize, QPointF(SCALING * double(gain) * u, SCALING * double(gain) * v));
 
-        } else {
+            if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
+                // Point lies outside (because of scaling), don't plot it
+                continue;
+            }
 
             // Draw the pixel using the chosen draw mode.
             switch (paintMode) {
@@ -182,24 +188,9 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
                     break;
                 }
 
-                if (dr < 0) {
-                    dr = 0;
-                }
-                if (dg < 0) {
-                    dg = 0;
-                }
-                if (db < 0) {
-                    db = 0;
-                }
-                if (dr > 255) {
-                    dr = 255;
-                }
-                if (dg > 255) {
-                    dg = 255;
-                }
-                if (db > 255) {
-                    db = 255;
-                }
+                dr = qBound(0., dr, 255.);
+                dg = qBound(0., dg, 255.);
+                db = qBound(0., db, 255.);
 
                 scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
                 break;
@@ -239,22 +230,33 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
                 scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
                 break;
             case PaintMode_Original:
-                scope.setPixel(pt, pixel);
+                scope.setPixel(pt, colors[ix]);
                 break;
-            case PaintMode_Green:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + int((255 - qRed(px)) / (3 * avgPxPerPx)), qGreen(px) + int(20 * (255 - qGreen(px)) / (avgPxPerPx)),
-                                         qBlue(px) + int((255 - qBlue(px)) / (avgPxPerPx)), qAlpha(px) + int((255 - qAlpha(px)) / (avgPxPerPx))));
-                break;
-            case PaintMode_Green2:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + int(ceil((255 - qRed(px)) / (4 * avgPxPerPx))), 255,
-                                         qBlue(px) + int(ceil((255 - qBlue(px)) / (avgPxPerPx))), qAlpha(px) + int(ceil((255 - qAlpha(px)) / (avgPxPerPx)))));
-                break;
-            case PaintMode_Black:
             default:
+                // The accumulating modes brighten the scope pixel once per image pixel,
+                // stop as soon as it is saturated.
                 px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
+                for (uint i = 0; i < count; ++i) {
+                    switch (paintMode) {
+                    case PaintMode_Green:
+                        npx = qRgba(qRed(px) + int((255 - qRed(px)) / (3 * avgPxPerPx)), qGreen(px) + int(20 * (255 - qGreen(px)) / (avgPxPerPx)),
+                                    qBlue(px) + int((255 - qBlue(px)) / (avgPxPerPx)), qAlpha(px) + int((255 - qAlpha(px)) / (avgPxPerPx)));
+                        break;
+                    case PaintMode_Green2:
+                        npx = qRgba(qRed(px) + int(ceil((255 - qRed(px)) / (4 * avgPxPerPx))), 255, qBlue(px) + int(ceil((255 - qBlue(px)) / (avgPxPerPx))),
+                                    qAlpha(px) + int(ceil((255 - qAlpha(px)) / (avgPxPerPx))));
+                        break;
+                    case PaintMode_Black:
+                    default:
+                        npx = qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20);
+                        break;
+                    }
+                    if (npx == px) {
+                        break;
+                    }
+                    px = npx;
+                }
+                scope.setPixel(pt, px);
                 break;
             }
         }
@@ -7,6 +7,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #pragma once
 
+#include "scopeframeanalysis.h"
 #include <QImage>
 #include <QObject>
 
@@ -26,6 +27,11 @@ public:
     QImage calculateVectorscope(const QSize &vectorscopeSize, qreal scalingFactor, const QImage &image, const float &gain,
                                 const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
                                 uint accelFactor = 1) const;
+    /** @brief Draws the vectorscope from the UV density of a shared frame analysis, which must provide analysisFeatures(colorSpace) */
+    QImage calculateVectorscope(const QSize &vectorscopeSize, qreal scalingFactor, const ScopeFrameAnalysis &analysis, const float &gain,
+                                const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool) const;
+    /** @brief The frame analysis features required to draw the vectorscope in @param colorSpace */
+    static ScopeFrameAnalysis::Features analysisFeatures(const VectorscopeGenerator::ColorSpace &colorSpace);
 
     QPoint mapToCircle(const QSize &targetSize, const QPointF &point) const;
     static const double scaling;
@@ -180,7 +180,12 @@ QImage Waveform::renderHUD(uint)
     return hud;
 }
 
-QImage Waveform::renderGfxScope(uint accelFactor, const QImage &qimage)
+ScopeFrameAnalysis::Features Waveform::analysisFeatures() const
+{
+    return WaveformGenerator::analysisFeatures(m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709);
+}
+
+QImage Waveform::renderGfxScope(uint, const ScopeFrameAnalysis &analysis)
 {
     QElapsedTimer timer;
     timer.start();
@@ -188,8 +193,8 @@ QImage Waveform::renderGfxScope(uint accelFactor, const QImage &qimage)
     const int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
     ITURec rec = m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709;
     qreal scalingFactor = devicePixelRatioF();
-    QImage wave = m_waveformGenerator->calculateWaveform((scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom)), scalingFactor, qimage,
-                                                         WaveformGenerator::PaintMode(paintmode), true, rec, accelFactor);
+    QImage wave = m_waveformGenerator->calculateWaveform((scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom)), scalingFactor, analysis,
+                                                         WaveformGenerator::PaintMode(paintmode), true, rec);
 
     Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), 1);
     return wave;
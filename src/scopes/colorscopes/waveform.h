@@ -28,6 +28,7 @@ public:
     ~Waveform() override;
 
     QString widgetName() const override;
+    ScopeFrameAnalysis::Features analysisFeatures() const override;
 
 protected:
     void readConfig() override;
@@ -49,7 +50,7 @@ private:
     /// Implemented methods ///
     QRect scopeRect() override;
     QImage renderHUD(uint) override;
-    QImage renderGfxScope(uint, const QImage &) override;
+    QImage renderGfxScope(uint, const ScopeFrameAnalysis &analysis) override;
     QImage renderBackground(uint) override;
     bool isHUDDependingOnInput() const override;
     bool isScopeDependingOnInput() const override;
@@ -26,15 +26,27 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const qre
                                             bool drawAxis, ITURec rec, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
+    ScopeFrameAnalysis analysis(image, analysisFeatures(rec), accelFactor);
+    return calculateWaveform(waveformSize, scalingFactor, analysis, paintMode, drawAxis, rec);
+}
+
+ScopeFrameAnalysis::Features WaveformGenerator::analysisFeatures(ITURec rec)
+{
+    return rec == ITURec::Rec_601 ? ScopeFrameAnalysis::Waveform601 : ScopeFrameAnalysis::Waveform709;
+}
 
+QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const qreal scalingFactor, const ScopeFrameAnalysis &analysis,
+                                            WaveformGenerator::PaintMode paintMode, bool drawAxis, ITURec rec)
+{
     // QTime time;
     // time.start();
 
+    const QSize frameSize = analysis.frameSize();
     QSize scaledWaveformSize = waveformSize * scalingFactor;
     QImage wave(scaledWaveformSize, QImage::Format_ARGB32);
     wave.setDevicePixelRatio(scalingFactor);
 
-    if (scaledWaveformSize.width() <= 0 || scaledWaveformSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (scaledWaveformSize.width() <= 0 || scaledWaveformSize.height() <= 0 || frameSize.width() <= 0 || frameSize.height() <= 0) {
         return QImage();
     }
 
@@ -43,69 +55,57 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const qre
 
     const uint ww = uint(scaledWaveformSize.width());
     const uint wh = uint(scaledWaveformSize.height());
-    const uint iw = uint(image.width());
-    const auto totalPixels = image.width() * image.height();
+    analysis.analyse();
+    const int columns = analysis.columns();
 
-    std::vector<std::vector<uint>> waveValues(size_t(scaledWaveformSize.width()), std::vector<uint>(size_t(scaledWaveformSize.height()), 0));
+    // Flat bins, one scope column after the other
+    std::vector<uint> waveValues(size_t(ww) * wh, 0);
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = float(totalPixels / accelFactor) / (ww * wh);
+    const float pixelDepth = float(analysis.samples()) / (ww * wh);
     const float gain = 255.f / (8 * pixelDepth);
     // qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
 
     // Subtract 1 from sizes because we start counting from 0.
     // Not doing it would result in attempts to paint outside of the image.
     const float hPrediv = (wh - 1) / 255.f;
-    const float wPrediv = (ww - 1) / float(iw - 1);
-
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const int x = i % image.width();
-        const QRgb pixel = image.pixel(x, i / image.width());
-
-        float dY, dx, dy;
-
-        if (rec == ITURec::Rec_601) {
-            // CIE 601 Luminance
-            dY = REC_601_R * qRed(pixel) + REC_601_G * qGreen(pixel) + REC_601_B * qBlue(pixel);
-        } else {
-            // CIE 709 Luminance
-            dY = REC_709_R * qRed(pixel) + REC_709_G * qGreen(pixel) + REC_709_B * qBlue(pixel);
+    const float wPrediv = columns > 1 ? (ww - 1) / float(columns - 1) : 0.f;
+
+    // Map the luma bins of each column bucket of the shared analysis to the scope
+    const uint *bins = analysis.waveformBins(rec);
+    for (int column = 0; column < columns; ++column) {
+        const uint *columnBins = bins + size_t(column) * ScopeFrameAnalysis::Bins;
+        uint *scopeColumn = waveValues.data() + size_t(column * wPrediv) * wh;
+        for (int luma = 0; luma < ScopeFrameAnalysis::Bins; ++luma) {
+            if (columnBins[luma] > 0) {
+                scopeColumn[size_t(luma * hPrediv)] += columnBins[luma];
+            }
         }
-        // dY is on [0,255] now.
-
-        dy = dY * hPrediv;
-        dx = x * wPrediv;
-        waveValues[size_t(dx)][size_t(dy)]++;
     }
 
-    switch (paintMode) {
-    case PaintMode_Green:
-        for (int i = 0; i < scaledWaveformSize.width(); ++i) {
-            for (int j = 0; j < scaledWaveformSize.height(); ++j) {
+    // Paint line by line, the bins of row j are drawn on the scope line wh - j - 1
+    for (uint j = 0; j < wh; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(wave.scanLine(int(wh - j - 1)));
+        switch (paintMode) {
+        case PaintMode_Green:
+            for (uint i = 0; i < ww; ++i) {
+                const float value = gain * float(waveValues[size_t(i) * wh + j]);
                 // Logarithmic scale. Needs fine tuning by hand, but looks great.
-                wave.setPixel(i, scaledWaveformSize.height() - j - 1,
-                              qRgba(CHOP255(52 * logf(0.1f * gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(52 * logf(gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(52 * logf(.25f * gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(64 * logf(gain * float(waveValues[size_t(i)][size_t(j)])))));
+                line[i] = qRgba(CHOP255(52 * logf(0.1f * value)), CHOP255(52 * logf(value)), CHOP255(52 * logf(.25f * value)), CHOP255(64 * logf(value)));
             }
-        }
-        break;
-    case PaintMode_Yellow:
-        for (int i = 0; i < scaledWaveformSize.width(); ++i) {
-            for (int j = 0; j < scaledWaveformSize.height(); ++j) {
-                wave.setPixel(i, scaledWaveformSize.height() - j - 1, qRgba(255, 242, 0, CHOP255(gain * float(waveValues[size_t(i)][size_t(j)]))));
+            break;
+        case PaintMode_Yellow:
+            for (uint i = 0; i < ww; ++i) {
+                line[i] = qRgba(255, 242, 0, CHOP255(gain * float(waveValues[size_t(i) * wh + j])));
             }
-        }
-        break;
-    default:
-        for (int i = 0; i < scaledWaveformSize.width(); ++i) {
-            for (int j = 0; j < scaledWaveformSize.height(); ++j) {
-                wave.setPixel(i, scaledWaveformSize.height() - j - 1, qRgba(255, 255, 255, CHOP255(2.f * gain * float(waveValues[size_t(i)][size_t(j)]))));
+            break;
+        default:
+            for (uint i = 0; i < ww; ++i) {
+                line[i] = qRgba(255, 255, 255, CHOP255(2.f * gain * float(waveValues[size_t(i) * wh + j])));
             }
+            break;
         }
-        break;
     }
 
     if (drawAxis) {
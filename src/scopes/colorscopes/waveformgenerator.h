@@ -9,6 +9,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QObject>
 #include "colorconstants.h"
+#include "scopeframeanalysis.h"
 
 class QImage;
 class QSize;
@@ -25,4 +26,9 @@ public:
 
     QImage calculateWaveform(const QSize &waveformSize, qreal scalingFactor, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
                              const ITURec rec, uint accelFactor = 1);
+    /** @brief Draws the waveform from the luma bins of a shared frame analysis, which must provide the Waveform feature matching @param rec */
+    QImage calculateWaveform(const QSize &waveformSize, qreal scalingFactor, const ScopeFrameAnalysis &analysis, WaveformGenerator::PaintMode paintMode,
+                             bool drawAxis, const ITURec rec);
+    /** @brief The frame analysis features required to draw the waveform of @param rec */
+    static ScopeFrameAnalysis::Features analysisFeatures(ITURec rec);
 };
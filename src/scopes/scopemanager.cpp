@@ -121,15 +121,52 @@ void ScopeManager::slotDistributeAudio(const audioShortVector &sampleData, int f
         }
     }
 }
+bool ScopeManager::requestedAnalysis(ScopeFrameAnalysis::Features &features, uint &accelFactor) const
+{
+    // Collect what the receiving scopes need so that the frame is only analysed once
+    features = ScopeFrameAnalysis::NoFeature;
+    accelFactor = 0;
+    for (const auto &m_colorScope : m_colorScopes) {
+        if (!m_colorScope.scope->visibleRegion().isEmpty() && (m_colorScope.scope->autoRefreshEnabled() || m_colorScope.singleFrameRequested)) {
+            features |= m_colorScope.scope->analysisFeatures();
+            uint scopeFactor = m_colorScope.scope->scopeAccelerationFactor();
+            accelFactor = accelFactor == 0 ? scopeFactor : qMin(accelFactor, scopeFactor);
+        }
+    }
+    return features != ScopeFrameAnalysis::NoFeature;
+}
+
 void ScopeManager::slotDistributeFrame(const QImage &image)
 {
 #ifdef DEBUG_SM
     qCDebug(KDENLIVE_LOG) << "ScopeManager: Starting to distribute frame.";
 #endif
+    ScopeFrameAnalysis::Features features;
+    uint accelFactor;
+    if (!requestedAnalysis(features, accelFactor)) {
+        return;
+    }
+    distributeAnalysis(std::make_shared<ScopeFrameAnalysis>(image, features, accelFactor));
+}
+
+void ScopeManager::slotDistributeSharedFrame(const SharedFrame &frame)
+{
+    ScopeFrameAnalysis::Features features;
+    uint accelFactor;
+    if (!requestedAnalysis(features, accelFactor)) {
+        // Nobody will render this frame, let the monitor send the next one
+        slotScopeReady();
+        return;
+    }
+    distributeAnalysis(std::make_shared<ScopeFrameAnalysis>(frame, features, accelFactor));
+}
+
+void ScopeManager::distributeAnalysis(const std::shared_ptr<ScopeFrameAnalysis> &analysis)
+{
     for (auto &m_colorScope : m_colorScopes) {
         if (!m_colorScope.scope->visibleRegion().isEmpty()) {
             if (m_colorScope.scope->autoRefreshEnabled()) {
-                m_colorScope.scope->slotRenderZoneUpdated(image);
+                m_colorScope.scope->slotRenderZoneUpdated(analysis);
 #ifdef DEBUG_SM
                 qCDebug(KDENLIVE_LOG) << "ScopeManager: Distributed frame to " << m_colorScopes[i].scope->widgetName();
 #endif
@@ -137,7 +174,7 @@ void ScopeManager::slotDistributeFrame(const QImage &image)
                 // Special case: Auto refresh is disabled, but user requested an update (e.g. by clicking).
                 // Force the scope to update.
                 m_colorScope.singleFrameRequested = false;
-                m_colorScope.scope->slotRenderZoneUpdated(image);
+                m_colorScope.scope->slotRenderZoneUpdated(analysis);
                 m_colorScope.scope->forceUpdateScope();
 #ifdef DEBUG_SM
                 qCDebug(KDENLIVE_LOG) << "ScopeManager: Distributed forced frame to " << m_colorScopes[i].scope->widgetName();
@@ -202,6 +239,7 @@ void ScopeManager::slotUpdateActiveRenderer()
     // Connect new renderer
     if (m_lastConnectedRenderer != nullptr) {
         connect(m_lastConnectedRenderer, &Monitor::frameUpdated, this, &ScopeManager::slotDistributeFrame, Qt::UniqueConnection);
+        connect(m_lastConnectedRenderer, &Monitor::sharedFrameUpdated, this, &ScopeManager::slotDistributeSharedFrame, Qt::UniqueConnection);
         connect(m_lastConnectedRenderer, &Monitor::audioSamplesSignal, this, &ScopeManager::slotDistributeAudio, Qt::UniqueConnection);
 
 #ifdef DEBUG_SM
@@ -76,6 +76,12 @@ private:
     /** @brief a list of all scopes dock object names */
     QStringList m_scopeNames;
 
+    /** @brief Collects the union of the statistics needed by the colour scopes that will receive the next frame.
+        Returns false if no scope needs the frame. */
+    bool requestedAnalysis(ScopeFrameAnalysis::Features &features, uint &accelFactor) const;
+    /** @brief Shares @param analysis with the visible colour scopes */
+    void distributeAnalysis(const std::shared_ptr<ScopeFrameAnalysis> &analysis);
+
     /**
       Checks whether there is any scope accepting audio data, or if all of them are hidden
       or if auto refresh is disabled.
@@ -128,7 +134,10 @@ private Q_SLOTS:
       */
     void checkActiveColourScopes();
 
+    /** @brief Creates one analysis of @param image with the statistics needed by all receiving colour scopes, and shares it with them */
     void slotDistributeFrame(const QImage &image);
+    /** @brief Same as slotDistributeFrame(), for a frame displayed by the monitor, which is analysed without copy */
+    void slotDistributeSharedFrame(const SharedFrame &frame);
     void slotDistributeAudio(const audioShortVector &sampleData, int freq, int num_channels, int num_samples);
     /**
       Allows a scope to explicitly request a new frame, even if the scope's autoRefresh is disabled.
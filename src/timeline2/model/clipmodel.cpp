@@ -54,7 +54,7 @@ ClipModel::ClipModel(const std::shared_ptr<TimelineModel> &parent, std::shared_p
         if (m_currentTrackId != -1) {
             if (auto ptr = m_parent.lock()) {
                 QModelIndex ix = ptr->makeClipIndexFromID(m_id);
-                Q_EMIT ptr->dataChanged(ix, ix, roles);
+                ptr->notifyChange(ix, ix, roles);
                 qDebug() << "// GOT CLIP STACK DATA CHANGE DONE: " << ix << " = " << roles;
             }
         }
@@ -1243,7 +1243,7 @@ Fun ClipModel::setClipState_lambda(PlaylistState::ClipState state)
             if (m_currentTrackId != -1 && ptr->isClip(m_id)) { // if this is false, the clip is being created. Don't update model in that case
                 refreshProducerFromBin(m_currentTrackId);
                 QModelIndex ix = ptr->makeClipIndexFromID(m_id);
-                Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::StatusRole});
+                ptr->notifyChange(ix, ix, {TimelineModel::StatusRole});
             }
             return true;
         }
@@ -1429,7 +1429,7 @@ void ClipModel::setOffset(int offset)
     m_positionOffset = offset;
     if (auto ptr = m_parent.lock()) {
         QModelIndex ix = ptr->makeClipIndexFromID(m_id);
-        Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::PositionOffsetRole});
+        ptr->notifyChange(ix, ix, {TimelineModel::PositionOffsetRole});
     }
 }
 
@@ -1455,7 +1455,7 @@ void ClipModel::setGrab(bool grab)
     m_grabbed = grab;
     if (auto ptr = m_parent.lock()) {
         QModelIndex ix = ptr->makeClipIndexFromID(m_id);
-        Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::GrabbedRole});
+        ptr->notifyChange(ix, ix, {TimelineModel::GrabbedRole});
     }
 }
 
@@ -1469,7 +1469,7 @@ void ClipModel::setSelected(bool sel)
     if (auto ptr = m_parent.lock()) {
         if (m_currentTrackId != -1) {
             QModelIndex ix = ptr->makeClipIndexFromID(m_id);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::SelectedRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::SelectedRole});
         }
     }
 }
@@ -309,7 +309,7 @@ void CompositionModel::setGrab(bool grab)
     m_grabbed = grab;
     if (auto ptr = m_parent.lock()) {
         QModelIndex ix = ptr->makeCompositionIndexFromID(m_id);
-        Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::GrabbedRole});
+        ptr->notifyChange(ix, ix, {TimelineModel::GrabbedRole});
     }
 }
 
@@ -323,7 +323,7 @@ void CompositionModel::setSelected(bool sel)
     if (auto ptr = m_parent.lock()) {
         if (m_currentTrackId != -1) {
             QModelIndex ix = ptr->makeCompositionIndexFromID(m_id);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::SelectedRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::SelectedRole});
         }
     }
 }
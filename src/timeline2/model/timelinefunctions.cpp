@@ -334,6 +334,7 @@ bool TimelineFunctions::requestClipCut(const std::shared_ptr<TimelineItemModel>
 
 bool TimelineFunctions::requestClipCutAll(std::shared_ptr<TimelineItemModel> timeline, int position)
 {
+    TimelineModel::NotificationBatch batch(timeline.get());
     QVector<std::shared_ptr<TrackModel>> affectedTracks;
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
@@ -443,22 +444,13 @@ std::pair<int, int> TimelineFunctions::requestSpacerStartOperation(const std::sh
                         }
                     } else if (outOfRange) {
                         // This is a grouped clip positionned before the spacer operation position, check maximum space before / after
-                        std::unordered_set<int> beforeOnTrack = timeline->getItemsInRange(tid, 0, pos - 1);
                         std::unordered_set<int> afterOnTrack = timeline->getItemsInRange(tid, itemEnd, position);
                         for (auto &c : allClips) {
-                            beforeOnTrack.erase(c);
                             afterOnTrack.erase(c);
                         }
-                        int lastPos = 0;
-                        for (int c : beforeOnTrack) {
-                            int p = timeline->getItemEnd(c);
-                            if (p >= pos - 1) {
-                                lastPos = pos;
-                                break;
-                            }
-                            if (p > lastPos) {
-                                lastPos = p;
-                            }
+                        int lastPos = qMax(0, timeline->getPreviousItemEnd(tid, pos - 1, allClips));
+                        if (lastPos >= pos - 1) {
+                            lastPos = pos;
                         }
                         if (lastPos > -1) {
                             if (relatedMaxSpace.contains(tid)) {
@@ -1869,6 +1861,7 @@ QString TimelineFunctions::copyClips(const std::shared_ptr<TimelineItemModel> &t
 
 bool TimelineFunctions::pasteClips(const std::shared_ptr<TimelineItemModel> &timeline, const QString &pasteString, int trackId, int position)
 {
+    TimelineModel::NotificationBatch batch(timeline.get());
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
     if (TimelineFunctions::pasteClips(timeline, pasteString, trackId, position, undo, redo)) {
@@ -2869,6 +2862,7 @@ bool TimelineFunctions::requestDeleteAllBlanksFrom(const std::shared_ptr<Timelin
 
 bool TimelineFunctions::requestDeleteAllClipsFrom(const std::shared_ptr<TimelineItemModel> &timeline, int trackId, int position)
 {
+    TimelineModel::NotificationBatch batch(timeline.get());
     // Abort if track is locked
     if (timeline->trackIsLocked(trackId)) {
         timeline->flashLock(trackId);
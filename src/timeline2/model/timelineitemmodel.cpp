@@ -24,6 +24,7 @@
 #include "transitions/transitionsrepository.hpp"
 #include <QDebug>
 #include <QFileInfo>
+#include <algorithm>
 #include <mlt++/MltField.h>
 #include <mlt++/MltProfile.h>
 #include <mlt++/MltTractor.h>
@@ -704,14 +705,113 @@ void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelInd
             roles.push_back(TimelineModel::OutPointRole);
         }
     }
-    Q_EMIT dataChanged(topleft, bottomright, roles);
+    notifyChange(topleft, bottomright, roles);
 }
 
 void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
 {
+    if (m_batchDepth > 0 && batchChange(topleft, bottomright, roles)) {
+        return;
+    }
     Q_EMIT dataChanged(topleft, bottomright, roles);
 }
 
+bool TimelineItemModel::batchChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
+{
+    if (!topleft.isValid() || !bottomright.isValid() || topleft.parent() != bottomright.parent()) {
+        return false;
+    }
+    // Items are stored by id since rows can change before the end of the batch
+    const QModelIndex parent = topleft.parent();
+    for (int row = topleft.row(); row <= bottomright.row(); ++row) {
+        const int itemId = row == topleft.row() ? int(topleft.internalId()) : int(index(row, 0, parent).internalId());
+        auto it = m_batchedChanges.find(itemId);
+        if (it == m_batchedChanges.end()) {
+            QVector<int> sortedRoles = roles;
+            std::sort(sortedRoles.begin(), sortedRoles.end());
+            m_batchedChanges.emplace(itemId, sortedRoles);
+        } else if (roles.isEmpty()) {
+            it->second.clear();
+        } else if (!it->second.isEmpty()) {
+            for (int role : roles) {
+                auto pos = std::lower_bound(it->second.begin(), it->second.end(), role);
+                if (pos == it->second.end() || *pos != role) {
+                    it->second.insert(pos, role);
+                }
+            }
+        }
+    }
+    m_batchedNotifications++;
+    return true;
+}
+
+void TimelineItemModel::_beginNotificationBatch()
+{
+    m_batchDepth++;
+}
+
+void TimelineItemModel::_endNotificationBatch()
+{
+    Q_ASSERT(m_batchDepth > 0);
+    if (--m_batchDepth == 0) {
+        flushBatchedChanges();
+    }
+}
+
+void TimelineItemModel::flushBatchedChanges()
+{
+    std::map<int, QVector<int>> changes;
+    std::swap(changes, m_batchedChanges);
+    // Find the current row of the changed items, by parent track (-1 for the tracks themselves)
+    std::map<int, std::map<int, QVector<int>>> rows;
+    for (const auto &change : changes) {
+        int itemId = change.first;
+        int trackId = -1;
+        if (isClip(itemId)) {
+            trackId = m_allClips.at(itemId)->getCurrentTrackId();
+        } else if (isComposition(itemId)) {
+            trackId = m_allCompositions.at(itemId)->getCurrentTrackId();
+        } else if (!isTrack(itemId)) {
+            // Item was deleted
+            continue;
+        }
+        if (trackId == -1 && !isTrack(itemId)) {
+            // Item is not in the timeline anymore
+            continue;
+        }
+        QModelIndex ix = isClip(itemId) ? makeClipIndexFromID(itemId) : isComposition(itemId) ? makeCompositionIndexFromID(itemId) : makeTrackIndexFromID(itemId);
+        if (ix.isValid()) {
+            rows[trackId][ix.row()] = change.second;
+        }
+    }
+    // Send one signal per range of consecutive rows sharing the same roles
+    for (const auto &trackRows : rows) {
+        const QModelIndex parent = trackRows.first == -1 ? QModelIndex() : makeTrackIndexFromID(trackRows.first);
+        auto it = trackRows.second.cbegin();
+        while (it != trackRows.second.cend()) {
+            auto last = it;
+            auto next = std::next(it);
+            while (next != trackRows.second.cend() && next->first == last->first + 1 && next->second == it->second) {
+                last = next;
+                ++next;
+            }
+            Q_EMIT dataChanged(index(it->first, 0, parent), index(last->first, 0, parent), it->second);
+            m_sentBatchNotifications++;
+            it = next;
+        }
+    }
+}
+
+int TimelineItemModel::batchedNotifications() const
+{
+    return m_batchedNotifications;
+}
+
+int TimelineItemModel::sentBatchNotifications() const
+{
+    return m_sentBatchNotifications;
+}
+
 void TimelineItemModel::rebuildMixer()
 {
     if (pCore->mixer() == nullptr) {
@@ -865,7 +965,7 @@ void TimelineItemModel::buildTrackCompositing(bool rebuild)
 
 void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, int role)
 {
-    Q_EMIT dataChanged(topleft, bottomright, {role});
+    notifyChange(topleft, bottomright, QVector<int>({role}));
 }
 
 void TimelineItemModel::_beginRemoveRows(const QModelIndex &i, int j, int k)
@@ -956,7 +1056,7 @@ void TimelineItemModel::processTimelineReplacement(QList<int> instances, const Q
                 replaced++;
                 QModelIndex ix = makeClipIndexFromID(id);
                 clip->forceThumbReload = !clip->forceThumbReload;
-                Q_EMIT dataChanged(
+                notifyChange(
                     ix, ix,
                     {BinIdRole, ClipThumbRole, AudioChannelsRole, AudioStreamRole, AudioMultiStreamRole, AudioStreamIndexRole, NameRole, ReloadAudioThumbRole});
             }
@@ -983,9 +1083,9 @@ void TimelineItemModel::processTimelineReplacement(QList<int> instances, const Q
                     replaced++;
                     QModelIndex ix = makeClipIndexFromID(id);
                     clip->forceThumbReload = !clip->forceThumbReload;
-                    Q_EMIT dataChanged(ix, ix,
-                                       {BinIdRole, ClipThumbRole, AudioChannelsRole, AudioStreamRole, AudioMultiStreamRole, AudioStreamIndexRole, NameRole,
-                                        ReloadAudioThumbRole});
+                    notifyChange(ix, ix,
+                                 {BinIdRole, ClipThumbRole, AudioChannelsRole, AudioStreamRole, AudioMultiStreamRole, AudioStreamIndexRole, NameRole,
+                                  ReloadAudioThumbRole});
                 }
             }
             if (!notReplacedIds.isEmpty()) {
@@ -8,6 +8,7 @@
 #include "assets/keyframes/model/keyframemodellist.hpp"
 #include "timelinemodel.hpp"
 #include "undohelper.hpp"
+#include <map>
 
 class MarkerListModel;
 
@@ -86,6 +87,10 @@ public:
     void notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, bool start, bool duration, bool updateThumb) override;
     void notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles) override;
     void notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, int role) override;
+    /** @brief Number of change notifications received while a NotificationBatch was active */
+    int batchedNotifications() const;
+    /** @brief Number of dataChanged signals sent at the end of the batches, in place of the batched notifications */
+    int sentBatchNotifications() const;
 
     /** @brief Import track effects */
     void importTrackEffects(int tid, std::weak_ptr<Mlt::Service> service);
@@ -119,10 +124,24 @@ public:
     void _endRemoveRows() override;
     void _endInsertRows() override;
     void _resetView() override;
+    void _beginNotificationBatch() override;
+    void _endNotificationBatch() override;
 
 protected:
     /** @brief This is an helper function that finishes a construction of a freshly created TimelineItemModel */
     static void finishConstruct(const std::shared_ptr<TimelineItemModel> &ptr);
+    /** @brief Store the change of the items in the given range until the end of the batch.
+        Returns false if the change cannot be batched and must be sent now */
+    bool batchChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles);
+    /** @brief Send the batched changes */
+    void flushBatchedChanges();
+
+    /** @brief Depth of the nested notification batches */
+    int m_batchDepth{0};
+    /** @brief The changed roles of each item, by item id, collected during a batch. An empty list means all roles */
+    std::map<int, QVector<int>> m_batchedChanges;
+    int m_batchedNotifications{0};
+    int m_sentBatchNotifications{0};
 
 Q_SIGNALS:
     /** @brief Triggered when a video track visibility changed */
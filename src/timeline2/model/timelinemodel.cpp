@@ -2396,6 +2396,43 @@ std::unordered_set<int> TimelineModel::getItemsInRange(int trackId, int start, i
     return allClips;
 }
 
+TimelineModel::NotificationBatch::NotificationBatch(TimelineModel *model)
+    : m_model(model)
+{
+    m_model->_beginNotificationBatch();
+}
+
+TimelineModel::NotificationBatch::~NotificationBatch()
+{
+    m_model->_endNotificationBatch();
+}
+
+int TimelineModel::getPreviousItemEnd(int trackId, int position, const std::unordered_set<int> &exceptions)
+{
+    READ_LOCK();
+    int lastEnd = -1;
+    if (isSubtitleTrack(trackId)) {
+        std::unordered_set<int> subs = getItemsInRange(trackId, 0, position);
+        for (int id : subs) {
+            if (exceptions.count(id) == 0) {
+                lastEnd = qMax(lastEnd, getItemEnd(id));
+            }
+        }
+        return lastEnd;
+    }
+    // Clips and compositions of a track end in the same order as they start
+    const auto track = getTrackById_const(trackId);
+    int clipId = track->getPreviousClip(position, exceptions);
+    if (clipId > -1) {
+        lastEnd = getClipEnd(clipId);
+    }
+    int compoId = track->getPreviousComposition(position, exceptions);
+    if (compoId > -1) {
+        lastEnd = qMax(lastEnd, getCompositionEnd(compoId));
+    }
+    return lastEnd;
+}
+
 bool TimelineModel::requestFakeGroupMove(int clipId, int groupId, int delta_track, int delta_pos, bool updateView, bool logUndo)
 {
     TRACE(clipId, groupId, delta_track, delta_pos, updateView, logUndo);
@@ -2647,6 +2684,7 @@ bool TimelineModel::requestGroupMove(int itemId, int groupId, int delta_track, i
 {
     QWriteLocker locker(&m_lock);
     TRACE(itemId, groupId, delta_track, delta_pos, updateView, logUndo);
+    NotificationBatch batch(this);
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
     bool res = false;
@@ -3741,13 +3779,13 @@ int TimelineModel::requestItemResize(int itemId, int size, bool right, bool logU
                                                                     secondMixData.firstClipInOut.second - secondMixData.secondClipInOut.first,
                                                                     currentMixCut - mixOffset);
                             QModelIndex ix = makeClipIndexFromID(secondMixData.secondClipId);
-                            Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                            notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                             return true;
                         };
                         Fun adjust_mix_undo = [this, tid, mixData, currentMixCut, currentMixDuration]() {
                             getTrackById_const(tid)->setMixDuration(mixData.second.secondClipId, currentMixDuration, currentMixCut);
                             QModelIndex ix = makeClipIndexFromID(mixData.second.secondClipId);
-                            Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                            notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                             return true;
                         };
                         PUSH_LAMBDA(adjust_mix_undo, undo);
@@ -3766,13 +3804,13 @@ int TimelineModel::requestItemResize(int itemId, int size, bool right, bool logU
                                            mixOffset = mixData.first.firstClipInOut.second - (in + size)]() {
                             getTrackById_const(tid)->setMixDuration(itemId, currentMixDuration - mixOffset, currentMixCut - mixOffset);
                             QModelIndex ix = makeClipIndexFromID(itemId);
-                            Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                            notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                             return true;
                         };
                         Fun adjust_mix_undo = [this, tid, itemId, currentMixCut, currentMixDuration]() {
                             getTrackById_const(tid)->setMixDuration(itemId, currentMixDuration, currentMixCut);
                             QModelIndex ix = makeClipIndexFromID(itemId);
-                            Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                            notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                             return true;
                         };
                         PUSH_LAMBDA(adjust_mix1, adjust_mix);
@@ -3805,14 +3843,14 @@ int TimelineModel::requestItemResize(int itemId, int size, bool right, bool logU
                                 getTrackById_const(tid)->setMixDuration(firstMixData.secondClipId,
                                                                         firstMixData.firstClipInOut.second - firstMixData.secondClipInOut.first, currentMixCut);
                                 QModelIndex ix = makeClipIndexFromID(firstMixData.secondClipId);
-                                Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                                notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                             }
                             return true;
                         };
                         Fun adjust_mix_undo = [this, tid, mixData, currentMixCut, currentMixDuration]() {
                             getTrackById_const(tid)->setMixDuration(mixData.first.secondClipId, currentMixDuration, currentMixCut);
                             QModelIndex ix = makeClipIndexFromID(mixData.first.secondClipId);
-                            Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                            notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                             return true;
                         };
                         PUSH_LAMBDA(adjust_mix_undo, undo);
@@ -3831,13 +3869,13 @@ int TimelineModel::requestItemResize(int itemId, int size, bool right, bool logU
                         Fun adjust_mix1 = [this, tid, currentMixCut, secondId = mixData.second.secondClipId, updatedMixDuration]() {
                             getTrackById_const(tid)->setMixDuration(secondId, updatedMixDuration, currentMixCut);
                             QModelIndex ix = makeClipIndexFromID(secondId);
-                            Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                            notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                             return true;
                         };
                         Fun adjust_mix_undo = [this, tid, secondId = mixData.second.secondClipId, currentMixCut, currentMixDuration]() {
                             getTrackById_const(tid)->setMixDuration(secondId, currentMixDuration, currentMixCut);
                             QModelIndex ix = makeClipIndexFromID(secondId);
-                            Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                            notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                             return true;
                         };
                         PUSH_LAMBDA(adjust_mix1, adjust_mix);
@@ -3897,13 +3935,13 @@ int TimelineModel::requestItemResize(int itemId, int size, bool right, bool logU
                                                                                 secondMixData.firstClipInOut.second - secondMixData.secondClipInOut.first,
                                                                                 currentMixCut - offset);
                                     QModelIndex ix = makeClipIndexFromID(secondMixData.secondClipId);
-                                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                                     return true;
                                 };
                                 Fun adjust_mix_undo = [this, trackId, mixData, currentMixCut, currentMixDuration]() {
                                     getTrackById_const(trackId)->setMixDuration(mixData.second.secondClipId, currentMixDuration, currentMixCut);
                                     QModelIndex ix = makeClipIndexFromID(mixData.second.secondClipId);
-                                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                                     return true;
                                 };
                                 PUSH_LAMBDA(adjust_mix2, adjust_mix);
@@ -4008,14 +4046,14 @@ bool TimelineModel::requestItemResize(int itemId, int &size, bool right, bool lo
                 Fun local_update = [this, itemId, tid, mixData, mixDuration] {
                     getTrackById_const(tid)->setMixDuration(itemId, qMax(1, mixDuration), mixData.first.mixOffset);
                     QModelIndex ix = makeClipIndexFromID(itemId);
-                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                     return true;
                 };
                 Fun local_update_undo = [this, itemId, tid, mixData, currentMixDuration] {
                     if (getTrackById_const(tid)->hasStartMix(itemId)) {
                         getTrackById_const(tid)->setMixDuration(itemId, currentMixDuration, mixData.first.mixOffset);
                         QModelIndex ix = makeClipIndexFromID(itemId);
-                        Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                        notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                     }
                     return true;
                 };
@@ -4099,13 +4137,13 @@ int TimelineModel::requestItemRippleResize(const std::shared_ptr<TimelineItemMod
                             MixInfo secondMixData = getTrackById_const(tid)->getMixInfo(itemId).second;
                             int offset = mixData.second.firstClipInOut.second - secondMixData.firstClipInOut.second;
                             getTrackById_const(tid)->setMixDuration(secondMixData.secondClipId, secondMixData.firstClipInOut.second -
-        secondMixData.secondClipInOut.first, currentMixCut - offset); QModelIndex ix = makeClipIndexFromID(secondMixData.secondClipId); Q_EMIT dataChanged(ix,
+        secondMixData.secondClipInOut.first, currentMixCut - offset); QModelIndex ix = makeClipIndexFromID(secondMixData.secondClipId); notifyChange(ix,
         ix, {TimelineModel::MixRole,TimelineModel::MixCutRole}); return true;
                         };
                         Fun adjust_mix_undo = [this, tid, mixData, currentMixCut, currentMixDuration]() {
                             getTrackById_const(tid)->setMixDuration(mixData.second.secondClipId, currentMixDuration, currentMixCut);
                             QModelIndex ix = makeClipIndexFromID(mixData.second.secondClipId);
-                            Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole,TimelineModel::MixCutRole});
+                            notifyChange(ix, ix, {TimelineModel::MixRole,TimelineModel::MixCutRole});
                             return true;
                         };
                         PUSH_LAMBDA(adjust_mix_undo, undo);
@@ -4205,13 +4243,13 @@ int TimelineModel::requestItemRippleResize(const std::shared_ptr<TimelineItemMod
                                                                                 secondMixData.firstClipInOut.second - secondMixData.secondClipInOut.first,
                                                                                 currentMixCut - offset);
                                     QModelIndex ix = makeClipIndexFromID(secondMixData.secondClipId);
-                                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                                     return true;
                                 };
                                 Fun adjust_mix_undo = [this, trackId, mixData, currentMixCut, currentMixDuration]() {
                                     getTrackById_const(trackId)->setMixDuration(mixData.second.secondClipId, currentMixDuration, currentMixCut);
                                     QModelIndex ix = makeClipIndexFromID(mixData.second.secondClipId);
-                                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                                     return true;
                                 };
                                 PUSH_LAMBDA(adjust_mix2, adjust_mix);
@@ -4326,13 +4364,13 @@ bool TimelineModel::requestItemRippleResize(const std::shared_ptr<TimelineItemMo
                 Fun local_update = [this, itemId, tid, mixData, mixDuration] {
                     getTrackById_const(tid)->setMixDuration(itemId, qMax(1, mixDuration), mixData.first.mixOffset);
                     QModelIndex ix = makeClipIndexFromID(itemId);
-                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole,TimelineModel::MixCutRole});
+                    notifyChange(ix, ix, {TimelineModel::MixRole,TimelineModel::MixCutRole});
                     return true;
                 };
                 Fun local_update_undo = [this, itemId, tid, mixData, currentMixDuration] {
                     getTrackById_const(tid)->setMixDuration(itemId, currentMixDuration, mixData.first.mixOffset);
                     QModelIndex ix = makeClipIndexFromID(itemId);
-                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole,TimelineModel::MixCutRole});
+                    notifyChange(ix, ix, {TimelineModel::MixRole,TimelineModel::MixCutRole});
                     return true;
                 };
                 local_update();
@@ -6258,7 +6296,7 @@ bool TimelineModel::requestClipReload(int clipId, int forceDuration, Fun &local_
         getTrackById(old_trackId)->requestClipInsertion(clipId, oldPos, refreshView, true, local_undo, local_redo, false, false, {}, true);
         if (maxDuration != m_allClips[clipId]->getMaxDuration()) {
             QModelIndex ix = makeClipIndexFromID(clipId);
-            Q_EMIT dataChanged(ix, ix, {TimelineModel::MaxDurationRole});
+            notifyChange(ix, ix, TimelineModel::MaxDurationRole);
         }
     }
     return clipIsShorter;
@@ -7083,7 +7121,7 @@ void TimelineModel::requestResizeMix(int cid, int duration, MixAlignment align,
             Fun adjust_mix_undo = [this, tid, cid, prevCut = m_allClips.at(cid)->getMixCutPosition(), prevDuration = m_allClips.at(cid)->getMixDuration()]() {
                 getTrackById_const(tid)->setMixDuration(cid, prevDuration, prevCut);
                 QModelIndex ix = makeClipIndexFromID(cid);
-                Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                 return true;
             };
             if (align == MixAlignment::AlignLeft) {
@@ -7123,7 +7161,7 @@ void TimelineModel::requestResizeMix(int cid, int duration, MixAlignment align,
                 Fun adjust_mix = [this, tid, cid, updatedDuration]() {
                     getTrackById_const(tid)->setMixDuration(cid, updatedDuration, updatedDuration);
                     QModelIndex ix = makeClipIndexFromID(cid);
-                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                     return true;
                 };
                 adjust_mix();
@@ -7157,7 +7195,7 @@ void TimelineModel::requestResizeMix(int cid, int duration, MixAlignment align,
                 Fun adjust_mix = [this, tid, cid, updatedDuration]() {
                     getTrackById_const(tid)->setMixDuration(cid, updatedDuration, 0);
                     QModelIndex ix = makeClipIndexFromID(cid);
-                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                     return true;
                 };
                 adjust_mix();
@@ -7206,7 +7244,7 @@ void TimelineModel::requestResizeMix(int cid, int duration, MixAlignment align,
                 Fun adjust_mix = [this, tid, cid, updatedDuration, mixCutPos]() {
                     getTrackById_const(tid)->setMixDuration(cid, updatedDuration, mixCutPos);
                     QModelIndex ix = makeClipIndexFromID(cid);
-                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                     return true;
                 };
                 adjust_mix();
@@ -7287,7 +7325,7 @@ void TimelineModel::requestResizeMix(int cid, int duration, MixAlignment align,
                 Fun adjust_mix = [this, tid, cid, updatedDuration, mixCutPos]() {
                     getTrackById_const(tid)->setMixDuration(cid, updatedDuration, mixCutPos);
                     QModelIndex ix = makeClipIndexFromID(cid);
-                    Q_EMIT dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                    notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
                     return true;
                 };
                 adjust_mix();
@@ -93,6 +93,23 @@ protected:
     TimelineModel(const QUuid &uuid, std::weak_ptr<DocUndoStack> undo_stack);
 
 public:
+    /** @class NotificationBatch
+        @brief While an instance is alive, the item change notifications of the timeline are collected instead of being sent to the view.
+        When the outermost batch ends, they are sent as a minimal set of dataChanged signals, one per range of consecutive rows sharing
+        the same roles. Use it around operations touching many items, batches can be nested.
+     */
+    class NotificationBatch
+    {
+    public:
+        explicit NotificationBatch(TimelineModel *model);
+        ~NotificationBatch();
+        NotificationBatch(const NotificationBatch &) = delete;
+        NotificationBatch &operator=(const NotificationBatch &) = delete;
+
+    private:
+        TimelineModel *m_model;
+    };
+
     friend class TrackModel;
     friend class TimelineTabs;
     friend class ProjectManager;
@@ -812,6 +829,12 @@ public:
      * @param listCompositions if enabled, the list will also contains composition ids
      */
     std::unordered_set<int> getItemsInRange(int trackId, int start, int end = -1, bool listCompositions = true);
+    /** @brief Returns the end of the item (clip, composition or subtitle) ending last among the items starting before a position, or -1 if there is none.
+     * @param trackId is the id of the track for concerned items
+     * @param position only items starting before this position are considered
+     * @param exceptions items to ignore
+     */
+    int getPreviousItemEnd(int trackId, int position, const std::unordered_set<int> &exceptions);
 
     /** @brief Returns a list of all luma files used in the project
      */
@@ -1116,4 +1139,6 @@ protected:
     virtual QModelIndex makeCompositionIndexFromID(int) const = 0;
     virtual QModelIndex makeTrackIndexFromID(int) const = 0;
     virtual void _resetView() = 0;
+    virtual void _beginNotificationBatch() = 0;
+    virtual void _endNotificationBatch() = 0;
 };
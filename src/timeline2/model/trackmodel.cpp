@@ -19,6 +19,9 @@
 #include "timelinemodel.hpp"
 #include <QDebug>
 #include <QModelIndex>
+#include <algorithm>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <mlt++/MltTransition.h>
 
@@ -60,7 +63,7 @@ TrackModel::TrackModel(const std::weak_ptr<TimelineModel> &parent, int id, const
             if (auto ptr2 = m_parent.lock()) {
                 QModelIndex ix = ptr2->makeTrackIndexFromID(m_id);
                 qDebug() << "==== TRACK ZONES CHANGED";
-                Q_EMIT ptr2->dataChanged(ix, ix, roles);
+                ptr2->notifyChange(ix, ix, roles);
             }
         });
     } else {
@@ -106,11 +109,30 @@ TrackModel::~TrackModel()
         m_sameCompositions.clear();
         m_allClips.clear();
         m_allCompositions.clear();
+        m_clipPos.clear();
+        m_clipRows.clear();
+        m_compositionRows.clear();
         m_track->remove_track(1);
         m_track->remove_track(0);
     }
 }
 
+void TrackModel::insertRow(std::vector<int> &rows, int itemId)
+{
+    auto it = std::lower_bound(rows.begin(), rows.end(), itemId);
+    if (it == rows.end() || *it != itemId) {
+        rows.insert(it, itemId);
+    }
+}
+
+void TrackModel::removeRow(std::vector<int> &rows, int itemId)
+{
+    auto it = std::lower_bound(rows.begin(), rows.end(), itemId);
+    if (it != rows.end() && *it == itemId) {
+        rows.erase(it);
+    }
+}
+
 int TrackModel::construct(const std::weak_ptr<TimelineModel> &parent, int id, int pos, const QString &trackName, bool audioTrack, bool singleOperation)
 {
     std::shared_ptr<TrackModel> track(new TrackModel(parent, id, trackName, audioTrack));
@@ -191,8 +213,10 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
         if (auto ptr = m_parent.lock()) {
             std::shared_ptr<ClipModel> clip = ptr->getClipPtr(clipId);
             m_allClips[clip->getId()] = clip; // store clip
+            insertRow(m_clipRows, clipId);
             // update clip position and track
             clip->setPosition(position);
+            m_clipPos.emplace(position, clipId);
             if (finalMove) {
                 clip->setSubPlaylistIndex(subPlaylist, m_id);
             }
@@ -436,7 +460,9 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
             m_playlists[target_track].consolidate_blanks();
             m_allClips[clipId]->setCurrentTrackId(-1);
             // m_allClips[clipId]->setSubPlaylistIndex(-1);
+            m_clipPos.erase({m_allClips[clipId]->getPosition(), clipId});
             m_allClips.erase(clipId);
+            removeRow(m_clipRows, clipId);
             delete prod;
             field->unblock();
             m_playlists[target_track].unlock();
@@ -706,7 +732,9 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
             // The second is parameter is delta - 1 because this function expects an out time, which is basically size - 1
             m_playlists[target_track].insert_blank(blank_index, delta - 1);
             if (!right) {
+                m_clipPos.erase({clip_position, clipId});
                 m_allClips[clipId]->setPosition(clip_position + delta);
+                m_clipPos.emplace(clip_position + delta, clipId);
                 // Because we inserted blank before, the index of our clip has increased
                 target_clip_mutable++;
             }
@@ -805,7 +833,9 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                     // m_track->unblock();
                 }
                 if (!right && err == 0) {
+                    m_clipPos.erase({m_allClips[clipId]->getPosition(), clipId});
                     m_allClips[clipId]->setPosition(m_playlists[target_track].clip_start(target_clip_mutable));
+                    m_clipPos.emplace(m_allClips[clipId]->getPosition(), clipId);
                 }
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
@@ -831,10 +861,9 @@ int TrackModel::getId() const
 int TrackModel::getClipByStartPosition(int position) const
 {
     READ_LOCK();
-    for (auto &clip : m_allClips) {
-        if (clip.second->getPosition() == position) {
-            return clip.second->getId();
-        }
+    auto it = m_clipPos.lower_bound({position, std::numeric_limits<int>::min()});
+    if (it != m_clipPos.end() && it->first == position) {
+        return it->second;
     }
     return -1;
 }
@@ -886,13 +915,60 @@ QSharedPointer<Mlt::Producer> TrackModel::getClipProducer(int clipId)
 int TrackModel::getCompositionByPosition(int position)
 {
     READ_LOCK();
-    for (const auto &comp : m_compoPos) {
-        if (comp.first == position) {
-            return comp.second;
-        } else if (comp.first < position) {
-            if (comp.first + m_allCompositions[comp.second]->getPlaytime() >= position) {
-                return comp.second;
-            }
+    // Compositions don't overlap, so only the last two compositions starting at or before position can match.
+    // The first one wins if it ends right before position
+    auto it = m_compoPos.upper_bound(position);
+    if (it == m_compoPos.begin()) {
+        return -1;
+    }
+    --it;
+    if (it != m_compoPos.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + m_allCompositions[prev->second]->getPlaytime() >= position) {
+            return prev->second;
+        }
+    }
+    if (it->first == position || it->first + m_allCompositions[it->second]->getPlaytime() >= position) {
+        return it->second;
+    }
+    return -1;
+}
+
+int TrackModel::getNextClip(int position) const
+{
+    READ_LOCK();
+    auto it = m_clipPos.lower_bound({position, std::numeric_limits<int>::min()});
+    return it == m_clipPos.end() ? -1 : it->second;
+}
+
+int TrackModel::getPreviousClip(int position, const std::unordered_set<int> &exceptions) const
+{
+    READ_LOCK();
+    auto it = m_clipPos.lower_bound({position, std::numeric_limits<int>::min()});
+    while (it != m_clipPos.begin()) {
+        --it;
+        if (exceptions.count(it->second) == 0) {
+            return it->second;
+        }
+    }
+    return -1;
+}
+
+int TrackModel::getNextComposition(int position) const
+{
+    READ_LOCK();
+    auto it = m_compoPos.lower_bound(position);
+    return it == m_compoPos.end() ? -1 : it->second;
+}
+
+int TrackModel::getPreviousComposition(int position, const std::unordered_set<int> &exceptions) const
+{
+    READ_LOCK();
+    auto it = m_compoPos.lower_bound(position);
+    while (it != m_compoPos.begin()) {
+        --it;
+        if (exceptions.count(it->second) == 0) {
+            return it->second;
         }
     }
     return -1;
@@ -901,28 +977,30 @@ int TrackModel::getCompositionByPosition(int position)
 int TrackModel::getClipByRow(int row) const
 {
     READ_LOCK();
-    if (row >= static_cast<int>(m_allClips.size())) {
+    if (row >= static_cast<int>(m_clipRows.size())) {
         return -1;
     }
-    auto it = m_allClips.cbegin();
-    std::advance(it, row);
-    return (*it).first;
+    return m_clipRows[size_t(row)];
 }
 
 std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
 {
     READ_LOCK();
     std::unordered_set<int> ids;
-    for (const auto &clp : m_allClips) {
-        int pos = clp.second->getPosition();
-        int length = clp.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
+    auto first = m_clipPos.lower_bound({position, std::numeric_limits<int>::min()});
+    // Clips starting before position may still cover it. Clips never contain each other, so their ends are ordered
+    // like their starts and we can stop at the first one that ends before position
+    for (auto it = std::make_reverse_iterator(first); it != m_clipPos.rend(); ++it) {
+        if (it->first + m_allClips.at(it->second)->getPlaytime() - 1 < position) {
+            break;
         }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(clp.first);
+        if (end == -1 || it->first < end) {
+            ids.insert(it->second);
         }
     }
+    for (auto it = first; it != m_clipPos.end() && (end == -1 || it->first < end); ++it) {
+        ids.insert(it->second);
+    }
     return ids;
 }
 
@@ -930,7 +1008,7 @@ int TrackModel::getRowfromClip(int clipId) const
 {
     READ_LOCK();
     Q_ASSERT(m_allClips.count(clipId) > 0);
-    return int(std::distance(m_allClips.begin(), m_allClips.find(clipId)));
+    return int(std::distance(m_clipRows.cbegin(), std::lower_bound(m_clipRows.cbegin(), m_clipRows.cend(), clipId)));
 }
 
 std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end)
@@ -938,17 +1016,17 @@ std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end
     READ_LOCK();
     // TODO: this function doesn't take into accounts the fact that there are two tracks
     std::unordered_set<int> ids;
-    for (const auto &compo : m_allCompositions) {
-        int pos = compo.second->getPosition();
-        int length = compo.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
-        }
-        if (pos >= position || pos + length - 1 >= position) {
-
-            ids.insert(compo.first);
+    auto it = m_compoPos.lower_bound(position);
+    // Compositions don't overlap, only the previous one can cover position
+    if (it != m_compoPos.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + m_allCompositions.at(prev->second)->getPlaytime() - 1 >= position && (end == -1 || prev->first < end)) {
+            ids.insert(prev->second);
         }
     }
+    for (; it != m_compoPos.end() && (end == -1 || it->first < end); ++it) {
+        ids.insert(it->second);
+    }
     return ids;
 }
 
@@ -956,7 +1034,8 @@ int TrackModel::getRowfromComposition(int tid) const
 {
     READ_LOCK();
     Q_ASSERT(m_allCompositions.count(tid) > 0);
-    return int(m_allClips.size()) + int(std::distance(m_allCompositions.begin(), m_allCompositions.find(tid)));
+    return int(m_clipRows.size()) +
+           int(std::distance(m_compositionRows.cbegin(), std::lower_bound(m_compositionRows.cbegin(), m_compositionRows.cend(), tid)));
 }
 
 QVariant TrackModel::getProperty(const QString &name) const
@@ -1007,6 +1086,16 @@ bool TrackModel::checkConsistency()
         clips.emplace_back(c.second->getPosition(), c.first);
     }
     std::sort(clips.begin(), clips.end());
+    if (!std::equal(clips.begin(), clips.end(), m_clipPos.begin(), m_clipPos.end())) {
+        qDebug() << "Error: the clip positions index doesn't match the clips";
+        return false;
+    }
+    if (!std::equal(m_allClips.begin(), m_allClips.end(), m_clipRows.begin(), m_clipRows.end(), [](const auto &c, int id) { return c.first == id; }) ||
+        !std::equal(m_allCompositions.begin(), m_allCompositions.end(), m_compositionRows.begin(), m_compositionRows.end(),
+                    [](const auto &c, int id) { return c.first == id; })) {
+        qDebug() << "Error: the row index doesn't match the items";
+        return false;
+    }
     int last_out = 0;
     for (size_t i = 0; i < clips.size(); ++i) {
         auto cur_clip = m_allClips[clips[i].second];
@@ -1476,6 +1565,7 @@ Fun TrackModel::requestCompositionDeletion_lambda(int compoId, bool updateView,
         }
         m_allCompositions[compoId]->setCurrentTrackId(-1);
         m_allCompositions.erase(compoId);
+        removeRow(m_compositionRows, compoId);
         m_compoPos.erase(old_in);
         ptr->m_snaps->removePoint(old_in);
         ptr->m_snaps->removePoint(old_out);
@@ -1493,9 +1583,7 @@ int TrackModel::getCompositionByRow(int row) const
         return -1;
     }
     Q_ASSERT(row <= int(m_allClips.size() + m_allCompositions.size()));
-    auto it = m_allCompositions.cbegin();
-    std::advance(it, row - int(m_allClips.size()));
-    return (*it).first;
+    return m_compositionRows[size_t(row) - m_clipRows.size()];
 }
 
 int TrackModel::getCompositionsCount() const
@@ -1519,6 +1607,7 @@ Fun TrackModel::requestCompositionInsertion_lambda(int compoId, int position, bo
             if (auto ptr = m_parent.lock()) {
                 std::shared_ptr<CompositionModel> composition = ptr->getCompositionPtr(compoId);
                 m_allCompositions[composition->getId()] = composition; // store clip
+                insertRow(m_compositionRows, compoId);
                 // update clip position and track
                 composition->setCurrentTrackId(getId());
                 int new_in = position;
@@ -1654,7 +1743,7 @@ void TrackModel::lock()
     setProperty(QStringLiteral("kdenlive:locked_track"), QStringLiteral("1"));
     if (auto ptr = m_parent.lock()) {
         QModelIndex ix = ptr->makeTrackIndexFromID(m_id);
-        Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::IsLockedRole});
+        ptr->notifyChange(ix, ix, {TimelineModel::IsLockedRole});
     }
 }
 void TrackModel::unlock()
@@ -1662,7 +1751,7 @@ void TrackModel::unlock()
     setProperty(QStringLiteral("kdenlive:locked_track"), nullptr);
     if (auto ptr = m_parent.lock()) {
         QModelIndex ix = ptr->makeTrackIndexFromID(m_id);
-        Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::IsLockedRole});
+        ptr->notifyChange(ix, ix, {TimelineModel::IsLockedRole});
     }
 }
 
@@ -1789,7 +1878,7 @@ bool TrackModel::requestRemoveMix(std::pair<int, int> clipIds, Fun &undo, Fun &r
                 /*QModelIndex ix = ptr->makeClipIndexFromID(clipIds.first);
                 Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::DurationRole});*/
                 QModelIndex ix2 = ptr->makeClipIndexFromID(clipIds.second);
-                Q_EMIT ptr->dataChanged(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                ptr->notifyChange(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
             }
             return true;
         };
@@ -1833,7 +1922,7 @@ bool TrackModel::requestRemoveMix(std::pair<int, int> clipIds, Fun &undo, Fun &r
                 m_sameCompositions[clipIds.second] = asset;
                 m_mixList.insert(clipIds.first, clipIds.second);
                 QModelIndex ix2 = ptr->makeClipIndexFromID(clipIds.second);
-                Q_EMIT ptr->dataChanged(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                ptr->notifyChange(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
             }
             return true;
         };
@@ -2137,7 +2226,7 @@ bool TrackModel::requestClipMix(const QString &mixId, std::pair<int, int> clipId
             std::shared_ptr<ClipModel> movedClip(ptr->getClipPtr(clipIds.second));
             movedClip->setMixDuration(0);
             QModelIndex ix = ptr->makeClipIndexFromID(clipIds.second);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
             QScopedPointer<Mlt::Field> field(m_track->field());
             field->block();
             field->disconnect_service(transition);
@@ -2170,7 +2259,7 @@ bool TrackModel::requestClipMix(const QString &mixId, std::pair<int, int> clipId
                                            ->requestResize(mixPosition + mixDurations.first + mixDurations.second - firstClipPos, true, local_undo, local_redo,
                                                            true, true);
                     QModelIndex ix = ptr->makeClipIndexFromID(clipIds.second);
-                    Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
+                    ptr->notifyChange(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
                 }
             }
             return result;
@@ -2269,7 +2358,7 @@ bool TrackModel::deleteMix(int clipId, bool final, bool notify)
             std::shared_ptr<ClipModel> movedClip(ptr->getClipPtr(clipId));
             movedClip->setMixDuration(final ? 0 : 1);
             QModelIndex ix = ptr->makeClipIndexFromID(clipId);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
         }
         if (final) {
             Mlt::Transition &transition = *static_cast<Mlt::Transition *>(m_sameCompositions[clipId]->getAsset());
@@ -2329,7 +2418,7 @@ bool TrackModel::createMix(MixInfo info, std::pair<QString, QVector<QPair<QStrin
         m_mixList.insert(info.firstClipId, info.secondClipId);
         if (finalMove) {
             QModelIndex ix2 = ptr->makeClipIndexFromID(info.secondClipId);
-            Q_EMIT ptr->dataChanged(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+            ptr->notifyChange(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
         }
         return true;
     }
@@ -2398,7 +2487,7 @@ bool TrackModel::createMix(std::pair<int, int> clipIds, std::pair<int, int> mixD
         std::shared_ptr<ClipModel> movedClip(ptr->getClipPtr(clipIds.second));
         movedClip->setMixDuration(mixData.second);
         QModelIndex ix = ptr->makeClipIndexFromID(clipIds.second);
-        Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+        ptr->notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
         bool reverse = movedClip->getSubPlaylistIndex() == 0;
         // Insert mix transition
         QString assetName;
@@ -2515,7 +2604,7 @@ void TrackModel::syncronizeMixes(bool finalMove)
         if (auto ptr = m_parent.lock()) {
             ptr->getClipPtr(secondClipId)->setMixDuration(mixOut - mixIn);
             QModelIndex ix = ptr->makeClipIndexFromID(secondClipId);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
         }
     }
     for (int i : std::as_const(toDelete)) {
@@ -10,11 +10,13 @@
 #include <QReadWriteLock>
 #include <QSharedPointer>
 #include <memory>
+#include <set>
 #include <mlt++/MltPlaylist.h>
 #include <mlt++/MltProfile.h>
 #include <mlt++/MltTractor.h>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class TimelineModel;
 class ClipModel;
@@ -295,6 +297,15 @@ protected:
 
     /** @brief Returns the composition id on this track starting position requested, or -1 if not found */
     int getCompositionByPosition(int position);
+    /** @brief Returns the id of the first clip starting at or after position, or -1 if there is none */
+    int getNextClip(int position) const;
+    /** @brief Returns the id of the last clip starting before position, ignoring the clips in exceptions, or -1 if there is none.
+        Since the clips of a track never contain each other, this is also the clip ending last before position */
+    int getPreviousClip(int position, const std::unordered_set<int> &exceptions = {}) const;
+    /** @brief Returns the id of the first composition starting at or after position, or -1 if there is none */
+    int getNextComposition(int position) const;
+    /** @brief Returns the id of the last composition starting before position, ignoring the compositions in exceptions, or -1 if there is none */
+    int getPreviousComposition(int position, const std::unordered_set<int> &exceptions = {}) const;
     /** @brief Add a track effect */
     bool addEffect(const QString &effectId);
 
@@ -370,6 +381,20 @@ private:
      */
     std::map<int, int> m_compoPos;
 
+    /** Same for the clips, stored as {position, clip_id}, to answer range queries without going through all clips.
+     *  Clips on the two playlists can overlap in a mix, so there can be two clips at a given position
+     */
+    std::set<std::pair<int, int>> m_clipPos;
+
+    /** Ids of the clips and of the compositions in row order (the order of m_allClips and m_allCompositions), to get the row of an item
+     *  with a binary search. New items usually get the highest id, so keeping these sorted is cheap
+     */
+    std::vector<int> m_clipRows;
+    std::vector<int> m_compositionRows;
+    /** @brief Add or remove an item id in m_clipRows or m_compositionRows */
+    static void insertRow(std::vector<int> &rows, int itemId);
+    static void removeRow(std::vector<int> &rows, int itemId);
+
     /// This is a lock that ensures safety in case of concurrent access
     mutable QReadWriteLock m_lock;
     void reverseCompositionXml(const QString &composition, QDomElement xml);
@@ -35,11 +35,11 @@ PreviewManager::PreviewManager(Mlt::Tractor *tractor, QUuid uuid, QObject *paren
     , m_overlayTrack(nullptr)
     , m_warnOnCrash(true)
     , m_previewTrackIndex(-1)
+    , m_renderFailed(false)
     , m_initialized(false)
 {
     m_previewGatherTimer.setSingleShot(true);
     m_previewGatherTimer.setInterval(200);
-    QObject::connect(&m_previewProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &PreviewManager::processEnded);
 
     if (KdenliveSettings::kdenliverendererpath().isEmpty() || !QFileInfo::exists(KdenliveSettings::kdenliverendererpath())) {
         KdenliveSettings::setKdenliverendererpath(QString());
@@ -49,9 +49,6 @@ PreviewManager::PreviewManager(Mlt::Tractor *tractor, QUuid uuid, QObject *paren
                                i18n("Could not find the kdenlive_render application, something is wrong with your installation. Rendering will not work"));
         }
     }
-
-    connect(this, &PreviewManager::abortPreview, &m_previewProcess, &QProcess::kill, Qt::DirectConnection);
-    connect(&m_previewProcess, &QProcess::readyReadStandardError, this, &PreviewManager::receivedStderr);
 }
 
 PreviewManager::~PreviewManager()
@@ -485,12 +482,12 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
     }
     if (add) {
         Q_EMIT dirtyChunksChanged();
-        if (m_previewProcess.state() == QProcess::NotRunning && KdenliveSettings::autopreview()) {
+        if (!previewProcessRunning() && KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     } else {
         // Remove processed chunks
-        bool isRendering = m_previewProcess.state() != QProcess::NotRunning;
+        bool isRendering = previewProcessRunning();
         m_previewGatherTimer.stop();
         abortRendering();
         m_tractor->lock();
@@ -520,16 +517,18 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
 
 void PreviewManager::abortRendering()
 {
-    if (m_previewProcess.state() == QProcess::NotRunning) {
+    if (!previewProcessRunning()) {
         return;
     }
     // Don't display error message on voluntary abort
     m_warnOnCrash = false;
     Q_EMIT abortPreview();
-    m_previewProcess.waitForFinished();
-    if (m_previewProcess.state() != QProcess::NotRunning) {
-        m_previewProcess.kill();
-        m_previewProcess.waitForFinished();
+    for (QProcess *process : std::as_const(m_previewProcesses)) {
+        process->waitForFinished();
+        if (process->state() != QProcess::NotRunning) {
+            process->kill();
+            process->waitForFinished();
+        }
     }
     // Re-init time estimation
     Q_EMIT previewRender(-1, QString(), 1000);
@@ -567,17 +566,18 @@ void PreviewManager::startPreviewRender()
     }
 }
 
-void PreviewManager::receivedStderr()
+void PreviewManager::receivedStderr(QProcess *process)
 {
-    QStringList resultList = QString::fromLocal8Bit(m_previewProcess.readAllStandardError()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    QStringList resultList = QString::fromLocal8Bit(process->readAllStandardError()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
     for (auto &result : resultList) {
         if (result.startsWith(QLatin1String("START:"))) {
-            if (m_previewProcess.state() == QProcess::Running) {
-                workingPreview = result.section(QLatin1String("START:"), 1).simplified().toInt();
-                Q_EMIT workingPreviewChanged();
+            if (process->state() == QProcess::Running) {
+                m_workingChunks.insert(process, result.section(QLatin1String("START:"), 1).simplified().toInt());
+                updateWorkingPreview();
             }
         } else if (result.startsWith(QLatin1String("DONE:"))) {
             int chunk = result.section(QLatin1String("DONE:"), 1).simplified().toInt();
+            m_workingChunks.remove(process);
             m_processedChunks++;
             QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
             Q_EMIT previewRender(chunk, m_cacheDir.absoluteFilePath(fileName), 1000 * m_processedChunks / m_chunksToRender);
@@ -594,43 +594,108 @@ void PreviewManager::doPreviewRender(const QString &scene)
         return;
     }
     QMutexLocker lock(&m_dirtyMutex);
-    Q_ASSERT(m_previewProcess.state() == QProcess::NotRunning);
+    Q_ASSERT(!previewProcessRunning());
+    // Processes from the previous render are finished, discard them
+    for (QProcess *process : std::as_const(m_previewProcesses)) {
+        process->deleteLater();
+    }
+    m_previewProcesses.clear();
+    m_workingChunks.clear();
+    m_renderFailed = false;
     std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end(), chunkSort);
-    const QStringList dirtyChunks = getCompressedList(m_dirtyChunks);
     m_chunksToRender = m_dirtyChunks.count();
     m_processedChunks = 0;
     int chunkSize = KdenliveSettings::timelinechunks();
-    QStringList args{QStringLiteral("preview-chunks"),
-                     scene,
-                     m_cacheDir.absolutePath(),
-                     dirtyChunks.join(QLatin1Char(',')),
-                     QString::number(chunkSize - 1),
-                     pCore->getCurrentProfilePath(),
-                     m_extension,
-                     m_consumerParams.join(QLatin1Char(' '))};
+    // Split the dirty chunks in contiguous slices, one per render process
+    const int workers = qBound(1, KdenliveSettings::previewworkers(), m_chunksToRender);
     pCore->currentDoc()->previewProgress(0);
-    m_previewProcess.start(KdenliveSettings::kdenliverendererpath(), args);
-    if (m_previewProcess.waitForStarted()) {
+    for (int i = 0; i < workers; i++) {
+        int first = i * m_chunksToRender / workers;
+        int last = (i + 1) * m_chunksToRender / workers;
+        const QStringList dirtyChunks = getCompressedList(m_dirtyChunks.mid(first, last - first));
+        QStringList args{QStringLiteral("preview-chunks"),
+                         scene,
+                         m_cacheDir.absolutePath(),
+                         dirtyChunks.join(QLatin1Char(',')),
+                         QString::number(chunkSize - 1),
+                         pCore->getCurrentProfilePath(),
+                         m_extension,
+                         m_consumerParams.join(QLatin1Char(' '))};
+        startPreviewProcess(args);
+    }
+}
+
+void PreviewManager::startPreviewProcess(const QStringList &args)
+{
+    auto *process = new QProcess(this);
+    connect(process, &QProcess::readyReadStandardError, this, [this, process]() { receivedStderr(process); });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, process](int exitCode, QProcess::ExitStatus status) { processEnded(process, exitCode, status); });
+    connect(this, &PreviewManager::abortPreview, process, &QProcess::kill, Qt::DirectConnection);
+    m_previewProcesses << process;
+    process->start(KdenliveSettings::kdenliverendererpath(), args);
+    if (process->waitForStarted()) {
         qDebug() << " -  - -STARTING PREVIEW JOBS . . . STARTED: " << args;
     }
 }
 
-void PreviewManager::processEnded(int exitCode, QProcess::ExitStatus status)
+bool PreviewManager::previewProcessRunning() const
 {
-    const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
-    QFile::remove(sceneList);
+    for (QProcess *process : m_previewProcesses) {
+        if (process->state() != QProcess::NotRunning) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PreviewManager::updateWorkingPreview()
+{
+    int current = -1;
+    for (int chunk : std::as_const(m_workingChunks)) {
+        if (current == -1 || chunk < current) {
+            current = chunk;
+        }
+    }
+    if (current != workingPreview) {
+        workingPreview = current;
+        Q_EMIT workingPreviewChanged();
+    }
+}
+
+void PreviewManager::processEnded(QProcess *process, int exitCode, QProcess::ExitStatus status)
+{
+    int chunk = m_workingChunks.value(process, -1);
+    m_workingChunks.remove(process);
     if (pCore->window() && (status == QProcess::QProcess::CrashExit || exitCode != 0)) {
-        Q_EMIT previewRender(0, m_errorLog, -1);
-        if (workingPreview >= 0) {
-            const QString fileName = QStringLiteral("%1.%2").arg(workingPreview).arg(m_extension);
+        if (chunk >= 0) {
+            const QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
             if (m_cacheDir.exists(fileName)) {
                 m_cacheDir.remove(fileName);
             }
         }
-    } else {
-        // Normal exit and exit code 0: everything okay
+        if (!m_renderFailed) {
+            m_renderFailed = true;
+            // Processes killed by a voluntary abort are not reported
+            if (m_warnOnCrash) {
+                // Only report the first failure and stop the other processes
+                Q_EMIT previewRender(0, m_errorLog, -1);
+                m_warnOnCrash = false;
+                Q_EMIT abortPreview();
+            }
+        }
+    }
+    if (previewProcessRunning()) {
+        updateWorkingPreview();
+        return;
+    }
+    const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
+    QFile::remove(sceneList);
+    if (!m_renderFailed) {
+        // Normal exit and exit code 0 for all processes: everything okay
         pCore->currentDoc()->previewProgress(1000);
     }
+    m_workingChunks.clear();
     workingPreview = -1;
     m_warnOnCrash = true;
     Q_EMIT workingPreviewChanged();
@@ -676,7 +741,7 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
     int end = endFrame - endFrame % chunkSize;
 
     m_previewGatherTimer.stop();
-    bool previewWasRunning = m_previewProcess.state() == QProcess::Running;
+    bool previewWasRunning = previewProcessRunning();
     bool alreadyRendered = false;
     bool wasInDirtyZone = false;
     if (!m_renderedChunks.isEmpty()) {
@@ -684,8 +749,13 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
         std::sort(m_renderedChunks.begin(), m_renderedChunks.end(), chunkSort);
         if (start <= m_renderedChunks.last().toInt() && end >= m_renderedChunks.first().toInt()) {
             alreadyRendered = true;
-        } else if (workingPreview >= start && workingPreview <= end) {
-            alreadyRendered = true;
+        } else {
+            for (int chunk : std::as_const(m_workingChunks)) {
+                if (chunk >= start && chunk <= end) {
+                    alreadyRendered = true;
+                    break;
+                }
+            }
         }
     }
     if (!alreadyRendered && !m_dirtyChunks.isEmpty()) {
@@ -807,7 +877,10 @@ void PreviewManager::gotPreviewRender(int frame, const QString &file, int progre
 void PreviewManager::corruptedChunk(int frame, const QString &fileName)
 {
     Q_EMIT abortPreview();
-    m_previewProcess.waitForFinished();
+    for (QProcess *process : std::as_const(m_previewProcesses)) {
+        process->waitForFinished();
+    }
+    m_workingChunks.clear();
     if (workingPreview >= 0) {
         workingPreview = -1;
         Q_EMIT workingPreviewChanged();
@@ -908,5 +981,5 @@ int PreviewManager::addedTracks() const
 
 bool PreviewManager::isRunning() const
 {
-    return workingPreview >= 0 || m_previewProcess.state() != QProcess::NotRunning;
+    return workingPreview >= 0 || previewProcessRunning();
 }
@@ -10,6 +10,7 @@
 
 #include <QDir>
 #include <QFuture>
+#include <QMap>
 #include <QMutex>
 #include <QProcess>
 #include <QTimer>
@@ -87,8 +88,12 @@ private:
     Mlt::Playlist *m_overlayTrack;
     bool m_warnOnCrash;
     int m_previewTrackIndex;
-    /** @brief: The kdenlive timeline preview process. */
-    QProcess m_previewProcess;
+    /** @brief: The kdenlive timeline preview processes, each one renders a slice of the dirty chunks. */
+    QList<QProcess *> m_previewProcesses;
+    /** @brief: The chunk currently rendered by each preview process. */
+    QMap<QProcess *, int> m_workingChunks;
+    /** @brief: True if one of the preview processes of the current render failed. */
+    bool m_renderFailed;
     /** @brief: The directory used to store the preview files. */
     QDir m_cacheDir;
     /** @brief: The directory used to store undo history of preview files (child of m_cacheDir). */
@@ -115,6 +120,12 @@ private:
     void corruptedChunk(int workingPreview, const QString &fileName);
     /** @brief: Get a compressed list of chunks, like: "0-500,525,575". */
     const QStringList getCompressedList(const QVariantList items) const;
+    /** @brief: Start a kdenlive_render process with the given arguments and add it to the preview processes. */
+    void startPreviewProcess(const QStringList &args);
+    /** @brief: Returns true if at least one preview process is still running. */
+    bool previewProcessRunning() const;
+    /** @brief: Sync workingPreview with the first chunk currently processed. */
+    void updateWorkingPreview();
 
     /** @brief Compare two chunks for usage by std::sort
      * @returns true if @param c1 is less than @param c2
@@ -131,8 +142,8 @@ private Q_SLOTS:
     /** @brief: When the timer collecting invalid zones is done, process. */
     void slotProcessDirtyChunks();
     /** @brief: Process preview rendering output. */
-    void receivedStderr();
-    void processEnded(int exitCode, QProcess::ExitStatus status);
+    void receivedStderr(QProcess *process);
+    void processEnded(QProcess *process, int exitCode, QProcess::ExitStatus status);
 
 public Q_SLOTS:
     /** @brief: Prepare and start rendering. */
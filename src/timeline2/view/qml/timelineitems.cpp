@@ -10,6 +10,8 @@
 #include "capture/mediacapture.h"
 #include "core.h"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioLevelsBuffer.h"
+#include "lib/audio/audioLevelsPyramid.h"
 #include <QElapsedTimer>
 #include <QPainter>
 #include <QPainterPath>
@@ -158,11 +160,12 @@ public:
         // setTextureSize(QSize(1, 1));
         connect(this, &TimelineWaveform::levelsChanged, [&]() {
             if (!m_binId.isEmpty()) {
-                if (m_audioLevels.isEmpty() && m_stream >= 0) {
+                if ((!m_audioLevels || m_audioLevels->isEmpty()) && m_stream >= 0) {
                     update();
                 } else {
                     // Clip changed, reset levels
-                    m_audioLevels.clear();
+                    m_audioLevels.reset();
+                    m_pyramid.reset();
                 }
             }
         });
@@ -178,15 +181,16 @@ public:
         if (m_binId.isEmpty()) {
             return;
         }
-        if (m_audioLevels.isEmpty() && m_stream >= 0) {
+        if ((!m_audioLevels || m_audioLevels->isEmpty()) && m_stream >= 0) {
             m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId, m_stream);
-            if (m_audioLevels.isEmpty()) {
+            if (!m_audioLevels || m_audioLevels->isEmpty()) {
                 return;
             }
+            m_pyramid = pCore->projectItemModel()->getAudioPyramidByBinID(m_binId, m_stream);
             m_audioMax = KdenliveSettings::normalizechannels() ? pCore->projectItemModel()->getAudioMaxLevel(m_binId, m_stream) : 0;
         }
 
-        if (m_outPoint == m_inPoint) {
+        if (!m_audioLevels || m_outPoint == m_inPoint) {
             return;
         }
         QRectF bgRect(0, 0, width(), height());
@@ -217,11 +221,17 @@ public:
             scaleFactor = m_audioMax;
         }
         bool reverse = m_speed < 0;
-        int maxLength = m_audioLevels.length();
+        // The levels may still be generated, only use the part published so far
+        int maxLength = m_audioLevels->size();
         if (reverse) {
             m_inPoint = qMin(m_inPoint, maxLength - m_channels);
         }
         int startPos = int(m_inPoint / indicesPrPixel);
+        // When zoomed out, each drawn step covers several frames: read their peak from the pyramid
+        int frameSpan = 0;
+        if (m_pyramid && m_pyramid->channels() == m_channels) {
+            frameSpan = int(increment * indicesPrPixel / m_channels);
+        }
         if (!KdenliveSettings::displayallchannels()) {
             // Draw merged channels
             double i = 0;
@@ -245,9 +255,9 @@ public:
                 if (idx + m_channels >= maxLength || idx < 0) {
                     break;
                 }
-                level = m_audioLevels.at(idx) / scaleFactor;
+                level = levelAt(idx, frameSpan, reverse) / scaleFactor;
                 for (int k = 1; k < m_channels; k++) {
-                    level = qMax(level, m_audioLevels.at(idx + k) / scaleFactor);
+                    level = qMax(level, levelAt(idx + k, frameSpan, reverse) / scaleFactor);
                 }
                 if (pathDraw) {
                     double val = height() - level * height();
@@ -306,10 +316,10 @@ public:
                     idx += channel;
                     if (idx >= maxLength || idx < 0) break;
                     if (pathDraw) {
-                        level = m_audioLevels.at(idx) * scaleFactor;
+                        level = levelAt(idx, frameSpan, reverse) * scaleFactor;
                         path.lineTo(i, y - level);
                     } else {
-                        level = m_audioLevels.at(idx) * scaleFactor; // divide height by 510 (2*255) to get height
+                        level = levelAt(idx, frameSpan, reverse) * scaleFactor; // divide height by 510 (2*255) to get height
                         painter->drawLine(int(i), int(y - level), int(i), int(y + level));
                     }
                 }
@@ -327,6 +337,20 @@ public:
         }
     }
 
+private:
+    /** @brief Returns the level at sample index @param idx, or the peak of the @param span frames starting there when zoomed out */
+    uint8_t levelAt(int idx, int span, bool reverse) const
+    {
+        if (span < 2) {
+            return m_audioLevels->at(idx);
+        }
+        int frame = idx / m_channels;
+        if (reverse) {
+            frame -= span - 1;
+        }
+        return m_pyramid->peak(idx % m_channels, frame, frame + span);
+    }
+
 Q_SIGNALS:
     void levelsChanged();
     void propertyChanged();
@@ -335,7 +359,8 @@ Q_SIGNALS:
     void audioChannelsChanged();
 
 private:
-    QVector<uint8_t> m_audioLevels;
+    std::shared_ptr<const AudioLevelsBuffer> m_audioLevels;
+    std::shared_ptr<const AudioLevelsPyramid> m_pyramid;
     int m_inPoint;
     int m_outPoint;
     QString m_binId;
@@ -11,10 +11,10 @@
 #include "core.h"
 #include "doc/kthumb.h"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 
 #include <QCryptographicHash>
 #include <QDebug>
-#include <mlt++/MltFilter.h>
 #include <mlt++/MltProfile.h>
 
 ThumbnailProvider::ThumbnailProvider()
@@ -45,18 +45,10 @@ QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSi
                 *size = result.size();
                 return result;
             }
-            std::unique_ptr<Mlt::Producer> prod = binClip->getThumbProducer();
-            if (prod && prod->is_valid()) {
-                if (binClip->clipType() != ClipType::Timeline && binClip->clipType() != ClipType::Playlist) {
-                    Mlt::Profile *prodProfile = &pCore->thumbProfile();
-                    Mlt::Filter scaler(*prodProfile, "swscale");
-                    Mlt::Filter padder(*prodProfile, "resize");
-                    Mlt::Filter converter(*prodProfile, "avcolor_space");
-                    prod->attach(scaler);
-                    prod->attach(padder);
-                    prod->attach(converter);
-                }
-                result = makeThumbnail(std::move(prod), frameNumber, requestedSize);
+            // Reuse a producer with its decoder already open and its filters attached
+            std::shared_ptr<Mlt::Producer> prod = ThumbnailProducerPool::get()->acquire(binClip);
+            if (prod) {
+                result = makeThumbnail(prod, frameNumber, requestedSize);
                 ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false);
             }
         }
@@ -65,7 +57,7 @@ QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSi
     return result;
 }
 
-QImage ThumbnailProvider::makeThumbnail(std::unique_ptr<Mlt::Producer> producer, int frameNumber, const QSize &requestedSize)
+QImage ThumbnailProvider::makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize)
 {
     Q_UNUSED(requestedSize)
     producer->seek(frameNumber);
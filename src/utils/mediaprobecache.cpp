@@ -0,0 +1,199 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "mediaprobecache.hpp"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <vector>
+
+namespace {
+constexpr quint32 cacheMagic = 0x4b4d5043; // KMPC
+// Increase when the probed properties change, older caches are then discarded
+constexpr quint32 cacheVersion = 1;
+} // namespace
+
+std::unique_ptr<MediaProbeCache> MediaProbeCache::instance;
+std::once_flag MediaProbeCache::m_onceFlag;
+
+MediaProbeCache::MediaProbeCache(const QString &path, int maxEntries)
+    : m_path(path)
+    , m_maxEntries(maxEntries)
+{
+}
+
+std::unique_ptr<MediaProbeCache> &MediaProbeCache::get()
+{
+    std::call_once(m_onceFlag, [] {
+        const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        instance.reset(new MediaProbeCache(QDir(dir).absoluteFilePath(QStringLiteral("mediaprobe.cache"))));
+    });
+    return instance;
+}
+
+MediaProbeCache::Key MediaProbeCache::key(const QString &path, const QString &fileHash)
+{
+    Key result;
+    if (fileHash.isEmpty()) {
+        return result;
+    }
+    const QFileInfo info(path);
+    if (!info.isFile()) {
+        return result;
+    }
+    result.path = info.absoluteFilePath();
+    result.size = info.size();
+    result.modified = info.lastModified().toMSecsSinceEpoch();
+    result.fileHash = fileHash;
+    return result;
+}
+
+void MediaProbeCache::load() const
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    if (in.status() != QDataStream::Ok || magic != cacheMagic || version != cacheVersion) {
+        qDebug() << "Ignoring outdated media probe cache" << m_path;
+        return;
+    }
+    for (quint32 i = 0; i < count; ++i) {
+        QString path;
+        Entry entry;
+        in >> path >> entry.size >> entry.modified >> entry.fileHash >> entry.properties;
+        if (in.status() != QDataStream::Ok) {
+            // Truncated file, keep what could be read
+            qWarning() << "Media probe cache is corrupted" << m_path;
+            break;
+        }
+        // Entries are written from the least to the most recently used
+        entry.lastUsed = ++m_clock;
+        m_entries[path] = std::move(entry);
+    }
+}
+
+bool MediaProbeCache::lookup(const Key &key, Properties &properties)
+{
+    if (!key.isValid()) {
+        return false;
+    }
+    QMutexLocker lock(&m_mutex);
+    load();
+    auto it = m_entries.find(key.path);
+    if (it == m_entries.end() || it->second.size != key.size || it->second.modified != key.modified || it->second.fileHash != key.fileHash) {
+        m_misses++;
+        return false;
+    }
+    it->second.lastUsed = ++m_clock;
+    properties = it->second.properties;
+    m_hits++;
+    return true;
+}
+
+void MediaProbeCache::store(const Key &key, const Properties &properties)
+{
+    if (!key.isValid()) {
+        return;
+    }
+    QMutexLocker lock(&m_mutex);
+    load();
+    m_entries[key.path] = {key.size, key.modified, key.fileHash, properties, ++m_clock};
+    m_dirty = true;
+    shrink();
+}
+
+void MediaProbeCache::remove(const QString &path)
+{
+    QMutexLocker lock(&m_mutex);
+    load();
+    if (m_entries.erase(QFileInfo(path).absoluteFilePath()) > 0) {
+        m_dirty = true;
+    }
+}
+
+void MediaProbeCache::shrink()
+{
+    if (int(m_entries.size()) <= m_maxEntries) {
+        return;
+    }
+    std::vector<std::pair<quint64, QString>> byAge;
+    byAge.reserve(m_entries.size());
+    for (const auto &entry : m_entries) {
+        byAge.emplace_back(entry.second.lastUsed, entry.first);
+    }
+    const size_t excess = m_entries.size() - size_t(m_maxEntries);
+    std::nth_element(byAge.begin(), byAge.begin() + excess, byAge.end());
+    for (size_t i = 0; i < excess; ++i) {
+        m_entries.erase(byAge[i].second);
+    }
+}
+
+bool MediaProbeCache::save()
+{
+    QByteArray data;
+    QMutexLocker lock(&m_mutex);
+    if (!m_dirty) {
+        return true;
+    }
+    std::vector<std::pair<quint64, QString>> byAge;
+    byAge.reserve(m_entries.size());
+    for (const auto &entry : m_entries) {
+        byAge.emplace_back(entry.second.lastUsed, entry.first);
+    }
+    std::sort(byAge.begin(), byAge.end());
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << cacheMagic << cacheVersion << quint32(byAge.size());
+    for (const auto &item : byAge) {
+        const Entry &entry = m_entries.at(item.second);
+        out << item.second << entry.size << entry.modified << entry.fileHash << entry.properties;
+    }
+    m_dirty = false;
+    lock.unlock();
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qWarning() << "Cannot write media probe cache" << m_path;
+        lock.relock();
+        m_dirty = true;
+        return false;
+    }
+    return true;
+}
+
+int MediaProbeCache::count() const
+{
+    QMutexLocker lock(&m_mutex);
+    load();
+    return int(m_entries.size());
+}
+
+int MediaProbeCache::hits() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_hits;
+}
+
+int MediaProbeCache::misses() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_misses;
+}
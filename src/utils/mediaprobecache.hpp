@@ -0,0 +1,99 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/** @class MediaProbeCache
+    @brief Persistent cache of the stream properties probed when loading a media clip.
+    Loading a clip opens its container and decoders to find the streams, frame rate, seekability and
+    variable frame rate of the file, which is slow for large projects and on network storage.
+    The properties found by the probe are stored here, keyed by the file path, and reused on the next
+    load as long as the size, modification time and kdenlive:file_hash of the file did not change.
+    The cache is validated lazily: the file is only stat'ed on lookup, the decoders are opened by MLT
+    when the first frame is requested.
+    Entries are kept in memory and written to a single file by save(). The least recently used entries
+    are dropped when the cache is full.
+    All methods are thread safe.
+ * Note that the cache used by the application is a Singleton, other instances are only used for tests
+ */
+class MediaProbeCache
+{
+
+public:
+    using Properties = QMap<QByteArray, QByteArray>;
+
+    struct Key
+    {
+        QString path;
+        qint64 size{-1};
+        qint64 modified{0};
+        QString fileHash;
+        bool isValid() const { return !path.isEmpty() && size >= 0 && !fileHash.isEmpty(); }
+    };
+
+    /** @param path the cache file, read on first access */
+    explicit MediaProbeCache(const QString &path, int maxEntries = 20000);
+
+    // Returns the instance of the Singleton, stored in the cache location
+    static std::unique_ptr<MediaProbeCache> &get();
+
+    /** @brief Build the key of a file from its current size and modification time.
+        @returns an invalid key if the file does not exist or @param fileHash is empty */
+    static Key key(const QString &path, const QString &fileHash);
+
+    /** @brief Get the probed properties of a file.
+        @returns false if the file was not probed yet or changed since */
+    bool lookup(const Key &key, Properties &properties);
+    /** @brief Store the probed properties of a file, replacing any previous entry for its path */
+    void store(const Key &key, const Properties &properties);
+    /** @brief Drop the entry of @param path, for example when its probe failed */
+    void remove(const QString &path);
+
+    /** @brief Write the cache file if entries changed since last load or save.
+        @returns false on error */
+    bool save();
+
+    int count() const;
+    /** @brief Number of lookups served from the cache */
+    int hits() const;
+    /** @brief Number of lookups that require a new probe */
+    int misses() const;
+
+protected:
+    struct Entry
+    {
+        qint64 size;
+        qint64 modified;
+        QString fileHash;
+        Properties properties;
+        // Lookup counter value on last use, for eviction
+        quint64 lastUsed;
+    };
+    /** @brief Read the cache file if not done yet. Must be called with the mutex locked */
+    void load() const;
+    /** @brief Drop the least recently used entries until the cache fits its capacity. Must be called with the mutex locked */
+    void shrink();
+
+    static std::unique_ptr<MediaProbeCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the cache only once;
+
+    QString m_path;
+    int m_maxEntries;
+    mutable QMutex m_mutex;
+    mutable bool m_loaded{false};
+    bool m_dirty{false};
+    mutable quint64 m_clock{0};
+    mutable std::unordered_map<QString, Entry> m_entries;
+    int m_hits{0};
+    int m_misses{0};
+};
@@ -0,0 +1,274 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "sharedaudiosource.hpp"
+
+#include <QHashFunctions>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
+#include <mlt++/MltFrame.h>
+#include <mlt++/MltProducer.h>
+#include <vector>
+
+namespace {
+constexpr char sourceProperty[] = "_kdenlive_shared_audio";
+constexpr char positionProperty[] = "_kdenlive_shared_audio_position";
+
+void releaseSource(void *data)
+{
+    delete static_cast<std::shared_ptr<SharedAudioSource> *>(data);
+}
+
+int cursorGetAudio(mlt_frame frame, void **buffer, mlt_audio_format *format, int *frequency, int *channels, int *samples)
+{
+    mlt_properties properties = MLT_FRAME_PROPERTIES(frame);
+    auto *source = static_cast<std::shared_ptr<SharedAudioSource> *>(mlt_properties_get_data(properties, sourceProperty, nullptr));
+    const int position = mlt_properties_get_int(properties, positionProperty);
+    if (source == nullptr || !(*source)->audio(position, format, frequency, channels, samples, buffer)) {
+        // No audio at this position, output silence
+        if (*format == mlt_audio_none) {
+            *format = mlt_audio_s16;
+        }
+        const int size = mlt_audio_format_size(*format, *samples, *channels);
+        *buffer = mlt_pool_alloc(size);
+        memset(*buffer, 0, size_t(size));
+    }
+    mlt_frame_set_audio(frame, *buffer, *format, mlt_audio_format_size(*format, *samples, *channels), mlt_pool_release);
+    return 0;
+}
+
+int cursorGetFrame(mlt_producer producer, mlt_frame_ptr frame, int)
+{
+    *frame = mlt_frame_init(MLT_PRODUCER_SERVICE(producer));
+    mlt_properties properties = MLT_FRAME_PROPERTIES(*frame);
+    mlt_frame_set_position(*frame, mlt_producer_position(producer));
+    auto *source = static_cast<std::shared_ptr<SharedAudioSource> *>(mlt_properties_get_data(MLT_PRODUCER_PROPERTIES(producer), sourceProperty, nullptr));
+    if (source != nullptr) {
+        // The frame keeps the source alive, it may outlive the cursor
+        mlt_properties_set_data(properties, sourceProperty, new std::shared_ptr<SharedAudioSource>(*source), 0, releaseSource, nullptr);
+    }
+    mlt_properties_set_int(properties, positionProperty, int(mlt_producer_frame(producer)));
+    mlt_properties_set_int(properties, "test_image", 1);
+    mlt_properties_set_int(properties, "test_audio", 0);
+    mlt_frame_push_audio(*frame, reinterpret_cast<void *>(cursorGetAudio));
+    mlt_producer_prepare_next(producer);
+    return 0;
+}
+} // namespace
+
+size_t SharedAudioSource::BlockKeyHash::operator()(const BlockKey &key) const
+{
+    return qHashMulti(0, key.position, key.format, key.frequency, key.channels);
+}
+
+SharedAudioSource::SharedAudioSource(std::shared_ptr<Mlt::Producer> decoder, qint64 maxBytes, int readAhead)
+    : m_decoder(std::move(decoder))
+    , m_maxBytes(maxBytes)
+    , m_readAhead(readAhead)
+{
+    if (m_readAhead < 1) {
+        m_readAhead = qMax(1, qRound(m_decoder->get_fps()));
+    }
+}
+
+std::shared_ptr<SharedAudioSource> SharedAudioSource::create(std::shared_ptr<Mlt::Producer> decoder, qint64 maxBytes, int readAhead)
+{
+    return std::shared_ptr<SharedAudioSource>(new SharedAudioSource(std::move(decoder), maxBytes, readAhead));
+}
+
+std::shared_ptr<Mlt::Producer> SharedAudioSource::createCursor(Mlt::Producer &model)
+{
+    mlt_producer raw = mlt_producer_new(model.get_profile());
+    if (raw == nullptr) {
+        return nullptr;
+    }
+    mlt_properties properties = MLT_PRODUCER_PROPERTIES(raw);
+    // Copy resource, service name, streams and in/out so that the cursor is saved like the model
+    mlt_properties_inherit(properties, model.get_properties());
+    mlt_properties_set_data(properties, sourceProperty, new std::shared_ptr<SharedAudioSource>(shared_from_this()), 0, releaseSource, nullptr);
+    raw->get_frame = cursorGetFrame;
+    auto cursor = std::make_shared<Mlt::Producer>(raw);
+    // Drop the reference of mlt_producer_new, the cursor holds its own
+    mlt_producer_close(raw);
+    return cursor;
+}
+
+bool SharedAudioSource::audio(int position, mlt_audio_format *format, int *frequency, int *channels, int *samples, void **buffer)
+{
+    const BlockKey key{position, int(*format), *frequency, *channels};
+    QMutexLocker lock(&m_mutex);
+    auto it = m_blocks.find(key);
+    if (it == m_blocks.end()) {
+        m_misses++;
+        lock.unlock();
+        // Decode without holding the cache, so that the other cursors keep reading it meanwhile
+        QMutexLocker decodeLock(&m_decodeMutex);
+        lock.relock();
+        it = m_blocks.find(key);
+        if (it == m_blocks.end()) {
+            // Not decoded by another cursor while waiting
+            const int generation = m_generation;
+            lock.unlock();
+            std::vector<std::pair<BlockKey, Block>> blocks = decode(key);
+            lock.relock();
+            if (generation != m_generation) {
+                // The decoder was reset while decoding
+                return false;
+            }
+            store(blocks);
+            it = m_blocks.find(key);
+            if (it == m_blocks.end()) {
+                return false;
+            }
+        }
+    } else {
+        m_hits++;
+    }
+    Block &block = it->second;
+    block.lastUsed = ++m_clock;
+    *format = block.format;
+    *frequency = block.frequency;
+    *channels = block.channels;
+    if (*samples <= 0) {
+        *samples = block.samples;
+    }
+    const int size = mlt_audio_format_size(block.format, *samples, block.channels);
+    *buffer = mlt_pool_alloc(size);
+    if (*samples == block.samples) {
+        memcpy(*buffer, block.data.constData(), size_t(block.data.size()));
+        return true;
+    }
+    // The cursor frame does not have the same number of samples as the source frame, truncate or pad with silence
+    memset(*buffer, 0, size_t(size));
+    const int sampleSize = mlt_audio_format_size(block.format, 1, 1);
+    const int copied = qMin(*samples, block.samples);
+    if (block.format == mlt_audio_s32 || block.format == mlt_audio_float) {
+        // Planar formats
+        for (int c = 0; c < block.channels; ++c) {
+            memcpy(static_cast<char *>(*buffer) + c * *samples * sampleSize, block.data.constData() + c * block.samples * sampleSize,
+                   size_t(copied * sampleSize));
+        }
+    } else {
+        memcpy(*buffer, block.data.constData(), size_t(copied * block.channels * sampleSize));
+    }
+    return true;
+}
+
+void SharedAudioSource::setDecoderProperties(const QMap<QString, QString> &properties)
+{
+    QMutexLocker decodeLock(&m_decodeMutex);
+    QMapIterator<QString, QString> i(properties);
+    while (i.hasNext()) {
+        i.next();
+        m_decoder->set(i.key().toUtf8().constData(), i.value().toUtf8().constData());
+    }
+    QMutexLocker lock(&m_mutex);
+    // The cached audio was decoded with the previous properties
+    m_generation++;
+    m_blocks.clear();
+    m_bytes = 0;
+}
+
+std::vector<std::pair<SharedAudioSource::BlockKey, SharedAudioSource::Block>> SharedAudioSource::decode(const BlockKey &first)
+{
+    std::vector<std::pair<BlockKey, Block>> blocks;
+    const int length = m_decoder->get_length();
+    const float fps = float(m_decoder->get_fps());
+    if (first.position < 0 || first.position >= length) {
+        return blocks;
+    }
+    m_decoder->seek(first.position);
+    for (int i = 0; i < m_readAhead && first.position + i < length; ++i) {
+        BlockKey key = first;
+        key.position += i;
+        if (i > 0) {
+            QMutexLocker lock(&m_mutex);
+            if (m_blocks.count(key) > 0) {
+                // The following frames were already read
+                break;
+            }
+        }
+        std::unique_ptr<Mlt::Frame> frame(m_decoder->get_frame());
+        if (!frame || !frame->is_valid()) {
+            break;
+        }
+        Block block;
+        block.format = mlt_audio_format(key.format);
+        block.frequency = key.frequency;
+        block.channels = key.channels;
+        // The samples of the frame at the source position, cursors truncate or pad them to their own frame
+        block.samples = mlt_audio_calculate_frame_samples(fps, key.frequency, key.position);
+        void *data = frame->get_audio(block.format, block.frequency, block.channels, block.samples);
+        if (data == nullptr) {
+            break;
+        }
+        block.data = QByteArray(static_cast<const char *>(data), mlt_audio_format_size(block.format, block.samples, block.channels));
+        blocks.emplace_back(key, std::move(block));
+    }
+    return blocks;
+}
+
+void SharedAudioSource::store(std::vector<std::pair<BlockKey, Block>> &blocks)
+{
+    for (auto &item : blocks) {
+        item.second.lastUsed = ++m_clock;
+        m_decodedFrames++;
+        auto previous = m_blocks.find(item.first);
+        if (previous != m_blocks.end()) {
+            m_bytes -= previous->second.data.size();
+        }
+        m_bytes += item.second.data.size();
+        m_blocks[item.first] = std::move(item.second);
+    }
+    shrink();
+}
+
+void SharedAudioSource::shrink()
+{
+    if (m_bytes <= m_maxBytes) {
+        return;
+    }
+    std::vector<std::pair<quint64, BlockKey>> byAge;
+    byAge.reserve(m_blocks.size());
+    for (const auto &block : m_blocks) {
+        byAge.emplace_back(block.second.lastUsed, block.first);
+    }
+    std::sort(byAge.begin(), byAge.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    // Free a quarter of the cache at once so that eviction does not run on every miss
+    const qint64 target = m_maxBytes * 3 / 4;
+    for (const auto &item : byAge) {
+        if (m_bytes <= target) {
+            break;
+        }
+        auto it = m_blocks.find(item.second);
+        m_bytes -= it->second.data.size();
+        m_blocks.erase(it);
+    }
+}
+
+int SharedAudioSource::hits() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_hits;
+}
+
+int SharedAudioSource::misses() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_misses;
+}
+
+int SharedAudioSource::decodedFrames() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_decodedFrames;
+}
+
+qint64 SharedAudioSource::cachedBytes() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_bytes;
+}
@@ -0,0 +1,117 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QMutex>
+#include <QtGlobal>
+#include <framework/mlt_types.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace Mlt {
+class Producer;
+}
+
+/** @class SharedAudioSource
+    @brief One audio decoder shared by all the track producers of a bin clip audio stream.
+    Each audio track using a clip needs its own producer, since tracks play the clip at different positions
+    and carry their own effects. Instead of opening a demuxer and decoder for each of them, the track producers
+    are lightweight cursors created by createCursor(): they decode nothing themselves and fetch the audio of
+    their frames from this source. The decoded audio is kept in a bounded cache of per frame blocks. On a cache
+    miss, the decoder seeks once and reads ahead a block of frames, so that cursors playing at different
+    positions mostly hit the cache instead of seeking the decoder back and forth.
+    Blocks hold the samples of the frame at the source position. A cursor asks for the samples of its frame in
+    the timeline, which may differ by one when the frame rate is not an integer: the block is then truncated
+    or padded with silence.
+    A cursor copies the properties of the producer it replaces, so it is saved in the project like that producer.
+    Decoding happens outside the cache lock, so cursors hitting the cache are not held up by another one decoding.
+    All methods are thread safe.
+ */
+class SharedAudioSource : public std::enable_shared_from_this<SharedAudioSource>
+{
+
+public:
+    /** @param decoder the producer decoding the audio stream, only used by this source from now on
+        @param maxBytes the size of the decoded audio cache
+        @param readAhead the number of frames decoded on a cache miss, one second of audio if -1 */
+    static std::shared_ptr<SharedAudioSource> create(std::shared_ptr<Mlt::Producer> decoder, qint64 maxBytes = 8 * 1024 * 1024, int readAhead = -1);
+
+    /** @brief Create a cursor on this source, with the properties (resource, streams, kdenlive data, ...) of @param model.
+        The model itself is not used to decode anything. */
+    std::shared_ptr<Mlt::Producer> createCursor(Mlt::Producer &model);
+
+    /** @brief Get the @param samples of frame @param position in the requested format.
+        The parameters are updated to the format of the returned audio, the @param buffer is allocated with mlt_pool_alloc.
+        The number of samples is kept, the audio of the frame is truncated or padded with silence to match it.
+        @returns false if the frame has no audio */
+    bool audio(int position, mlt_audio_format *format, int *frequency, int *channels, int *samples, void **buffer);
+
+    /** @brief Set @param properties on the decoder, for example when the clip frame rate is forced, and drop the cached audio */
+    void setDecoderProperties(const QMap<QString, QString> &properties);
+
+    /** @brief Number of requests served from the cache */
+    int hits() const;
+    /** @brief Number of requests that needed to decode */
+    int misses() const;
+    /** @brief Number of frames decoded */
+    int decodedFrames() const;
+    /** @brief Size of the cached audio */
+    qint64 cachedBytes() const;
+
+protected:
+    SharedAudioSource(std::shared_ptr<Mlt::Producer> decoder, qint64 maxBytes, int readAhead);
+
+    struct BlockKey
+    {
+        int position;
+        int format;
+        int frequency;
+        int channels;
+        bool operator==(const BlockKey &other) const
+        {
+            return position == other.position && format == other.format && frequency == other.frequency && channels == other.channels;
+        }
+    };
+    struct BlockKeyHash
+    {
+        size_t operator()(const BlockKey &key) const;
+    };
+    struct Block
+    {
+        QByteArray data;
+        mlt_audio_format format;
+        int frequency;
+        int channels;
+        int samples;
+        quint64 lastUsed;
+    };
+    /** @brief Decode the frames from @param first on, until read ahead is done or a cached frame is found.
+        Must be called with the decoder mutex locked and the cache mutex unlocked */
+    std::vector<std::pair<BlockKey, Block>> decode(const BlockKey &first);
+    /** @brief Add the decoded @param blocks to the cache. Must be called with the mutex locked */
+    void store(std::vector<std::pair<BlockKey, Block>> &blocks);
+    /** @brief Drop the least recently used blocks until the cache fits its capacity. Must be called with the mutex locked */
+    void shrink();
+
+    // Guards the cache
+    mutable QMutex m_mutex;
+    // Guards the decoder, taken before the cache mutex when both are needed
+    QMutex m_decodeMutex;
+    std::shared_ptr<Mlt::Producer> m_decoder;
+    qint64 m_maxBytes;
+    int m_readAhead;
+    std::unordered_map<BlockKey, Block, BlockKeyHash> m_blocks;
+    qint64 m_bytes{0};
+    quint64 m_clock{0};
+    // Increased when the decoder properties change, audio decoded before is dropped
+    int m_generation{0};
+    int m_hits{0};
+    int m_misses{0};
+    int m_decodedFrames{0};
+};
@@ -9,7 +9,9 @@
 #include "core.h"
 #include "doc/kdenlivedoc.h"
 #include "project/projectmanager.h"
+#include "thumbnailpack.hpp"
 #include <QDir>
+#include <QFileInfo>
 #include <QMutexLocker>
 #include <list>
 
@@ -122,9 +124,34 @@ bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOn
     if (!ok || volatileOnly) {
         return false;
     }
-    locker.unlock();
-    QDir thumbFolder = getDir(pos < 0, &ok);
-    return ok && thumbFolder.exists(key);
+    if (pos < 0) {
+        locker.unlock();
+        QDir thumbFolder = getDir(true, &ok);
+        return ok && thumbFolder.exists(key);
+    }
+    std::shared_ptr<ThumbnailPack> thumbPack = getPack(getHash(binId, &ok), locker);
+    return thumbPack && thumbPack->contains(pos);
+}
+
+std::vector<int> ThumbnailCache::missingThumbnails(const QString &binId, const std::vector<int> &positions) const
+{
+    QMutexLocker locker(&m_mutex);
+    bool ok = false;
+    const QString hash = getHash(binId, &ok);
+    if (!ok) {
+        return positions;
+    }
+    std::vector<int> missing;
+    for (int pos : positions) {
+        if (!m_volatileCache->contains(hash + QStringLiteral("#%1.jpg").arg(pos))) {
+            missing.push_back(pos);
+        }
+    }
+    if (missing.empty()) {
+        return missing;
+    }
+    std::shared_ptr<ThumbnailPack> thumbPack = getPack(hash, locker);
+    return thumbPack ? thumbPack->missing(missing) : missing;
 }
 
 QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly) const
@@ -140,9 +167,6 @@ QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly
     }
     QDir thumbFolder = getDir(true, &ok);
     if (ok && thumbFolder.exists(key)) {
-        if (std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), -1) != m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(-1);
-        }
         locker.unlock();
         return QImage(thumbFolder.absoluteFilePath(key));
     }
@@ -178,18 +202,9 @@ QImage ThumbnailCache::getThumbnail(QString hash, const QString &binId, int pos,
     if (volatileOnly) {
         return QImage();
     }
-    bool ok = false;
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && thumbFolder.exists(hash)) {
-        if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-            std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(pos);
-        }
-        locker.unlock();
-        return QImage(thumbFolder.absoluteFilePath(hash));
-    }
-    locker.unlock();
-    return QImage();
+    Q_UNUSED(binId)
+    std::shared_ptr<ThumbnailPack> thumbPack = getPack(hash.section(QLatin1Char('#'), 0, 0), locker);
+    return thumbPack ? thumbPack->image(pos) : QImage();
 }
 
 QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatileOnly) const
@@ -203,16 +218,8 @@ QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatile
     if (!ok || volatileOnly) {
         return QImage();
     }
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && thumbFolder.exists(key)) {
-        if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-            std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(pos);
-        }
-        locker.unlock();
-        return QImage(thumbFolder.absoluteFilePath(key));
-    }
-    return QImage();
+    std::shared_ptr<ThumbnailPack> thumbPack = getPack(getHash(binId, &ok), locker);
+    return thumbPack ? thumbPack->image(pos) : QImage();
 }
 
 void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
@@ -234,16 +241,9 @@ void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage
     }
     m_volatileCache->insert(key, img, (int)img.sizeInBytes());
     if (persistent) {
-        QDir thumbFolder = getDir(false, &ok);
-        if (ok) {
-            if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-                std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-                m_storedOnDisk[binId].push_back(pos);
-            }
-            locker.unlock();
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: " << thumbFolder.absoluteFilePath(key);
-            }
+        std::shared_ptr<ThumbnailPack> thumbPack = getPack(getHash(binId, &ok), locker);
+        if (thumbPack && !thumbPack->store(pos, img)) {
+            qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: " << thumbPack->path();
         }
     }
 }
@@ -255,32 +255,35 @@ bool ThumbnailCache::checkIntegrity() const
 
 void ThumbnailCache::saveCachedThumbs(const std::unordered_map<QString, std::vector<int>> &keys)
 {
-    bool ok;
-    QDir thumbFolder = getDir(false, &ok);
-    if (!ok) {
-        return;
-    }
-    QMutexLocker locker(&m_mutex);
     for (auto &key : keys) {
+        QMutexLocker locker(&m_mutex);
         bool ok;
+        const QString hash = getHash(key.first, &ok);
+        if (!ok) {
+            continue;
+        }
+        // Collect the images first, the pack is written without holding the cache lock
+        std::vector<std::pair<int, QImage>> images;
         for (const auto &pos : key.second) {
-            if (m_storedOnDisk.find(key.first) == m_storedOnDisk.end() ||
-                std::find(m_storedOnDisk[key.first].begin(), m_storedOnDisk[key.first].end(), pos) == m_storedOnDisk[key.first].end()) {
-                const QString thumbKey = getKey(key.first, pos, &ok);
-                if (!ok) {
-                    continue;
-                }
-                if (!thumbFolder.exists(thumbKey) && m_volatileCache->contains(thumbKey)) {
-                    QImage img = m_volatileCache->get(thumbKey);
-                    if (!img.save(thumbFolder.absoluteFilePath(thumbKey))) {
-                        qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
-                        break;
-                    } else {
-                        m_storedOnDisk[key.first].push_back(pos);
-                    }
-                }
+            const QString thumbKey = hash + QStringLiteral("#%1.jpg").arg(pos);
+            if (m_volatileCache->contains(thumbKey)) {
+                images.emplace_back(pos, m_volatileCache->get(thumbKey));
+            }
+        }
+        if (images.empty()) {
+            continue;
+        }
+        std::shared_ptr<ThumbnailPack> thumbPack = getPack(hash, locker);
+        if (!thumbPack) {
+            return;
+        }
+        for (const auto &image : images) {
+            if (!thumbPack->contains(image.first) && !thumbPack->store(image.first, image.second)) {
+                qDebug() << "// Error writing thumbnails to " << thumbPack->path();
+                return;
             }
         }
+        compactIfNeeded(thumbPack);
     }
 }
 
@@ -298,29 +301,14 @@ void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
         m_storedVolatile.erase(binId);
     }
     bool ok = false;
-    // Video thumbs
-    QStringList files;
-    if (m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
-        // Remove persistent cache
-        for (const auto &pos : m_storedOnDisk.at(binId)) {
-            if (pos >= 0) {
-                auto key = getKey(binId, pos, &ok);
-                if (ok) {
-                    files << key;
-                }
-            }
-        }
-        m_storedOnDisk.erase(binId);
+    // Video thumbs, remove persistent cache
+    const QString hash = getHash(binId, &ok);
+    if (!ok) {
+        return;
     }
-    // Release mutex before deleting files
-    locker.unlock();
-    if (!files.isEmpty()) {
-        QDir thumbFolder = getDir(false, &ok);
-        if (ok) {
-            while (!files.isEmpty()) {
-                thumbFolder.remove(files.takeFirst());
-            }
-        }
+    std::shared_ptr<ThumbnailPack> thumbPack = getPack(hash, locker);
+    if (thumbPack) {
+        thumbPack->remove();
     }
 }
 
@@ -329,11 +317,64 @@ void ThumbnailCache::clearCache()
     QMutexLocker locker(&m_mutex);
     m_volatileCache->clear();
     m_storedVolatile.clear();
-    m_storedOnDisk.clear();
+    m_packs.clear();
+    m_openPacks.clear();
+}
+
+std::shared_ptr<ThumbnailPack> ThumbnailCache::getPack(const QString &hash, QMutexLocker<QMutex> &locker) const
+{
+    if (hash.isEmpty()) {
+        locker.unlock();
+        return nullptr;
+    }
+    std::shared_ptr<ThumbnailPack> thumbPack;
+    std::shared_ptr<ThumbnailPack> evicted;
+    bool created = false;
+    auto it = m_packs.find(hash);
+    if (it != m_packs.end()) {
+        thumbPack = it->second;
+        m_openPacks.remove(hash);
+    } else {
+        bool ok = false;
+        QDir thumbFolder = getDir(false, &ok);
+        if (!ok) {
+            locker.unlock();
+            return nullptr;
+        }
+        thumbPack = std::make_shared<ThumbnailPack>(thumbFolder.absoluteFilePath(hash + QStringLiteral(".thumbs")));
+        m_packs[hash] = thumbPack;
+        created = true;
+    }
+    // Only keep a limited number of pack files open, the index of the others stays in memory
+    m_openPacks.push_front(hash);
+    if (m_openPacks.size() > maxOpenPacks) {
+        evicted = m_packs[m_openPacks.back()];
+        m_openPacks.pop_back();
+    }
+    locker.unlock();
+    if (evicted) {
+        evicted->close();
+    }
+    if (created) {
+        // Import the thumbnails stored with the legacy one file per frame layout
+        QDir thumbFolder(QFileInfo(thumbPack->path()).absolutePath());
+        thumbPack->migrate(thumbFolder, hash);
+        compactIfNeeded(thumbPack);
+    }
+    return thumbPack;
+}
+
+void ThumbnailCache::compactIfNeeded(const std::shared_ptr<ThumbnailPack> &thumbPack)
+{
+    // Replaced thumbnails waste space, rewrite the pack once they take more than half of it
+    const qint64 dead = thumbPack->deadBytes();
+    if (dead > 1024 * 1024 && dead * 2 > thumbPack->fileSize()) {
+        thumbPack->compact();
+    }
 }
 
 // static
-QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
+QString ThumbnailCache::getHash(const QString &binId, bool *ok)
 {
     if (binId.isEmpty()) {
         *ok = false;
@@ -344,7 +385,19 @@ QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
     if (!*ok) {
         return QString();
     }
-    return binClip->hashForThumbs() + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".jpg");
+    const QString hash = binClip->hashForThumbs();
+    *ok = !hash.isEmpty();
+    return hash;
+}
+
+// static
+QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
+{
+    const QString hash = getHash(binId, ok);
+    if (!*ok) {
+        return QString();
+    }
+    return hash + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".jpg");
 }
 
 // static
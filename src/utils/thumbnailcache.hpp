@@ -10,11 +10,14 @@
 #include <QImage>
 #include <QMutex>
 #include <QUrl>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
 
+class ThumbnailPack;
+
 /** @class ThumbnailCache
     @brief This class class is an interface to the caches that store thumbnails.
     In Kdenlive, we use two such caches, a persistent that is stored on disk to allow thumbnails to be reused when reopening.
@@ -22,6 +25,7 @@
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
     KImageCache is not suitable since it lacks a way to remove objects from the cache.
+    The persistent video thumbnails of a clip are packed in a single file per clip hash, see ThumbnailPack.
  * Note that this class is a Singleton
  */
 class ThumbnailCache
@@ -39,6 +43,11 @@ public:
      */
     bool hasThumbnail(const QString &binId, int pos, bool volatileOnly = false) const;
 
+    /** @brief Returns the positions, among @param positions, for which no thumbnail of clip @param binId is cached.
+       The persistent cache is checked with a single index lookup, without disk access.
+     */
+    std::vector<int> missingThumbnails(const QString &binId, const std::vector<int> &positions) const;
+
     /** @brief Get a given thumbnail from the cache
        @param binId is the id of the queried clip
        @param pos is the position where we query
@@ -74,6 +83,14 @@ protected:
 
     // Return the key associated to a thumbnail
     static QString getKey(const QString &binId, int pos, bool *ok);
+    // Return the hash used to store the thumbnails of a clip
+    static QString getHash(const QString &binId, bool *ok);
+
+    /** @brief Returns the persistent pack of a clip hash, opening it (and importing the legacy thumbnail files) if needed.
+       Must be called with the mutex locked through @param locker, which is unlocked on return. */
+    std::shared_ptr<ThumbnailPack> getPack(const QString &hash, QMutexLocker<QMutex> &locker) const;
+    /** @brief Compact a pack if replaced thumbnails take too much space */
+    static void compactIfNeeded(const std::shared_ptr<ThumbnailPack> &thumbPack);
     static QStringList getAudioKey(const QString &binId, bool *ok);
 
     // Return the dir where the persistent cache lives
@@ -86,8 +103,12 @@ protected:
     std::unique_ptr<Cache_t> m_volatileCache;
     mutable QMutex m_mutex;
 
-    // the following maps keeps track of the positions that we store for each clip in volatile caches.
-    // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
+    // the following map keeps track of the positions that we store for each clip in volatile caches.
+    // Note that we don't track deletions due to items dropped from the cache. So the map can contain more items that are currently stored.
     std::unordered_map<QString, std::vector<int>> m_storedVolatile;
-    mutable std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
+
+    // Persistent packs by clip hash, and the most recently used ones, whose file is kept open
+    mutable std::unordered_map<QString, std::shared_ptr<ThumbnailPack>> m_packs;
+    mutable std::list<QString> m_openPacks;
+    static constexpr size_t maxOpenPacks = 32;
 };
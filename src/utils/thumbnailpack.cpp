@@ -0,0 +1,367 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "thumbnailpack.hpp"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+// File layout, all integers are big endian:
+// header: magic, version
+// record: magic, position, data size, data
+constexpr quint32 packMagic = 0x4b54504b; // KTPK
+constexpr quint32 packVersion = 1;
+constexpr quint32 recordMagic = 0x54524543; // TREC
+constexpr qint64 headerSize = 8;
+constexpr qint64 recordHeaderSize = 12;
+
+QByteArray packHeader()
+{
+    QByteArray header(headerSize, 0);
+    qToBigEndian(packMagic, header.data());
+    qToBigEndian(packVersion, header.data() + 4);
+    return header;
+}
+
+QByteArray recordHeader(int pos, quint32 size)
+{
+    QByteArray header(recordHeaderSize, 0);
+    qToBigEndian(recordMagic, header.data());
+    qToBigEndian(qint32(pos), header.data() + 4);
+    qToBigEndian(size, header.data() + 8);
+    return header;
+}
+} // namespace
+
+ThumbnailPack::ThumbnailPack(const QString &path)
+    : m_path(path)
+{
+}
+
+ThumbnailPack::~ThumbnailPack()
+{
+    close();
+}
+
+const QString &ThumbnailPack::path() const
+{
+    return m_path;
+}
+
+void ThumbnailPack::close()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_file) {
+        if (m_map) {
+            m_file->unmap(const_cast<uchar *>(m_map));
+        }
+        m_file.reset();
+    }
+    m_map = nullptr;
+    m_mapSize = 0;
+}
+
+const uchar *ThumbnailPack::mapped(qint64 end) const
+{
+    if (m_map && m_mapSize >= end) {
+        return m_map;
+    }
+    if (!m_file) {
+        if (!QFile::exists(m_path)) {
+            return nullptr;
+        }
+        m_file = std::make_unique<QFile>(m_path);
+        if (!m_file->open(QIODevice::ReadWrite) && !m_file->open(QIODevice::ReadOnly)) {
+            m_file.reset();
+            return nullptr;
+        }
+    }
+    if (m_map) {
+        m_file->unmap(const_cast<uchar *>(m_map));
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+    const qint64 size = m_file->size();
+    if (size < end || size == 0) {
+        return nullptr;
+    }
+    m_map = m_file->map(0, size);
+    m_mapSize = m_map ? size : 0;
+    return m_map;
+}
+
+void ThumbnailPack::loadIndex() const
+{
+    if (m_indexLoaded) {
+        return;
+    }
+    m_indexLoaded = true;
+    m_index.clear();
+    m_end = 0;
+    m_deadBytes = 0;
+    const uchar *data = mapped(headerSize);
+    if (data == nullptr) {
+        return;
+    }
+    if (qFromBigEndian<quint32>(data) != packMagic || qFromBigEndian<quint32>(data + 4) != packVersion) {
+        qWarning() << "Ignoring invalid thumbnail pack" << m_path;
+        return;
+    }
+    qint64 offset = headerSize;
+    while (offset + recordHeaderSize <= m_mapSize) {
+        const uchar *header = data + offset;
+        const quint32 size = qFromBigEndian<quint32>(header + 8);
+        if (qFromBigEndian<quint32>(header) != recordMagic || offset + recordHeaderSize + size > m_mapSize) {
+            // Truncated or corrupted tail, it will be overwritten by the next append
+            break;
+        }
+        const int pos = qFromBigEndian<qint32>(header + 4);
+        auto previous = m_index.find(pos);
+        if (previous != m_index.end()) {
+            m_deadBytes += recordHeaderSize + previous->second.size;
+        }
+        m_index[pos] = {offset + recordHeaderSize, size};
+        offset += recordHeaderSize + size;
+    }
+    m_end = offset;
+}
+
+bool ThumbnailPack::contains(int pos) const
+{
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    return m_index.count(pos) > 0;
+}
+
+std::vector<int> ThumbnailPack::missing(const std::vector<int> &positions) const
+{
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    std::vector<int> result;
+    for (int pos : positions) {
+        if (m_index.count(pos) == 0) {
+            result.push_back(pos);
+        }
+    }
+    return result;
+}
+
+std::vector<int> ThumbnailPack::positions() const
+{
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    std::vector<int> result;
+    result.reserve(m_index.size());
+    for (const auto &record : m_index) {
+        result.push_back(record.first);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+QImage ThumbnailPack::decode(const Record &record) const
+{
+    const uchar *data = mapped(record.offset + record.size);
+    if (data == nullptr) {
+        return QImage();
+    }
+    return QImage::fromData(data + record.offset, int(record.size), "JPG");
+}
+
+QImage ThumbnailPack::image(int pos) const
+{
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    auto it = m_index.find(pos);
+    if (it == m_index.end()) {
+        return QImage();
+    }
+    return decode(it->second);
+}
+
+QMap<int, QImage> ThumbnailPack::images(const std::vector<int> &positions) const
+{
+    QMap<int, QImage> result;
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    for (int pos : positions) {
+        auto it = m_index.find(pos);
+        if (it != m_index.end()) {
+            QImage img = decode(it->second);
+            if (!img.isNull()) {
+                result.insert(pos, img);
+            }
+        }
+    }
+    return result;
+}
+
+bool ThumbnailPack::store(int pos, const QImage &img)
+{
+    if (img.isNull()) {
+        return false;
+    }
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!img.save(&buffer, "JPG")) {
+        return false;
+    }
+    return storeEncoded(pos, data);
+}
+
+bool ThumbnailPack::storeEncoded(int pos, const QByteArray &data)
+{
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    return append(pos, data);
+}
+
+bool ThumbnailPack::append(int pos, const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        return false;
+    }
+    // The mapping must be released before the file grows or is truncated
+    if (m_map) {
+        m_file->unmap(const_cast<uchar *>(m_map));
+        m_map = nullptr;
+        m_mapSize = 0;
+    }
+    if (!m_file || !m_file->isWritable()) {
+        m_file = std::make_unique<QFile>(m_path);
+        if (!m_file->open(QIODevice::ReadWrite)) {
+            qWarning() << "Cannot write thumbnail pack" << m_path;
+            m_file.reset();
+            return false;
+        }
+    }
+    if (m_end == 0) {
+        // New or invalid pack
+        if (!m_file->resize(0) || m_file->write(packHeader()) != headerSize) {
+            return false;
+        }
+        m_index.clear();
+        m_deadBytes = 0;
+        m_end = headerSize;
+    } else if (m_file->size() != m_end && !m_file->resize(m_end)) {
+        return false;
+    }
+    if (!m_file->seek(m_end) || m_file->write(recordHeader(pos, quint32(data.size()))) != recordHeaderSize ||
+        m_file->write(data) != data.size() || !m_file->flush()) {
+        // Leave the partial record behind, it is ignored on load and overwritten on next append
+        return false;
+    }
+    auto previous = m_index.find(pos);
+    if (previous != m_index.end()) {
+        m_deadBytes += recordHeaderSize + previous->second.size;
+    }
+    m_index[pos] = {m_end + recordHeaderSize, quint32(data.size())};
+    m_end += recordHeaderSize + data.size();
+    return true;
+}
+
+int ThumbnailPack::migrate(const QDir &dir, const QString &prefix)
+{
+    const QStringList files = dir.entryList({prefix + QStringLiteral("#*.jpg")}, QDir::Files);
+    if (files.isEmpty()) {
+        return 0;
+    }
+    int imported = 0;
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    for (const QString &fileName : files) {
+        bool ok = false;
+        const int pos = fileName.section(QLatin1Char('#'), -1).section(QLatin1Char('.'), 0, 0).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        QFile file(dir.absoluteFilePath(fileName));
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        const QByteArray data = file.readAll();
+        file.close();
+        // Thumbnails stored in the pack are more recent than the legacy files
+        if (m_index.count(pos) > 0 || append(pos, data)) {
+            file.remove();
+            imported++;
+        }
+    }
+    return imported;
+}
+
+bool ThumbnailPack::compact()
+{
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    if (m_deadBytes == 0) {
+        return true;
+    }
+    std::vector<std::pair<int, Record>> records(m_index.begin(), m_index.end());
+    std::sort(records.begin(), records.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    QByteArray packed = packHeader();
+    std::unordered_map<int, Record> index;
+    const uchar *data = mapped(m_end);
+    if (data == nullptr) {
+        return false;
+    }
+    for (const auto &record : records) {
+        packed.append(recordHeader(record.first, record.second.size));
+        index[record.first] = {packed.size(), record.second.size};
+        packed.append(reinterpret_cast<const char *>(data + record.second.offset), record.second.size);
+    }
+    // Release the file so that it can be replaced
+    m_file->unmap(const_cast<uchar *>(m_map));
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_file.reset();
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(packed) != packed.size() || !file.commit()) {
+        qWarning() << "Cannot compact thumbnail pack" << m_path;
+        return false;
+    }
+    m_index = std::move(index);
+    m_end = packed.size();
+    m_deadBytes = 0;
+    return true;
+}
+
+qint64 ThumbnailPack::fileSize() const
+{
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    return m_end;
+}
+
+qint64 ThumbnailPack::deadBytes() const
+{
+    QMutexLocker lock(&m_mutex);
+    loadIndex();
+    return m_deadBytes;
+}
+
+bool ThumbnailPack::remove()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_file) {
+        if (m_map) {
+            m_file->unmap(const_cast<uchar *>(m_map));
+        }
+        m_file.reset();
+    }
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_index.clear();
+    m_indexLoaded = true;
+    m_end = 0;
+    m_deadBytes = 0;
+    return !QFile::exists(m_path) || QFile::remove(m_path);
+}
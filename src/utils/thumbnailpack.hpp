@@ -0,0 +1,99 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/** @class ThumbnailPack
+    @brief Persistent store for the video thumbnails of one clip hash, packed in a single file.
+    The pack starts with a header, followed by records appended one after the other, each record
+    holding a frame position and the JPEG data of its thumbnail. Storing a thumbnail for a position
+    that is already in the pack appends a new record, the previous one becomes dead space until the
+    pack is compacted.
+    The index (position -> record) is read once when opening the pack and then kept in memory, so
+    lookups never touch the disk. Thumbnails are read through a memory mapping of the file.
+    A truncated last record, left by a crash while appending, is ignored and overwritten by the next append.
+    All methods are thread safe.
+ */
+class ThumbnailPack
+{
+
+public:
+    /** @param path the pack file, which is created on the first store */
+    explicit ThumbnailPack(const QString &path);
+    ~ThumbnailPack();
+
+    const QString &path() const;
+
+    /** @brief Returns true if a thumbnail is stored for @param pos */
+    bool contains(int pos) const;
+    /** @brief Returns the positions, among @param positions, that have no stored thumbnail */
+    std::vector<int> missing(const std::vector<int> &positions) const;
+    /** @brief Returns all stored positions, sorted */
+    std::vector<int> positions() const;
+
+    /** @brief Returns the thumbnail stored for @param pos, or a null image */
+    QImage image(int pos) const;
+    /** @brief Returns the stored thumbnails for @param positions, the missing ones are not in the result */
+    QMap<int, QImage> images(const std::vector<int> &positions) const;
+
+    /** @brief Encodes @param img and appends it to the pack, returns false on error */
+    bool store(int pos, const QImage &img);
+    /** @brief Appends already encoded image @param data to the pack, returns false on error */
+    bool storeEncoded(int pos, const QByteArray &data);
+
+    /** @brief Imports the thumbnails stored with the previous one file per frame layout,
+        named @param prefix followed by #position.jpg in @param dir, and deletes these files.
+        @returns the number of imported thumbnails */
+    int migrate(const QDir &dir, const QString &prefix);
+
+    /** @brief Rewrites the pack without its dead records. The new pack replaces the old one atomically.
+        @returns false on error, the pack is then left unchanged */
+    bool compact();
+    /** @brief Size of the pack file, including the dead records */
+    qint64 fileSize() const;
+    /** @brief Size of the records that were replaced by a later one */
+    qint64 deadBytes() const;
+
+    /** @brief Close the file and its mapping, the index is kept. The file is reopened when needed. */
+    void close();
+    /** @brief Delete the pack file and clear the index */
+    bool remove();
+
+protected:
+    struct Record
+    {
+        // Offset of the image data in the file
+        qint64 offset;
+        quint32 size;
+    };
+    /** @brief Load the index from the file if not done yet. Must be called with the mutex locked */
+    void loadIndex() const;
+    /** @brief Open the file and map it, up to at least @param end. Must be called with the mutex locked */
+    const uchar *mapped(qint64 end) const;
+    bool append(int pos, const QByteArray &data);
+    QImage decode(const Record &record) const;
+
+    QString m_path;
+    mutable QMutex m_mutex;
+    mutable bool m_indexLoaded{false};
+    mutable std::unordered_map<int, Record> m_index;
+    // End of the last valid record, where the next record is appended
+    mutable qint64 m_end{0};
+    mutable qint64 m_deadBytes{0};
+    mutable std::unique_ptr<QFile> m_file;
+    mutable const uchar *m_map{nullptr};
+    mutable qint64 m_mapSize{0};
+};
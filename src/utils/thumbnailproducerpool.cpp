@@ -0,0 +1,169 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "thumbnailproducerpool.hpp"
+#include "bin/projectclip.h"
+#include "core.h"
+
+#include <QMutexLocker>
+#include <mlt++/MltFilter.h>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+
+std::unique_ptr<ThumbnailProducerPool> ThumbnailProducerPool::instance;
+std::once_flag ThumbnailProducerPool::m_onceFlag;
+
+ThumbnailProducerPool::ThumbnailProducerPool(int maxProducers, int maxPerClip)
+    : m_maxProducers(maxProducers)
+    , m_maxPerClip(maxPerClip)
+{
+}
+
+std::unique_ptr<ThumbnailProducerPool> &ThumbnailProducerPool::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ThumbnailProducerPool()); });
+    return instance;
+}
+
+quint64 ThumbnailProducerPool::generation(const QString &binId) const
+{
+    auto it = m_clipsInUse.find(binId);
+    return (m_epoch << 32) + (it == m_clipsInUse.end() ? 0 : it->second.generation);
+}
+
+void ThumbnailProducerPool::releaseUse(const QString &binId)
+{
+    auto it = m_clipsInUse.find(binId);
+    if (it != m_clipsInUse.end() && --it->second.count <= 0) {
+        m_clipsInUse.erase(it);
+    }
+}
+
+std::shared_ptr<Mlt::Producer> ThumbnailProducerPool::acquire(const std::shared_ptr<ProjectClip> &binClip)
+{
+    const QString binId = binClip->clipId();
+    std::unique_ptr<Mlt::Producer> producer;
+    QMutexLocker lock(&m_mutex);
+    // Producers built before an invalidation of the clip are not returned to the pool
+    m_clipsInUse[binId].count++;
+    const quint64 producerGeneration = generation(binId);
+    auto it = m_entries.find(binId);
+    if (it != m_entries.end() && !it->second.idle.empty()) {
+        producer = std::move(it->second.idle.back());
+        it->second.idle.pop_back();
+        m_idleCount--;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+        lock.unlock();
+        m_hits++;
+    } else {
+        lock.unlock();
+        // Opening the clip can be slow, don't block the other requests meanwhile
+        producer = binClip->getThumbProducer();
+        if (producer == nullptr || !producer->is_valid()) {
+            QMutexLocker failedLock(&m_mutex);
+            releaseUse(binId);
+            return nullptr;
+        }
+        if (binClip->clipType() != ClipType::Timeline && binClip->clipType() != ClipType::Playlist) {
+            Mlt::Profile *prodProfile = &pCore->thumbProfile();
+            Mlt::Filter scaler(*prodProfile, "swscale");
+            Mlt::Filter padder(*prodProfile, "resize");
+            Mlt::Filter converter(*prodProfile, "avcolor_space");
+            producer->attach(scaler);
+            producer->attach(padder);
+            producer->attach(converter);
+        }
+        m_misses++;
+    }
+    return std::shared_ptr<Mlt::Producer>(producer.release(),
+                                          [this, binId, producerGeneration](Mlt::Producer *prod) { release(binId, producerGeneration, prod); });
+}
+
+void ThumbnailProducerPool::release(const QString &binId, quint64 producerGeneration, Mlt::Producer *producer)
+{
+    std::unique_ptr<Mlt::Producer> prod(producer);
+    std::vector<std::unique_ptr<Mlt::Producer>> evicted;
+    QMutexLocker lock(&m_mutex);
+    const bool stale = producerGeneration != generation(binId);
+    releaseUse(binId);
+    if (stale) {
+        // Clip source changed while the producer was in use
+        lock.unlock();
+        return;
+    }
+    auto it = m_entries.find(binId);
+    if (it == m_entries.end()) {
+        m_lru.push_front(binId);
+        it = m_entries.emplace(binId, Entry()).first;
+        it->second.lruPos = m_lru.begin();
+    } else {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lruPos);
+    }
+    if (int(it->second.idle.size()) >= m_maxPerClip) {
+        evicted.push_back(std::move(prod));
+    } else {
+        it->second.idle.push_back(std::move(prod));
+        m_idleCount++;
+        shrink(evicted);
+    }
+    lock.unlock();
+    // Closing the decoders happens here, outside of the lock
+}
+
+void ThumbnailProducerPool::shrink(std::vector<std::unique_ptr<Mlt::Producer>> &evicted)
+{
+    auto lruIt = m_lru.end();
+    while (m_idleCount > m_maxProducers && lruIt != m_lru.begin()) {
+        --lruIt;
+        auto it = m_entries.find(*lruIt);
+        while (!it->second.idle.empty() && m_idleCount > m_maxProducers) {
+            evicted.push_back(std::move(it->second.idle.back()));
+            it->second.idle.pop_back();
+            m_idleCount--;
+        }
+        if (it->second.idle.empty()) {
+            lruIt = m_lru.erase(lruIt);
+            m_entries.erase(it);
+        }
+    }
+}
+
+void ThumbnailProducerPool::invalidate(const QString &binId)
+{
+    std::vector<std::unique_ptr<Mlt::Producer>> evicted;
+    QMutexLocker lock(&m_mutex);
+    auto use = m_clipsInUse.find(binId);
+    if (use != m_clipsInUse.end()) {
+        // The producers in use are deleted when released
+        use->second.generation++;
+    }
+    auto it = m_entries.find(binId);
+    if (it != m_entries.end()) {
+        evicted = std::move(it->second.idle);
+        m_idleCount -= int(evicted.size());
+        m_lru.erase(it->second.lruPos);
+        m_entries.erase(it);
+    }
+}
+
+void ThumbnailProducerPool::clear()
+{
+    std::unordered_map<QString, Entry> evicted;
+    QMutexLocker lock(&m_mutex);
+    m_epoch++;
+    std::swap(evicted, m_entries);
+    m_lru.clear();
+    m_idleCount = 0;
+}
+
+int ThumbnailProducerPool::hits() const
+{
+    return m_hits;
+}
+
+int ThumbnailProducerPool::misses() const
+{
+    return m_misses;
+}
@@ -0,0 +1,99 @@
+/*
+    SPDX-FileCopyrightText: 2024 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Mlt {
+class Producer;
+}
+class ProjectClip;
+
+/** @class ThumbnailProducerPool
+    @brief A bounded pool of warm producers used to extract timeline thumbnails.
+    Building a thumbnail producer opens the container and the decoder of the clip, and attaches
+    the scaling filters. Instead of doing it for each thumbnail request, the producers are
+    returned to this pool after use and reused by the next request on the same clip, from any thread.
+    A producer is only used by one thread at a time. The idle producers are evicted in least recently
+    used order when the pool is full.
+ * Note that this class is a Singleton
+ */
+class ThumbnailProducerPool
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ThumbnailProducerPool> &get();
+
+    /** @brief Get a thumbnail producer for a clip, reusing an idle one if possible.
+       The producer is used exclusively by the caller and returns to the pool when the last reference is dropped.
+       @param binClip is the clip for which we want thumbnails
+       @returns nullptr if the clip cannot produce thumbnails yet
+     */
+    std::shared_ptr<Mlt::Producer> acquire(const std::shared_ptr<ProjectClip> &binClip);
+
+    /** @brief Discard the producers of a clip, for example when its source changed.
+       Producers currently in use are deleted instead of going back to the pool. */
+    void invalidate(const QString &binId);
+
+    /** @brief Discard all producers, for example when the thumbnail profile changed */
+    void clear();
+
+    /** @brief Number of requests served by an idle producer */
+    int hits() const;
+    /** @brief Number of requests that had to build a new producer */
+    int misses() const;
+
+protected:
+    // Constructor is protected because class is a Singleton
+    explicit ThumbnailProducerPool(int maxProducers = 16, int maxPerClip = 2);
+
+    /** @brief Return a producer to the pool after use, or delete it if it is stale or the clip already has enough idle producers */
+    void release(const QString &binId, quint64 generation, Mlt::Producer *producer);
+    /** @brief Returns the generation of the producers of a clip, which changes on each invalidation. Must be called with the mutex locked. */
+    quint64 generation(const QString &binId) const;
+    /** @brief Count one less producer of a clip in use, forgetting its generation when none is left. Must be called with the mutex locked. */
+    void releaseUse(const QString &binId);
+    /** @brief Evict idle producers of the least recently used clips until the pool fits its capacity.
+        Must be called with the mutex locked, the evicted producers are moved to @param evicted to be deleted after unlocking. */
+    void shrink(std::vector<std::unique_ptr<Mlt::Producer>> &evicted);
+
+    static std::unique_ptr<ThumbnailProducerPool> instance;
+    static std::once_flag m_onceFlag; // flag to create the pool only once;
+
+    struct Entry
+    {
+        std::vector<std::unique_ptr<Mlt::Producer>> idle;
+        // Position in the LRU list
+        std::list<QString>::iterator lruPos;
+    };
+    int m_maxProducers;
+    int m_maxPerClip;
+    int m_idleCount{0};
+    mutable QMutex m_mutex;
+    // Most recently used clips first
+    std::list<QString> m_lru;
+    std::unordered_map<QString, Entry> m_entries;
+    struct ClipUse
+    {
+        // Invalidations while producers of the clip were in use
+        quint64 generation{0};
+        int count{0};
+    };
+    // Clips with producers in use, the others have no producer that could become stale
+    std::unordered_map<QString, ClipUse> m_clipsInUse;
+    // Global clear count
+    quint64 m_epoch{0};
+    std::atomic<int> m_hits{0};
+    std::atomic<int> m_misses{0};
+};
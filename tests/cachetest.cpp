@@ -8,6 +8,8 @@
 // test specific headers
 #include "doc/docundostack.hpp"
 #include "doc/kdenlivedoc.h"
+#include <QTemporaryDir>
+#include <QThread>
 #include <cmath>
 #include <iostream>
 #include <tuple>
@@ -15,7 +17,13 @@
 
 #include "core.h"
 #include "definitions.h"
+#include "monitor/playbackprefetcher.h"
+#include "monitor/shuttlecache.h"
+#include "utils/mediaprobecache.hpp"
+#include "utils/sharedaudiosource.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "utils/thumbnailpack.hpp"
+#include "utils/thumbnailproducerpool.hpp"
 
 TEST_CASE("Cache insert-remove", "[Cache]")
 {
@@ -48,6 +56,38 @@ TEST_CASE("Cache insert-remove", "[Cache]")
         ThumbnailCache::get()->storeThumbnail(binId, 0, img, false);
         REQUIRE(ThumbnailCache::get()->checkIntegrity());
     }
+
+    SECTION("Thumbnail producers are reused until the clip is invalidated")
+    {
+        auto binClip = binModel->getClipByBinID(binId);
+        auto &pool = ThumbnailProducerPool::get();
+        int hits = pool->hits();
+        int misses = pool->misses();
+        std::shared_ptr<Mlt::Producer> prod = pool->acquire(binClip);
+        REQUIRE(prod != nullptr);
+        Mlt::Producer *firstProducer = prod.get();
+        REQUIRE(pool->misses() == misses + 1);
+        // While in use, the producer is not shared
+        std::shared_ptr<Mlt::Producer> other = pool->acquire(binClip);
+        REQUIRE(other != nullptr);
+        REQUIRE(other.get() != firstProducer);
+        other.reset();
+        prod.reset();
+        prod = pool->acquire(binClip);
+        REQUIRE(pool->hits() == hits + 1);
+        prod.reset();
+        pool->invalidate(binId);
+        misses = pool->misses();
+        prod = pool->acquire(binClip);
+        REQUIRE(pool->misses() == misses + 1);
+        // A producer in use during an invalidation is not returned to the pool
+        pool->invalidate(binId);
+        prod.reset();
+        prod = pool->acquire(binClip);
+        REQUIRE(pool->misses() == misses + 2);
+        prod.reset();
+        pool->clear();
+    }
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
 
@@ -90,3 +130,443 @@ TEST_CASE("getAudioKey() should dereference `ok` param", "ThumbnailCache") {
     }
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
+
+TEST_CASE("Thumbnail pack store", "[Cache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = QDir(dir.path()).absoluteFilePath(QStringLiteral("abcd.thumbs"));
+    QImage red(64, 36, QImage::Format_RGB32);
+    red.fill(Qt::red);
+    QImage blue(64, 36, QImage::Format_RGB32);
+    blue.fill(Qt::blue);
+
+    SECTION("Thumbnails are found again after reopening the pack")
+    {
+        {
+            ThumbnailPack pack(path);
+            REQUIRE(pack.store(0, red));
+            REQUIRE(pack.store(25, blue));
+            REQUIRE(pack.contains(25));
+            REQUIRE_FALSE(pack.contains(50));
+        }
+        ThumbnailPack pack(path);
+        REQUIRE(pack.positions() == std::vector<int>({0, 25}));
+        REQUIRE(pack.missing({0, 25, 50}) == std::vector<int>({50}));
+        QMap<int, QImage> images = pack.images({0, 25, 50});
+        REQUIRE(images.size() == 2);
+        REQUIRE(images.value(0).size() == red.size());
+        REQUIRE(qBlue(images.value(25).pixel(10, 10)) > 200);
+    }
+
+    SECTION("Replaced thumbnails are dropped by compaction")
+    {
+        ThumbnailPack pack(path);
+        REQUIRE(pack.store(0, red));
+        REQUIRE(pack.store(0, blue));
+        REQUIRE(pack.deadBytes() > 0);
+        const qint64 size = pack.fileSize();
+        REQUIRE(pack.compact());
+        REQUIRE(pack.deadBytes() == 0);
+        REQUIRE(pack.fileSize() < size);
+        REQUIRE(QFileInfo(path).size() == pack.fileSize());
+        REQUIRE(qBlue(pack.image(0).pixel(10, 10)) > 200);
+    }
+
+    SECTION("A truncated record is ignored and overwritten")
+    {
+        {
+            ThumbnailPack pack(path);
+            REQUIRE(pack.store(0, red));
+            REQUIRE(pack.store(25, blue));
+        }
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::ReadWrite));
+        REQUIRE(file.resize(file.size() - 10));
+        file.close();
+        ThumbnailPack pack(path);
+        REQUIRE(pack.positions() == std::vector<int>({0}));
+        REQUIRE(pack.store(50, red));
+        ThumbnailPack reopened(path);
+        REQUIRE(reopened.positions() == std::vector<int>({0, 50}));
+        REQUIRE_FALSE(reopened.image(50).isNull());
+    }
+
+    SECTION("Legacy thumbnail files are imported")
+    {
+        QDir folder(dir.path());
+        REQUIRE(red.save(folder.absoluteFilePath(QStringLiteral("abcd#0.jpg"))));
+        REQUIRE(blue.save(folder.absoluteFilePath(QStringLiteral("abcd#25.jpg"))));
+        REQUIRE(blue.save(folder.absoluteFilePath(QStringLiteral("other#25.jpg"))));
+        ThumbnailPack pack(path);
+        REQUIRE(pack.migrate(folder, QStringLiteral("abcd")) == 2);
+        REQUIRE(pack.positions() == std::vector<int>({0, 25}));
+        REQUIRE_FALSE(folder.exists(QStringLiteral("abcd#0.jpg")));
+        REQUIRE(folder.exists(QStringLiteral("other#25.jpg")));
+    }
+}
+
+TEST_CASE("Media probe cache", "[Cache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString cachePath = QDir(dir.path()).absoluteFilePath(QStringLiteral("mediaprobe.cache"));
+    const QString mediaPath = QDir(dir.path()).absoluteFilePath(QStringLiteral("clip.mp4"));
+    QFile media(mediaPath);
+    REQUIRE(media.open(QIODevice::WriteOnly));
+    media.write(QByteArray(1024, 'a'));
+    media.close();
+    MediaProbeCache::Properties probed;
+    probed.insert("length", "250");
+    probed.insert("seekable", "1");
+    probed.insert("meta.media.variable_frame_rate", "0");
+
+    SECTION("Probed properties are found again after reloading the cache")
+    {
+        {
+            MediaProbeCache cache(cachePath);
+            cache.store(MediaProbeCache::key(mediaPath, QStringLiteral("hash")), probed);
+            REQUIRE(cache.save());
+        }
+        MediaProbeCache cache(cachePath);
+        MediaProbeCache::Properties properties;
+        REQUIRE(cache.lookup(MediaProbeCache::key(mediaPath, QStringLiteral("hash")), properties));
+        REQUIRE(properties == probed);
+        REQUIRE(cache.hits() == 1);
+    }
+
+    SECTION("Changed files are probed again")
+    {
+        MediaProbeCache cache(cachePath);
+        cache.store(MediaProbeCache::key(mediaPath, QStringLiteral("hash")), probed);
+        MediaProbeCache::Properties properties;
+        REQUIRE_FALSE(cache.lookup(MediaProbeCache::key(mediaPath, QStringLiteral("other")), properties));
+        REQUIRE(media.open(QIODevice::Append));
+        media.write("b");
+        media.close();
+        REQUIRE_FALSE(cache.lookup(MediaProbeCache::key(mediaPath, QStringLiteral("hash")), properties));
+        REQUIRE(cache.misses() == 2);
+        // Files without hash or missing files are never cached
+        REQUIRE_FALSE(MediaProbeCache::key(mediaPath, QString()).isValid());
+        REQUIRE_FALSE(MediaProbeCache::key(QDir(dir.path()).absoluteFilePath(QStringLiteral("missing.mp4")), QStringLiteral("hash")).isValid());
+    }
+
+    SECTION("Least recently used entries are dropped")
+    {
+        MediaProbeCache cache(cachePath, 2);
+        QStringList paths;
+        for (int i = 0; i < 3; ++i) {
+            paths << QDir(dir.path()).absoluteFilePath(QStringLiteral("clip%1.mp4").arg(i));
+            QFile file(paths.last());
+            REQUIRE(file.open(QIODevice::WriteOnly));
+            file.write("data");
+            file.close();
+        }
+        MediaProbeCache::Properties properties;
+        cache.store(MediaProbeCache::key(paths.at(0), QStringLiteral("hash")), probed);
+        cache.store(MediaProbeCache::key(paths.at(1), QStringLiteral("hash")), probed);
+        REQUIRE(cache.lookup(MediaProbeCache::key(paths.at(0), QStringLiteral("hash")), properties));
+        cache.store(MediaProbeCache::key(paths.at(2), QStringLiteral("hash")), probed);
+        REQUIRE(cache.count() == 2);
+        REQUIRE(cache.lookup(MediaProbeCache::key(paths.at(0), QStringLiteral("hash")), properties));
+        REQUIRE_FALSE(cache.lookup(MediaProbeCache::key(paths.at(1), QStringLiteral("hash")), properties));
+    }
+}
+
+TEST_CASE("Shared audio source", "[Cache]")
+{
+    Mlt::Profile profile;
+    std::shared_ptr<Mlt::Producer> decoder = std::make_shared<Mlt::Producer>(profile, "noise");
+    REQUIRE(decoder->is_valid());
+    decoder->set("length", 200);
+    decoder->set("out", 199);
+    Mlt::Producer model(profile, "noise");
+    model.set("length", 200);
+    model.set("out", 199);
+    model.set("kdenlive:id", 3);
+    // Small read ahead and cache, about 10 frames of 48kHz stereo float audio
+    auto source = SharedAudioSource::create(decoder, 160 * 1024, 5);
+    std::shared_ptr<Mlt::Producer> first = source->createCursor(model);
+    std::shared_ptr<Mlt::Producer> second = source->createCursor(model);
+    REQUIRE(first->is_valid());
+    // Cursors are saved like the producer they replace
+    REQUIRE(QString(first->get("mlt_service")) == QStringLiteral("noise"));
+    REQUIRE(first->get_int("kdenlive:id") == 3);
+    REQUIRE(first->get_length() == 200);
+
+    auto readAudio = [](Mlt::Producer &cursor, int position) {
+        cursor.seek(position);
+        std::unique_ptr<Mlt::Frame> frame(cursor.get_frame());
+        mlt_audio_format format = mlt_audio_f32le;
+        int frequency = 48000;
+        int channels = 2;
+        int samples = mlt_audio_calculate_frame_samples(float(cursor.get_fps()), frequency, position);
+        return frame->get_audio(format, frequency, channels, samples) != nullptr && samples > 0;
+    };
+
+    SECTION("Cursors share the decoded audio")
+    {
+        REQUIRE(readAudio(*first.get(), 10));
+        REQUIRE(source->misses() == 1);
+        REQUIRE(source->decodedFrames() == 5);
+        // The second track reads the same frames without decoding them again
+        for (int i = 10; i < 15; ++i) {
+            REQUIRE(readAudio(*second.get(), i));
+        }
+        REQUIRE(source->decodedFrames() == 5);
+        REQUIRE(source->hits() == 5);
+        REQUIRE(source->misses() == 1);
+    }
+
+    SECTION("Decoded audio cache is bounded")
+    {
+        for (int i = 0; i < 100; i += 5) {
+            REQUIRE(readAudio(*first.get(), i));
+        }
+        REQUIRE(source->decodedFrames() == 100);
+        REQUIRE(source->cachedBytes() > 0);
+        REQUIRE(source->cachedBytes() <= 160 * 1024);
+        // Old positions were evicted and must be decoded again
+        const int misses = source->misses();
+        REQUIRE(readAudio(*second.get(), 0));
+        REQUIRE(source->misses() == misses + 1);
+    }
+
+    SECTION("Decoder properties drop the decoded audio")
+    {
+        REQUIRE(readAudio(*first.get(), 10));
+        REQUIRE(source->cachedBytes() > 0);
+        source->setDecoderProperties({{QStringLiteral("force_fps"), QStringLiteral("25")}});
+        REQUIRE(decoder->get_int("force_fps") == 25);
+        REQUIRE(source->cachedBytes() == 0);
+        REQUIRE(readAudio(*second.get(), 10));
+        REQUIRE(source->misses() == 2);
+    }
+}
+
+TEST_CASE("Shared audio source at a fractional frame rate", "[Cache]")
+{
+    Mlt::Profile profile;
+    profile.set_frame_rate(30000, 1001);
+    std::shared_ptr<Mlt::Producer> decoder = std::make_shared<Mlt::Producer>(profile, "noise");
+    REQUIRE(decoder->is_valid());
+    decoder->set("length", 200);
+    decoder->set("out", 199);
+    Mlt::Producer model(profile, "noise");
+    model.set("length", 200);
+    model.set("out", 199);
+    auto source = SharedAudioSource::create(decoder, 8 * 1024 * 1024, 10);
+    std::shared_ptr<Mlt::Producer> first = source->createCursor(model);
+    std::shared_ptr<Mlt::Producer> second = source->createCursor(model);
+
+    // Clips placed at @offset in the timeline get the samples of their timeline frame, 1601 or 1602 at 29.97 fps
+    auto readAudio = [&profile](Mlt::Producer &cursor, int position, int offset) {
+        cursor.seek(position);
+        std::unique_ptr<Mlt::Frame> frame(cursor.get_frame());
+        mlt_audio_format format = mlt_audio_float;
+        int frequency = 48000;
+        int channels = 2;
+        const int expected = mlt_audio_calculate_frame_samples(float(profile.fps()), frequency, position + offset);
+        int samples = expected;
+        return frame->get_audio(format, frequency, channels, samples) != nullptr && samples == expected;
+    };
+
+    int differences = 0;
+    for (int i = 0; i < 10; ++i) {
+        if (mlt_audio_calculate_frame_samples(float(profile.fps()), 48000, i) != mlt_audio_calculate_frame_samples(float(profile.fps()), 48000, i + 3)) {
+            differences++;
+        }
+    }
+    // The test needs sample counts that differ from the source frames
+    REQUIRE(differences > 0);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(readAudio(*first.get(), i, 3));
+    }
+    REQUIRE(source->misses() == 1);
+    REQUIRE(source->hits() == 9);
+    // Another track at a different offset reads the same blocks
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(readAudio(*second.get(), i, 7));
+    }
+    REQUIRE(source->misses() == 1);
+    REQUIRE(source->decodedFrames() == 10);
+}
+
+TEST_CASE("Playback prefetch", "[Cache]")
+{
+    Mlt::Profile profile;
+    // Cuts of two track producers
+    Mlt::Producer red(profile, "color", "red");
+    Mlt::Producer blue(profile, "color", "blue");
+    red.set("length", 100);
+    blue.set("length", 100);
+    std::shared_ptr<Mlt::Producer> first(red.cut(0, 20));
+    std::shared_ptr<Mlt::Producer> second(blue.cut(10, 30));
+    const QSize size(64, 36);
+
+    SECTION("Prepared cuts are hits")
+    {
+        // 3 frames per cut, the consumer reads 5 frames ahead
+        PlaybackPrefetcher prefetcher(3, 5);
+        prefetcher.setFrameSize(size);
+        prefetcher.frameShown(0);
+        prefetcher.prefetch(0, {{20, 1, first, true}, {40, 2, second, true}});
+        prefetcher.waitForDone();
+        for (int i = 1; i <= 25; ++i) {
+            prefetcher.frameShown(i);
+        }
+        REQUIRE(prefetcher.hits() == 1);
+        REQUIRE(prefetcher.misses() == 0);
+    }
+
+    SECTION("Cuts that cannot be prepared are misses")
+    {
+        PlaybackPrefetcher prefetcher(3, 5);
+        prefetcher.setFrameSize(size);
+        prefetcher.frameShown(0);
+        // The first cut is within the consumer read ahead
+        prefetcher.prefetch(0, {{4, 1, first, true}, {20, 2, second, true}});
+        prefetcher.waitForDone();
+        for (int i = 1; i <= 30; ++i) {
+            prefetcher.frameShown(i);
+        }
+        REQUIRE(prefetcher.hits() == 1);
+        REQUIRE(prefetcher.misses() == 1);
+    }
+
+    SECTION("Seeks release the cuts without counting them")
+    {
+        PlaybackPrefetcher prefetcher(3, 5);
+        prefetcher.setFrameSize(size);
+        prefetcher.frameShown(0);
+        prefetcher.prefetch(0, {{20, 1, first, true}});
+        prefetcher.waitForDone();
+        prefetcher.frameShown(50);
+        prefetcher.frameShown(51);
+        REQUIRE(prefetcher.hits() == 0);
+        REQUIRE(prefetcher.misses() == 0);
+    }
+
+    SECTION("Reset waits for the running jobs")
+    {
+        // Enough frames for the job to still be running when reset
+        PlaybackPrefetcher prefetcher(100000, 5);
+        prefetcher.setFrameSize(size);
+        prefetcher.frameShown(0);
+        prefetcher.prefetch(0, {{20, 1, first, true}});
+        // Wait for the job to start rendering
+        int tries = 0;
+        while (first->position() == 0 && tries++ < 500) {
+            QThread::msleep(2);
+        }
+        REQUIRE(first->position() > 0);
+        prefetcher.reset();
+        // The producer is not seeked by the prefetcher anymore
+        first->seek(3);
+        QThread::msleep(50);
+        REQUIRE(first->position() == 3);
+        prefetcher.frameShown(30);
+        prefetcher.frameShown(31);
+        REQUIRE(prefetcher.hits() == 0);
+        REQUIRE(prefetcher.misses() == 0);
+    }
+
+    SECTION("Jobs stop before the consumer reaches their cut")
+    {
+        PlaybackPrefetcher prefetcher(100000, 5);
+        prefetcher.setFrameSize(size);
+        prefetcher.frameShown(0);
+        prefetcher.prefetch(0, {{20, 1, first, true}});
+        int tries = 0;
+        while (first->position() == 0 && tries++ < 500) {
+            QThread::msleep(2);
+        }
+        // Two read aheads away from the cut, the job stops without being waited for
+        prefetcher.frameShown(5);
+        prefetcher.frameShown(10);
+        prefetcher.waitForDone();
+        first->seek(3);
+        QThread::msleep(50);
+        REQUIRE(first->position() == 3);
+        prefetcher.frameShown(15);
+        prefetcher.frameShown(20);
+        REQUIRE(prefetcher.hits() == 0);
+        REQUIRE(prefetcher.misses() == 1);
+    }
+}
+
+TEST_CASE("Shuttle playback cache", "[Cache]")
+{
+    Mlt::Profile profile;
+    std::shared_ptr<Mlt::Producer> source = std::make_shared<Mlt::Producer>(profile, "noise");
+    REQUIRE(source->is_valid());
+    source->set("length", 100);
+    source->set("out", 99);
+    const int imageSize = 64 * 36 * 2;
+    // Blocks of 5 frames, room for 4 blocks
+    auto cache = ShuttleCache::create(source, 20 * imageSize, 5);
+    REQUIRE(cache);
+    std::shared_ptr<Mlt::Producer> producer = cache->producer();
+
+    auto showFrame = [&producer]() {
+        std::unique_ptr<Mlt::Frame> frame(producer->get_frame());
+        mlt_image_format format = mlt_image_yuv422;
+        int width = 64;
+        int height = 36;
+        REQUIRE(frame->get_image(format, width, height) != nullptr);
+        return frame->get_position();
+    };
+
+    SECTION("Reverse playback decodes each block once")
+    {
+        source->seek(50);
+        source->set_speed(-1);
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE(showFrame() == 50 - i);
+        }
+        // The monitor producer was advanced like by the consumer
+        REQUIRE(source->position() == 40);
+        REQUIRE(cache->misses() == 2);
+        REQUIRE(cache->hits() == 8);
+        REQUIRE(cache->decodedFrames() == 10);
+    }
+
+    SECTION("Fast forward reads the block from the requested frame")
+    {
+        source->seek(10);
+        source->set_speed(2);
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(showFrame() == 10 + 2 * i);
+        }
+        REQUIRE(cache->misses() == 1);
+        REQUIRE(cache->decodedFrames() == 5);
+    }
+
+    SECTION("Decoded frames are bounded")
+    {
+        source->seek(99);
+        source->set_speed(-1);
+        for (int i = 0; i < 60; ++i) {
+            showFrame();
+        }
+        REQUIRE(cache->cachedBytes() <= 20 * imageSize);
+        REQUIRE(cache->decodedFrames() == 60);
+    }
+
+    SECTION("Frames carry the audio of the monitor producer")
+    {
+        source->seek(30);
+        source->set_speed(-1);
+        std::unique_ptr<Mlt::Frame> frame(producer->get_frame());
+        REQUIRE(frame->get_int("test_audio") == 0);
+        mlt_audio_format format = mlt_audio_s16;
+        int frequency = 48000;
+        int channels = 2;
+        int samples = mlt_audio_calculate_frame_samples(float(source->get_fps()), frequency, 30);
+        REQUIRE(frame->get_audio(format, frequency, channels, samples) != nullptr);
+        REQUIRE(samples > 0);
+        // Only the audio was requested, no image was decoded
+        REQUIRE(cache->decodedFrames() == 0);
+        REQUIRE(source->position() == 29);
+    }
+}
@@ -9,6 +9,10 @@
 #include "scopes/colorscopes/waveformgenerator.h"
 #include "scopes/colorscopes/rgbparadegenerator.h"
 #include "scopes/colorscopes/histogramgenerator.h"
+#include "scopes/colorscopes/scopeframeanalysis.h"
+#include "scopes/colorscopes/scopekernels.h"
+
+#include <cstring>
 
 // test for a bug where pixels were assumed to be RGB which was not true on
 // Windows, resulting in red and blue switched. BUG: 453149
@@ -69,3 +73,184 @@ TEST_CASE("Colorscope RGB/BGR handling")
         CHECK(rgbScope == bgrScope);
     }
 }
+
+TEST_CASE("Colorscope shared frame analysis", "[Colorscopes]")
+{
+    // a gradient so that the columns and values differ
+    QImage inputImage(320, 240, QImage::Format_RGBA8888);
+    for (int y = 0; y < inputImage.height(); ++y) {
+        for (int x = 0; x < inputImage.width(); ++x) {
+            inputImage.setPixel(x, y, qRgb(x % 256, y % 256, (x + y) % 256));
+        }
+    }
+
+    QSize scopeSize{256, 256};
+    qreal scalingFactor = 1.0;
+    ScopeFrameAnalysis::Features features = WaveformGenerator::analysisFeatures(ITURec::Rec_709) | ScopeFrameAnalysis::Parade |
+                                            HistogramGenerator::analysisFeatures(HistogramGenerator::ComponentY, ITURec::Rec_601) |
+                                            VectorscopeGenerator::analysisFeatures(VectorscopeGenerator::ColorSpace_YPbPr);
+    ScopeFrameAnalysis shared(inputImage, features);
+
+    SECTION("Statistics are accumulated once for all scopes")
+    {
+        shared.analyse();
+        CHECK(shared.samples() == inputImage.width() * inputImage.height());
+        CHECK(shared.columns() == inputImage.width());
+        CHECK(shared.provides(ScopeFrameAnalysis::RGBHistogram));
+        CHECK_FALSE(shared.provides(ScopeFrameAnalysis::UVDensityYUV));
+        const int *red = shared.histogram(ScopeFrameAnalysis::Red);
+        // Each red value 0-63 appears in two columns of 240 pixels
+        CHECK(red[0] == 2 * inputImage.height());
+        CHECK(red[200] == inputImage.height());
+    }
+
+    SECTION("Scopes drawn from the shared analysis match the standalone ones")
+    {
+        WaveformGenerator waveform{};
+        CHECK(waveform.calculateWaveform(scopeSize, scalingFactor, shared, WaveformGenerator::PaintMode_Yellow, false, ITURec::Rec_709) ==
+              waveform.calculateWaveform(scopeSize, scalingFactor, inputImage, WaveformGenerator::PaintMode_Yellow, false, ITURec::Rec_709));
+
+        RGBParadeGenerator rgb{};
+        CHECK(rgb.calculateRGBParade(scopeSize, scalingFactor, shared, RGBParadeGenerator::PaintMode_RGB, false, false) ==
+              rgb.calculateRGBParade(scopeSize, scalingFactor, inputImage, RGBParadeGenerator::PaintMode_RGB, false, false));
+
+        HistogramGenerator hist{};
+        CHECK(hist.calculateHistogram(scopeSize, scalingFactor, shared, HistogramGenerator::ComponentY, ITURec::Rec_601, false, false) ==
+              hist.calculateHistogram(scopeSize, scalingFactor, inputImage, HistogramGenerator::ComponentY, ITURec::Rec_601, false, false));
+
+        VectorscopeGenerator vectorscope{};
+        CHECK(vectorscope.calculateVectorscope(scopeSize, scalingFactor, shared, 1, VectorscopeGenerator::PaintMode_Green2,
+                                               VectorscopeGenerator::ColorSpace_YPbPr, false) ==
+              vectorscope.calculateVectorscope(scopeSize, scalingFactor, inputImage, 1, VectorscopeGenerator::PaintMode_Green2,
+                                               VectorscopeGenerator::ColorSpace_YPbPr, false));
+    }
+}
+
+namespace {
+// a UHD frame with pseudo random content
+QImage randomUhdImage()
+{
+    QImage image(3840, 2160, QImage::Format_RGBA8888);
+    quint32 seed = 1;
+    for (int y = 0; y < image.height(); ++y) {
+        auto *line = reinterpret_cast<quint32 *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            line[x] = seed;
+        }
+    }
+    return image;
+}
+} // namespace
+
+TEST_CASE("Colorscope kernels", "[Colorscopes]")
+{
+    const QImage inputImage = randomUhdImage();
+
+    SECTION("All kernels produce the same planes")
+    {
+        const int width = inputImage.width();
+        std::vector<std::vector<uint8_t>> reference;
+        for (auto kernel : {ScopeKernels::Kernel::Scalar, ScopeKernels::Kernel::SSE41, ScopeKernels::Kernel::AVX2}) {
+            std::vector<std::vector<uint8_t>> data(9, std::vector<uint8_t>(size_t(width)));
+            ScopeKernels::LinePlanes planes;
+            planes.red = data[0].data();
+            planes.green = data[1].data();
+            planes.blue = data[2].data();
+            planes.luma601 = data[3].data();
+            planes.luma709 = data[4].data();
+            planes.uYUV = data[5].data();
+            planes.vYUV = data[6].data();
+            planes.uYPbPr = data[7].data();
+            planes.vYPbPr = data[8].data();
+            // Odd pixel count to also check the scalar tail of the SIMD kernels
+            ScopeKernels::decodeLine(kernel)(inputImage.constScanLine(0), width - 3, {0, 1, 2}, planes);
+            if (reference.empty()) {
+                reference = data;
+            } else {
+                CHECK(data == reference);
+            }
+        }
+        // White is at the top of the luma range, grey at the center of the vectorscope
+        const uint8_t pixels[8] = {255, 255, 255, 255, 128, 128, 128, 255};
+        uint8_t luma[2], u[2], v[2];
+        ScopeKernels::LinePlanes planes;
+        planes.luma709 = luma;
+        planes.uYUV = u;
+        planes.vYUV = v;
+        ScopeKernels::decodeLine()(pixels, 2, {0, 1, 2}, planes);
+        CHECK(luma[0] == 255);
+        CHECK(u[1] == 127);
+        CHECK(v[1] == 127);
+    }
+}
+
+TEST_CASE("Colorscope native YUV frames", "[Colorscopes]")
+{
+    // A limited range yuv422 frame: a luma ramp from black (16) to white (235), no chroma
+    const int width = 220;
+    const int height = 8;
+    const int size = width * height * 2;
+    auto *data = static_cast<uint8_t *>(mlt_pool_alloc(size));
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uint8_t *px = data + (y * width + x) * 2;
+            px[0] = uint8_t(16 + x * 219 / (width - 1));
+            px[1] = 128;
+        }
+    }
+    Mlt::Frame mltFrame(mlt_frame_init(nullptr));
+    mltFrame.set("format", mlt_image_yuv422);
+    mltFrame.set("width", width);
+    mltFrame.set("height", height);
+    mltFrame.set("colorspace", 709);
+    mltFrame.set_image(data, size, mlt_pool_release);
+    SharedFrame frame(mltFrame);
+
+    // Only the luma of the frame colorspace is read from the Y plane, Rec.601 would be computed from RGB
+    ScopeFrameAnalysis analysis(frame, WaveformGenerator::analysisFeatures(ITURec::Rec_709) | ScopeFrameAnalysis::LumaHistogram709 |
+                                           ScopeFrameAnalysis::UVDensityYPbPr);
+    analysis.analyse();
+    REQUIRE(analysis.frameSize() == QSize(width, height));
+    CHECK(analysis.image().isNull());
+    CHECK(analysis.samples() == width * height);
+
+    SECTION("Luma is read from the Y plane and expanded to full range")
+    {
+        const int *luma = analysis.histogram(ScopeFrameAnalysis::Luma709);
+        CHECK(luma[0] == height);
+        CHECK(luma[255] == height);
+        const uint *wave = analysis.waveformBins(ITURec::Rec_709);
+        CHECK(wave[0] == uint(height));
+        CHECK(wave[size_t(width - 1) * ScopeFrameAnalysis::Bins + 255] == uint(height));
+    }
+
+    SECTION("Grey pixels fall in the center chroma bin")
+    {
+        const uint *density = analysis.uvDensity(ScopeFrameAnalysis::UV_YPbPr);
+        CHECK(density[128 * ScopeFrameAnalysis::UVBins + 128] == uint(width * height));
+    }
+}
+
+TEST_CASE("Colorscope native YUV frames of odd size", "[Colorscopes]")
+{
+    // Grey frames, each luma pixel must be counted once in the chroma density
+    const int width = 9;
+    const int height = 5;
+    for (mlt_image_format format : {mlt_image_yuv422, mlt_image_yuv420p}) {
+        const int size = mlt_image_format_size(format, width, height, nullptr);
+        auto *data = static_cast<uint8_t *>(mlt_pool_alloc(size));
+        memset(data, 128, size_t(size));
+        Mlt::Frame mltFrame(mlt_frame_init(nullptr));
+        mltFrame.set("format", format);
+        mltFrame.set("width", width);
+        mltFrame.set("height", height);
+        mltFrame.set_image(data, size, mlt_pool_release);
+        SharedFrame frame(mltFrame);
+        ScopeFrameAnalysis analysis(frame, ScopeFrameAnalysis::UVDensityYPbPr);
+        analysis.analyse();
+        CHECK(analysis.image().isNull());
+        const uint *density = analysis.uvDensity(ScopeFrameAnalysis::UV_YPbPr);
+        CHECK(density[128 * ScopeFrameAnalysis::UVBins + 128] == uint(width * height));
+    }
+}
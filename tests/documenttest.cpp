@@ -5,7 +5,16 @@
 
 #include "test_utils.hpp"
 // test specific headers
+#include "doc/autosavejournal.h"
 #include "doc/documentchecker.h"
+#include "doc/kdenlivedoc.h"
+#include "doc/mediarelocator.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QScopeGuard>
+#include <QStandardPaths>
+#include <QTemporaryDir>
 
 TEST_CASE("Basic tests of the document checker parts", "[DocumentChecker]")
 {
@@ -60,3 +69,174 @@ TEST_CASE("Missing project items", "[DocumentChecker]")
         CHECK(results.value(DocumentChecker::MissingType::Proxy) == 1);
     }
 }
+
+TEST_CASE("Missing media relocation", "[DocumentChecker]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    QDir root(dir.path());
+    REQUIRE(root.mkpath(QStringLiteral("a/b")));
+    REQUIRE(root.mkpath(QStringLiteral("c")));
+    const auto writeFile = [&root](const QString &path, const QByteArray &data) {
+        QFile file(root.absoluteFilePath(path));
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write(data);
+        file.close();
+        return MediaRelocator::fileHash(file.fileName());
+    };
+    // Two files with the same size, one of them renamed
+    const QString firstHash = writeFile(QStringLiteral("a/b/first.mp4"), QByteArray(100, 'a'));
+    const QString secondHash = writeFile(QStringLiteral("c/renamed.mp4"), QByteArray(100, 'b'));
+    writeFile(QStringLiteral("c/unique.mp4"), QByteArray(150, 'c'));
+    writeFile(QStringLiteral("a/named.png"), QByteArray(10, 'd'));
+
+    QMap<int, MediaRelocator::Target> targets;
+    targets.insert(1, {QStringLiteral("first.mp4"), 100, firstHash});
+    targets.insert(2, {QStringLiteral("second.mp4"), 100, secondHash});
+    targets.insert(3, {QStringLiteral("unique.mp4"), 150, QStringLiteral("0123")});
+    targets.insert(4, {QStringLiteral("named.png"), -1, QString()});
+    targets.insert(5, {QStringLiteral("lost.mp4"), 200, QStringLiteral("4567")});
+
+    MediaRelocator relocator(root);
+    const QMap<int, QString> found = relocator.relocate(targets, false);
+    CHECK(found.value(1) == root.absoluteFilePath(QStringLiteral("a/b/first.mp4")));
+    CHECK(found.value(2) == root.absoluteFilePath(QStringLiteral("c/renamed.mp4")));
+    // Same name and size, but the hash differs
+    CHECK_FALSE(found.contains(3));
+    CHECK_FALSE(found.contains(4));
+    CHECK_FALSE(found.contains(5));
+    CHECK(relocator.scannedFolders() == 4);
+    CHECK(relocator.hashedFiles() == 3);
+
+    // Files that cannot be found by hash are matched by name like a QDir name filter
+    targets.insert(6, {QStringLiteral("FIRST.mp4"), -1, QString()});
+    const QMap<int, QString> named = relocator.relocate(targets);
+    CHECK(named.value(3) == root.absoluteFilePath(QStringLiteral("c/unique.mp4")));
+    CHECK(named.value(4) == root.absoluteFilePath(QStringLiteral("a/named.png")));
+    CHECK(named.value(6) == root.absoluteFilePath(QStringLiteral("a/b/first.mp4")));
+    CHECK_FALSE(named.contains(5));
+
+    // Single file search, used by the document checker
+    CHECK(DocumentChecker::searchFileRecursively(root, QStringLiteral("100"), secondHash, QStringLiteral("/old/second.mp4")) ==
+          root.absoluteFilePath(QStringLiteral("c/renamed.mp4")));
+    CHECK(DocumentChecker::searchFileRecursively(root, QStringLiteral("200"), QStringLiteral("4567"), QStringLiteral("/old/lost.mp4")).isEmpty());
+}
+
+TEST_CASE("Autosave journal", "[AutoSave]")
+{
+    QByteArrayList scene;
+    for (int i = 0; i < 200; i++) {
+        scene << QStringLiteral("  <entry producer=\"producer%1\" in=\"0\" out=\"%2\"/>").arg(i).arg(i * 10).toUtf8();
+    }
+
+    SECTION("Diff and patch")
+    {
+        QByteArrayList edited = scene;
+        edited[10] = "  <entry producer=\"moved\"/>";
+        edited.removeAt(150);
+        edited.insert(50, "  <blank length=\"20\"/>");
+        const QByteArray delta = AutoSaveJournal::diff(scene, edited);
+        REQUIRE_FALSE(delta.isEmpty());
+        REQUIRE(delta.size() < scene.join('\n').size() / 10);
+        QByteArrayList lines = scene;
+        REQUIRE(AutoSaveJournal::patch(lines, delta));
+        REQUIRE(lines == edited);
+        REQUIRE(AutoSaveJournal::diff(scene, scene).isEmpty());
+        // A delta does not apply to a shorter document
+        QByteArrayList shorter = scene.mid(0, 20);
+        REQUIRE_FALSE(AutoSaveJournal::patch(shorter, delta));
+        REQUIRE(shorter == scene.mid(0, 20));
+    }
+
+    SECTION("Recover snapshot and journal")
+    {
+        // The journals are written in the application data folder, keep them out of the user profile
+        QStandardPaths::setTestModeEnabled(true);
+        const auto restorePaths = qScopeGuard([]() { QStandardPaths::setTestModeEnabled(false); });
+        QTemporaryDir dir;
+        REQUIRE(dir.isValid());
+        QFile file(dir.filePath(QStringLiteral("autosave.kdenlive")));
+        REQUIRE(file.open(QIODevice::ReadWrite));
+        AutoSaveJournal journal;
+        REQUIRE(journal.write(&file, scene.join('\n')));
+        REQUIRE(journal.lastWriteWasSnapshot());
+        QByteArrayList edited = scene;
+        for (int i = 0; i < 5; i++) {
+            edited[i * 30] = QByteArray("  <entry producer=\"edit") + QByteArray::number(i) + "\"/>";
+            REQUIRE(journal.write(&file, edited.join('\n')));
+            REQUIRE_FALSE(journal.lastWriteWasSnapshot());
+            REQUIRE(journal.lastWriteSize() < 200);
+        }
+        REQUIRE(QFile::exists(AutoSaveJournal::journalPath(file.fileName())));
+        // The journal is not listed with the autosave files
+        REQUIRE(QDir(dir.path()).entryList(QDir::Files) == QStringList{QStringLiteral("autosave.kdenlive")});
+        // The snapshot is not modified by the journal records
+        file.close();
+        REQUIRE(file.open(QIODevice::ReadWrite));
+        REQUIRE(file.readAll() == scene.join('\n'));
+        REQUIRE(AutoSaveJournal::recover(&file) == 5);
+        file.seek(0);
+        REQUIRE(file.readAll() == edited.join('\n'));
+        REQUIRE_FALSE(QFile::exists(AutoSaveJournal::journalPath(file.fileName())));
+        // Nothing left to replay
+        REQUIRE(AutoSaveJournal::recover(&file) == 0);
+    }
+}
+
+TEST_CASE("Streamed project save", "[Save]")
+{
+    const QString scene = QStringLiteral("<?xml version='1.0' encoding='utf-8'?>\n<mlt LC_NUMERIC=\"C\" producer=\"main_bin\">\n"
+                                         " <playlist id=\"playlist0\"><property name=\"meta.volume\">0.5</property></playlist>\n"
+                                         " <tractor id=\"tractor0\" global_feed=\"1\" in=\"0\" out=\"10\">\n"
+                                         "  <property name=\"meta.volume\">0.5</property>\n"
+                                         "  <track producer=\"playlist0\"/>\n"
+                                         " </tractor>\n"
+                                         " <!-- a comment & entities: &lt;&amp; -->\n"
+                                         "</mlt>\n");
+
+    SECTION("Output matches the document based save")
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        REQUIRE(KdenliveDoc::writeSceneList(scene, &buffer));
+        QDomDocument expected;
+        expected.setContent(scene);
+        QDomElement tractor = expected.documentElement().firstChildElement(QStringLiteral("tractor"));
+        Xml::setXmlProperty(tractor, QStringLiteral("meta.volume"), QStringLiteral("1"));
+        QDomDocument result;
+        REQUIRE(result.setContent(data));
+        CHECK(result.toString() == expected.toString());
+        // Only the main tractor volume is reset
+        CHECK(Xml::getXmlProperty(result.documentElement().firstChildElement(QStringLiteral("playlist")), QStringLiteral("meta.volume")) ==
+              QStringLiteral("0.5"));
+    }
+
+    SECTION("Dataset projects are saved unchanged")
+    {
+        for (const QString &name : {QStringLiteral("clip-ids.kdenlive"), QStringLiteral("test-nesting-effects.kdenlive")}) {
+            QFile source(sourcesPath + "/dataset/" + name);
+            REQUIRE(source.open(QIODevice::ReadOnly));
+            const QString content = QString::fromUtf8(source.readAll());
+            QByteArray data;
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::WriteOnly);
+            REQUIRE(KdenliveDoc::writeSceneList(content, &buffer));
+            QDomDocument expected;
+            expected.setContent(content);
+            QDomDocument result;
+            REQUIRE(result.setContent(data));
+            CHECK(result.toString() == expected.toString());
+        }
+    }
+
+    SECTION("Corrupted scenes are rejected")
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        CHECK_FALSE(KdenliveDoc::writeSceneList(QStringLiteral("<mlt><playlist id=\"playlist0\"/></mlt>"), &buffer));
+        CHECK_FALSE(KdenliveDoc::writeSceneList(QStringLiteral("<mlt><tractor><track producer=\"a\"/></tractor>"), &buffer));
+        CHECK_FALSE(KdenliveDoc::writeSceneList(QStringLiteral("<kdenlive><track/></kdenlive>"), &buffer));
+    }
+}
@@ -194,6 +194,39 @@ TEST_CASE("Keyframe model", "[KeyframeModel]")
         state0();
     }
 
+    SECTION("Interpolation matches MLT")
+    {
+        const double fps = pCore->getCurrentFps();
+        REQUIRE(KdenliveTests::addKeyframe(model, GenTime(20, fps), KeyframeType::CurveSmooth, 0.8));
+        REQUIRE(KdenliveTests::addKeyframe(model, GenTime(45, fps), KeyframeType::Linear, 0.1));
+        REQUIRE(KdenliveTests::addKeyframe(model, GenTime(60, fps), KeyframeType::CurveSmooth, 0.6));
+        REQUIRE(KdenliveTests::addKeyframe(model, GenTime(90, fps), KeyframeType::Discrete, 0.3));
+        REQUIRE(KdenliveTests::addKeyframe(model, GenTime(95, fps), KeyframeType::CubicIn, 1.));
+        auto checkValues = [&]() {
+            // Reference: the whole animation evaluated by MLT
+            Mlt::Properties mlt_prop;
+            mlt_prop.set("key", KdenliveTests::getAnimProperty(model).toUtf8().constData());
+            (void)mlt_prop.anim_get_double("key", 0, 150);
+            const QVector<QVariant> values = KdenliveTests::getInterpolatedValues(model, -5, 130);
+            REQUIRE(values.size() == 136);
+            for (int frame = -5; frame <= 130; ++frame) {
+                const double expected = mlt_prop.anim_get_double("key", qMax(0, frame));
+                REQUIRE(values.at(frame + 5).toDouble() == Approx(expected));
+                REQUIRE(KdenliveTests::getInterpolatedValue(model, frame).toDouble() == Approx(expected));
+            }
+        };
+        checkValues();
+
+        // The cached interpolation must follow the changes
+        REQUIRE(KdenliveTests::removeKeyframe(model, GenTime(60, fps)));
+        checkValues();
+        undoStack->undo();
+        checkValues();
+        REQUIRE(model->updateKeyframe(GenTime(45, fps), 0.9));
+        checkValues();
+        REQUIRE(KdenliveTests::getInterpolatedValues(model, 10, 9).isEmpty());
+    }
+
     SECTION("Move keyframes + undo")
     {
         auto state0 = [&]() {
@@ -6,6 +6,7 @@
 */
 #include "test_utils.hpp"
 // test specific headers
+#include "bin/projectsortproxymodel.h"
 #include "doc/kdenlivedoc.h"
 #include <QUndoGroup>
 
@@ -2238,3 +2239,56 @@ TEST_CASE("New KdenliveDoc activeTrack", "KdenliveDoc")
         pCore->projectManager()->closeCurrentDocument(false, false);
     }
 }
+
+TEST_CASE("Bin search index", "[ProjectItemModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    KdenliveDoc document(undoStack);
+    pCore->projectManager()->testSetDocument(&document);
+
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    const QString rootId = binModel->getRootFolder()->clipId();
+    QString interviewsId, beachId, musicId;
+    REQUIRE(binModel->requestAddFolder(interviewsId, QStringLiteral("Interviews"), rootId, undo, redo));
+    REQUIRE(binModel->requestAddFolder(beachId, QStringLiteral("Beach Day"), interviewsId, undo, redo));
+    REQUIRE(binModel->requestAddFolder(musicId, QStringLiteral("Music"), rootId, undo, redo));
+    QString binId = KdenliveTests::createProducer(pCore->getProjectProfile(), "red", binModel);
+
+    ProjectSortProxyModel proxy;
+    proxy.setSourceModel(binModel.get());
+    const int allRows = proxy.rowCount();
+
+    // Matching folder is shown inside its parent
+    proxy.slotSetSearchString(QStringLiteral("beach"));
+    REQUIRE(proxy.rowCount() == 1);
+    QModelIndex interviews = proxy.index(0, 0);
+    REQUIRE(interviews.data().toString() == QStringLiteral("Interviews"));
+    REQUIRE(proxy.rowCount(interviews) == 1);
+    const int fullScan = proxy.lastScanCount();
+    REQUIRE(fullScan >= 4);
+
+    // Appended characters only scan the previous matches
+    proxy.slotSetSearchString(QStringLiteral("beach d"));
+    REQUIRE(proxy.lastScanCount() == 1);
+    REQUIRE(proxy.rowCount() == 1);
+    proxy.slotSetSearchString(QStringLiteral("BEACH"));
+    REQUIRE(proxy.lastScanCount() == fullScan);
+
+    // Renamed items are reindexed
+    REQUIRE(binModel->requestRenameFolder(binModel->getFolderByBinId(musicId), QStringLiteral("Beach music")));
+    REQUIRE(proxy.rowCount() == 2);
+
+    // Marker comments are searched
+    auto clip = binModel->getClipByBinID(binId);
+    REQUIRE(clip->getMarkerModel()->addMarker(GenTime(10, pCore->getCurrentFps()), QStringLiteral("Sunset"), 0));
+    proxy.slotSetSearchString(QStringLiteral("sunset"));
+    REQUIRE(proxy.rowCount() == 1);
+
+    proxy.slotSetSearchString(QString());
+    REQUIRE(proxy.rowCount() == allRows);
+    binModel->clean();
+    pCore->projectManager()->closeCurrentDocument(false, false);
+}
@@ -6,6 +6,7 @@
 // test specific headers
 #include "doc/kdenlivedoc.h"
 #include "render/renderrequest.h"
+#include "render/renderscheduler.h"
 #include "renderpresets/renderpresetmodel.hpp"
 #include "renderpresets/renderpresetrepository.hpp"
 
@@ -279,3 +280,101 @@ TEST_CASE("Tests of the render functions to use guides for sections", "[RenderRe
         CHECK(sections.at(2).second == out);
     }
 }
+
+TEST_CASE("Segment ranges for parallel rendering", "[RenderRequestSegments]")
+{
+    SECTION("Segments start on a GOP boundary")
+    {
+        QVector<std::pair<int, int>> ranges = RenderRequest::segmentRanges(0, 999, 25, 4, 100);
+        REQUIRE(ranges.size() == 4);
+        CHECK(ranges.at(0) == std::make_pair(0, 249));
+        CHECK(ranges.at(1) == std::make_pair(250, 499));
+        CHECK(ranges.at(2) == std::make_pair(500, 749));
+        CHECK(ranges.at(3) == std::make_pair(750, 999));
+
+        // Boundaries are relative to the render in point
+        ranges = RenderRequest::segmentRanges(10, 1009, 60, 4, 100);
+        REQUIRE(ranges.size() == 4);
+        CHECK(ranges.at(0) == std::make_pair(10, 309));
+        CHECK(ranges.at(1) == std::make_pair(310, 609));
+        CHECK(ranges.at(2) == std::make_pair(610, 909));
+        CHECK(ranges.at(3) == std::make_pair(910, 1009));
+    }
+
+    SECTION("Last segment shorter than a GOP is merged")
+    {
+        QVector<std::pair<int, int>> ranges = RenderRequest::segmentRanges(0, 619, 300, 4, 200);
+        REQUIRE(ranges.size() == 2);
+        CHECK(ranges.at(0) == std::make_pair(0, 299));
+        CHECK(ranges.at(1) == std::make_pair(300, 619));
+    }
+
+    SECTION("Short ranges are not split")
+    {
+        CHECK(RenderRequest::segmentRanges(0, 150, 25, 4, 100).isEmpty());
+        CHECK(RenderRequest::segmentRanges(0, 999, 25, 1, 100).isEmpty());
+        CHECK(RenderRequest::segmentRanges(0, 999, 600, 4, 100).isEmpty());
+    }
+}
+
+TEST_CASE("Concurrent render queue scheduling", "[RenderScheduler]")
+{
+    using Job = RenderScheduler::Job;
+    auto job = [](const QString &output, int threads, int memory, int priority = RenderScheduler::NormalPriority) {
+        Job j;
+        j.output = output;
+        j.priority = priority;
+        j.cost = {threads, memory};
+        return j;
+    };
+
+    SECTION("Jobs run side by side within the budget")
+    {
+        RenderScheduler scheduler(8, 4000, 4);
+        std::vector<Job> waiting = {job("a.mp4", 3, 1000), job("b.mp4", 3, 1000), job("c.mp4", 3, 1000)};
+        CHECK(scheduler.jobsToStart(waiting, {}) == std::vector<size_t>{0, 1});
+        // One slot left in the budget once a job is running
+        CHECK(scheduler.jobsToStart(waiting, {job("x.mp4", 3, 1000)}) == std::vector<size_t>{0});
+        // Memory budget
+        waiting = {job("a.mp4", 1, 3000), job("b.mp4", 1, 3000)};
+        CHECK(scheduler.jobsToStart(waiting, {}) == std::vector<size_t>{0});
+        // Maximum job count
+        RenderScheduler serial(8, 4000, 1);
+        waiting = {job("a.mp4", 1, 100), job("b.mp4", 1, 100)};
+        CHECK(serial.jobsToStart(waiting, {}) == std::vector<size_t>{0});
+        CHECK(serial.jobsToStart(waiting, {job("x.mp4", 1, 100)}).empty());
+    }
+
+    SECTION("A job larger than the budget runs alone")
+    {
+        RenderScheduler scheduler(4, 1000, 4);
+        std::vector<Job> waiting = {job("a.mp4", 8, 2000), job("b.mp4", 1, 100)};
+        CHECK(scheduler.jobsToStart(waiting, {}) == std::vector<size_t>{0});
+        // Smaller jobs queued after a blocked one wait
+        CHECK(scheduler.jobsToStart(waiting, {job("x.mp4", 1, 100)}).empty());
+    }
+
+    SECTION("Priorities and passes")
+    {
+        RenderScheduler scheduler(4, 0, 4);
+        std::vector<Job> waiting = {job("a.mp4", 2, 100, RenderScheduler::LowPriority), job("b.mp4", 2, 100),
+                                    job("c.mp4", 2, 100, RenderScheduler::HighPriority)};
+        CHECK(scheduler.jobsToStart(waiting, {}) == std::vector<size_t>{1, 2});
+        // Two passes writing the same file never run together
+        waiting = {job("a.mp4", 1, 100), job("a.mp4", 1, 100), job("b.mp4", 1, 100)};
+        CHECK(scheduler.jobsToStart(waiting, {}) == std::vector<size_t>{0, 2});
+    }
+
+    SECTION("Cost estimation")
+    {
+        RenderScheduler::Cost hd = RenderScheduler::estimateCost(1920, 1080, 1, true);
+        RenderScheduler::Cost uhd = RenderScheduler::estimateCost(3840, 2160, 1, true);
+        RenderScheduler::Cost audio = RenderScheduler::estimateCost(3840, 2160, 4, false);
+        CHECK(hd.threads == 2);
+        CHECK(uhd.memory > hd.memory);
+        CHECK(audio.threads == 1);
+        CHECK(audio.memory < hd.memory);
+        // A segmented render runs one process per segment plus the audio
+        CHECK(RenderScheduler::estimateCost(1920, 1080, 1, true, 3).threads == 4 * hd.threads);
+    }
+}
@@ -60,6 +60,75 @@ TEST_CASE("Remove all spaces", "[Spacer]")
         REQUIRE(timeline->getClipPosition(cid4) == 20);
     };
 
+    SECTION("Range queries use the position index")
+    {
+        // We have clips at 10, 80, 101 on track 1 (length 20 frames each)
+        state1();
+        auto track = KdenliveTests::getTrackById_const(timeline, tid1);
+        REQUIRE(timeline->getItemsInRange(tid1, 0) == std::unordered_set<int>({cid1, cid2, cid3}));
+        REQUIRE(timeline->getItemsInRange(tid1, 25, 85) == std::unordered_set<int>({cid1, cid2}));
+        REQUIRE(timeline->getItemsInRange(tid1, 30, 80).empty());
+        REQUIRE(timeline->getItemsInRange(tid1, 100, 102) == std::unordered_set<int>({cid3}));
+        REQUIRE(track->getClipByStartPosition(101) == cid3);
+        REQUIRE(track->getClipByStartPosition(100) == -1);
+        REQUIRE(track->getNextClip(31) == cid2);
+        REQUIRE(track->getNextClip(102) == -1);
+        REQUIRE(track->getPreviousClip(80) == cid1);
+        REQUIRE(track->getPreviousClip(81, {cid2}) == cid1);
+        REQUIRE(timeline->getPreviousItemEnd(tid1, 80, {}) == 30);
+        REQUIRE(timeline->getPreviousItemEnd(tid1, 80, {cid1}) == -1);
+
+        // The index follows the resize from the left
+        REQUIRE(timeline->requestItemResize(cid3, 15, false) == 15);
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(track->getClipByStartPosition(106) == cid3);
+        REQUIRE(timeline->getItemsInRange(tid1, 100, 105).empty());
+        undoStack->undo();
+        state1();
+        REQUIRE(track->getClipByStartPosition(101) == cid3);
+
+        // And the deletion
+        REQUIRE(timeline->requestItemDeletion(cid2));
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(timeline->getItemsInRange(tid1, 30, 100).empty());
+        REQUIRE(track->getNextClip(31) == cid3);
+        undoStack->undo();
+        state1();
+    }
+    SECTION("Clip rows follow insertions and deletions")
+    {
+        // Rows are ordered by clip id
+        REQUIRE(timeline->makeClipIndexFromID(cid1).row() == 0);
+        REQUIRE(timeline->makeClipIndexFromID(cid2).row() == 1);
+        REQUIRE(timeline->makeClipIndexFromID(cid3).row() == 2);
+        REQUIRE(timeline->makeClipIndexFromID(cid4).row() == 0);
+        REQUIRE(timeline->requestItemDeletion(cid2));
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(timeline->makeClipIndexFromID(cid3).row() == 1);
+        undoStack->undo();
+        state1();
+        REQUIRE(timeline->makeClipIndexFromID(cid2).row() == 1);
+        REQUIRE(timeline->makeClipIndexFromID(cid3).row() == 2);
+    }
+    SECTION("Group move notifications are batched")
+    {
+        std::unordered_set<int> ids = {cid2, cid3};
+        int gid = timeline->requestClipsGroup(ids);
+        REQUIRE(gid > -1);
+        int batched = timeline->batchedNotifications();
+        int sent = timeline->sentBatchNotifications();
+        REQUIRE(timeline->requestGroupMove(cid2, gid, 0, 5));
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(timeline->getClipPosition(cid2) == 85);
+        REQUIRE(timeline->getClipPosition(cid3) == 106);
+        // Both clips are on adjacent rows, their changes are sent together
+        REQUIRE(timeline->batchedNotifications() > batched);
+        REQUIRE(timeline->sentBatchNotifications() > sent);
+        REQUIRE(timeline->sentBatchNotifications() - sent < timeline->batchedNotifications() - batched);
+        undoStack->undo();
+        undoStack->undo();
+        state1();
+    }
     SECTION("Ensure remove spaces behaves correctly")
     {
         // We have clips at 10, 80, 101 on track 1 (length 20 frames each)
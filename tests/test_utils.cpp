@@ -213,6 +213,21 @@ bool KdenliveTests::addKeyframe(std::shared_ptr<KeyframeModel> model, GenTime po
     return model->addKeyframe(pos, type, value);
 }
 
+QString KdenliveTests::getAnimProperty(std::shared_ptr<KeyframeModel> model)
+{
+    return model->getAnimProperty();
+}
+
+QVariant KdenliveTests::getInterpolatedValue(std::shared_ptr<KeyframeModel> model, int pos)
+{
+    return model->getInterpolatedValue(pos);
+}
+
+QVector<QVariant> KdenliveTests::getInterpolatedValues(std::shared_ptr<KeyframeModel> model, int from, int to)
+{
+    return model->getInterpolatedValues(from, to);
+}
+
 bool KdenliveTests::removeKeyframe(std::shared_ptr<KeyframeModel> model, GenTime pos)
 {
     return model->removeKeyframe(pos);
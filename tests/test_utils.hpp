@@ -129,6 +129,9 @@ public:
     static bool addKeyframe(std::shared_ptr<KeyframeModel> model, GenTime pos, KeyframeType::KeyframeEnum type, QVariant value);
     static bool removeKeyframe(std::shared_ptr<KeyframeModel> model, GenTime pos);
     static bool removeAllKeyframes(std::shared_ptr<KeyframeModel> model);
+    static QString getAnimProperty(std::shared_ptr<KeyframeModel> model);
+    static QVariant getInterpolatedValue(std::shared_ptr<KeyframeModel> model, int pos);
+    static QVector<QVariant> getInterpolatedValues(std::shared_ptr<KeyframeModel> model, int from, int to);
     static void forceClipAudio(std::shared_ptr<TimelineItemModel> timeline, int clipId);
     static int groupsCount(std::shared_ptr<TimelineItemModel> timeline);
     static std::unordered_map<int, int> groupUpLink(std::shared_ptr<TimelineItemModel> timeline);
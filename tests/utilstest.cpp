@@ -6,8 +6,18 @@
 #include "catch.hpp"
 #include "test_utils.hpp"
 // test specific headers
+#include "audiomixer/audiometerring.hpp"
+#include "jobs/audiolevelstask.h"
+#include "lib/audio/audioLevelsBuffer.h"
+#include "lib/audio/audioLevelsPyramid.h"
 #include "utils/qstringutils.h"
 
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+#include <cmath>
+#include <thread>
+
 TEST_CASE("Testing for different utils", "[Utils]")
 {
 
@@ -30,3 +40,228 @@ TEST_CASE("Testing for different utils", "[Utils]")
         REQUIRE(names.removeDuplicates() == 0);
     }
 }
+
+TEST_CASE("Audio levels buffer", "[Utils]")
+{
+    // Use more than one chunk to check values across chunk boundaries
+    const int capacity = AudioLevelsBuffer::ChunkSize * 2 + 10;
+    AudioLevelsBuffer buffer(capacity);
+    REQUIRE(buffer.isEmpty());
+    REQUIRE(buffer.capacity() == capacity);
+    for (int i = 0; i < capacity; i++) {
+        buffer.append(uint8_t(i % 251));
+    }
+    REQUIRE(buffer.size() == capacity);
+    REQUIRE(buffer.last() == uint8_t((capacity - 1) % 251));
+    REQUIRE(buffer.at(AudioLevelsBuffer::ChunkSize) == uint8_t(AudioLevelsBuffer::ChunkSize % 251));
+    // Values past the capacity are dropped
+    buffer.append(1);
+    REQUIRE(buffer.size() == capacity);
+    const QVector<uint8_t> copy = buffer.toVector();
+    REQUIRE(copy.size() == capacity);
+    REQUIRE(AudioLevelsBuffer(copy).toVector() == copy);
+}
+
+TEST_CASE("Audio meter ring", "[Utils]")
+{
+    AudioMeterRing ring(3, 2);
+    REQUIRE(ring.capacity() == 3);
+    REQUIRE(ring.channels() == 2);
+    int pos = -1;
+    double levels[2] = {0., 0.};
+    REQUIRE_FALSE(ring.pop(pos, levels));
+    for (int i = 0; i < 3; i++) {
+        const double values[2] = {-double(i), -10. - i};
+        REQUIRE(ring.push(i, values));
+    }
+    // The ring is full, new levels are dropped
+    const double values[2] = {1., 1.};
+    REQUIRE_FALSE(ring.push(3, values));
+    REQUIRE(ring.dropped() == 1);
+    REQUIRE(ring.pop(pos, levels));
+    REQUIRE(pos == 0);
+    REQUIRE(levels[1] == -10.);
+    // Entries are popped in order, across the end of the storage
+    REQUIRE(ring.push(4, values));
+    for (int expected : {1, 2, 4}) {
+        REQUIRE(ring.pop(pos, levels));
+        REQUIRE(pos == expected);
+    }
+    REQUIRE(levels[0] == 1.);
+    REQUIRE_FALSE(ring.pop(pos, levels));
+    REQUIRE(ring.push(5, values));
+    ring.clear();
+    REQUIRE_FALSE(ring.pop(pos, levels));
+
+    // One producer and one consumer thread
+    AudioMeterRing shared(16, 1);
+    const int count = 100000;
+    std::thread producer([&shared]() {
+        for (int i = 0; i < count; i++) {
+            const double value = i;
+            while (!shared.push(i, &value)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int next = 0;
+    bool ordered = true;
+    while (next < count) {
+        double value;
+        if (shared.pop(pos, &value)) {
+            ordered = ordered && pos == next && value == next;
+            next++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    REQUIRE(ordered);
+}
+
+TEST_CASE("Segmented audio levels", "[Utils]")
+{
+    // 2 interleaved channels, 300 frames, as computed in a single pass
+    const int channels = 2;
+    const int frames = 300;
+    QVector<uint8_t> single;
+    for (int i = 0; i < frames * channels; i++) {
+        single << uint8_t((i * 13) % 256);
+    }
+    auto segmentLevels = [&single, channels](int start, int end) {
+        auto levels = std::make_shared<AudioLevelsBuffer>(qMax(0, end - start) * channels);
+        for (int i = start * channels; i < end * channels; i++) {
+            levels->append(single.at(i));
+        }
+        return levels;
+    };
+
+    SECTION("Segments are stitched like a single pass")
+    {
+        // The first segment writes in the stream buffer, the others in their own buffer
+        AudioLevelsBuffer levels(frames * channels);
+        for (int i = 0; i < 100 * channels; i++) {
+            levels.append(single.at(i));
+        }
+        AudioLevelsTask::stitchSegment(levels, nullptr, 0, 100, channels);
+        AudioLevelsTask::stitchSegment(levels, segmentLevels(100, 200).get(), 100, 200, channels);
+        AudioLevelsTask::stitchSegment(levels, segmentLevels(200, 300).get(), 200, 300, channels);
+        REQUIRE(levels.toVector() == single);
+    }
+
+    SECTION("Short and long segments keep the next ones at their position")
+    {
+        AudioLevelsBuffer levels(frames * channels);
+        // The first segment misses its last 5 frames, the second one has 3 frames too many
+        for (int i = 0; i < 95 * channels; i++) {
+            levels.append(single.at(i));
+        }
+        AudioLevelsTask::stitchSegment(levels, nullptr, 0, 100, channels);
+        REQUIRE(levels.size() == 100 * channels);
+        AudioLevelsTask::stitchSegment(levels, segmentLevels(100, 203).get(), 100, 200, channels);
+        AudioLevelsTask::stitchSegment(levels, segmentLevels(200, 300).get(), 200, 300, channels);
+        const QVector<uint8_t> result = levels.toVector();
+        REQUIRE(result.size() == single.size());
+        REQUIRE(result.mid(0, 95 * channels) == single.mid(0, 95 * channels));
+        REQUIRE(result.mid(100 * channels) == single.mid(100 * channels));
+    }
+}
+
+TEST_CASE("Audio levels pyramid", "[Utils]")
+{
+    // 2 interleaved channels, 1000 frames
+    QVector<uint8_t> levels;
+    for (int i = 0; i < 1000; i++) {
+        levels << uint8_t(i % 200) << uint8_t((i * 7) % 255);
+    }
+    AudioLevelsPyramid pyramid(std::make_shared<AudioLevelsBuffer>(levels), 2);
+    REQUIRE(pyramid.frames() == 1000);
+    REQUIRE(pyramid.levelCount() == 11);
+
+    SECTION("Peak and minimum are exact on any range")
+    {
+        auto bruteMax = [&levels](int channel, int start, int end) {
+            uint8_t result = 0;
+            for (int f = start; f < end; f++) {
+                result = qMax(result, levels.at(2 * f + channel));
+            }
+            return result;
+        };
+        auto bruteMin = [&levels](int channel, int start, int end) {
+            uint8_t result = 255;
+            for (int f = start; f < end; f++) {
+                result = qMin(result, levels.at(2 * f + channel));
+            }
+            return result;
+        };
+        REQUIRE(pyramid.peak(0, 0, 1) == 0);
+        REQUIRE(pyramid.peak(0, 0, 256) == bruteMax(0, 0, 256));
+        REQUIRE(pyramid.peak(1, 512, 768) == bruteMax(1, 512, 768));
+        // Unaligned span: the blocks around 199 and 200 only partly overlap [3, 199[ and [201, 390[
+        REQUIRE(pyramid.peak(0, 3, 199) == 198);
+        REQUIRE(pyramid.minimum(0, 201, 390) == 1);
+        for (int start = 0; start < 990; start += 37) {
+            for (int span : {1, 2, 5, 16, 63, 333}) {
+                int end = qMin(1000, start + span);
+                REQUIRE(pyramid.peak(0, start, end) == bruteMax(0, start, end));
+                REQUIRE(pyramid.peak(1, start, end) == bruteMax(1, start, end));
+                REQUIRE(pyramid.minimum(0, start, end) == bruteMin(0, start, end));
+                REQUIRE(pyramid.minimum(1, start, end) == bruteMin(1, start, end));
+            }
+        }
+        // Out of range queries
+        REQUIRE(pyramid.peak(2, 0, 10) == 0);
+        REQUIRE(pyramid.peak(0, 1000, 1010) == 0);
+    }
+
+    SECTION("RMS of an unaligned span is close to the exact value")
+    {
+        auto bruteRms = [&levels](int channel, int start, int end) {
+            double sum = 0.;
+            for (int f = start; f < end; f++) {
+                sum += double(levels.at(2 * f + channel)) * levels.at(2 * f + channel);
+            }
+            return std::sqrt(sum / (end - start));
+        };
+        // Each decimated level truncates its RMS to an integer
+        for (auto range : {std::make_pair(3, 199), std::make_pair(201, 390), std::make_pair(17, 983)}) {
+            REQUIRE(std::abs(pyramid.rms(0, range.first, range.second) - bruteRms(0, range.first, range.second)) < 4.);
+            REQUIRE(std::abs(pyramid.rms(1, range.first, range.second) - bruteRms(1, range.first, range.second)) < 4.);
+        }
+    }
+
+    SECTION("Binary cache round trip")
+    {
+        QTemporaryDir dir;
+        const QString path = dir.filePath(QStringLiteral("levels"));
+        REQUIRE(pyramid.save(path));
+        std::shared_ptr<AudioLevelsPyramid> loaded = AudioLevelsPyramid::load(path);
+        REQUIRE(loaded != nullptr);
+        REQUIRE(loaded->channels() == 2);
+        REQUIRE(loaded->baseLevels()->toVector() == levels);
+        REQUIRE(loaded->levelCount() == pyramid.levelCount());
+        REQUIRE(loaded->peak(1, 100, 900) == pyramid.peak(1, 100, 900));
+        REQUIRE(loaded->rms(0, 0, 1000) == pyramid.rms(0, 0, 1000));
+        REQUIRE(AudioLevelsPyramid::load(dir.filePath(QStringLiteral("missing"))) == nullptr);
+    }
+
+    SECTION("Corrupt binary cache")
+    {
+        QTemporaryDir dir;
+        const auto writeHeader = [&dir](const QString &name, quint32 baseSize, quint32 levelCount) {
+            const QString path = dir.filePath(name);
+            QFile file(path);
+            REQUIRE(file.open(QIODevice::WriteOnly));
+            QDataStream out(&file);
+            out << quint32(0x4b444c56) << quint32(1) << quint32(2) << baseSize << levelCount;
+            out.writeRawData(QByteArray(64, 'a').constData(), 64);
+            return path;
+        };
+        // The base level does not fit in the file
+        REQUIRE(AudioLevelsPyramid::load(writeHeader(QStringLiteral("huge"), 0xfffffffe, 31)) == nullptr);
+        // 32 frames are decimated 5 times
+        REQUIRE(AudioLevelsPyramid::load(writeHeader(QStringLiteral("levels"), 64, 2)) == nullptr);
+        // Truncated levels
+        REQUIRE(AudioLevelsPyramid::load(writeHeader(QStringLiteral("truncated"), 64, 5)) == nullptr);
+    }
+}